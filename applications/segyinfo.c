@@ -1,4 +1,6 @@
+#define _GNU_SOURCE
 #include <float.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -26,17 +28,30 @@ int main(int argc, char* argv[]) {
 
     if( argc < 2 ) {
         puts("Missing argument, expected run signature:");
-        printf("  %s <segy_file> [mmap]\n", argv[0]);
+        printf("  %s <segy_file> [mmap] [stats [threads]]\n", argv[0]);
         exit(1);
     }
 
+    int use_mmap = 0;
+    int stats = 0;
+    int threads = 1;
+    for( int i = 2; i < argc; ++i ) {
+        if( strcmp( argv[ i ], "mmap" ) == 0 ) {
+            use_mmap = 1;
+        } else if( strcmp( argv[ i ], "stats" ) == 0 ) {
+            stats = 1;
+            if( i + 1 < argc && atoi( argv[ i + 1 ] ) > 0 )
+                threads = atoi( argv[ ++i ] );
+        }
+    }
+
     segy_file* fp = segy_open( argv[ 1 ], "rb" );
     if( !fp ) {
         perror( "fopen():" );
         exit( 3 );
     }
 
-    if( argc > 2 && strcmp( argv[ 2 ], "mmap" ) == 0 ) {
+    if( use_mmap ) {
         int err = segy_mmap( fp );
         if( err != SEGY_OK )
             fputs( "Could not mmap file. Using fstream fallback.", stderr );
@@ -47,11 +62,11 @@ int main(int argc, char* argv[]) {
     const int samples = fp->metadata.samplecount;
     const long trace_bsize = fp->metadata.trace_bsize;
     const int extended_headers = fp->metadata.ext_textheader_count;
-    const int traces = fp->metadata.tracecount;
+    const long long traces = fp->metadata.tracecount;
 
     printf( "Sample format: %d\n", format );
     printf( "Samples per trace: %d\n", samples );
-    printf( "Traces: %d\n", traces );
+    printf( "Traces: %lld\n", traces );
     printf("Extended text header count: %d\n", extended_headers );
     puts("");
 
@@ -80,6 +95,9 @@ int main(int argc, char* argv[]) {
     puts("Info from second trace:");
     printSegyTraceInfo( traceh );
 
+    const segy_entry_definition* map =
+        fp->traceheader_mapping_standard.offset_to_entry_definition;
+
     clock_t start = clock();
     float* trbuf = malloc( sizeof( float ) * trace_bsize );
 
@@ -88,8 +106,8 @@ int main(int argc, char* argv[]) {
 
     int min_sample_count = 999999999;
     int max_sample_count = 0;
-    for( int i = 0; i < traces; ++i ) {
-        err = segy_read_standard_traceheader( fp, i, traceh );
+    for( long long i = 0; i < traces; ++i ) {
+        err = segy_read_traceheader64( fp, i, 0, map, traceh );
         if( err != 0 ) {
             perror( "Unable to read trace" );
             exit( err );
@@ -106,10 +124,10 @@ int main(int argc, char* argv[]) {
         min_sample_count = minimum( sample_count, min_sample_count );
         max_sample_count = maximum( sample_count, max_sample_count );
 
-        err = segy_readtrace( fp, i, trbuf );
+        err = segy_readtrace64( fp, i, trbuf );
 
         if( err != 0 ) {
-            fprintf( stderr, "Unable to read trace: %d\n", i );
+            fprintf( stderr, "Unable to read trace: %lld\n", i );
             exit( err );
         }
 
@@ -125,7 +143,7 @@ int main(int argc, char* argv[]) {
 
     puts("");
     puts("Info from last trace:");
-    err = segy_read_standard_traceheader( fp, traces - 1, traceh );
+    err = segy_read_traceheader64( fp, traces - 1, 0, map, traceh );
 
     if( err != 0 ) {
         perror( "Unable to read trace." );
@@ -144,6 +162,32 @@ int main(int argc, char* argv[]) {
     clock_t diff = clock() - start;
     printf("Read all trace headers in: %.2f s\n", (double) diff / CLOCKS_PER_SEC);
 
+    if( stats ) {
+        segy_amplitudes amp;
+        struct timespec begin, end;
+        clock_gettime( CLOCK_MONOTONIC, &begin );
+        err = segy_stats( fp, NULL, 1, &amp, NULL, 0, 0, 0, NULL, threads );
+        clock_gettime( CLOCK_MONOTONIC, &end );
+
+        if( err != 0 ) {
+            fprintf( stderr, "Unable to compute amplitude statistics\n" );
+            exit( err );
+        }
+
+        const double seconds = ( end.tv_sec - begin.tv_sec )
+                             + ( end.tv_nsec - begin.tv_nsec ) * 1e-9;
+        const double count = amp.count > 0 ? (double)amp.count : NAN;
+
+        puts("");
+        printf("Amplitude samples: %lld\n", amp.count );
+        printf("Amplitude NaNs:    %lld\n", amp.nans );
+        printf("Amplitude min:     %f\n", amp.min );
+        printf("Amplitude max:     %f\n", amp.max );
+        printf("Amplitude mean:    %f\n", amp.sum / count );
+        printf("Amplitude RMS:     %f\n", sqrt( amp.sumsq / count ) );
+        printf("Computed amplitude statistics in: %.2f s\n", seconds );
+    }
+
     segy_close( fp );
     return 0;
 }
@@ -1,12 +1,18 @@
+#define _GNU_SOURCE
 #include <errno.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <getopt.h>
 #include <unistd.h>
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
 #include "apputils.c"
 #include <segyio/segy.h>
 
@@ -27,6 +33,7 @@ static int help(void) {
           "                           formats: ibm ieee short long char\n"
           "-b, --il                   inline header word byte offset\n"
           "-B, --xl                   crossline header word byte offset\n"
+          "-j, --threads=N            crop traces with N threads (default 1)\n"
           "-v, --verbose              increase verbosity\n"
           "    --version              output version information and exit\n"
           "    --help                 display this help and exit\n"
@@ -35,6 +42,9 @@ static int help(void) {
           "essentially a copy. If a begin option is omitted, the program\n"
           "copies from the start. If an end option is omitted, the program\n"
           "copies until the end.\n"
+          "\n"
+          "Runs of consecutive traces that are copied unchanged are moved in\n"
+          "large blocks, in the kernel when the system supports it.\n"
         );
     return 0;
 }
@@ -186,12 +196,242 @@ static int valid_trfield( int x ) {
 #define BINSIZE  SEGY_BINARY_HEADER_SIZE
 #define TEXTSIZE SEGY_TEXT_HEADER_SIZE
 
+/* upper bound of a run, in bytes, and so the buffer size of every thread */
+#define CHUNKSIZE (8 * 1024 * 1024)
+
+/*
+ * A run of consecutive traces in SRC that are written back to back in DST.
+ * Identity runs are not changed by the crop at all, and can be copied as one
+ * block of bytes.
+ */
+struct run {
+    long long src;
+    long long count;
+    long long dst;
+    int len;
+    int identity;
+};
+
+struct crop {
+    long long trace0;
+    long long record;
+    int elemsize;
+    int samples;
+    int sbeg, send;
+    int dt;
+    int src, dst;
+
+    struct run* runs;
+    int nruns;
+    int next;
+    int err;
+    const char* errmsg;
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t lock;
+#endif
+};
+
+/*
+ * Write the cropped copy of the trace header in to out, and return how the
+ * samples should be cropped
+ */
+static struct delay crop_header( const struct crop* crop,
+                                 const char* in,
+                                 char* out ) {
+    struct delay d = delay_recording_time( in,
+                                           crop->sbeg,
+                                           crop->send,
+                                           crop->dt,
+                                           crop->samples );
+
+    memmove( out, in, TRHSIZE );
+    segy_set_tracefield_int( out, SEGY_TR_SAMPLE_COUNT, d.len );
+    segy_set_tracefield_int( out, SEGY_TR_DELAY_REC_TIME, d.delay );
+    return d;
+}
+
+static int read_at( int fd, char* buf, long long size, long long offset ) {
+    while( size > 0 ) {
+#ifdef HAVE_PREAD
+        const ssize_t sz = pread( fd, buf, size, offset );
+#else
+        if( lseek( fd, offset, SEEK_SET ) < 0 ) return errno;
+        const ssize_t sz = read( fd, buf, size );
+#endif
+        if( sz < 0 && errno == EINTR ) continue;
+        if( sz < 0 ) return errno;
+        if( sz == 0 ) return EIO;
+        buf += sz, offset += sz, size -= sz;
+    }
+    return 0;
+}
+
+static int write_at( int fd, const char* buf, long long size, long long offset ) {
+    while( size > 0 ) {
+#ifdef HAVE_PREAD
+        const ssize_t sz = pwrite( fd, buf, size, offset );
+#else
+        if( lseek( fd, offset, SEEK_SET ) < 0 ) return errno;
+        const ssize_t sz = write( fd, buf, size );
+#endif
+        if( sz < 0 && errno == EINTR ) continue;
+        if( sz < 0 ) return errno;
+        buf += sz, offset += sz, size -= sz;
+    }
+    return 0;
+}
+
+/*
+ * Copy bytes from src to dst without modifying them. copy_file_range lets
+ * the kernel (or file system, with reflinks) do the copy, and blocks are
+ * read and written through buf when it is not available or not supported
+ * for these files.
+ */
+static int copy_block( const struct crop* crop,
+                       char* buf,
+                       long long size,
+                       long long from,
+                       long long to ) {
+#ifdef HAVE_COPY_FILE_RANGE
+    while( size > 0 ) {
+        loff_t in = from, out = to;
+        const ssize_t sz = copy_file_range( crop->src, &in,
+                                            crop->dst, &out,
+                                            size, 0 );
+        if( sz < 0 && errno == EINTR ) continue;
+        if( sz < 0 ) {
+            if( errno == EXDEV || errno == ENOSYS
+             || errno == EINVAL || errno == EOPNOTSUPP )
+                break;
+            return errno;
+        }
+        if( sz == 0 ) return EIO;
+        from += sz, to += sz, size -= sz;
+    }
+#endif
+
+    while( size > 0 ) {
+        const long long block = size < CHUNKSIZE ? size : CHUNKSIZE;
+        int err = read_at( crop->src, buf, block, from );
+        if( !err ) err = write_at( crop->dst, buf, block, to );
+        if( err ) return err;
+        from += block, to += block, size -= block;
+    }
+
+    return 0;
+}
+
+static int crop_run( const struct crop* crop, const struct run* r, char* buf ) {
+    const long long from = crop->trace0 + r->src * crop->record;
+
+    if( r->identity )
+        return copy_block( crop, buf, r->count * crop->record, from, r->dst );
+
+    int err = read_at( crop->src, buf, r->count * crop->record, from );
+    if( err ) return err;
+
+    /*
+     * Crop the traces in-place. The cropped traces are never longer than the
+     * source traces, so the output never overtakes the input.
+     */
+    const long long outsize = TRHSIZE + (long long)crop->elemsize * r->len;
+    char header[ TRHSIZE ];
+    for( long long i = 0; i < r->count; ++i ) {
+        const char* in = buf + i * crop->record;
+        char* out = buf + i * outsize;
+        const struct delay d = crop_header( crop, in, header );
+        memmove( out + TRHSIZE,
+                 in + TRHSIZE + (long long)crop->elemsize * d.skip,
+                 (long long)crop->elemsize * d.len );
+        memcpy( out, header, TRHSIZE );
+    }
+
+    return write_at( crop->dst, buf, r->count * outsize, r->dst );
+}
+
+static void* crop_worker( void* arg ) {
+    struct crop* crop = arg;
+
+    const long long bufsize = crop->record > CHUNKSIZE
+                            ? crop->record
+                            : CHUNKSIZE;
+    char* buf = malloc( bufsize );
+
+    while( true ) {
+#ifdef HAVE_PTHREAD
+        pthread_mutex_lock( &crop->lock );
+#endif
+        int next = -1;
+        if( !buf && !crop->err ) {
+            crop->err = ENOMEM;
+            crop->errmsg = "Unable to allocate";
+        } else if( !crop->err && crop->next < crop->nruns ) {
+            next = crop->next++;
+        }
+#ifdef HAVE_PTHREAD
+        pthread_mutex_unlock( &crop->lock );
+#endif
+        if( next < 0 ) break;
+
+        const int err = crop_run( crop, crop->runs + next, buf );
+        if( !err ) continue;
+
+#ifdef HAVE_PTHREAD
+        pthread_mutex_lock( &crop->lock );
+#endif
+        if( !crop->err ) {
+            crop->err = err;
+            crop->errmsg = "Unable to copy traces";
+        }
+#ifdef HAVE_PTHREAD
+        pthread_mutex_unlock( &crop->lock );
+#endif
+    }
+
+    free( buf );
+    return NULL;
+}
+
+static void copy_runs( struct crop* crop, int threads ) {
+#ifdef HAVE_PTHREAD
+    if( threads > crop->nruns ) threads = crop->nruns;
+    if( threads < 1 ) threads = 1;
+#ifndef HAVE_PREAD
+    /* without pread, the file offset is shared by all threads */
+    threads = 1;
+#endif
+
+    pthread_mutex_init( &crop->lock, NULL );
+    pthread_t* workers = malloc( sizeof( pthread_t ) * threads );
+    int started = 0;
+    if( workers ) {
+        for( ; started < threads - 1; ++started ) {
+            if( pthread_create( workers + started, NULL, crop_worker, crop ) )
+                break;
+        }
+    }
+
+    crop_worker( crop );
+
+    for( int i = 0; i < started; ++i )
+        pthread_join( workers[ i ], NULL );
+
+    free( workers );
+    pthread_mutex_destroy( &crop->lock );
+#else
+    (void)threads;
+    crop_worker( crop );
+#endif
+}
+
 struct options {
     int ibeg, iend;
     int xbeg, xend;
     int sbeg, send;
     int format;
     int il, xl;
+    int threads;
     char* src;
     char* dst;
     int verbosity;
@@ -206,6 +446,7 @@ static struct options parse_options( int argc, char** argv ) {
     opts.sbeg = -1, opts.send = INT_MAX;
     opts.format = 0;
     opts.il = SEGY_TR_INLINE, opts.xl = SEGY_TR_CROSSLINE;
+    opts.threads = 1;
     opts.verbosity = 0;
     opts.version = 0, opts.help = 0;
     opts.errmsg = NULL;
@@ -231,6 +472,7 @@ static struct options parse_options( int argc, char** argv ) {
         { "format",             required_argument, 0, 'f' },
         { "il",                 required_argument, 0, 'b' },
         { "xl",                 required_argument, 0, 'B' },
+        { "threads",            required_argument, 0, 'j' },
 
         { "verbose",            no_argument,       0, 'v' },
         { "version",            no_argument,       0, 'V' },
@@ -245,7 +487,7 @@ static struct options parse_options( int argc, char** argv ) {
 
     while( true ) {
         int option_index = 0;
-        int c = getopt_long( argc, argv, "vi:I:x:X:f:s:S:b:B:",
+        int c = getopt_long( argc, argv, "vi:I:x:X:f:s:S:b:B:j:",
                              long_options, &option_index );
 
         if( c == -1 ) break;
@@ -323,6 +565,13 @@ static struct options parse_options( int argc, char** argv ) {
                 opts.errmsg = parsenum_errmsg[ ret ];
                 return opts;
 
+            case 'j':
+                ret = parseint( optarg, &opts.threads );
+                if( ret == 0 && opts.threads > 0 ) break;
+                opts.errmsg = ret ? parsenum_errmsg[ ret ]
+                                  : "threads must be at least 1";
+                return opts;
+
             default:
                 opthelp.errmsg = "";
                 return opthelp;
@@ -480,69 +729,124 @@ int main( int argc, char** argv ) {
     const int trace_bsize = segy_trsize( format, src_samples );
     const int elemsize = trace_bsize / src_samples;
     if( verbosity > 2 ) printf( "Found %d bytes per trace\n", trace_bsize );
-    void* trace = malloc( trace_bsize );
 
-    if( verbosity > 0 ) puts( "Copying traces" );
+    struct crop crop;
+    crop.trace0 = TEXTSIZE + BINSIZE + (long long)ext_headers * TEXTSIZE;
+    crop.record = TRHSIZE + trace_bsize;
+    crop.elemsize = elemsize;
+    crop.samples = src_samples;
+    crop.sbeg = sbeg;
+    crop.send = send;
+    crop.dt = bindt;
+    crop.src = fileno( src );
+    crop.dst = fileno( dst );
+    crop.runs = NULL;
+    crop.nruns = 0;
+    crop.next = 0;
+    crop.err = 0;
+    crop.errmsg = NULL;
+
+    /*
+     * Find the traces to copy, and how to crop them, from the trace headers,
+     * as runs of consecutive traces. Traces that are not changed at all are
+     * copied byte for byte.
+     */
+    if( verbosity > 0 ) puts( "Finding traces to copy" );
     long long traces = 0;
-    while( true ) {
+    int capacity = 0;
+    int last_len = src_samples;
+    long long outpos = crop.trace0;
+    char cropped[ TRHSIZE ];
+    for( long long trno = 0; ; ++trno ) {
         sz = fread( trheader, TRHSIZE, 1, src );
 
         if( sz != 1 && feof( src ) ) break;
         if( sz != 1 && ferror( src ) )
             exit( errmsg( ferror( src ), "Unable to read trace header" ) );
 
+        if( fseek( src, trace_bsize, SEEK_CUR ) != 0 )
+            exit( errmsg2( errno, "Unable to read trace",
+                                   strerror( errno ) ) );
+
         int ilno;
         segy_get_tracefield_int( trheader, il, &ilno );
         int xlno;
         segy_get_tracefield_int( trheader, xl, &xlno );
 
         /* outside copy interval - skip this trace */
-        if( ilno < ibeg || ilno > iend || xlno < xbeg || xlno > xend ) {
-            fseek( src, elemsize * src_samples, SEEK_CUR );
+        if( ilno < ibeg || ilno > iend || xlno < xbeg || xlno > xend )
             continue;
-        }
-
-        sz = fread( trace, elemsize, src_samples, src );
-        if( sz != src_samples )
-            exit( errmsg2( errno, "Unable to read trace",
-                                   strerror( errno ) ) );
 
-        /* figure out how to crop the trace */
-        struct delay d = delay_recording_time( trheader,
-                                               sbeg,
-                                               send,
-                                               bindt,
-                                               src_samples );
-
-        segy_set_tracefield_int( trheader, SEGY_TR_SAMPLE_COUNT, d.len );
-        segy_set_tracefield_int( trheader, SEGY_TR_DELAY_REC_TIME, d.delay );
-        segy_set_binfield_int( binheader, SEGY_BIN_SAMPLES, d.len );
-
-        if( verbosity > 2 ) printf( "Copying trace %lld\n", traces );
-        sz = fwrite( trheader, TRHSIZE, 1, dst );
-        if( sz != 1 )
-            exit( errmsg2( errno, "Unable to write trace header",
-                                   strerror( errno ) ) );
+        const struct delay d = crop_header( &crop, trheader, cropped );
+        if( d.len < 0 )
+            exit( errmsg( -4, "Invalid sample interval - trace would be empty" ) );
 
-        sz = fwrite( (char*)trace + elemsize * d.skip, elemsize, d.len, dst );
-        if( sz != d.len )
-            exit( errmsg2( errno, "Unable to write trace",
-                                   strerror( errno ) ) );
+        const int identity = d.skip == 0
+                          && d.len == src_samples
+                          && memcmp( cropped, trheader, TRHSIZE ) == 0;
+        last_len = d.len;
         ++traces;
+
+        struct run* prev = crop.nruns ? crop.runs + crop.nruns - 1 : NULL;
+        if( prev
+         && prev->src + prev->count == trno
+         && prev->identity == identity
+         && prev->len == d.len
+         && ( prev->count + 1 ) * crop.record <= CHUNKSIZE ) {
+            ++prev->count;
+        } else {
+            if( crop.nruns == capacity ) {
+                capacity = capacity ? capacity * 2 : 1024;
+                struct run* runs = realloc( crop.runs,
+                                            capacity * sizeof( struct run ) );
+                if( !runs ) exit( errmsg( ENOMEM, "Unable to allocate" ) );
+                crop.runs = runs;
+            }
+
+            struct run* r = crop.runs + crop.nruns++;
+            r->src = trno;
+            r->count = 1;
+            r->dst = outpos;
+            r->len = d.len;
+            r->identity = identity;
+        }
+
+        outpos += TRHSIZE + (long long)elemsize * d.len;
     }
 
+    if( traces ) segy_set_binfield_int( binheader, SEGY_BIN_SAMPLES, last_len );
+
+    if( fflush( dst ) != 0 )
+        exit( errmsg2( errno, "Unable to write", strerror( errno ) ) );
+
+    if( verbosity > 0 )
+        printf( "Copying %lld traces in %d runs\n", traces, crop.nruns );
+
+    struct timespec begin, end;
+    clock_gettime( CLOCK_MONOTONIC, &begin );
+    copy_runs( &crop, opts.threads );
+    clock_gettime( CLOCK_MONOTONIC, &end );
+
+    if( crop.err )
+        exit( errmsg2( crop.err, crop.errmsg, strerror( crop.err ) ) );
+
     fseek( dst, SEGY_TEXT_HEADER_SIZE, SEEK_SET );
     sz = fwrite( binheader, BINSIZE, 1, dst );
     if( sz != 1 ) exit( errmsg2( errno, "Unable to write binary header",
                                          strerror( errno ) ) );
 
-    if( verbosity > 0 )
-        printf( "Copied %lld traces\n", traces );
+    if( verbosity > 0 ) {
+        const double seconds = ( end.tv_sec - begin.tv_sec )
+                             + ( end.tv_nsec - begin.tv_nsec ) * 1e-9;
+        const double mib = ( outpos - crop.trace0 ) / ( 1024.0 * 1024.0 );
+        printf( "Copied %lld traces, %.1f MiB in %.2fs (%.1f MiB/s)\n",
+                traces, mib, seconds, seconds > 0 ? mib / seconds : 0.0 );
+    }
 
     if( !traces )
         fprintf( stderr, "segyio-crop: no traces copied\n" );
 
-    free( trace );
+    free( crop.runs );
     fclose( dst );
     fclose( src );
 }
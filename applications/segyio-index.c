@@ -0,0 +1,200 @@
+/* st_mtim is POSIX.1-2008, and hidden by -std=c99 unless asked for */
+#ifndef __APPLE__
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <getopt.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "apputils.h"
+#include <segyio/segy.h>
+
+static int printhelp(void){
+    puts( "Usage: segyio-index [OPTION]... FILE...\n"
+          "Write the geometry index FILE.segyidx for every FILE.\n"
+          "\n"
+          "segyio reads the sorting, line numbers and offsets from the index\n"
+          "instead of scanning the trace headers of FILE when opening it.\n"
+          "The index is ignored if FILE is modified after it is written.\n"
+          "\n"
+          "-b, --il=BYTE        inline header word byte offset (default 189)\n"
+          "-B, --xl=BYTE        crossline header word byte offset (default 193)\n"
+          "-o, --offset=BYTE    offset header word byte offset (default 37)\n"
+          "-v, --verbose        print the geometry of every FILE\n"
+          "     --version       output version information and exit\n"
+          "     --help          display this help and exit\n"
+          "\n"
+        );
+    return 0;
+}
+
+struct options {
+    int il, xl, offset;
+    int verbose;
+    int version;
+    int help;
+    const char* errmsg;
+};
+
+static struct options parse_options( int argc, char** argv ){
+    struct options opts;
+    opts.il = SEGY_TR_INLINE, opts.xl = SEGY_TR_CROSSLINE;
+    opts.offset = SEGY_TR_OFFSET;
+    opts.verbose = 0;
+    opts.version = 0, opts.help = 0;
+    opts.errmsg = NULL;
+
+    static struct option long_options[] = {
+        {"il",              required_argument,  0,    'b'},
+        {"xl",              required_argument,  0,    'B'},
+        {"offset",          required_argument,  0,    'o'},
+        {"verbose",         no_argument,        0,    'v'},
+        {"version",         no_argument,        0,    'V'},
+        {"help",            no_argument,        0,    'h'},
+        {0, 0, 0, 0}
+    };
+
+    static const char* parsenum_errmsg[] = { "", "num must be an integer",
+                                                 "num must be non-negative" };
+
+    opterr = 1;
+
+    while( true ){
+
+        int option_index = 0;
+        int c = getopt_long( argc, argv, "b:B:o:v",
+                            long_options, &option_index);
+
+        if ( c == -1 ) break;
+
+        int ret;
+        switch( c ){
+            case  0: break;
+            case 'h': opts.help = 1;    return opts;
+            case 'V': opts.version = 1; return opts;
+            case 'v': opts.verbose = 1; break;
+
+            case 'b':
+                ret = parseint( optarg, &opts.il );
+                if( ret == 0 ) break;
+                opts.errmsg = parsenum_errmsg[ ret ];
+                return opts;
+
+            case 'B':
+                ret = parseint( optarg, &opts.xl );
+                if( ret == 0 ) break;
+                opts.errmsg = parsenum_errmsg[ ret ];
+                return opts;
+
+            case 'o':
+                ret = parseint( optarg, &opts.offset );
+                if( ret == 0 ) break;
+                opts.errmsg = parsenum_errmsg[ ret ];
+                return opts;
+
+            default:
+                 opts.help = 1;
+                 opts.errmsg = "";
+                 return opts;
+        }
+    }
+    return opts;
+}
+
+/*
+ * The index is stamped with the modification time in nanoseconds, the same
+ * resolution python's os.stat().st_mtime_ns reports, so that both sides agree
+ * on which indices are stale.
+ */
+static long long mtime_ns( const struct stat* st ) {
+#ifdef __APPLE__
+    const struct timespec* ts = &st->st_mtimespec;
+#else
+    const struct timespec* ts = &st->st_mtim;
+#endif
+    return (long long)ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+static const char* index_errmsg( int err ) {
+    switch( err ) {
+        case SEGY_FOPEN_ERROR:
+            return "Unable to open index for writing";
+        case SEGY_INVALID_FIELD:
+        case SEGY_INVALID_FIELD_DATATYPE:
+            return "Invalid inline, crossline or offset header word";
+        case SEGY_INVALID_SORTING:
+        case SEGY_NOTFOUND:
+            return "Unable to infer geometry, file is not a sorted cube";
+        default:
+            return "Unable to write index";
+    }
+}
+
+int main( int argc, char** argv ){
+
+    struct options opts = parse_options( argc, argv );
+
+    if( opts.help )    return printhelp() + (opts.errmsg ? 2 : 0);
+    if( opts.version ) return printversion( "segyio-index" );
+    if( opts.errmsg )  return errmsg( EINVAL, opts.errmsg );
+
+    if( optind == argc ){
+         int err = errmsg(2, "Missing argument\n");
+         printhelp();
+         return err;
+    }
+
+    for( int i = optind; i < argc; ++i ){
+        const char* path = argv[ i ];
+
+        struct stat st;
+        if( stat( path, &st ) != 0 )
+            return errmsg2( errno, path, strerror( errno ) );
+
+        segy_file* fp = segy_open( path, "rb" );
+        if( !fp ) return errmsg2( errno, path, strerror( errno ) );
+
+        int err = segy_collect_metadata( fp, -1, -1, -1 );
+        if( err ) {
+            segy_close( fp );
+            return errmsg2( err, path, "Unable to read file metadata" );
+        }
+
+        char* index = malloc( strlen( path ) + sizeof( ".segyidx" ) );
+        if( !index ) {
+            segy_close( fp );
+            return errmsg( ENOMEM, "Unable to allocate memory" );
+        }
+        strcpy( index, path );
+        strcat( index, ".segyidx" );
+
+        err = segy_write_index( fp, index, mtime_ns( &st ),
+                                opts.il, opts.xl, opts.offset );
+
+        segy_index_header h;
+        if( !err && opts.verbose )
+            err = segy_read_index( fp, index, mtime_ns( &st ),
+                                   opts.il, opts.xl, opts.offset, &h );
+
+        segy_close( fp );
+        free( index );
+        if( err ) return errmsg2( err, path, index_errmsg( err ) );
+
+        if( opts.verbose ) {
+            const char* sorting = h.sorting == SEGY_INLINE_SORTING
+                                ? "inline" : "crossline";
+            printf( "%s: %d traces, %s sorted, "
+                    "%d inlines, %d crosslines, %d offsets\n",
+                    path, h.tracecount, sorting,
+                    h.iline_count, h.xline_count, h.offset_count );
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,238 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <getopt.h>
+#include <unistd.h>
+
+#include "apputils.h"
+#include <segyio/segy.h>
+
+static int printhelp(void){
+    puts( "Usage: segyio-sort [OPTION]... SRC DST\n"
+          "Write a copy of SRC to DST with the traces sorted by header words.\n"
+          "\n"
+          "The traces are sorted by the words given with --key and\n"
+          "--descending, with the first word the most significant, and\n"
+          "traces with equal words keep their order in SRC. Without any\n"
+          "keys, the traces are sorted by inline, crossline and offset,\n"
+          "which turns unsorted data into an inline sorted cube.\n"
+          "\n"
+          "DST is written front to back, with at most about --memory MiB of\n"
+          "buffers, so files much larger than memory can be sorted.\n"
+          "\n"
+          "-k, --key=BYTE         sort by the word at BYTE, ascending\n"
+          "-d, --descending=BYTE  sort by the word at BYTE, descending\n"
+          "-m, --memory=MIB       buffer size in MiB (default 1024)\n"
+          "-j, --threads=N        read with N threads (default 1)\n"
+          "-v, --verbose          print progress and throughput\n"
+          "     --version         output version information and exit\n"
+          "     --help            display this help and exit\n"
+          "\n"
+        );
+    return 0;
+}
+
+#define MAX_KEYS 16
+
+struct options {
+    int fields[ MAX_KEYS ];
+    int descending[ MAX_KEYS ];
+    int nkeys;
+    int memory;
+    int threads;
+    int verbose;
+    int version;
+    int help;
+    const char* src;
+    const char* dst;
+    const char* errmsg;
+};
+
+static struct options parse_options( int argc, char** argv ){
+    struct options opts;
+    opts.nkeys = 0;
+    opts.memory = 1024;
+    opts.threads = 1;
+    opts.verbose = 0;
+    opts.version = 0, opts.help = 0;
+    opts.src = NULL, opts.dst = NULL;
+    opts.errmsg = NULL;
+
+    static struct option long_options[] = {
+        {"key",             required_argument,  0,    'k'},
+        {"descending",      required_argument,  0,    'd'},
+        {"memory",          required_argument,  0,    'm'},
+        {"threads",         required_argument,  0,    'j'},
+        {"verbose",         no_argument,        0,    'v'},
+        {"version",         no_argument,        0,    'V'},
+        {"help",            no_argument,        0,    'h'},
+        {0, 0, 0, 0}
+    };
+
+    static const char* parsenum_errmsg[] = { "", "num must be an integer",
+                                                 "num must be non-negative" };
+
+    opterr = 1;
+
+    while( true ){
+
+        int option_index = 0;
+        int c = getopt_long( argc, argv, "k:d:m:j:v",
+                            long_options, &option_index);
+
+        if ( c == -1 ) break;
+
+        int ret;
+        switch( c ){
+            case  0: break;
+            case 'h': opts.help = 1;    return opts;
+            case 'V': opts.version = 1; return opts;
+            case 'v': opts.verbose = 1; break;
+
+            case 'k':
+            case 'd':
+                if( opts.nkeys == MAX_KEYS ) {
+                    opts.errmsg = "too many keys";
+                    return opts;
+                }
+
+                ret = parseint( optarg, opts.fields + opts.nkeys );
+                if( ret != 0 ) {
+                    opts.errmsg = parsenum_errmsg[ ret ];
+                    return opts;
+                }
+                opts.descending[ opts.nkeys ] = c == 'd';
+                ++opts.nkeys;
+                break;
+
+            case 'm':
+                ret = parseint( optarg, &opts.memory );
+                if( ret == 0 ) break;
+                opts.errmsg = parsenum_errmsg[ ret ];
+                return opts;
+
+            case 'j':
+                ret = parseint( optarg, &opts.threads );
+                if( ret == 0 ) break;
+                opts.errmsg = parsenum_errmsg[ ret ];
+                return opts;
+
+            default:
+                 opts.help = 1;
+                 opts.errmsg = "";
+                 return opts;
+        }
+    }
+
+    if( argc - optind != 2 ) {
+        opts.errmsg = "Wrong number of files, expected SRC and DST";
+        return opts;
+    }
+
+    if( opts.memory < 1 ) {
+        opts.errmsg = "memory must be at least 1 MiB";
+        return opts;
+    }
+
+    if( opts.threads < 1 ) {
+        opts.errmsg = "threads must be at least 1";
+        return opts;
+    }
+
+    if( opts.nkeys == 0 ) {
+        opts.fields[ 0 ] = SEGY_TR_INLINE;
+        opts.fields[ 1 ] = SEGY_TR_CROSSLINE;
+        opts.fields[ 2 ] = SEGY_TR_OFFSET;
+        opts.descending[ 0 ] = 0;
+        opts.descending[ 1 ] = 0;
+        opts.descending[ 2 ] = 0;
+        opts.nkeys = 3;
+    }
+
+    opts.src = argv[ optind ];
+    opts.dst = argv[ optind + 1 ];
+    return opts;
+}
+
+int main( int argc, char** argv ){
+
+    struct options opts = parse_options( argc, argv );
+
+    if( opts.help )    return printhelp() + (opts.errmsg ? 2 : 0);
+    if( opts.version ) return printversion( "segyio-sort" );
+    if( opts.errmsg )  return errmsg( EINVAL, opts.errmsg );
+
+    segy_file* src = segy_open( opts.src, "rb" );
+    if( !src ) return errmsg2( errno, opts.src, strerror( errno ) );
+
+    int err = segy_collect_metadata( src, -1, -1, -1 );
+    if( err ) {
+        segy_close( src );
+        return errmsg2( err, opts.src, "Unable to read file metadata" );
+    }
+
+    const long long traces = src->metadata.tracecount;
+    long long* perm = malloc( ( traces ? traces : 1 ) * sizeof( long long ) );
+    if( !perm ) {
+        segy_close( src );
+        return errmsg( ENOMEM, "Unable to allocate memory" );
+    }
+
+    err = segy_sort_traces( src, 0, segy_traceheader_default_map(),
+                            opts.fields, opts.descending, opts.nkeys,
+                            perm );
+    if( err ) {
+        free( perm );
+        segy_close( src );
+        return errmsg2( err, opts.src, "Unable to sort, invalid key?" );
+    }
+
+    if( opts.verbose ) {
+        long long moved = 0;
+        for( long long i = 0; i < traces; ++i )
+            moved += perm[ i ] != i;
+
+        printf( "%s: %lld traces, %lld out of place\n",
+                opts.src, traces, moved );
+    }
+
+    segy_file* dst = segy_open( opts.dst, "wb" );
+    if( !dst ) {
+        const int errcode = errno;
+        free( perm );
+        segy_close( src );
+        return errmsg2( errcode, opts.dst, strerror( errcode ) );
+    }
+
+    struct timespec begin, end;
+    clock_gettime( CLOCK_MONOTONIC, &begin );
+
+    const size_t memory = (size_t)opts.memory * 1024 * 1024;
+    err = segy_permute_traces( src, dst, perm, traces, memory, opts.threads );
+
+    const int closeerr = segy_close( dst );
+    clock_gettime( CLOCK_MONOTONIC, &end );
+
+    if( opts.verbose && !err && !closeerr ) {
+        const long long trace0 = src->metadata.trace0;
+        const long long record = SEGY_TRACE_HEADER_SIZE
+                               * src->metadata.traceheader_count
+                               + src->metadata.trace_bsize;
+        const double seconds = ( end.tv_sec - begin.tv_sec )
+                             + ( end.tv_nsec - begin.tv_nsec ) * 1e-9;
+        const double mib = ( trace0 + traces * record ) / ( 1024.0 * 1024.0 );
+        printf( "Wrote %lld traces, %.1f MiB in %.2fs (%.1f MiB/s)\n",
+                traces, mib, seconds, seconds > 0 ? mib / seconds : 0.0 );
+    }
+
+    free( perm );
+    segy_close( src );
+
+    if( err )      return errmsg2( err, opts.src, "Unable to sort" );
+    if( closeerr ) return errmsg2( closeerr, opts.dst, "Unable to write" );
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <getopt.h>
+#include <unistd.h>
+
+#include "apputils.h"
+#include <segyio/segy.h>
+
+static int printhelp(void){
+    puts( "Usage: segyio-transpose [OPTION]... SRC DST\n"
+          "Write a copy of the cube SRC to DST in another trace order.\n"
+          "\n"
+          "By default DST is a SEG-Y file with the lines in the other\n"
+          "sorting, i.e. an inline sorted SRC becomes crossline sorted and\n"
+          "the other way around. With --depth-major, DST is a raw volume of\n"
+          "the samples of all traces, one depth (or time) slice after the\n"
+          "other, as native floats or integers in the byte order of this\n"
+          "machine.\n"
+          "\n"
+          "SRC is read in a few passes of large reads, with at most about\n"
+          "--memory MiB of buffers, so cubes much larger than memory can be\n"
+          "reordered.\n"
+          "\n"
+          "-d, --depth-major    write a raw, sample-major volume\n"
+          "-m, --memory=MIB     buffer size in MiB (default 1024)\n"
+          "-j, --threads=N      decode with N threads (default 1), only\n"
+          "                     used with --depth-major\n"
+          "-b, --il=BYTE        inline header word byte offset (default 189)\n"
+          "-B, --xl=BYTE        crossline header word byte offset (default 193)\n"
+          "-v, --verbose        print the geometry of SRC\n"
+          "     --version       output version information and exit\n"
+          "     --help          display this help and exit\n"
+          "\n"
+        );
+    return 0;
+}
+
+struct options {
+    int il, xl;
+    int memory;
+    int threads;
+    int depth_major;
+    int verbose;
+    int version;
+    int help;
+    const char* src;
+    const char* dst;
+    const char* errmsg;
+};
+
+static struct options parse_options( int argc, char** argv ){
+    struct options opts;
+    opts.il = SEGY_TR_INLINE, opts.xl = SEGY_TR_CROSSLINE;
+    opts.memory = 1024;
+    opts.threads = 1;
+    opts.depth_major = 0;
+    opts.verbose = 0;
+    opts.version = 0, opts.help = 0;
+    opts.src = NULL, opts.dst = NULL;
+    opts.errmsg = NULL;
+
+    static struct option long_options[] = {
+        {"depth-major",     no_argument,        0,    'd'},
+        {"memory",          required_argument,  0,    'm'},
+        {"threads",         required_argument,  0,    'j'},
+        {"il",              required_argument,  0,    'b'},
+        {"xl",              required_argument,  0,    'B'},
+        {"verbose",         no_argument,        0,    'v'},
+        {"version",         no_argument,        0,    'V'},
+        {"help",            no_argument,        0,    'h'},
+        {0, 0, 0, 0}
+    };
+
+    static const char* parsenum_errmsg[] = { "", "num must be an integer",
+                                                 "num must be non-negative" };
+
+    opterr = 1;
+
+    while( true ){
+
+        int option_index = 0;
+        int c = getopt_long( argc, argv, "dm:j:b:B:v",
+                            long_options, &option_index);
+
+        if ( c == -1 ) break;
+
+        int ret;
+        switch( c ){
+            case  0: break;
+            case 'h': opts.help = 1;    return opts;
+            case 'V': opts.version = 1; return opts;
+            case 'd': opts.depth_major = 1; break;
+            case 'v': opts.verbose = 1; break;
+
+            case 'm':
+                ret = parseint( optarg, &opts.memory );
+                if( ret == 0 ) break;
+                opts.errmsg = parsenum_errmsg[ ret ];
+                return opts;
+
+            case 'j':
+                ret = parseint( optarg, &opts.threads );
+                if( ret == 0 ) break;
+                opts.errmsg = parsenum_errmsg[ ret ];
+                return opts;
+
+            case 'b':
+                ret = parseint( optarg, &opts.il );
+                if( ret == 0 ) break;
+                opts.errmsg = parsenum_errmsg[ ret ];
+                return opts;
+
+            case 'B':
+                ret = parseint( optarg, &opts.xl );
+                if( ret == 0 ) break;
+                opts.errmsg = parsenum_errmsg[ ret ];
+                return opts;
+
+            default:
+                 opts.help = 1;
+                 opts.errmsg = "";
+                 return opts;
+        }
+    }
+
+    if( argc - optind != 2 ) {
+        opts.errmsg = "Wrong number of files, expected SRC and DST";
+        return opts;
+    }
+
+    if( opts.memory < 1 ) {
+        opts.errmsg = "memory must be at least 1 MiB";
+        return opts;
+    }
+
+    if( opts.threads < 1 ) {
+        opts.errmsg = "threads must be at least 1";
+        return opts;
+    }
+
+    opts.src = argv[ optind ];
+    opts.dst = argv[ optind + 1 ];
+    return opts;
+}
+
+int main( int argc, char** argv ){
+
+    struct options opts = parse_options( argc, argv );
+
+    if( opts.help )    return printhelp() + (opts.errmsg ? 2 : 0);
+    if( opts.version ) return printversion( "segyio-transpose" );
+    if( opts.errmsg )  return errmsg( EINVAL, opts.errmsg );
+
+    segy_file* src = segy_open( opts.src, "rb" );
+    if( !src ) return errmsg2( errno, opts.src, strerror( errno ) );
+
+    int err = segy_collect_metadata( src, -1, -1, -1 );
+    if( err ) {
+        segy_close( src );
+        return errmsg2( err, opts.src, "Unable to read file metadata" );
+    }
+
+    /*
+     * The traces are moved to where the geometry says they belong, so check
+     * every trace header against it before anything is written. The
+     * depth-major volume is in trace order, and only needs the geometry for
+     * the verbose output.
+     */
+    segy_geometry geometry;
+    if( !opts.depth_major || opts.verbose ) {
+        const int strict = !opts.depth_major;
+        err = segy_infer_geometry( src, opts.il, opts.xl, SEGY_TR_OFFSET,
+                                   strict, &geometry );
+        if( err ) {
+            segy_close( src );
+            return errmsg2( err, opts.src,
+                            "Unable to infer geometry, "
+                            "file is not a sorted cube" );
+        }
+    }
+
+    if( opts.verbose ) {
+        const char* sorting = geometry.sorting == SEGY_INLINE_SORTING
+                            ? "inline" : "crossline";
+        printf( "%s: %lld traces, %s sorted, "
+                "%d inlines, %d crosslines, %d offsets\n",
+                opts.src, src->metadata.tracecount, sorting,
+                geometry.iline_count, geometry.xline_count,
+                geometry.offset_count );
+    }
+
+    segy_file* dst = segy_open( opts.dst, "wb" );
+    if( !dst ) {
+        const int errcode = errno;
+        segy_close( src );
+        return errmsg2( errcode, opts.dst, strerror( errcode ) );
+    }
+
+    /* SRC is read front to back, once per pass */
+    segy_set_access_pattern( src, SEGY_ACCESS_SEQUENTIAL );
+
+    const size_t memory = (size_t)opts.memory * 1024 * 1024;
+    if( opts.depth_major )
+        err = segy_write_depth_major( src, dst, memory, opts.threads );
+    else
+        err = segy_transpose( src, dst, &geometry, memory );
+
+    segy_close( src );
+    const int closeerr = segy_close( dst );
+
+    if( err )      return errmsg2( err, opts.src, "Unable to transpose" );
+    if( closeerr ) return errmsg2( closeerr, opts.dst, "Unable to write" );
+    return 0;
+}
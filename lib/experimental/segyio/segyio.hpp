@@ -8,6 +8,7 @@
 #include <exception>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
@@ -592,7 +593,7 @@ struct truncate_always : public truncable< Derived > {
  * fmt format()      - data format
  * unsigned long long trace0()     - offset of first trace past extended text headers
  * int tracesize()   - size of each trace in bytes
- * int tracecount()  - number of traces in this file
+ * long long tracecount() - number of traces in this file
  */
 
 template< typename Derived >
@@ -602,7 +603,7 @@ struct trace_meta_fromfile {
 
     unsigned long long trace0()     const noexcept(true);
     int  tracesize()  const noexcept(true);
-    int  tracecount() const noexcept(true);
+    long long tracecount() const noexcept(true);
 
     void operator()( segy_file* fp ) noexcept(false);
 
@@ -610,7 +611,7 @@ private:
     unsigned long long tr0 = 0;
     int trsize = 0;
     int smp = 0;
-    int traces = 0;
+    long long traces = 0;
     segyio::fmt fmt;
 };
 
@@ -654,13 +655,13 @@ struct binary_header_reader{
 
 template< typename Derived >
 struct trace_bounds_check {
-    void operator()( int i ) const noexcept(false);
+    void operator()( long long i ) const noexcept(false);
 };
 
 template< typename Derived >
 struct trace_reader {
     template< typename OutputIt >
-    OutputIt get( int i, OutputIt out ) noexcept(false);
+    OutputIt get( long long i, OutputIt out ) noexcept(false);
     void operator()( const segy_file* ) noexcept(false);
 };
 
@@ -759,13 +760,13 @@ struct trace_header {
 
 template< typename Derived >
 struct trace_header_reader {
-    trace_header get_th( int i ) noexcept(false);
+    trace_header get_th( long long i ) noexcept(false);
 };
 
 template< typename Derived >
 struct trace_writer {
     template< typename InputIt >
-    InputIt put( int i, InputIt in );
+    InputIt put( long long i, InputIt in );
 };
 
 template< typename Derived >
@@ -1147,7 +1148,7 @@ int  trace_meta_fromfile< T >::tracesize() const noexcept(true) {
 }
 
 template< typename T >
-int  trace_meta_fromfile< T >::tracecount() const noexcept(true) {
+long long trace_meta_fromfile< T >::tracecount() const noexcept(true) {
     return this->traces;
 }
 
@@ -1179,7 +1180,7 @@ void trace_meta_fromfile< T >::operator()( segy_file* fp ) noexcept(false) {
 }
 
 template< typename Derived >
-void trace_bounds_check< Derived >::operator()( int i ) const noexcept(false)
+void trace_bounds_check< Derived >::operator()( long long i ) const noexcept(false)
 {
     auto* self = static_cast< const Derived* >( this );
     if ( i >= 0 && i < self->tracecount() ) return;
@@ -1198,12 +1199,12 @@ void trace_bounds_check< Derived >::operator()( int i ) const noexcept(false)
 
 template< typename Derived >
 template< typename OutputIt >
-OutputIt trace_reader< Derived >::get( int i, OutputIt out ) noexcept(false) {
+OutputIt trace_reader< Derived >::get( long long i, OutputIt out ) noexcept(false) {
     auto* self = static_cast< Derived* >( this );
     auto* fp = self->escape();
 
     self->consider( i );
-    auto err = segy_readtrace( fp, i, self->buffer() );
+    auto err = segy_readtrace64( fp, i, self->buffer() );
 
     switch( err ) {
         case SEGY_OK:
@@ -1325,12 +1326,14 @@ binary_header binary_header_reader< Derived >::get_bin() noexcept(false) {
 }
 
 template< typename Derived >
-trace_header trace_header_reader< Derived >::get_th( int i ) noexcept(false) {
+trace_header trace_header_reader< Derived >::get_th( long long i ) noexcept(false) {
     char buffer[ SEGY_TRACE_HEADER_SIZE ] = {};
     auto* self = static_cast< Derived* >( this );
+    auto* fp = self->escape();
 
     self->consider( i );
-    auto err = segy_read_standard_traceheader( self->escape(), i, buffer );
+    const auto* map = fp->traceheader_mapping_standard.offset_to_entry_definition;
+    auto err = segy_read_traceheader64( fp, i, 0, map, buffer );
 
     switch( err ) {
         case SEGY_OK: break;
@@ -1476,6 +1479,10 @@ void volume_meta_fromfile< Derived >::operator()( segy_file* fp,
     const auto il = int(cfg.iline);
     const auto xl = int(cfg.xline);
 
+    /* the line geometry functions count traces with int */
+    if( self->tracecount() > std::numeric_limits< int >::max() )
+        throw std::invalid_argument( "too many traces for a volume" );
+
     int sort = SEGY_UNKNOWN_SORTING;
 
     int err;
@@ -1511,7 +1518,7 @@ void volume_meta_fromfile< Derived >::operator()( segy_file* fp,
     err = segy_offsets( fp,
                         il,
                         xl,
-                        self->tracecount(),
+                        int(self->tracecount()),
                         &ofs );
 
     switch( err ) {
@@ -1564,7 +1571,7 @@ void volume_meta_fromfile< Derived >::operator()( segy_file* fp,
 
 template< typename Derived >
 template< typename InputIt >
-InputIt trace_writer< Derived >::put( int i, InputIt in ) noexcept(false) {
+InputIt trace_writer< Derived >::put( long long i, InputIt in ) noexcept(false) {
     auto* self = static_cast< Derived* >( this );
     auto* fp = self->escape();
 
@@ -1606,9 +1613,9 @@ InputIt trace_writer< Derived >::put( int i, InputIt in ) noexcept(false) {
     }
 
     segy_from_native( format, len, self->buffer() );
-    auto err = segy_writetrace( fp,
-                                i,
-                                self->buffer() );
+    auto err = segy_writetrace64( fp,
+                                  i,
+                                  self->buffer() );
 
     switch( err ) {
         case SEGY_OK:
@@ -274,6 +274,8 @@ typedef enum {
     SEGY_MEMORY_ERROR,
     SEGY_DS_FLUSH_ERROR,
     SEGY_DS_CLOSE_ERROR,
+    SEGY_INVALID_INDEX,
+    SEGY_TOO_MANY_TRACES,
     // values are duplicated until enum is properly cleaned
     SEGY_DS_READ_ERROR = SEGY_FREAD_ERROR,
     SEGY_DS_WRITE_ERROR = SEGY_FWRITE_ERROR,
@@ -329,7 +331,7 @@ typedef struct {
     int traceheader_count;
 
     /* Number of traces in the file. */
-    int tracecount;
+    long long tracecount;
 } segy_metadata;
 
 
@@ -409,6 +411,30 @@ struct segy_datasource {
     segy_header_mapping traceheader_mapping_extension1;
 
     segy_metadata metadata;
+
+    /* Optional positional I/O. Reads/writes `size` bytes at absolute `offset`
+     * without using or changing the stream position, so that several threads
+     * can access the same datasource concurrently. May be NULL, in which case
+     * segyio falls back to seek + read/write.
+     *
+     * New fields are only ever added after this point, so that the layout of
+     * the fields above stays the same. Datasources built outside of segyio
+     * must be zero-initialized, e.g. with segy_init_datasource, so that the
+     * optional fields are NULL.
+     */
+    int ( *read_at )( struct segy_datasource* self,
+                      long long offset,
+                      void* buffer,
+                      size_t size );
+    int ( *write_at )( struct segy_datasource* self,
+                       long long offset,
+                       const void* buffer,
+                       size_t size );
+
+    /* Read queue for traces that are far apart on disk, opened by segyio on
+     * first use and closed by segy_close. Leave it NULL.
+     */
+    struct segy_queue* queue;
 };
 
 typedef struct segy_datasource segy_datasource;
@@ -452,11 +478,84 @@ typedef struct {
  * Some functions return values, notably the family concerned with the binary
  * header such as segy_trsize, that should be used in consecutive segy function
  * calls that use the same name for one of its parameters.
+ *
+ * Functions with the 64 suffix take trace numbers and trace counts as long
+ * long, for files with more than INT_MAX traces. The functions without the
+ * suffix are wrappers over them, kept for compatibility.
  */
 
 segy_file* segy_open( const char* path, const char* mode );
 int segy_mmap( segy_datasource* );
 segy_datasource* segy_memopen( unsigned char* addr, size_t size );
+/*
+ * Create a datasource from an open file descriptor, using pread/pwrite for all
+ * I/O. Trace and header reads do not share a file position, so the handle can
+ * be read from by several threads at once. The datasource takes ownership of
+ * fd, which is closed by segy_close. Returns NULL if the fd can not be used or
+ * positional I/O is not available on this platform, in which case fd is left
+ * open.
+ */
+segy_datasource* segy_open_fd( int fd );
+
+/*
+ * Zero-initialize a datasource, so that all callbacks, including the optional
+ * ones, are NULL. Use this before setting the callbacks of a datasource built
+ * outside of segyio.
+ */
+void segy_init_datasource( segy_datasource* ds );
+
+/*
+ * Wrap a datasource in a block cache. The file is read in aligned blocks of
+ * block_size bytes, which are kept in an LRU cache of capacity bytes, and
+ * sequential misses read increasingly many blocks ahead. Small reads, like
+ * header words and single traces, are then served from memory, and the inner
+ * datasource only sees a few large requests. This is useful for datasources
+ * where every request is expensive, like python streams or network storage.
+ *
+ * Writes go through to the inner datasource right away. The inner datasource
+ * must not be used directly while the cache is open, and it is closed and
+ * freed, like with segy_close, when the cached datasource is closed. The
+ * metadata of the inner datasource is copied, so it can be wrapped both
+ * before and after segy_collect_metadata.
+ *
+ * block_size and capacity of 0 picks the defaults, 64k blocks and a 16M
+ * cache. Returns NULL on failure, in which case inner is left untouched.
+ *
+ * segy_cached_inner returns the datasource wrapped by a cached datasource, or
+ * NULL if ds is not a cached datasource.
+ */
+segy_datasource* segy_cached_datasource( segy_datasource* inner,
+                                         size_t block_size,
+                                         size_t capacity );
+segy_datasource* segy_cached_inner( segy_datasource* ds );
+
+typedef enum {
+    SEGY_ACCESS_NORMAL = 0,
+    SEGY_ACCESS_SEQUENTIAL,
+    SEGY_ACCESS_RANDOM,
+    SEGY_ACCESS_STRIDED,
+    SEGY_ACCESS_WILLNEED,
+} SEGY_ACCESS_PATTERN;
+
+/*
+ * Tell the operating system how the file will be read, with posix_fadvise for
+ * files and posix_madvise for memory mapped files. SEGY_ACCESS_SEQUENTIAL is
+ * for streaming through the file, e.g. reading all inlines, and makes the
+ * kernel read ahead aggressively. SEGY_ACCESS_RANDOM and SEGY_ACCESS_STRIDED,
+ * e.g. reading crosslines or depth slices, turn readahead off, since the
+ * traces read are further apart than the readahead window. SEGY_ACCESS_WILLNEED
+ * starts reading the whole file into the page cache.
+ *
+ * segy_prefetch_traces starts reading the `count` traces from `first` into the
+ * page cache, and returns without waiting for them.
+ *
+ * The hints are only that; they are ignored for in-memory datasources and on
+ * platforms without fadvise/madvise, and failing to apply a hint is not an
+ * error. SEGY_INVALID_ARGS is returned for unknown patterns and negative
+ * trace ranges.
+ */
+int segy_set_access_pattern( segy_datasource*, int pattern );
+int segy_prefetch_traces( segy_datasource*, long long first, long long count );
 
 int segy_flush( segy_datasource* );
 int segy_close( segy_datasource* );
@@ -608,6 +707,115 @@ int segy_field_forall( segy_datasource*,
                        int step,
                        void* buf );
 
+int segy_field_forall64( segy_datasource*,
+                         int traceheader_index,
+                         const segy_entry_definition* offset_map,
+                         int field,
+                         long long start,
+                         long long stop,
+                         long long step,
+                         void* buf );
+
+/*
+ * The inverse of segy_field_forall. The header word `field` of the traces in
+ * [start, stop) by step is set to the values in buf, which holds one value
+ * per trace in the same format as segy_field_forall writes them.
+ * segy_write_field_broadcast sets the header word of all the traces to the
+ * single value in buf.
+ *
+ * Only the bytes of the header word are changed. When the traces are small,
+ * the headers of many traces are read and written back with a single
+ * request, rather than a small write per trace.
+ */
+int segy_write_field_forall( segy_datasource*,
+                             int traceheader_index,
+                             const segy_entry_definition* offset_map,
+                             int field,
+                             long long start,
+                             long long stop,
+                             long long step,
+                             const void* buf );
+
+int segy_write_field_broadcast( segy_datasource*,
+                                int traceheader_index,
+                                const segy_entry_definition* offset_map,
+                                int field,
+                                long long start,
+                                long long stop,
+                                long long step,
+                                const void* buf );
+
+/*
+ * A column for segy_read_all_traceheaders. The header word `field` of the
+ * `traceheader_index`th trace header (0 is the standard header), as described
+ * by `offset_map`, of every trace is written to `buf`, which must fit
+ * tracecount elements of the field's type, like segy_field_forall.
+ */
+typedef struct {
+    int traceheader_index;
+    const segy_entry_definition* offset_map;
+    int field;
+    void* buf;
+} segy_header_column;
+
+/*
+ * Read many header words of all traces in a single, sequential pass over the
+ * file, rather than one pass per header word with segy_field_forall. The
+ * headers of many traces are read with a single request when the traces are
+ * small.
+ */
+int segy_read_all_traceheaders( segy_datasource*,
+                                segy_header_column* columns,
+                                int ncolumns );
+
+/*
+ * Group the traces by their key, for example the header words read with
+ * segy_read_all_traceheaders. `keys` is a traces-by-nkeys array, so that the
+ * key of trace i is keys[i * nkeys] .. keys[i * nkeys + nkeys - 1]. Traces
+ * are in the same group when all the words in their keys are equal.
+ *
+ * The groups are numbered in the order of their first trace, and written in
+ * compressed sparse row form: the traces of group g are
+ * index[offsets[g]] .. index[offsets[g + 1] - 1], in increasing order.
+ * `index` must fit `traces` elements, and `offsets` traces + 1, since every
+ * trace can be its own group. The number of groups is written to `groups`.
+ */
+int segy_group_traces( const long long* keys,
+                       int nkeys,
+                       long long traces,
+                       long long* offsets,
+                       long long* index,
+                       long long* groups );
+
+/*
+ * Compute the permutation that stably sorts the traces by their keys, laid
+ * out like for segy_group_traces, with the first word the most significant.
+ * The traces are in ascending order of the word, or descending when
+ * descending[k] is non-zero. descending can be NULL, which sorts all words in
+ * ascending order. perm[i] is the trace that goes in position i, and must
+ * fit `traces` elements.
+ *
+ * The sort is a radix sort, which does a few linear passes over the keys
+ * regardless of their order.
+ *
+ * segy_sort_traces reads the header words `fields` of all traces in a single
+ * pass, like segy_read_all_traceheaders, and computes the permutation that
+ * sorts them. perm must fit tracecount elements.
+ */
+int segy_sort_permutation( const long long* keys,
+                           int nkeys,
+                           const int* descending,
+                           long long traces,
+                           long long* perm );
+
+int segy_sort_traces( segy_datasource*,
+                      int traceheader_index,
+                      const segy_entry_definition* offset_map,
+                      const int* fields,
+                      const int* descending,
+                      int nkeys,
+                      long long* perm );
+
 /*
  * exception: segy_trace_bsize computes the size of the traces in bytes. Cannot
  * fail. Equivalent to segy_trsize(SEGY_IBM_FLOAT_4_BYTE, samples);
@@ -635,9 +843,11 @@ int segy_trace0(
 
 /*
  * number of traces in this file.
- * if this function fails, the input argument is not modified.
+ * if this function fails, the input argument is not modified. segy_traces
+ * fails with SEGY_TOO_MANY_TRACES if the count does not fit in an int.
  */
 int segy_traces( segy_datasource*, int* );
+int segy_traces64( segy_datasource*, long long* );
 
 int segy_sample_indices( segy_datasource*,
                          float t0,
@@ -687,6 +897,12 @@ int segy_read_traceheader( segy_datasource*,
                            const segy_entry_definition* mapping,
                            char* buf );
 
+int segy_read_traceheader64( segy_datasource*,
+                             long long traceno,
+                             int traceheader_no,
+                             const segy_entry_definition* mapping,
+                             char* buf );
+
 /* Write the 'traceheaderno' trace header at `traceno` from `buf` into file. */
 int segy_write_traceheader( segy_datasource*,
                             int traceno,
@@ -694,6 +910,12 @@ int segy_write_traceheader( segy_datasource*,
                             const segy_entry_definition* mapping,
                             const char* buf );
 
+int segy_write_traceheader64( segy_datasource*,
+                              long long traceno,
+                              int traceheader_no,
+                              const segy_entry_definition* mapping,
+                              const char* buf );
+
 /* Read the standard trace header at `traceno` into `buf`. */
 int segy_read_standard_traceheader( segy_datasource*,
                                     int traceno,
@@ -742,10 +964,32 @@ int segy_readtrace( segy_datasource*,
                     int traceno,
                     void* buf );
 
+int segy_readtrace64( segy_datasource*,
+                      long long traceno,
+                      void* buf );
+
 int segy_writetrace( segy_datasource*,
                      int traceno,
                      const void* buf );
 
+int segy_writetrace64( segy_datasource*,
+                       long long traceno,
+                       const void* buf );
+
+/*
+ * Get a pointer to the first sample of trace `traceno` of a memory mapped or
+ * in-memory datasource, so that traces can be used without copying. The
+ * samples are exactly as stored, i.e. unlike segy_readtrace they are not
+ * byte swapped for little-endian files. Consecutive
+ * traces are trace_bsize + SEGY_TRACE_HEADER_SIZE * traceheader_count bytes
+ * apart. The pointer is valid until the datasource is closed.
+ *
+ * Returns SEGY_MMAP_INVALID if the datasource is not in memory.
+ */
+int segy_trace_ptr( segy_datasource*,
+                    int traceno,
+                    void** out );
+
 /*
  * read/write sub traces, with the same assumption and requirements as
  * segy_readtrace. start and stop are *indices*, not byte offsets, so
@@ -777,6 +1021,14 @@ int segy_readsubtr( segy_datasource*,
                     void* buf,
                     void* rangebuf );
 
+int segy_readsubtr64( segy_datasource*,
+                      long long traceno,
+                      int start,
+                      int stop,
+                      int step,
+                      void* buf,
+                      void* rangebuf );
+
 int segy_writesubtr( segy_datasource*,
                      int traceno,
                      int start,
@@ -785,6 +1037,14 @@ int segy_writesubtr( segy_datasource*,
                      const void* buf,
                      void* rangebuf );
 
+int segy_writesubtr64( segy_datasource*,
+                       long long traceno,
+                       int start,
+                       int stop,
+                       int step,
+                       const void* buf,
+                       void* rangebuf );
+
 /*
  * convert to/from native float from segy formats (likely IBM or IEEE).  Size
  * parameter is long long because it needs to know the number of *samples*,
@@ -804,6 +1064,36 @@ int segy_from_native( int format,
                       long long size,
                       void* buf );
 
+typedef enum {
+    SEGY_SIMD_SCALAR = 0,
+    SEGY_SIMD_SSE2,
+    SEGY_SIMD_AVX2,
+    SEGY_SIMD_AVX512,
+    SEGY_SIMD_NEON,
+} SEGY_SIMD;
+
+/*
+ * The IBM float conversion in segy_to_native and segy_from_native uses
+ * vectorized kernels, selected at runtime from what the host CPU supports. The
+ * results are bit-exact regardless of the instruction set.
+ *
+ * segy_simd_supported returns non-zero if the instruction set (SEGY_SIMD) is
+ * both compiled in and supported by the CPU. segy_simd returns the instruction
+ * set currently in use. segy_set_simd overrides the selection, which is useful
+ * for testing and benchmarking, and fails with SEGY_INVALID_ARGS if the
+ * instruction set is not supported. The selection is global and not
+ * thread-safe, and should be set before any conversion takes place.
+ */
+int segy_simd_supported( int isa );
+int segy_simd( void );
+int segy_set_simd( int isa );
+
+/*
+ * Read line_length traces, stride * offsets traces apart, like segy_readtrace.
+ * The traces are read like segy_read_traces, so adjacent traces are read in
+ * large requests, and the traces of e.g. a long crossline are in flight at the
+ * same time.
+ */
 int segy_read_line( segy_datasource* ds,
                     int line_trace0,
                     int line_length,
@@ -818,6 +1108,251 @@ int segy_write_line( segy_datasource* ds,
                     int offsets,
                     const void* buf );
 
+typedef enum {
+    /* reserve the disk space of all the traces when the writer is opened */
+    SEGY_WRITER_PREALLOCATE = 1 << 0,
+    /* write full buffers in a background thread, while the next fills up */
+    SEGY_WRITER_BACKGROUND  = 1 << 1,
+} SEGY_WRITER_FLAGS;
+
+/*
+ * Buffered, sequential trace writer. Traces are appended in order, starting
+ * at trace `first`, and assembled in a write buffer of about `bufsize` bytes
+ * (0 for the default), which is written to the datasource in one write when
+ * it is full. This is much faster than a segy_write_traceheader and
+ * segy_writetrace per trace when creating files.
+ *
+ * segy_writer_put appends a trace. `headers` is the traceheader_count trace
+ * headers of the trace, as used by segy_write_traceheader, and `samples` is
+ * the trace in native format, as used by segy_writetrace after
+ * segy_from_native. Neither buffer is modified. `mappings` are the header
+ * mappings of the traceheader_count trace headers. If it is NULL, the
+ * standard and extension 1 mappings of the datasource are used, which is only
+ * possible for files with at most two trace headers.
+ *
+ * With SEGY_WRITER_PREALLOCATE, the disk space for `count` traces is
+ * allocated up front on file datasources, where the system supports it. With
+ * SEGY_WRITER_BACKGROUND, full buffers are written by another thread while
+ * the next buffer is filled.
+ *
+ * segy_writer_flush writes out the buffered traces, and segy_writer_close
+ * flushes and frees the writer. Both return the first error of any write
+ * since the writer was opened. The datasource must outlive the writer, and
+ * must not be used for anything else while the writer is open.
+ */
+typedef struct segy_writer segy_writer;
+
+segy_writer* segy_writer_open( segy_datasource*,
+                               long long first,
+                               long long count,
+                               size_t bufsize,
+                               int flags,
+                               const segy_entry_definition* const* mappings );
+int segy_writer_put( segy_writer*, const char* headers, const void* samples );
+int segy_writer_flush( segy_writer* );
+int segy_writer_close( segy_writer* );
+
+/*
+ * Read-and-convert variants of segy_readsubtr and segy_read_line. Every trace
+ * is converted to native representation right after it is read, while it is
+ * still in cache, and the samples are only byteswapped once (if at all), so
+ * no separate segy_to_native pass is needed.
+ *
+ * outformat is either the format of the file (ds->metadata.format), in which
+ * case the output is the same as segy_readsubtr followed by segy_to_native,
+ * or SEGY_IEEE_FLOAT_4_BYTE or SEGY_IEEE_FLOAT_8_BYTE to get float or double
+ * samples regardless of the on-disk format. The buffer must fit the output
+ * samples, i.e. be large enough for outformat, not the on-disk format.
+ *
+ * Converting from 8-byte formats to float allocates a temporary buffer for
+ * every trace. Returns SEGY_INVALID_ARGS if the conversion is not supported.
+ */
+int segy_readsubtr_native( segy_datasource*,
+                           int traceno,
+                           int start,
+                           int stop,
+                           int step,
+                           int outformat,
+                           void* buf,
+                           void* rangebuf );
+
+int segy_readsubtr_native64( segy_datasource*,
+                             long long traceno,
+                             int start,
+                             int stop,
+                             int step,
+                             int outformat,
+                             void* buf,
+                             void* rangebuf );
+
+/*
+ * Read the subtraces [sample_start:sample_stop:sample_step] of the n traces
+ * in tracenos, back-to-back into out, converted to native like
+ * segy_readsubtr_native in the file's format. Traces that are close on disk
+ * are read in a single request, so reading many adjacent traces is about as
+ * fast as one large read. Many traces that are all far apart are read through
+ * a segy_queue kept on the datasource instead, so that their reads are in
+ * flight at the same time.
+ */
+int segy_read_traces( segy_datasource*,
+                      const int* tracenos,
+                      int n,
+                      int sample_start,
+                      int sample_stop,
+                      int sample_step,
+                      void* out );
+
+int segy_read_traces64( segy_datasource*,
+                        const long long* tracenos,
+                        long long n,
+                        int sample_start,
+                        int sample_stop,
+                        int sample_step,
+                        void* out );
+
+/*
+ * Read the depth (or time) slices [sample_start:sample_stop:sample_step] of
+ * the count traces trace0, trace0 + trace_step, ... into out, converted to
+ * native like segy_read_traces. The output is slice-major, i.e. sample s of
+ * trace k is at out[s * count + k].
+ *
+ * Rather than reading one sample per trace, the traces are read in large
+ * batches, in file order, and the samples scattered into the slices, so many
+ * slices cost about as much as one. The working buffer is bounded, and does
+ * not grow with the size of the file.
+ */
+int segy_read_depth_slices( segy_datasource*,
+                            long long trace0,
+                            long long count,
+                            int trace_step,
+                            int sample_start,
+                            int sample_stop,
+                            int sample_step,
+                            void* out );
+
+typedef enum {
+    SEGY_QUEUE_SYNC = 0,
+    SEGY_QUEUE_THREADS,
+    SEGY_QUEUE_IO_URING,
+} SEGY_QUEUE_BACKEND;
+
+/*
+ * Asynchronous trace reads. A queue keeps up to `depth` reads in flight at the
+ * same time, which hides the latency of scattered reads on devices that serve
+ * many requests in parallel, like NVMe drives and network file systems.
+ *
+ * On Linux, file descriptor backed datasources are read with io_uring. Other
+ * datasources with positional reads (read_at) are read by a pool of threads,
+ * and the rest synchronously, as part of submit. segy_queue_backend returns
+ * the SEGY_QUEUE_BACKEND in use.
+ *
+ * segy_submit_read_traces queues reads like segy_read_traces, and returns as
+ * soon as all the reads are in flight, waiting for earlier reads to complete
+ * when the queue is full. tracenos is not used after submit returns, but out
+ * must not be touched until segy_wait returns, which happens when all
+ * submitted reads are complete. segy_wait returns the first error of any read
+ * since the previous wait.
+ *
+ * segy_queue_close waits for outstanding reads like segy_wait, and frees the
+ * queue. The datasource must outlive the queue, and a queue must only be used
+ * from one thread at a time.
+ */
+typedef struct segy_queue segy_queue;
+
+segy_queue* segy_queue_open( segy_datasource*, int depth );
+int segy_queue_close( segy_queue* );
+int segy_queue_backend( const segy_queue* );
+
+int segy_submit_read_traces( segy_queue*,
+                             const long long* tracenos,
+                             long long n,
+                             int sample_start,
+                             int sample_stop,
+                             int sample_step,
+                             void* out );
+
+int segy_wait( segy_queue* );
+
+int segy_read_line_native( segy_datasource* ds,
+                           int line_trace0,
+                           int line_length,
+                           int stride,
+                           int offsets,
+                           int outformat,
+                           void* buf );
+
+/*
+ * Like segy_read_line_native, but splits the traces between `threads` threads
+ * which read and convert straight into buf. This requires a datasource with
+ * positional reads (read_at), otherwise the line is read serially.
+ *
+ * segy_read_cube reads all traces in file order.
+ */
+int segy_read_line_parallel( segy_datasource* ds,
+                             int line_trace0,
+                             int line_length,
+                             int stride,
+                             int offsets,
+                             int outformat,
+                             void* buf,
+                             int threads );
+
+int segy_read_cube( segy_datasource* ds,
+                    int outformat,
+                    void* buf,
+                    int threads );
+
+/*
+ * Amplitude statistics of a set of samples. NaNs are counted in nans and left
+ * out of everything else, so count is the number of samples that are not NaN.
+ * With no such samples min is +inf and max is -inf. The mean is sum / count
+ * and the RMS sqrt( sumsq / count ).
+ */
+typedef struct {
+    long long count;
+    long long nans;
+    double min;
+    double max;
+    double sum;
+    double sumsq;
+} segy_amplitudes;
+
+/*
+ * Compute amplitude statistics of all traces in a single pass over the file.
+ * The traces are split between `threads` threads like segy_read_cube, and the
+ * samples are accumulated with the vectorized kernels selected by segy_simd.
+ *
+ * Every trace belongs to the group groups[traceno], which must be in [0,
+ * ngroups), e.g. the index of its inline. If groups is NULL, all traces are in
+ * group 0. `stats` must have room for ngroups entries.
+ *
+ * If `traces` is not NULL, the statistics of every single trace are written to
+ * it, so it must have room for tracecount entries.
+ *
+ * If `histograms` is not NULL, it is ngroups histograms of `bins` counts, and
+ * the samples of every group in [low, high] are counted in equally wide bins.
+ * high is in the last bin, and samples outside of [low, high] are not counted.
+ *
+ * All outputs are overwritten. Every thread has its own copy of the group
+ * statistics and histograms, which are merged at the end.
+ */
+int segy_stats( segy_datasource* ds,
+                const int* groups,
+                int ngroups,
+                segy_amplitudes* stats,
+                segy_amplitudes* traces,
+                double low,
+                double high,
+                int bins,
+                long long* histograms,
+                int threads );
+
+/*
+ * Merge the statistics src into dst, as if dst was computed over the samples
+ * of both.
+ */
+void segy_amplitudes_merge( segy_amplitudes* dst, const segy_amplitudes* src );
+
 /*
  * Count inlines and crosslines. Use this function to determine how large buffer
  * the functions `segy_inline_indices` and `segy_crossline_indices` expect.  If
@@ -852,6 +1387,84 @@ int segy_lines_count( segy_datasource*,
                       int offsets,
                       int* il_count,
                       int* xl_count );
+/*
+ * Infer the sorting, number of offsets and number of inlines and crosslines,
+ * as segy_sorting, segy_offsets and segy_lines_count would, but without
+ * scanning the headers line by line. Instead, the grid is worked out from a
+ * few trace headers (binary search), and checked against a handful of traces
+ * spread over the file. Files that do not look like a regular grid are
+ * scanned, and get the same result as the scanning functions.
+ *
+ * If `strict` is non-zero, every trace header is read (in a single pass) and
+ * checked against the grid, and SEGY_NOTFOUND is returned if any trace is
+ * out of place. The scanning functions do not check this, and neither does
+ * segy_infer_geometry when `strict` is zero.
+ */
+typedef struct {
+    int sorting;
+    int offset_count;
+    int iline_count;
+    int xline_count;
+} segy_geometry;
+
+int segy_infer_geometry( segy_datasource*,
+                         int il,
+                         int xl,
+                         int offset,
+                         int strict,
+                         segy_geometry* out );
+
+/*
+ * Out-of-core reordering of cubes, for files too large to fit in memory.
+ * Both functions use at most about `memory` bytes of buffers, and read the
+ * input in a few passes of large reads.
+ *
+ * segy_transpose writes a copy of src to dst with the lines in the other
+ * sorting, i.e. an inline sorted file becomes crossline sorted and the other
+ * way around. The headers and traces are copied as-is, and the traces of all
+ * offsets at a point are kept together. `geometry` is the geometry of src, as
+ * found by segy_infer_geometry, and the output is written in bands of output
+ * lines, one pass over src per band. The traces are placed by their position
+ * in src alone, so infer the geometry with `strict` unless src is known to be
+ * a regular cube.
+ *
+ * segy_write_depth_major writes the samples of all traces in src to dst as a
+ * raw, sample-major volume, i.e. the first sample of every trace, then the
+ * second sample of every trace, and so on, converted to native like
+ * segy_read_traces. Every pass reads the whole of src, with the decoding
+ * split between `threads` threads when src has positional reads (read_at),
+ * and writes as many depth slices as fit in memory.
+ */
+int segy_transpose( segy_datasource* src,
+                    segy_datasource* dst,
+                    const segy_geometry* geometry,
+                    size_t memory );
+
+int segy_write_depth_major( segy_datasource* src,
+                            segy_datasource* dst,
+                            size_t memory,
+                            int threads );
+
+/*
+ * Write the traces of src to dst in the order `order`, so that trace i in dst
+ * is trace order[i] in src. `count` need not be the tracecount, and order need
+ * not be a permutation, which makes this useful to extract a subset of the
+ * traces, too. The text and binary headers are copied as-is. src and dst must
+ * be different files.
+ *
+ * dst is written front to back in bands of traces that fit in about `memory`
+ * bytes. Every band is read in file order, with traces close to each other
+ * read by a single request, split between `threads` threads when src has
+ * positional reads (read_at). When dst has positional writes, a band is
+ * written in the background while the next band is read.
+ */
+int segy_permute_traces( segy_datasource* src,
+                         segy_datasource* dst,
+                         const long long* order,
+                         long long count,
+                         size_t memory,
+                         int threads );
+
 /*
  * Find the `line_length` for the inlines. Assumes all inlines, crosslines and
  * traces don't vary in length.
@@ -938,6 +1551,79 @@ int segy_rotation_cw( segy_datasource*,
                       int linenos_sz,
                       float* rotation );
 
+/*
+ * Read the CDP-X and CDP-Y of every trace in a single pass over the file,
+ * scaled like segy_rotation_cw does it: from trace header extension 1 when
+ * the file has it and the coordinate is set, and otherwise from the standard
+ * header, with the source/group scalar applied. cdpx and cdpy must fit
+ * tracecount doubles.
+ */
+int segy_read_cdps( segy_datasource*, double* cdpx, double* cdpy );
+
+/*
+ * A spatial index over n points, usually the CDP coordinates of all traces,
+ * for nearest-point and point-in-polygon queries that do not have to look at
+ * every point.
+ *
+ * The points are binned in a uniform grid of columns-by-rows square cells of
+ * size cellsize, with the south-west corner at (x0, y0), and about two points
+ * per cell. The index is a counting sort of the points by cell: the points in
+ * cell (column, row) are index[offsets[c]] to index[offsets[c + 1] - 1], with
+ * c = row * columns + column, in increasing order.
+ *
+ * To build an index, set x, y and n, and call segy_spatial_grid to size the
+ * grid. Then, point offsets to columns * rows + 1 and index to n long longs,
+ * and call segy_spatial_build. The index does not own any of the arrays, and
+ * x and y must outlive it. The index can be stored by storing x and y, as
+ * building it again is a single pass over the points.
+ */
+typedef struct {
+    const double* x;
+    const double* y;
+    long long n;
+
+    double x0;
+    double y0;
+    double cellsize;
+    long long columns;
+    long long rows;
+
+    long long* offsets;
+    long long* index;
+} segy_spatial_index;
+
+int segy_spatial_grid( segy_spatial_index* );
+int segy_spatial_build( segy_spatial_index* );
+
+/*
+ * Find the k points closest to (x, y), ordered by distance, nearest first.
+ * Points at the same distance are ordered by their number. The point numbers
+ * are written to points, and the distances to distances, which must both fit
+ * k elements. found is set to the number of points found, which is k, or n if
+ * the index has fewer than k points.
+ */
+int segy_spatial_nearest( const segy_spatial_index*,
+                          double x,
+                          double y,
+                          int k,
+                          long long* points,
+                          double* distances,
+                          int* found );
+
+/*
+ * Find the points inside the polygon, given as vertices (x, y) pairs with an
+ * implicit edge from the last vertex back to the first. Points inside are
+ * found with the even-odd rule, so self-intersecting polygons have holes, and
+ * points right on an edge can go either way. The point numbers are written to
+ * points, in increasing order, which must fit n elements, and count is set to
+ * the number of points inside.
+ */
+int segy_spatial_within( const segy_spatial_index*,
+                         const double* polygon,
+                         int vertices,
+                         long long* points,
+                         long long* count );
+
 /*
  * Find the stride needed for an inline/crossline traversal.
  */
@@ -970,6 +1656,61 @@ int segy_read_stanza_data( segy_datasource* ds,
                            int stanza_headerno,
                            size_t stanza_data_size,
                            char* stanza_data );
+/*
+ * Geometry index. Figuring out the sorting, offsets and line numbers of a file
+ * means scanning trace headers, which can be slow for large files on network
+ * storage. segy_write_index does this once and writes the result to the file
+ * at `path`. By convention, the index of file.sgy is file.sgy.segyidx. Every
+ * trace header is checked against the grid before the index is written, like
+ * segy_infer_geometry with strict, and files that are not a regular cube get
+ * no index.
+ *
+ * An index is only valid for the file it was built from, and for the same
+ * inline, crossline and offset fields. The index records the file size, a
+ * hash of the binary header and a few trace headers, and `mtime`, which can be
+ * any modification stamp of the caller's choice, or 0 to not check it. Use a
+ * fine-grained stamp, like the modification time in nanoseconds, so that a
+ * file rewritten right after its index was written is still caught.
+ * segy_read_index returns SEGY_INVALID_INDEX if the index is malformed or
+ * does not match the file, in which case the geometry must be scanned as
+ * usual.
+ */
+typedef struct {
+    int il;
+    int xl;
+    int offset;
+    int sorting;
+    int tracecount;
+    int iline_count;
+    int xline_count;
+    int offset_count;
+} segy_index_header;
+
+int segy_write_index( segy_datasource*,
+                      const char* path,
+                      long long mtime,
+                      int il,
+                      int xl,
+                      int offset );
+
+int segy_read_index( segy_datasource*,
+                     const char* path,
+                     long long mtime,
+                     int il,
+                     int xl,
+                     int offset,
+                     segy_index_header* out );
+
+/*
+ * Read the line numbers from the index described by `header`, as
+ * segy_inline_indices, segy_crossline_indices and segy_offset_indices would.
+ */
+int segy_read_index_lines( const char* path,
+                           const segy_index_header* header,
+                           int* ilines,
+                           int* xlines,
+                           int* offsets );
+
 /*
  * Parses Trace Header Layout xml into mappings structure and outputs the
  * results into `mappings` and `mappings_length` parameters. Note:
@@ -1,7 +1,7 @@
 #define _POSIX_SOURCE /* fileno */
 
 /* 64-bit off_t in fseeko/ftello */
-#define _POSIX_C_SOURCE 200808L
+#define _POSIX_C_SOURCE 200809L
 #define _FILE_OFFSET_BITS 64
 
 #if defined(_WIN32) || defined(_MSC_VER)
@@ -19,6 +19,39 @@
   #include <sys/stat.h>
 #endif //HAVE_SYS_STAT_H
 
+#ifdef HAVE_PREAD
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif //HAVE_PREAD
+
+#if defined(HAVE_POSIX_FADVISE) || defined(HAVE_POSIX_MADVISE)
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif //HAVE_POSIX_FADVISE || HAVE_POSIX_MADVISE
+
+#ifdef HAVE_PTHREAD
+  #include <pthread.h>
+#endif //HAVE_PTHREAD
+
+#ifdef HAVE_POSIX_FALLOCATE
+  #include <fcntl.h>
+#endif //HAVE_POSIX_FALLOCATE
+
+#ifdef HAVE_IO_URING
+  #include <errno.h>
+  #include <linux/io_uring.h>
+  #include <sys/syscall.h>
+  #include <sys/uio.h>
+  #include <unistd.h>
+
+  /*
+   * syscall is only declared with _DEFAULT_SOURCE, which also defines the
+   * endian.h macros that clash with the byte order functions in this file
+   */
+  long syscall( long number, ... );
+#endif //HAVE_IO_URING
+
 #include <assert.h>
 #include <limits.h>
 #include <math.h>
@@ -29,6 +62,32 @@
 
 #include <segyio/segy.h>
 
+/*
+ * The IBM float conversion has vectorized kernels. SSE2 is baseline on x86-64
+ * and NEON on aarch64, so these are used unconditionally when the compiler
+ * targets them. AVX2 and AVX-512 are compiled with function-level target
+ * attributes and picked at runtime, so that the library still runs on older
+ * CPUs.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SEGY_HAVE_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #if defined(__clang__) || __GNUC__ >= 5
+        #define SEGY_HAVE_AVX2
+        #define SEGY_HAVE_AVX512
+        #include <immintrin.h>
+    #endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define SEGY_HAVE_NEON
+    #include <arm_neon.h>
+#endif
+
 static const unsigned char a2e[256] = {
     0,  1,  2,  3,  55, 45, 46, 47, 22, 5,  37, 11, 12, 13, 14, 15,
     16, 17, 18, 19, 60, 61, 50, 38, 24, 25, 63, 39, 28, 29, 30, 31,
@@ -672,6 +731,135 @@ static int fileclose( segy_datasource* self ) {
     return err;
 }
 
+#ifdef HAVE_PREAD
+/*
+ * File descriptor backed datasource. All I/O goes through pread/pwrite, and
+ * the position is only used by the stateful read/write/seek interface, so
+ * read_at and write_at are safe to call from several threads.
+ */
+struct fdfile {
+    int fd;
+    long long pos;
+};
+typedef struct fdfile fdfile;
+
+static int pread_all( int fd, long long offset, void* buffer, size_t size ) {
+    char* dst = (char*)buffer;
+    while( size > 0 ) {
+        const ssize_t readc = pread( fd, dst, size, (off_t)offset );
+        if( readc < 0 && errno == EINTR ) continue;
+        if( readc <= 0 ) return SEGY_FREAD_ERROR;
+        dst += readc;
+        offset += readc;
+        size -= readc;
+    }
+    return SEGY_OK;
+}
+
+static int fdread_at( segy_datasource* self,
+                      long long offset,
+                      void* buffer,
+                      size_t size ) {
+    const fdfile* fp = (fdfile*)self->stream;
+    return pread_all( fp->fd, offset, buffer, size );
+}
+
+static int fdwrite_at( segy_datasource* self,
+                       long long offset,
+                       const void* buffer,
+                       size_t size ) {
+    if ( !self->writable ) return SEGY_READONLY;
+    const fdfile* fp = (fdfile*)self->stream;
+    const char* src = (const char*)buffer;
+    while( size > 0 ) {
+        const ssize_t writec = pwrite( fp->fd, src, size, (off_t)offset );
+        if( writec < 0 && errno == EINTR ) continue;
+        if( writec <= 0 ) return SEGY_FWRITE_ERROR;
+        src += writec;
+        offset += writec;
+        size -= writec;
+    }
+    return SEGY_OK;
+}
+
+static int fdread( segy_datasource* self, void* buffer, size_t size ) {
+    fdfile* fp = (fdfile*)self->stream;
+    const int err = fdread_at( self, fp->pos, buffer, size );
+    if( err != SEGY_OK ) return err;
+    fp->pos += size;
+    return SEGY_OK;
+}
+
+static int fdwrite( segy_datasource* self, const void* buffer, size_t size ) {
+    fdfile* fp = (fdfile*)self->stream;
+    const int err = fdwrite_at( self, fp->pos, buffer, size );
+    if( err != SEGY_OK ) return err;
+    fp->pos += size;
+    return SEGY_OK;
+}
+
+static int fdsize( segy_datasource* self, long long* out ) {
+    const fdfile* fp = (fdfile*)self->stream;
+    struct stat st;
+    if( fstat( fp->fd, &st ) != 0 ) return SEGY_FSEEK_ERROR;
+    *out = st.st_size;
+    return SEGY_OK;
+}
+
+static int fdseek( segy_datasource* self, long long pos, int whence ) {
+    fdfile* fp = (fdfile*)self->stream;
+    long long base;
+    switch( whence ) {
+        case SEEK_SET: base = 0; break;
+        case SEEK_CUR: base = fp->pos; break;
+        case SEEK_END: {
+            const int err = fdsize( self, &base );
+            if( err != SEGY_OK ) return err;
+            break;
+        }
+        default:
+            return SEGY_FSEEK_ERROR;
+    }
+
+    if( base + pos < 0 ) return SEGY_FSEEK_ERROR;
+    fp->pos = base + pos;
+    return SEGY_OK;
+}
+
+static int fdtell( segy_datasource* self, long long* pos ) {
+    const fdfile* fp = (fdfile*)self->stream;
+    *pos = fp->pos;
+    return SEGY_OK;
+}
+
+static int fdflush( segy_datasource* self ) {
+    /* there are no userland buffers, pwrite goes straight to the kernel */
+    (void)self; // mark parameter as unused
+    return SEGY_OK;
+}
+
+static int fdclose( segy_datasource* self ) {
+    fdfile* fp = (fdfile*)self->stream;
+    const int err = close( fp->fd );
+    free( fp );
+    if( err != 0 ) return SEGY_FWRITE_ERROR;
+    return SEGY_OK;
+}
+
+/*
+ * Read-only FILE datasources read through pread on the underlying descriptor,
+ * which leaves the FILE untouched. Writable files may have pending writes in
+ * the stdio buffers, so they don't get positional reads.
+ */
+static int fileread_at( segy_datasource* self,
+                        long long offset,
+                        void* buffer,
+                        size_t size ) {
+    FILE* file = (FILE*)self->stream;
+    return pread_all( fileno( file ), offset, buffer, size );
+}
+#endif //HAVE_PREAD
+
 /* Describes a file loaded into memory. */
 struct memfile {
     unsigned char* addr;
@@ -711,6 +899,30 @@ static int memwrite( segy_datasource* self, const void* buffer, size_t size ) {
     return SEGY_OK;
 }
 
+static int memread_at( segy_datasource* self,
+                       long long offset,
+                       void* buffer,
+                       size_t size ) {
+    const memfile* mp = (memfile*)self->stream;
+    if( offset < 0 || (size_t)offset > mp->size || size > mp->size - offset )
+        return SEGY_FREAD_ERROR;
+
+    memcpy( buffer, mp->addr + offset, size );
+    return SEGY_OK;
+}
+
+static int memwrite_at( segy_datasource* self,
+                        long long offset,
+                        const void* buffer,
+                        size_t size ) {
+    const memfile* mp = (memfile*)self->stream;
+    if( offset < 0 || (size_t)offset > mp->size || size > mp->size - offset )
+        return SEGY_FWRITE_ERROR;
+
+    memcpy( mp->addr + offset, buffer, size );
+    return SEGY_OK;
+}
+
 static int memseek( segy_datasource* self, long long pos, int whence ) {
     memfile* mp = (memfile*)self->stream;
     /*
@@ -823,6 +1035,10 @@ static void init_traceheader_mapping(
 
 #define MODEBUF_SIZE 5
 
+void segy_init_datasource( segy_datasource* ds ) {
+    memset( ds, 0, sizeof( segy_datasource ) );
+}
+
 segy_file* segy_open( const char* path, const char* mode ) {
 
     if( !path || !mode ) return NULL;
@@ -868,7 +1084,7 @@ segy_file* segy_open( const char* path, const char* mode ) {
 
     if( !fp ) return NULL;
 
-    segy_file* ds = malloc( sizeof( segy_file ) );
+    segy_file* ds = calloc( 1, sizeof( segy_file ) );
 
     if( !ds ) {
         fclose( fp );
@@ -884,8 +1100,14 @@ segy_file* segy_open( const char* path, const char* mode ) {
     ds->size = filesize;
     ds->flush = fileflush;
     ds->close = fileclose;
+    ds->read_at = NULL;
+    ds->write_at = NULL;
     ds->writable = strstr( binary_mode, "+" ) || strstr( binary_mode, "w" );
 
+#ifdef HAVE_PREAD
+    if( !ds->writable ) ds->read_at = fileread_at;
+#endif //HAVE_PREAD
+
     ds->minimize_requests_number = true;
     ds->memory_speedup = false;
 
@@ -931,7 +1153,7 @@ segy_datasource* segy_memopen( unsigned char* addr, size_t size ) {
     mp->cur = addr;
     mp->size = size;
 
-    segy_datasource* ds = malloc( sizeof( segy_datasource ) );
+    segy_datasource* ds = calloc( 1, sizeof( segy_datasource ) );
     if( !ds ) {
         free( mp );
         return NULL;
@@ -945,6 +1167,8 @@ segy_datasource* segy_memopen( unsigned char* addr, size_t size ) {
     ds->size = memsize;
     ds->flush = memflush;
     ds->close = memclose;
+    ds->read_at = memread_at;
+    ds->write_at = memwrite_at;
 
     ds->writable = true;
 
@@ -979,6 +1203,74 @@ segy_datasource* segy_memopen( unsigned char* addr, size_t size ) {
     return ds;
 }
 
+segy_datasource* segy_open_fd( int fd ) {
+#ifndef HAVE_PREAD
+    (void)fd; // mark parameter as unused
+    return NULL;
+#else
+    const int flags = fcntl( fd, F_GETFL );
+    if( flags == -1 ) return NULL;
+
+    fdfile* fp = malloc( sizeof( fdfile ) );
+    if( !fp ) return NULL;
+    fp->fd = fd;
+    fp->pos = 0;
+
+    segy_datasource* ds = calloc( 1, sizeof( segy_datasource ) );
+    if( !ds ) {
+        free( fp );
+        return NULL;
+    }
+    ds->stream = fp;
+
+    ds->read = fdread;
+    ds->write = fdwrite;
+    ds->seek = fdseek;
+    ds->tell = fdtell;
+    ds->size = fdsize;
+    ds->flush = fdflush;
+    ds->close = fdclose;
+    ds->read_at = fdread_at;
+    ds->write_at = fdwrite_at;
+
+    ds->writable = ( flags & O_ACCMODE ) != O_RDONLY;
+
+    /*
+     * Every request is a syscall, just like with fread on a fresh seek, so
+     * prefer few, large reads
+     */
+    ds->minimize_requests_number = true;
+    ds->memory_speedup = false;
+
+    ds->metadata.endianness = SEGY_MSB;
+    ds->metadata.encoding = SEGY_EBCDIC;
+    ds->metadata.format = SEGY_IBM_FLOAT_4_BYTE;
+    ds->metadata.elemsize = 4;
+    ds->metadata.ext_textheader_count = 0;
+    ds->metadata.trace0 = -1;
+    ds->metadata.samplecount = -1;
+    ds->metadata.trace_bsize = -1;
+    ds->metadata.traceheader_count = 1;
+    ds->metadata.tracecount = -1;
+
+    init_traceheader_mapping(
+        &ds->traceheader_mapping_standard,
+        segy_traceheader_default_name_map(),
+        segy_traceheader_default_map(),
+        "SEG00000"
+    );
+
+    init_traceheader_mapping(
+        &ds->traceheader_mapping_extension1,
+        segy_ext1_traceheader_default_name_map(),
+        segy_ext1_traceheader_default_map(),
+        "SEG00001"
+    );
+
+    return ds;
+#endif //HAVE_PREAD
+}
+
 int segy_mmap( segy_datasource* ds ) {
 #ifndef HAVE_MMAP
     return SEGY_MMAP_INVALID;
@@ -986,8 +1278,19 @@ int segy_mmap( segy_datasource* ds ) {
     /* don't re-map; i.e. multiple consecutive calls should be no-ops */
     if( ds->read == memread ) return SEGY_OK;
 
-    /* make mmap available for file datasource only */
-    if( ds->read != fileread ) return SEGY_MMAP_INVALID;
+    /* make mmap available for file datasources only */
+    int fd;
+    if( ds->read == fileread ) {
+        fd = fileno( (FILE*) ds->stream );
+    }
+#ifdef HAVE_PREAD
+    else if( ds->read == fdread ) {
+        fd = ((fdfile*)ds->stream)->fd;
+    }
+#endif //HAVE_PREAD
+    else {
+        return SEGY_MMAP_INVALID;
+    }
 
     long long fsize;
     int err = ds->size( ds, &fsize );
@@ -999,7 +1302,6 @@ int segy_mmap( segy_datasource* ds ) {
 
     const int prot = ds->writable ? PROT_READ | PROT_WRITE : PROT_READ;
 
-    int fd = fileno( (FILE*) ds->stream );
     void* addr = mmap( NULL, fsize, prot, MAP_SHARED, fd, 0 );
 
     // cppcheck-suppress memleak
@@ -1025,6 +1327,8 @@ int segy_mmap( segy_datasource* ds ) {
     ds->size = memsize;
     ds->flush = mmapflush;
     ds->close = mmapclose;
+    ds->read_at = memread_at;
+    ds->write_at = memwrite_at;
 
     ds->minimize_requests_number = false;
     ds->memory_speedup = true;
@@ -1043,142 +1347,678 @@ int segy_flush( segy_datasource* ds ) {
     return SEGY_OK;
 }
 
-static int seek_traceheader_offset(
-    segy_datasource* ds,
-    int trace,
+static long long traceheader_offset(
+    const segy_datasource* ds,
+    long long trace,
     int traceheader,
     long long offset
 ) {
     long long trace_size = ds->metadata.trace_bsize +
                            SEGY_TRACE_HEADER_SIZE * ds->metadata.traceheader_count;
-    long long pos = ds->metadata.trace0 +
-                    trace * trace_size +
-                    traceheader * SEGY_TRACE_HEADER_SIZE +
-                    offset;
+    return ds->metadata.trace0 +
+           trace * trace_size +
+           traceheader * SEGY_TRACE_HEADER_SIZE +
+           offset;
+}
 
-    int err = ds->seek( ds, pos, SEEK_SET );
-    if( err != 0 ) return SEGY_DS_SEEK_ERROR;
-    return SEGY_OK;
+/*
+ * The file descriptor of file datasources, or -1 if the datasource does not
+ * wrap a file descriptor
+ */
+static int datasource_fd( const segy_datasource* ds ) {
+    if( ds->read == fileread ) return fileno( (FILE*)ds->stream );
+#ifdef HAVE_PREAD
+    if( ds->read == fdread ) return ((const fdfile*)ds->stream)->fd;
+#endif //HAVE_PREAD
+    return -1;
 }
 
-int segy_close( segy_datasource* ds ) {
-    int err = segy_flush( ds);
-    if( err != SEGY_OK ) return err;
+#if defined(HAVE_MMAP) && defined(HAVE_POSIX_MADVISE)
+static int madvice( int pattern ) {
+    switch( pattern ) {
+        case SEGY_ACCESS_SEQUENTIAL: return POSIX_MADV_SEQUENTIAL;
+        case SEGY_ACCESS_RANDOM:     return POSIX_MADV_RANDOM;
+        case SEGY_ACCESS_STRIDED:    return POSIX_MADV_RANDOM;
+        case SEGY_ACCESS_WILLNEED:   return POSIX_MADV_WILLNEED;
+        default:                     return POSIX_MADV_NORMAL;
+    }
+}
 
-    err = ds->close(ds);
-    free( ds );
-    if( err != 0 ) return SEGY_DS_CLOSE_ERROR;
-    return SEGY_OK;
+/* madvise the [begin, end) bytes of the mapping, extended to whole pages */
+static void madvise_range( segy_datasource* ds,
+                           long long begin,
+                           long long end,
+                           int pattern ) {
+    const memfile* mp = (memfile*)ds->stream;
+    const long long size = (long long)mp->size;
+    if( end > size ) end = size;
+    if( begin >= end ) return;
+
+    const long pagesize = sysconf( _SC_PAGESIZE );
+    if( pagesize > 0 ) begin -= begin % pagesize;
+
+    posix_madvise( mp->addr + begin, end - begin, madvice( pattern ) );
 }
+#endif //HAVE_MMAP && HAVE_POSIX_MADVISE
 
-int segy_collect_metadata(
-    segy_datasource* ds,
-    int endianness,
-    int encoding,
-    int ext_textheader_count
-) {
-    if( endianness != SEGY_LSB && endianness != SEGY_MSB ) {
-        int err = segy_endianness( ds, &endianness );
-        if( err != SEGY_OK ) return err;
+#ifdef HAVE_POSIX_FADVISE
+static int fadvice( int pattern ) {
+    switch( pattern ) {
+        case SEGY_ACCESS_SEQUENTIAL: return POSIX_FADV_SEQUENTIAL;
+        case SEGY_ACCESS_RANDOM:     return POSIX_FADV_RANDOM;
+        case SEGY_ACCESS_STRIDED:    return POSIX_FADV_RANDOM;
+        case SEGY_ACCESS_WILLNEED:   return POSIX_FADV_WILLNEED;
+        default:                     return POSIX_FADV_NORMAL;
     }
-    ds->metadata.endianness = endianness;
+}
+#endif //HAVE_POSIX_FADVISE
 
-    if( encoding != SEGY_ASCII && encoding != SEGY_EBCDIC ) {
-        int err = segy_encoding( ds, &encoding );
-        if( err != SEGY_OK ) return err;
+/*
+ * Apply the access pattern to the bytes [begin, end) of the file, where end
+ * of 0 means to the end of the file
+ */
+static void advise( segy_datasource* ds,
+                    long long begin,
+                    long long end,
+                    int pattern ) {
+#if defined(HAVE_MMAP) && defined(HAVE_POSIX_MADVISE)
+    if( ds->close == mmapclose ) {
+        const memfile* mp = (memfile*)ds->stream;
+        madvise_range( ds, begin, end ? end : (long long)mp->size, pattern );
+        return;
     }
-    ds->metadata.encoding = encoding;
-
-    char binheader[SEGY_BINARY_HEADER_SIZE];
-    int err = segy_binheader( ds, binheader );
-    if( err ) {
-        return err;
+#endif //HAVE_MMAP && HAVE_POSIX_MADVISE
+
+#ifdef HAVE_POSIX_FADVISE
+    const int fd = datasource_fd( ds );
+    if( fd >= 0 ) {
+        const off_t len = end ? (off_t)( end - begin ) : 0;
+        posix_fadvise( fd, (off_t)begin, len, fadvice( pattern ) );
+        return;
     }
+#endif //HAVE_POSIX_FADVISE
 
-    ds->metadata.format = segy_format( binheader );
-    ds->metadata.elemsize = segy_formatsize( ds->metadata.format );
-    if( ds->metadata.elemsize <= 0 ) {
+    (void)ds; // mark parameters as unused
+    (void)begin;
+    (void)end;
+    (void)pattern;
+}
+
+int segy_set_access_pattern( segy_datasource* ds, int pattern ) {
+    if( pattern < SEGY_ACCESS_NORMAL || pattern > SEGY_ACCESS_WILLNEED )
         return SEGY_INVALID_ARGS;
-    }
 
-    if( ext_textheader_count < 0 ) {
-        segy_field_data fd;
-        err = segy_get_binfield( binheader, SEGY_BIN_EXT_HEADERS, &fd );
-        if( err != SEGY_OK ) return err;
+    advise( ds, 0, 0, pattern );
+    return SEGY_OK;
+}
 
-        ext_textheader_count = fd.value.i16;
-        if( ext_textheader_count < 0 ) return SEGY_INVALID_FIELD_VALUE;
-    }
-    ds->metadata.ext_textheader_count = ext_textheader_count;
+int segy_prefetch_traces( segy_datasource* ds,
+                          long long first,
+                          long long count ) {
+    if( first < 0 || count < 0 ) return SEGY_INVALID_ARGS;
+    if( count == 0 ) return SEGY_OK;
 
-    unsigned long long trace0;
-    err = segy_trace0( binheader, &trace0, ext_textheader_count );
-    if( err != SEGY_OK ) return err;
-    ds->metadata.trace0 = trace0;
+    const long long begin = traceheader_offset( ds, first, 0, 0 );
+    const long long end = traceheader_offset( ds, first + count, 0, 0 );
+    advise( ds, begin, end, SEGY_ACCESS_WILLNEED );
+    return SEGY_OK;
+}
 
-    ds->metadata.samplecount = segy_samples( binheader );
-    ds->metadata.trace_bsize = ds->metadata.samplecount * ds->metadata.elemsize;
+/*
+ * Read/write size bytes at the absolute position pos. Datasources with
+ * positional I/O leave the stream position alone, which makes concurrent
+ * reads safe. Otherwise fall back to seek + read/write.
+ */
+static int read_at( segy_datasource* ds,
+                    long long pos,
+                    void* buf,
+                    size_t size ) {
+    if( ds->read_at ) {
+        const int err = ds->read_at( ds, pos, buf, size );
+        if( err != 0 ) return SEGY_DS_READ_ERROR;
+        return SEGY_OK;
+    }
 
-    int traceheader_count;
-    err = segy_traceheaders( binheader, &traceheader_count );
-    if( err != SEGY_OK ) return err;
-    ds->metadata.traceheader_count = traceheader_count;
+    int err = ds->seek( ds, pos, SEEK_SET );
+    if( err != 0 ) return SEGY_DS_SEEK_ERROR;
 
-    if( ds->metadata.traceheader_count == 1 ) {
-        // remove extension1 maps, which are on by default
-        memset(
-            &ds->traceheader_mapping_extension1,
-            0,
-            sizeof( ds->traceheader_mapping_extension1 )
-        );
+    err = ds->read( ds, buf, size );
+    if( err != 0 ) return SEGY_DS_READ_ERROR;
+    return SEGY_OK;
+}
+
+static int write_at( segy_datasource* ds,
+                     long long pos,
+                     const void* buf,
+                     size_t size ) {
+    if( ds->write_at ) {
+        const int err = ds->write_at( ds, pos, buf, size );
+        if( err != 0 ) return SEGY_DS_WRITE_ERROR;
+        return SEGY_OK;
     }
 
-    int tracecount;
-    err = segy_traces( ds, &tracecount );
-    if( err != SEGY_OK ) return err;
-    ds->metadata.tracecount = tracecount;
+    int err = ds->seek( ds, pos, SEEK_SET );
+    if( err != 0 ) return SEGY_DS_SEEK_ERROR;
 
+    err = ds->write( ds, buf, size );
+    if( err != 0 ) return SEGY_DS_WRITE_ERROR;
     return SEGY_OK;
 }
 
-/* Converts entry type to more general datatype.  */
-static const uint8_t entry_type_to_datatype_map[22] = {
-    [ SEGY_ENTRY_TYPE_UNDEFINED   ] = SEGY_UNDEFINED_FIELD,
-    [ SEGY_ENTRY_TYPE_INT2        ] = SEGY_SIGNED_SHORT_2_BYTE,
-    [ SEGY_ENTRY_TYPE_INT4        ] = SEGY_SIGNED_INTEGER_4_BYTE,
-    [ SEGY_ENTRY_TYPE_INT8        ] = SEGY_SIGNED_INTEGER_8_BYTE,
-    [ SEGY_ENTRY_TYPE_UINT1       ] = SEGY_UNSIGNED_CHAR_1_BYTE,
-    [ SEGY_ENTRY_TYPE_UINT2       ] = SEGY_UNSIGNED_SHORT_2_BYTE,
-    [ SEGY_ENTRY_TYPE_UINT4       ] = SEGY_UNSIGNED_INTEGER_4_BYTE,
-    [ SEGY_ENTRY_TYPE_UINT8       ] = SEGY_UNSIGNED_INTEGER_8_BYTE,
-    [ SEGY_ENTRY_TYPE_IBMFP       ] = SEGY_IBM_FLOAT_4_BYTE,
-    [ SEGY_ENTRY_TYPE_IEEE32      ] = SEGY_IEEE_FLOAT_4_BYTE,
-    [ SEGY_ENTRY_TYPE_IEEE64      ] = SEGY_IEEE_FLOAT_8_BYTE,
-    [ SEGY_ENTRY_TYPE_LINETRC     ] = SEGY_UNSIGNED_INTEGER_4_BYTE,
-    [ SEGY_ENTRY_TYPE_REELTRC     ] = SEGY_UNSIGNED_INTEGER_4_BYTE,
-    [ SEGY_ENTRY_TYPE_LINETRC8    ] = SEGY_UNSIGNED_INTEGER_8_BYTE,
-    [ SEGY_ENTRY_TYPE_REELTRC8    ] = SEGY_UNSIGNED_INTEGER_8_BYTE,
-    [ SEGY_ENTRY_TYPE_COOR4       ] = SEGY_SIGNED_INTEGER_4_BYTE,
-    [ SEGY_ENTRY_TYPE_ELEV4       ] = SEGY_SIGNED_INTEGER_4_BYTE,
-    [ SEGY_ENTRY_TYPE_TIME2       ] = SEGY_SIGNED_SHORT_2_BYTE,
-    [ SEGY_ENTRY_TYPE_SPNUM4      ] = SEGY_SIGNED_INTEGER_4_BYTE,
-    [ SEGY_ENTRY_TYPE_SCALE6_MANT ] = SEGY_SIGNED_INTEGER_4_BYTE,
-    [ SEGY_ENTRY_TYPE_SCALE6_EXP  ] = SEGY_SIGNED_SHORT_2_BYTE,
-    [ SEGY_ENTRY_TYPE_STRING8     ] = SEGY_STRING_8_BYTE,
+/*
+ * Block cache datasource. The file is split into aligned blocks of blocksize
+ * bytes, and reads are served from an LRU cache of these blocks. Misses read
+ * the missing block, and if the misses are sequential, an increasing number
+ * of blocks ahead, in one request to the inner datasource. Writes go straight
+ * through to the inner datasource, and update the cached blocks they overlap.
+ *
+ * The cache is not safe to use from several threads, so it offers no
+ * positional I/O.
+ */
+#define SEGY_CACHE_BLOCK_SIZE ( 64 * 1024 )
+#define SEGY_CACHE_CAPACITY   ( 16 * 1024 * 1024 )
+#define SEGY_CACHE_READAHEAD  32
+
+struct cacheblock {
+    long long index; /* block number in the file, -1 if unused */
+    size_t len;      /* bytes read; shorter than blocksize for the last block */
+    int prev;        /* LRU neighbours, most recently used first */
+    int next;
+    int chain;       /* next block in the same hash bucket */
+    unsigned char* data;
 };
 
-int segy_entry_type_to_datatype( uint8_t entry_type ) {
-    return entry_type_to_datatype_map[entry_type];
+struct blockcache {
+    segy_datasource* inner;
+    size_t blocksize;
+    int capacity;
+    struct cacheblock* blocks;
+    unsigned char* memory;
+    int* buckets;
+    int nbuckets;
+    int head;
+    int tail;
+
+    unsigned char* staging;
+    int maxreadahead;
+    int readahead;
+    long long nextmiss; /* the block right after the previous miss */
+
+    long long pos;
+    long long size;
+};
+typedef struct blockcache blockcache;
+
+static int inner_read_at( segy_datasource* inner,
+                          long long pos,
+                          void* buf,
+                          size_t size ) {
+    if( inner->read_at ) return inner->read_at( inner, pos, buf, size );
+
+    const int err = inner->seek( inner, pos, SEEK_SET );
+    if( err != 0 ) return err;
+    return inner->read( inner, buf, size );
 }
 
-static int get_field( const char* header,
-                      const segy_entry_definition* mapping,
-                      int mapsize,
-                      int offset,
-                      segy_field_data* fd ) {
+static int inner_write_at( segy_datasource* inner,
+                           long long pos,
+                           const void* buf,
+                           size_t size ) {
+    if( inner->write_at ) return inner->write_at( inner, pos, buf, size );
 
-    if( offset < 0 || offset >= mapsize ) {
-        return SEGY_INVALID_FIELD;
+    const int err = inner->seek( inner, pos, SEEK_SET );
+    if( err != 0 ) return err;
+    return inner->write( inner, buf, size );
+}
+
+static int cache_bucket( const blockcache* c, long long index ) {
+    const unsigned long long h = (unsigned long long)index
+                               * 0x9E3779B97F4A7C15ull;
+    return (int)( h >> 32 ) & ( c->nbuckets - 1 );
+}
+
+static int cache_find( const blockcache* c, long long index ) {
+    int i = c->buckets[ cache_bucket( c, index ) ];
+    while( i >= 0 && c->blocks[ i ].index != index )
+        i = c->blocks[ i ].chain;
+    return i;
+}
+
+static void lru_unlink( blockcache* c, int i ) {
+    struct cacheblock* b = c->blocks + i;
+    if( b->prev >= 0 ) c->blocks[ b->prev ].next = b->next;
+    else               c->head = b->next;
+    if( b->next >= 0 ) c->blocks[ b->next ].prev = b->prev;
+    else               c->tail = b->prev;
+}
+
+static void lru_push_front( blockcache* c, int i ) {
+    struct cacheblock* b = c->blocks + i;
+    b->prev = -1;
+    b->next = c->head;
+    if( c->head >= 0 ) c->blocks[ c->head ].prev = i;
+    c->head = i;
+    if( c->tail < 0 ) c->tail = i;
+}
+
+/* Remove the block from its hash chain, and mark it unused */
+static void cache_drop( blockcache* c, int i ) {
+    struct cacheblock* b = c->blocks + i;
+    if( b->index < 0 ) return;
+
+    int* link = c->buckets + cache_bucket( c, b->index );
+    while( *link != i ) link = &c->blocks[ *link ].chain;
+    *link = b->chain;
+
+    b->index = -1;
+    b->chain = -1;
+}
+
+/* Take the least recently used block, and make it hold block `index` */
+static int cache_evict( blockcache* c, long long index ) {
+    const int i = c->tail;
+    cache_drop( c, i );
+    lru_unlink( c, i );
+    lru_push_front( c, i );
+
+    struct cacheblock* b = c->blocks + i;
+    const int bucket = cache_bucket( c, index );
+    b->index = index;
+    b->chain = c->buckets[ bucket ];
+    c->buckets[ bucket ] = i;
+    return i;
+}
+
+/*
+ * Get the cached block `index`, reading it (and possibly the blocks after it)
+ * from the inner datasource if it is not cached.
+ */
+static int cache_get( blockcache* c, long long index, int* out ) {
+    const int found = cache_find( c, index );
+    if( found >= 0 ) {
+        lru_unlink( c, found );
+        lru_push_front( c, found );
+        *out = found;
+        return SEGY_OK;
+    }
+
+    const long long bs = (long long)c->blocksize;
+    const long long lastblock = ( c->size + bs - 1 ) / bs;
+    if( index >= lastblock ) return SEGY_DS_READ_ERROR;
+
+    /* grow the readahead for sequential misses, and reset it otherwise */
+    if( index == c->nextmiss ) {
+        c->readahead *= 2;
+        if( c->readahead > c->maxreadahead ) c->readahead = c->maxreadahead;
+    } else {
+        c->readahead = 1;
+    }
+
+    int n = 1;
+    while( n < c->readahead
+        && index + n < lastblock
+        && cache_find( c, index + n ) < 0 ) {
+        ++n;
+    }
+
+    const long long begin = index * bs;
+    long long end = ( index + n ) * bs;
+    if( end > c->size ) end = c->size;
+
+    const int err = inner_read_at( c->inner, begin, c->staging, end - begin );
+    if( err != 0 ) return SEGY_DS_READ_ERROR;
+
+    /* insert back-to-front, so that the requested block is the most recent */
+    for( int k = n - 1; k >= 0; --k ) {
+        const int i = cache_evict( c, index + k );
+        struct cacheblock* b = c->blocks + i;
+        const long long offset = k * bs;
+        b->len = (size_t)( end - begin - offset < bs ? end - begin - offset : bs );
+        memcpy( b->data, c->staging + offset, b->len );
+    }
+
+    c->nextmiss = index + n;
+    *out = c->head;
+    return SEGY_OK;
+}
+
+static int cacheread( segy_datasource* self, void* buffer, size_t size ) {
+    blockcache* c = (blockcache*)self->stream;
+    if( c->pos < 0 || c->pos + (long long)size > c->size )
+        return SEGY_DS_READ_ERROR;
+
+    /* large reads would only flush the cache, so read them directly */
+    if( size >= c->blocksize * c->capacity / 2 ) {
+        const int err = inner_read_at( c->inner, c->pos, buffer, size );
+        if( err != 0 ) return SEGY_DS_READ_ERROR;
+        c->pos += size;
+        return SEGY_OK;
+    }
+
+    unsigned char* dst = (unsigned char*)buffer;
+    while( size > 0 ) {
+        const long long index = c->pos / (long long)c->blocksize;
+        const size_t offset = (size_t)( c->pos % (long long)c->blocksize );
+
+        int i;
+        const int err = cache_get( c, index, &i );
+        if( err != SEGY_OK ) return err;
+
+        const struct cacheblock* b = c->blocks + i;
+        if( offset >= b->len ) return SEGY_DS_READ_ERROR;
+
+        const size_t len = b->len - offset < size ? b->len - offset : size;
+        memcpy( dst, b->data + offset, len );
+        dst += len;
+        size -= len;
+        c->pos += len;
+    }
+
+    return SEGY_OK;
+}
+
+static int cachewrite( segy_datasource* self, const void* buffer, size_t size ) {
+    blockcache* c = (blockcache*)self->stream;
+    if( !self->writable ) return SEGY_READONLY;
+    if( c->pos < 0 ) return SEGY_DS_WRITE_ERROR;
+
+    const int err = inner_write_at( c->inner, c->pos, buffer, size );
+    if( err != 0 ) return SEGY_DS_WRITE_ERROR;
+
+    const long long bs = (long long)c->blocksize;
+    const long long end = c->pos + (long long)size;
+
+    /* the last block is only partially cached, and grows with the file */
+    if( end > c->size ) {
+        const int last = cache_find( c, c->size / bs );
+        if( last >= 0 ) cache_drop( c, last );
+        c->size = end;
+    }
+
+    const unsigned char* src = (const unsigned char*)buffer;
+    for( long long pos = c->pos; pos < end; ) {
+        const long long index = pos / bs;
+        const long long offset = pos % bs;
+        const long long len = bs - offset < end - pos ? bs - offset : end - pos;
+
+        const int i = cache_find( c, index );
+        if( i >= 0 ) {
+            struct cacheblock* b = c->blocks + i;
+            if( b->len < c->blocksize ) cache_drop( c, i );
+            else memcpy( b->data + offset, src + ( pos - c->pos ), len );
+        }
+
+        pos += len;
+    }
+
+    c->pos = end;
+    return SEGY_OK;
+}
+
+static int cacheseek( segy_datasource* self, long long pos, int whence ) {
+    blockcache* c = (blockcache*)self->stream;
+    switch( whence ) {
+        case SEEK_SET: c->pos = pos; return SEGY_OK;
+        case SEEK_CUR: c->pos += pos; return SEGY_OK;
+        case SEEK_END: c->pos = c->size + pos; return SEGY_OK;
+        default:       return SEGY_DS_SEEK_ERROR;
+    }
+}
+
+static int cachetell( segy_datasource* self, long long* pos ) {
+    const blockcache* c = (blockcache*)self->stream;
+    *pos = c->pos;
+    return SEGY_OK;
+}
+
+static int cachesize( segy_datasource* self, long long* out ) {
+    const blockcache* c = (blockcache*)self->stream;
+    *out = c->size;
+    return SEGY_OK;
+}
+
+static int cacheflush( segy_datasource* self ) {
+    const blockcache* c = (blockcache*)self->stream;
+    return c->inner->flush( c->inner );
+}
+
+static void cache_free( blockcache* c ) {
+    free( c->blocks );
+    free( c->memory );
+    free( c->buckets );
+    free( c->staging );
+    free( c );
+}
+
+static int cacheclose( segy_datasource* self ) {
+    blockcache* c = (blockcache*)self->stream;
+    const int err = c->inner->close( c->inner );
+    free( c->inner );
+    cache_free( c );
+    return err;
+}
+
+segy_datasource* segy_cached_datasource( segy_datasource* inner,
+                                         size_t block_size,
+                                         size_t capacity ) {
+    if( !inner ) return NULL;
+    if( block_size == 0 ) block_size = SEGY_CACHE_BLOCK_SIZE;
+    if( capacity == 0 ) capacity = SEGY_CACHE_CAPACITY;
+
+    size_t nblocks = capacity / block_size;
+    if( nblocks < 1 ) nblocks = 1;
+    if( nblocks > INT_MAX / 2 ) return NULL;
+
+    long long size;
+    if( inner->size( inner, &size ) != 0 ) return NULL;
+
+    blockcache* c = calloc( 1, sizeof( blockcache ) );
+    if( !c ) return NULL;
+
+    c->inner = inner;
+    c->blocksize = block_size;
+    c->capacity = (int)nblocks;
+    c->size = size;
+    c->pos = 0;
+    c->nextmiss = -1;
+    c->readahead = 1;
+    c->maxreadahead = c->capacity / 4 < SEGY_CACHE_READAHEAD
+                    ? c->capacity / 4
+                    : SEGY_CACHE_READAHEAD;
+    if( c->maxreadahead < 1 ) c->maxreadahead = 1;
+
+    c->nbuckets = 1;
+    while( c->nbuckets < 2 * c->capacity ) c->nbuckets *= 2;
+
+    c->blocks = malloc( nblocks * sizeof( struct cacheblock ) );
+    c->memory = malloc( nblocks * block_size );
+    c->buckets = malloc( c->nbuckets * sizeof( int ) );
+    c->staging = malloc( c->maxreadahead * block_size );
+
+    segy_datasource* ds = calloc( 1, sizeof( segy_datasource ) );
+    if( !ds || !c->blocks || !c->memory || !c->buckets || !c->staging ) {
+        free( ds );
+        cache_free( c );
+        return NULL;
+    }
+
+    for( int i = 0; i < c->nbuckets; ++i )
+        c->buckets[ i ] = -1;
+
+    c->head = c->tail = -1;
+    for( int i = 0; i < c->capacity; ++i ) {
+        struct cacheblock* b = c->blocks + i;
+        b->index = -1;
+        b->len = 0;
+        b->chain = -1;
+        b->data = c->memory + i * block_size;
+        lru_push_front( c, i );
+    }
+
+    ds->stream = c;
+
+    ds->read = cacheread;
+    ds->write = cachewrite;
+    ds->seek = cacheseek;
+    ds->tell = cachetell;
+    ds->size = cachesize;
+    ds->flush = cacheflush;
+    ds->close = cacheclose;
+    ds->read_at = NULL;
+    ds->write_at = NULL;
+
+    ds->writable = inner->writable;
+
+    /* small requests are served from memory, so there is no need to batch */
+    ds->minimize_requests_number = false;
+    ds->memory_speedup = false;
+
+    ds->metadata = inner->metadata;
+    ds->traceheader_mapping_standard = inner->traceheader_mapping_standard;
+    ds->traceheader_mapping_extension1 = inner->traceheader_mapping_extension1;
+
+    return ds;
+}
+
+segy_datasource* segy_cached_inner( segy_datasource* ds ) {
+    if( ds->read != cacheread ) return NULL;
+    return ((blockcache*)ds->stream)->inner;
+}
+
+/*
+ * Traces that are at most this many bytes apart on disk are read with a single
+ * request, and the bytes in between thrown away. A request never spans more
+ * than the max span, unless a single subtrace is larger.
+ */
+#define SEGY_COALESCE_MAX_GAP  ( 64 * 1024 )
+#define SEGY_COALESCE_MAX_SPAN ( 8 * 1024 * 1024 )
+
+static int close_queue( segy_datasource* ds );
+
+/*
+ * The datasource is always closed and freed, even if closing its queue or
+ * flushing fails, and the first error is returned.
+ */
+int segy_close( segy_datasource* ds ) {
+    int err = close_queue( ds );
+
+    const int flusherr = segy_flush( ds );
+    if( err == SEGY_OK ) err = flusherr;
+
+    const int closeerr = ds->close( ds );
+    free( ds );
+    if( err == SEGY_OK && closeerr != 0 ) err = SEGY_DS_CLOSE_ERROR;
+    return err;
+}
+
+int segy_collect_metadata(
+    segy_datasource* ds,
+    int endianness,
+    int encoding,
+    int ext_textheader_count
+) {
+    if( endianness != SEGY_LSB && endianness != SEGY_MSB ) {
+        int err = segy_endianness( ds, &endianness );
+        if( err != SEGY_OK ) return err;
+    }
+    ds->metadata.endianness = endianness;
+
+    if( encoding != SEGY_ASCII && encoding != SEGY_EBCDIC ) {
+        int err = segy_encoding( ds, &encoding );
+        if( err != SEGY_OK ) return err;
+    }
+    ds->metadata.encoding = encoding;
+
+    char binheader[SEGY_BINARY_HEADER_SIZE];
+    int err = segy_binheader( ds, binheader );
+    if( err ) {
+        return err;
+    }
+
+    ds->metadata.format = segy_format( binheader );
+    ds->metadata.elemsize = segy_formatsize( ds->metadata.format );
+    if( ds->metadata.elemsize <= 0 ) {
+        return SEGY_INVALID_ARGS;
+    }
+
+    if( ext_textheader_count < 0 ) {
+        segy_field_data fd;
+        err = segy_get_binfield( binheader, SEGY_BIN_EXT_HEADERS, &fd );
+        if( err != SEGY_OK ) return err;
+
+        ext_textheader_count = fd.value.i16;
+        if( ext_textheader_count < 0 ) return SEGY_INVALID_FIELD_VALUE;
+    }
+    ds->metadata.ext_textheader_count = ext_textheader_count;
+
+    unsigned long long trace0;
+    err = segy_trace0( binheader, &trace0, ext_textheader_count );
+    if( err != SEGY_OK ) return err;
+    ds->metadata.trace0 = trace0;
+
+    ds->metadata.samplecount = segy_samples( binheader );
+    ds->metadata.trace_bsize = ds->metadata.samplecount * ds->metadata.elemsize;
+
+    int traceheader_count;
+    err = segy_traceheaders( binheader, &traceheader_count );
+    if( err != SEGY_OK ) return err;
+    ds->metadata.traceheader_count = traceheader_count;
+
+    if( ds->metadata.traceheader_count == 1 ) {
+        // remove extension1 maps, which are on by default
+        memset(
+            &ds->traceheader_mapping_extension1,
+            0,
+            sizeof( ds->traceheader_mapping_extension1 )
+        );
+    }
+
+    long long tracecount;
+    err = segy_traces64( ds, &tracecount );
+    if( err != SEGY_OK ) return err;
+    ds->metadata.tracecount = tracecount;
+
+    return SEGY_OK;
+}
+
+/* Converts entry type to more general datatype.  */
+static const uint8_t entry_type_to_datatype_map[22] = {
+    [ SEGY_ENTRY_TYPE_UNDEFINED   ] = SEGY_UNDEFINED_FIELD,
+    [ SEGY_ENTRY_TYPE_INT2        ] = SEGY_SIGNED_SHORT_2_BYTE,
+    [ SEGY_ENTRY_TYPE_INT4        ] = SEGY_SIGNED_INTEGER_4_BYTE,
+    [ SEGY_ENTRY_TYPE_INT8        ] = SEGY_SIGNED_INTEGER_8_BYTE,
+    [ SEGY_ENTRY_TYPE_UINT1       ] = SEGY_UNSIGNED_CHAR_1_BYTE,
+    [ SEGY_ENTRY_TYPE_UINT2       ] = SEGY_UNSIGNED_SHORT_2_BYTE,
+    [ SEGY_ENTRY_TYPE_UINT4       ] = SEGY_UNSIGNED_INTEGER_4_BYTE,
+    [ SEGY_ENTRY_TYPE_UINT8       ] = SEGY_UNSIGNED_INTEGER_8_BYTE,
+    [ SEGY_ENTRY_TYPE_IBMFP       ] = SEGY_IBM_FLOAT_4_BYTE,
+    [ SEGY_ENTRY_TYPE_IEEE32      ] = SEGY_IEEE_FLOAT_4_BYTE,
+    [ SEGY_ENTRY_TYPE_IEEE64      ] = SEGY_IEEE_FLOAT_8_BYTE,
+    [ SEGY_ENTRY_TYPE_LINETRC     ] = SEGY_UNSIGNED_INTEGER_4_BYTE,
+    [ SEGY_ENTRY_TYPE_REELTRC     ] = SEGY_UNSIGNED_INTEGER_4_BYTE,
+    [ SEGY_ENTRY_TYPE_LINETRC8    ] = SEGY_UNSIGNED_INTEGER_8_BYTE,
+    [ SEGY_ENTRY_TYPE_REELTRC8    ] = SEGY_UNSIGNED_INTEGER_8_BYTE,
+    [ SEGY_ENTRY_TYPE_COOR4       ] = SEGY_SIGNED_INTEGER_4_BYTE,
+    [ SEGY_ENTRY_TYPE_ELEV4       ] = SEGY_SIGNED_INTEGER_4_BYTE,
+    [ SEGY_ENTRY_TYPE_TIME2       ] = SEGY_SIGNED_SHORT_2_BYTE,
+    [ SEGY_ENTRY_TYPE_SPNUM4      ] = SEGY_SIGNED_INTEGER_4_BYTE,
+    [ SEGY_ENTRY_TYPE_SCALE6_MANT ] = SEGY_SIGNED_INTEGER_4_BYTE,
+    [ SEGY_ENTRY_TYPE_SCALE6_EXP  ] = SEGY_SIGNED_SHORT_2_BYTE,
+    [ SEGY_ENTRY_TYPE_STRING8     ] = SEGY_STRING_8_BYTE,
+};
+
+int segy_entry_type_to_datatype( uint8_t entry_type ) {
+    return entry_type_to_datatype_map[entry_type];
+}
+
+static int get_field( const char* header,
+                      const segy_entry_definition* mapping,
+                      int mapsize,
+                      int offset,
+                      segy_field_data* fd ) {
+
+    if( offset < 0 || offset >= mapsize ) {
+        return SEGY_INVALID_FIELD;
     }
 
     fd->entry_type = mapping[offset].entry_type;
@@ -1523,7 +2363,9 @@ int segy_set_binfield_int( char* header,
     return set_field_int( header, binheader_map, mapsize, offset, val );
 }
 
-static int slicelength( int start, int stop, int step ) {
+static long long slicelength64( long long start,
+                                long long stop,
+                                long long step ) {
     if( step == 0 ) return 0;
 
     if( ( step < 0 && stop >= start ) ||
@@ -1540,6 +2382,10 @@ static int slicelength( int start, int stop, int step ) {
     return (stop - start - 1) / step + 1;
 }
 
+static int slicelength( int start, int stop, int step ) {
+    return (int)slicelength64( start, stop, step );
+}
+
 /* Byte-swaps field value in the header. Returns new offset after swapping or -1
  * if error occurred.
  */
@@ -1571,12 +2417,29 @@ static int bswap_header_field_value(
     return offset + size;
 }
 
+/* Convert the on-disk value at offset in the header buf to native, in-place */
+static int decode_traceheader_field( const segy_datasource* ds,
+                                     const segy_entry_definition* mapping,
+                                     int offset,
+                                     int datatype,
+                                     char* buf ) {
+    if( ds->metadata.encoding == SEGY_EBCDIC && datatype == SEGY_STRING_8_BYTE ) {
+        encode( buf + offset, buf + offset, e2a, 8 );
+    }
+
+    if( ds->metadata.endianness == SEGY_LSB ) {
+        int next = bswap_header_field_value( mapping, buf, offset );
+        if( next < 0 ) return SEGY_INVALID_FIELD_DATATYPE;
+    }
+    return SEGY_OK;
+}
+
 /* Serves similar function as segy_read_traceheader, but reads just one value
  * from it.
  */
 static int segy_read_traceheader_offset(
     segy_datasource* ds,
-    int traceno,
+    long long traceno,
     int traceheader_no,
     int offset,
     int datatype,
@@ -1585,31 +2448,96 @@ static int segy_read_traceheader_offset(
     char* buf
 ) {
 
-    int err = seek_traceheader_offset( ds, traceno, traceheader_no, offset );
+    const long long pos = traceheader_offset( ds, traceno, traceheader_no, offset );
+    const int err = read_at( ds, pos, buf + offset, elemsize );
     if( err != SEGY_OK ) return err;
 
-    err = ds->read( ds, buf + offset, elemsize );
-    if( err != 0 ) return SEGY_DS_READ_ERROR;
+    return decode_traceheader_field( ds, mapping, offset, datatype, buf );
+}
 
-    if( ds->metadata.encoding == SEGY_EBCDIC && datatype == SEGY_STRING_8_BYTE ) {
-        encode( buf + offset, buf + offset, e2a, 8 );
-    }
+/* Write the value of fd as its datatype, elemsize bytes, to buf */
+static int copy_field_value( const segy_field_data* fd,
+                             int elemsize,
+                             char* buf ) {
+    switch( entry_type_to_datatype_map[fd->entry_type] ) {
+        case SEGY_SIGNED_INTEGER_8_BYTE:
+            memcpy( buf, &fd->value.i64, elemsize );
+            break;
 
-    if( ds->metadata.endianness == SEGY_LSB ) {
-        int next = bswap_header_field_value( mapping, buf, offset );
-        if( next < 0 ) return SEGY_INVALID_FIELD_DATATYPE;
-    }
-    return SEGY_OK;
-}
+        case SEGY_SIGNED_INTEGER_4_BYTE:
+            memcpy( buf, &fd->value.i32, elemsize );
+            break;
 
-int segy_field_forall( segy_datasource* ds,
-                       int traceheader_index,
-                       const segy_entry_definition* offset_map,
-                       int field,
-                       int start,
+        case SEGY_SIGNED_SHORT_2_BYTE:
+            memcpy( buf, &fd->value.i16, elemsize );
+            break;
+
+        case SEGY_SIGNED_CHAR_1_BYTE:
+            memcpy( buf, &fd->value.i8, elemsize );
+            break;
+
+        case SEGY_UNSIGNED_INTEGER_8_BYTE:
+            memcpy( buf, &fd->value.u64, elemsize );
+            break;
+
+        case SEGY_UNSIGNED_INTEGER_4_BYTE:
+            memcpy( buf, &fd->value.u32, elemsize );
+            break;
+
+        case SEGY_UNSIGNED_SHORT_2_BYTE:
+            memcpy( buf, &fd->value.u16, elemsize );
+            break;
+
+        case SEGY_UNSIGNED_CHAR_1_BYTE:
+            memcpy( buf, &fd->value.u8, elemsize );
+            break;
+
+        case SEGY_IEEE_FLOAT_8_BYTE:
+            memcpy( buf, &fd->value.f64, elemsize );
+            break;
+
+        case SEGY_IEEE_FLOAT_4_BYTE:
+        case SEGY_IBM_FLOAT_4_BYTE:
+            memcpy( buf, &fd->value.f32, elemsize );
+            break;
+
+        case SEGY_STRING_8_BYTE:
+            memcpy( buf, &fd->value.str8, elemsize );
+            break;
+
+        default:
+            return SEGY_INVALID_FIELD_DATATYPE;
+    }
+
+    return SEGY_OK;
+}
+
+int segy_field_forall( segy_datasource* ds,
+                       int traceheader_index,
+                       const segy_entry_definition* offset_map,
+                       int field,
+                       int start,
                        int stop,
                        int step,
                        void* buffer ) {
+    return segy_field_forall64( ds,
+                                traceheader_index,
+                                offset_map,
+                                field,
+                                start,
+                                stop,
+                                step,
+                                buffer );
+}
+
+int segy_field_forall64( segy_datasource* ds,
+                         int traceheader_index,
+                         const segy_entry_definition* offset_map,
+                         int field,
+                         long long start,
+                         long long stop,
+                         long long step,
+                         void* buffer ) {
     int err;
     char* buf = (char*)buffer;
 
@@ -1620,12 +2548,12 @@ int segy_field_forall( segy_datasource* ds,
     err = segy_get_tracefield( header, offset_map, field, &fd );
     if( err != SEGY_OK ) return SEGY_INVALID_ARGS;
 
-    int slicelen = slicelength( start, stop, step );
+    long long slicelen = slicelength64( start, stop, step );
     int datatype = entry_type_to_datatype_map[fd.entry_type];
     int elemsize = segy_formatsize( datatype );
 
     const int zfield = field - 1;
-    for( int i = start; slicelen > 0; i += step, buf += elemsize, --slicelen ) {
+    for( long long i = start; slicelen > 0; i += step, buf += elemsize, --slicelen ) {
         err = segy_read_traceheader_offset(
             ds, i, traceheader_index, zfield, datatype, elemsize, offset_map, header
         );
@@ -1634,60 +2562,679 @@ int segy_field_forall( segy_datasource* ds,
         err = segy_get_tracefield( header, offset_map, field, &fd );
         if( err != 0 ) return err;
 
-        switch( entry_type_to_datatype_map[fd.entry_type] ) {
-            case SEGY_SIGNED_INTEGER_8_BYTE:
-                memcpy( buf, &fd.value.i64, elemsize );
-                break;
+        err = copy_field_value( &fd, elemsize, buf );
+        if( err != SEGY_OK ) return err;
+    }
 
-            case SEGY_SIGNED_INTEGER_4_BYTE:
-                memcpy( buf, &fd.value.i32, elemsize );
-                break;
+    return SEGY_OK;
+}
 
-            case SEGY_SIGNED_SHORT_2_BYTE:
-                memcpy( buf, &fd.value.i16, elemsize );
-                break;
+int segy_read_all_traceheaders( segy_datasource* ds,
+                                segy_header_column* columns,
+                                int ncolumns ) {
+    if( ncolumns < 0 ) return SEGY_INVALID_ARGS;
+    if( ncolumns == 0 ) return SEGY_OK;
 
-            case SEGY_SIGNED_CHAR_1_BYTE:
-                memcpy( buf, &fd.value.i8, elemsize );
-                break;
+    const long long tracecount = ds->metadata.tracecount;
+    const int headers = ds->metadata.traceheader_count;
+    if( tracecount <= 0 ) return SEGY_OK;
 
-            case SEGY_UNSIGNED_INTEGER_8_BYTE:
-                memcpy( buf, &fd.value.u64, elemsize );
-                break;
+    int* elemsizes = malloc( 2 * ncolumns * sizeof( int ) );
+    if( !elemsizes ) return SEGY_MEMORY_ERROR;
+    int* datatypes = elemsizes + ncolumns;
 
-            case SEGY_UNSIGNED_INTEGER_4_BYTE:
-                memcpy( buf, &fd.value.u32, elemsize );
-                break;
+    // check every column up front with a zero-init'd header, like forall
+    char header[ SEGY_TRACE_HEADER_SIZE ] = { 0 };
+    for( int c = 0; c < ncolumns; ++c ) {
+        segy_field_data fd;
+        const segy_header_column* col = columns + c;
+        int err = segy_get_tracefield( header, col->offset_map, col->field, &fd );
+        if( err != SEGY_OK
+         || col->traceheader_index < 0
+         || col->traceheader_index >= headers ) {
+            free( elemsizes );
+            return SEGY_INVALID_ARGS;
+        }
 
-            case SEGY_UNSIGNED_SHORT_2_BYTE:
-                memcpy( buf, &fd.value.u16, elemsize );
-                break;
+        datatypes[ c ] = entry_type_to_datatype_map[ fd.entry_type ];
+        elemsizes[ c ] = segy_formatsize( datatypes[ c ] );
+    }
 
-            case SEGY_UNSIGNED_CHAR_1_BYTE:
-                memcpy( buf, &fd.value.u8, elemsize );
-                break;
+    /*
+     * Read the headers of many traces with a single request, unless the
+     * traces are so large that reading only the headers is cheaper. The
+     * trace data in between is thrown away.
+     */
+    const long long hsize = (long long)SEGY_TRACE_HEADER_SIZE * headers;
+    const long long stride = hsize + ds->metadata.trace_bsize;
+    long long batch = 1;
+    if( ds->minimize_requests_number
+     && ds->metadata.trace_bsize <= SEGY_COALESCE_MAX_GAP ) {
+        batch = SEGY_COALESCE_MAX_SPAN / stride;
+        if( batch < 1 ) batch = 1;
+        if( batch > tracecount ) batch = tracecount;
+    }
 
-            case SEGY_IEEE_FLOAT_8_BYTE:
-                memcpy( buf, &fd.value.f64, elemsize );
-                break;
+    char* chunk = malloc( (batch - 1) * stride + hsize );
+    if( !chunk ) {
+        free( elemsizes );
+        return SEGY_MEMORY_ERROR;
+    }
 
-            case SEGY_IEEE_FLOAT_4_BYTE:
-            case SEGY_IBM_FLOAT_4_BYTE:
-                memcpy( buf, &fd.value.f32, elemsize );
-                break;
+    int err = SEGY_OK;
+    for( long long t0 = 0; err == SEGY_OK && t0 < tracecount; t0 += batch ) {
+        const int n = (int)( tracecount - t0 < batch ? tracecount - t0 : batch );
+        const long long pos = traceheader_offset( ds, t0, 0, 0 );
+        err = read_at( ds, pos, chunk, (n - 1) * stride + hsize );
+
+        for( int i = 0; err == SEGY_OK && i < n; ++i ) {
+            for( int c = 0; err == SEGY_OK && c < ncolumns; ++c ) {
+                const segy_header_column* col = columns + c;
+                const int zfield = col->field - 1;
+                const int elemsize = elemsizes[ c ];
+                const char* src = chunk
+                                + i * stride
+                                + col->traceheader_index * SEGY_TRACE_HEADER_SIZE;
+
+                memcpy( header + zfield, src + zfield, elemsize );
+                err = decode_traceheader_field( ds,
+                                                col->offset_map,
+                                                zfield,
+                                                datatypes[ c ],
+                                                header );
+                if( err != SEGY_OK ) break;
+
+                segy_field_data fd;
+                err = segy_get_tracefield( header, col->offset_map, col->field, &fd );
+                if( err != SEGY_OK ) break;
+
+                char* dst = (char*)col->buf + ( t0 + i ) * elemsize;
+                err = copy_field_value( &fd, elemsize, dst );
+            }
+        }
+    }
 
-            case SEGY_STRING_8_BYTE:
-                memcpy( buf, &fd.value.str8, elemsize );
+    free( chunk );
+    free( elemsizes );
+    return err;
+}
+
+static uint64_t hash_key( const long long* key, int nkeys ) {
+    uint64_t hash = 0x9e3779b97f4a7c15ULL;
+    for( int i = 0; i < nkeys; ++i ) {
+        /* the splitmix64 finalizer, which spreads sequential keys well */
+        uint64_t x = hash ^ (uint64_t)key[ i ];
+        x = ( x ^ ( x >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+        x = ( x ^ ( x >> 27 ) ) * 0x94d049bb133111ebULL;
+        hash = x ^ ( x >> 31 );
+    }
+    return hash;
+}
+
+/*
+ * Insert the groups into a fresh, empty table of tablesize slots. The slots
+ * hold the group number + 1, and 0 for empty.
+ */
+static void rehash_groups( long long* table,
+                           long long tablesize,
+                           const long long* keys,
+                           int nkeys,
+                           const long long* first,
+                           long long groups ) {
+    const uint64_t mask = (uint64_t)tablesize - 1;
+    for( long long g = 0; g < groups; ++g ) {
+        uint64_t slot = hash_key( keys + first[ g ] * nkeys, nkeys ) & mask;
+        while( table[ slot ] ) slot = ( slot + 1 ) & mask;
+        table[ slot ] = g + 1;
+    }
+}
+
+int segy_group_traces( const long long* keys,
+                       int nkeys,
+                       long long traces,
+                       long long* offsets,
+                       long long* index,
+                       long long* groups ) {
+    if( nkeys < 1 || traces < 0 ) return SEGY_INVALID_ARGS;
+
+    /*
+     * The group of every trace is found with an open-addressing hash table
+     * with linear probing, keyed on the trace's key. The table grows with the
+     * number of groups, not the number of traces, so files with few, large
+     * groups use little memory.
+     */
+    long long tablesize = 1024;
+    long long capacity = 1024;
+    long long ngroups = 0;
+    long long* table = calloc( tablesize, sizeof( long long ) );
+    long long* first = malloc( capacity * sizeof( long long ) );
+    long long* groupof = malloc( ( traces ? traces : 1 ) * sizeof( long long ) );
+
+    int err = SEGY_OK;
+    if( !table || !first || !groupof ) {
+        err = SEGY_MEMORY_ERROR;
+        goto cleanup;
+    }
+
+    const size_t keysize = nkeys * sizeof( long long );
+    for( long long i = 0; i < traces; ++i ) {
+        const long long* key = keys + i * nkeys;
+        const uint64_t mask = (uint64_t)tablesize - 1;
+        uint64_t slot = hash_key( key, nkeys ) & mask;
+
+        long long g = -1;
+        while( table[ slot ] ) {
+            const long long candidate = table[ slot ] - 1;
+            if( memcmp( keys + first[ candidate ] * nkeys, key, keysize ) == 0 ) {
+                g = candidate;
                 break;
+            }
+            slot = ( slot + 1 ) & mask;
+        }
 
-            default:
-                return SEGY_INVALID_FIELD_DATATYPE;
+        if( g >= 0 ) {
+            groupof[ i ] = g;
+            continue;
+        }
+
+        /* a new group, numbered in the order of its first trace */
+        if( ngroups == capacity ) {
+            capacity *= 2;
+            long long* tmp = realloc( first, capacity * sizeof( long long ) );
+            if( !tmp ) {
+                err = SEGY_MEMORY_ERROR;
+                goto cleanup;
+            }
+            first = tmp;
+        }
+
+        g = ngroups++;
+        first[ g ] = i;
+        groupof[ i ] = g;
+        table[ slot ] = g + 1;
+
+        /* keep the load factor below 1/2 */
+        if( ngroups * 2 > tablesize ) {
+            free( table );
+            tablesize *= 2;
+            table = calloc( tablesize, sizeof( long long ) );
+            if( !table ) {
+                err = SEGY_MEMORY_ERROR;
+                goto cleanup;
+            }
+            rehash_groups( table, tablesize, keys, nkeys, first, ngroups );
+        }
+    }
+
+    /* count the group sizes, then scatter the traces in a stable order */
+    memset( offsets, 0, ( ngroups + 1 ) * sizeof( long long ) );
+    for( long long i = 0; i < traces; ++i )
+        ++offsets[ groupof[ i ] + 1 ];
+
+    for( long long g = 0; g < ngroups; ++g )
+        offsets[ g + 1 ] += offsets[ g ];
+
+    memcpy( first, offsets, ngroups * sizeof( long long ) );
+    for( long long i = 0; i < traces; ++i )
+        index[ first[ groupof[ i ] ]++ ] = i;
+
+    *groups = ngroups;
+
+cleanup:
+    free( table );
+    free( first );
+    free( groupof );
+    return err;
+}
+
+#define SEGY_RADIX_BITS 11
+#define SEGY_RADIX_SIZE ( 1 << SEGY_RADIX_BITS )
+
+/*
+ * Stable LSD radix sort of the (key, val) pairs by key, with tmpkeys and
+ * tmpvals as scratch space of n elements. The histograms of all digits are
+ * counted in a single pass, and the passes over digits that are equal for
+ * all keys are skipped.
+ */
+static int radix_sort_pairs( uint64_t* keys,
+                             long long* vals,
+                             uint64_t* tmpkeys,
+                             long long* tmpvals,
+                             long long n ) {
+    enum { passes = ( 64 + SEGY_RADIX_BITS - 1 ) / SEGY_RADIX_BITS };
+    const uint64_t mask = SEGY_RADIX_SIZE - 1;
+    if( n < 2 ) return SEGY_OK;
+
+    long long* counts = calloc( passes * SEGY_RADIX_SIZE, sizeof( long long ) );
+    if( !counts ) return SEGY_MEMORY_ERROR;
+
+    for( long long i = 0; i < n; ++i ) {
+        for( int p = 0; p < passes; ++p ) {
+            const uint64_t digit = ( keys[ i ] >> ( p * SEGY_RADIX_BITS ) ) & mask;
+            ++counts[ p * SEGY_RADIX_SIZE + digit ];
+        }
+    }
+
+    uint64_t* srckeys = keys;
+    long long* srcvals = vals;
+    uint64_t* dstkeys = tmpkeys;
+    long long* dstvals = tmpvals;
+
+    for( int p = 0; p < passes; ++p ) {
+        long long* count = counts + p * SEGY_RADIX_SIZE;
+        const int shift = p * SEGY_RADIX_BITS;
+
+        const uint64_t digit0 = ( srckeys[ 0 ] >> shift ) & mask;
+        if( count[ digit0 ] == n ) continue;
+
+        long long sum = 0;
+        for( int d = 0; d < SEGY_RADIX_SIZE; ++d ) {
+            const long long c = count[ d ];
+            count[ d ] = sum;
+            sum += c;
+        }
+
+        for( long long i = 0; i < n; ++i ) {
+            const uint64_t digit = ( srckeys[ i ] >> shift ) & mask;
+            const long long pos = count[ digit ]++;
+            dstkeys[ pos ] = srckeys[ i ];
+            dstvals[ pos ] = srcvals[ i ];
+        }
+
+        uint64_t* tk = srckeys; srckeys = dstkeys; dstkeys = tk;
+        long long* tv = srcvals; srcvals = dstvals; dstvals = tv;
+    }
+
+    if( srckeys != keys ) {
+        memcpy( keys, srckeys, n * sizeof( uint64_t ) );
+        memcpy( vals, srcvals, n * sizeof( long long ) );
+    }
+
+    free( counts );
+    return SEGY_OK;
+}
+
+int segy_sort_permutation( const long long* keys,
+                           int nkeys,
+                           const int* descending,
+                           long long traces,
+                           long long* perm ) {
+    if( nkeys < 1 || traces < 0 ) return SEGY_INVALID_ARGS;
+
+    for( long long i = 0; i < traces; ++i )
+        perm[ i ] = i;
+
+    if( traces < 2 ) return SEGY_OK;
+
+    uint64_t* ukeys = malloc( 2 * traces * sizeof( uint64_t ) );
+    long long* tmp = malloc( traces * sizeof( long long ) );
+    if( !ukeys || !tmp ) {
+        free( ukeys );
+        free( tmp );
+        return SEGY_MEMORY_ERROR;
+    }
+
+    /*
+     * Sort by the least significant word first, which the stable sorts by
+     * the more significant words preserve. Flipping the sign bit orders
+     * signed keys as unsigned, and complementing reverses the order.
+     */
+    int err = SEGY_OK;
+    for( int k = nkeys - 1; k >= 0 && err == SEGY_OK; --k ) {
+        const uint64_t flip = ( 1ULL << 63 )
+                            ^ ( descending && descending[ k ] ? ~0ULL : 0 );
+
+        for( long long i = 0; i < traces; ++i )
+            ukeys[ i ] = (uint64_t)keys[ perm[ i ] * nkeys + k ] ^ flip;
+
+        err = radix_sort_pairs( ukeys, perm, ukeys + traces, tmp, traces );
+    }
+
+    free( ukeys );
+    free( tmp );
+    return err;
+}
+
+/*
+ * The int64 sort key of a header word, in the format segy_field_forall writes
+ * it, such that the order of the keys is the order of the values
+ */
+static int field_sort_key( int datatype, const char* src, long long* out ) {
+    int8_t i8; int16_t i16; int32_t i32; int64_t i64;
+    uint8_t u8; uint16_t u16; uint32_t u32; uint64_t u64;
+    float f32; double f64;
+
+    switch( datatype ) {
+        case SEGY_SIGNED_CHAR_1_BYTE:
+            memcpy( &i8, src, 1 );  *out = i8;  return SEGY_OK;
+        case SEGY_SIGNED_SHORT_2_BYTE:
+            memcpy( &i16, src, 2 ); *out = i16; return SEGY_OK;
+        case SEGY_SIGNED_INTEGER_4_BYTE:
+            memcpy( &i32, src, 4 ); *out = i32; return SEGY_OK;
+        case SEGY_SIGNED_INTEGER_8_BYTE:
+            memcpy( &i64, src, 8 ); *out = i64; return SEGY_OK;
+        case SEGY_UNSIGNED_CHAR_1_BYTE:
+            memcpy( &u8, src, 1 );  *out = u8;  return SEGY_OK;
+        case SEGY_UNSIGNED_SHORT_2_BYTE:
+            memcpy( &u16, src, 2 ); *out = u16; return SEGY_OK;
+        case SEGY_UNSIGNED_INTEGER_4_BYTE:
+            memcpy( &u32, src, 4 ); *out = u32; return SEGY_OK;
+
+        case SEGY_UNSIGNED_INTEGER_8_BYTE:
+            /* shift the range down, so that the signed order is kept */
+            memcpy( &u64, src, 8 );
+            *out = (long long)( u64 ^ ( 1ULL << 63 ) );
+            return SEGY_OK;
+
+        case SEGY_IBM_FLOAT_4_BYTE:
+        case SEGY_IEEE_FLOAT_4_BYTE:
+            memcpy( &f32, src, 4 );
+            f64 = f32;
+            break;
+
+        case SEGY_IEEE_FLOAT_8_BYTE:
+            memcpy( &f64, src, 8 );
+            break;
+
+        case SEGY_STRING_8_BYTE:
+            /* compare the strings byte by byte, as a big-endian number */
+            u64 = 0;
+            for( int i = 0; i < 8; ++i )
+                u64 = ( u64 << 8 ) | (uint8_t)src[ i ];
+            *out = (long long)( u64 ^ ( 1ULL << 63 ) );
+            return SEGY_OK;
+
+        default:
+            return SEGY_INVALID_FIELD_DATATYPE;
+    }
+
+    /*
+     * Positive floats order like their bits, and negative floats in reverse,
+     * so flip the magnitude of the negatives. -0.0 sorts with 0.0.
+     */
+    if( f64 == 0.0 ) f64 = 0.0;
+    memcpy( &i64, &f64, 8 );
+    *out = i64 < 0 ? (long long)( (uint64_t)i64 ^ 0x7fffffffffffffffULL )
+                   : i64;
+    return SEGY_OK;
+}
+
+int segy_sort_traces( segy_datasource* ds,
+                      int traceheader_index,
+                      const segy_entry_definition* offset_map,
+                      const int* fields,
+                      const int* descending,
+                      int nkeys,
+                      long long* perm ) {
+    if( nkeys < 1 ) return SEGY_INVALID_ARGS;
+
+    const long long traces = ds->metadata.tracecount;
+    if( traces < 1 ) return SEGY_OK;
+
+    segy_header_column* columns = calloc( nkeys, sizeof( segy_header_column ) );
+    int* datatypes = calloc( nkeys, sizeof( int ) );
+    int* elemsizes = calloc( nkeys, sizeof( int ) );
+    long long* keys = malloc( traces * nkeys * sizeof( long long ) );
+
+    int err = SEGY_OK;
+    if( !columns || !datatypes || !elemsizes || !keys ) {
+        err = SEGY_MEMORY_ERROR;
+        goto cleanup;
+    }
+
+    char header[ SEGY_TRACE_HEADER_SIZE ] = { 0 };
+    for( int k = 0; k < nkeys; ++k ) {
+        segy_field_data fd;
+        err = segy_get_tracefield( header, offset_map, fields[ k ], &fd );
+        if( err != SEGY_OK ) {
+            err = SEGY_INVALID_ARGS;
+            goto cleanup;
+        }
+
+        datatypes[ k ] = entry_type_to_datatype_map[ fd.entry_type ];
+        elemsizes[ k ] = segy_formatsize( datatypes[ k ] );
+        if( elemsizes[ k ] < 0 ) {
+            err = SEGY_INVALID_FIELD_DATATYPE;
+            goto cleanup;
+        }
+
+        columns[ k ].traceheader_index = traceheader_index;
+        columns[ k ].offset_map = offset_map;
+        columns[ k ].field = fields[ k ];
+        columns[ k ].buf = malloc( traces * elemsizes[ k ] );
+        if( !columns[ k ].buf ) {
+            err = SEGY_MEMORY_ERROR;
+            goto cleanup;
+        }
+    }
+
+    /* all the key words are read in a single pass over the file */
+    err = segy_read_all_traceheaders( ds, columns, nkeys );
+    if( err != SEGY_OK ) goto cleanup;
+
+    for( int k = 0; k < nkeys && err == SEGY_OK; ++k ) {
+        const char* src = columns[ k ].buf;
+        for( long long i = 0; i < traces && err == SEGY_OK; ++i ) {
+            err = field_sort_key( datatypes[ k ],
+                                  src + i * elemsizes[ k ],
+                                  keys + i * nkeys + k );
         }
+
+        free( columns[ k ].buf );
+        columns[ k ].buf = NULL;
+    }
+
+    if( err == SEGY_OK )
+        err = segy_sort_permutation( keys, nkeys, descending, traces, perm );
+
+cleanup:
+    if( columns ) {
+        for( int k = 0; k < nkeys; ++k )
+            free( columns[ k ].buf );
+    }
+    free( columns );
+    free( datatypes );
+    free( elemsizes );
+    free( keys );
+    return err;
+}
+
+/* Convert the native value at offset in the header buf to on-disk, in-place */
+static int encode_traceheader_field( const segy_datasource* ds,
+                                     const segy_entry_definition* mapping,
+                                     int offset,
+                                     int datatype,
+                                     char* buf ) {
+    if( ds->metadata.encoding == SEGY_EBCDIC && datatype == SEGY_STRING_8_BYTE ) {
+        encode( buf + offset, buf + offset, a2e, 8 );
+    }
+
+    if( ds->metadata.endianness == SEGY_LSB ) {
+        int next = bswap_header_field_value( mapping, buf, offset );
+        if( next < 0 ) return SEGY_INVALID_FIELD_DATATYPE;
     }
+    return SEGY_OK;
+}
+
+/*
+ * Write the on-disk representation of the value at src, in the format
+ * segy_field_forall outputs, to dst
+ */
+static int encode_field_value( const segy_datasource* ds,
+                               const segy_entry_definition* mapping,
+                               int field,
+                               int datatype,
+                               int elemsize,
+                               const char* src,
+                               char* dst ) {
+    segy_field_data fd;
+    memset( &fd, 0, sizeof( fd ) );
+    fd.entry_type = mapping[ field - 1 ].entry_type;
+    memcpy( &fd.value, src, elemsize );
+
+    char header[ SEGY_TRACE_HEADER_SIZE ] = { 0 };
+    int err = segy_set_tracefield( header, mapping, field, fd );
+    if( err != SEGY_OK ) return err;
+
+    err = encode_traceheader_field( ds, mapping, field - 1, datatype, header );
+    if( err != SEGY_OK ) return err;
 
+    memcpy( dst, header + field - 1, elemsize );
     return SEGY_OK;
 }
 
+/*
+ * Write the values of the header word for the traces in the slice. valstride
+ * is the distance between the values in buf, and 0 broadcasts a single value
+ * to all traces.
+ */
+static int write_field_values( segy_datasource* ds,
+                               int traceheader_index,
+                               const segy_entry_definition* offset_map,
+                               int field,
+                               long long start,
+                               long long stop,
+                               long long step,
+                               const char* buf,
+                               int valstride ) {
+    if( !ds->writable ) return SEGY_READONLY;
+    if( step == 0 ) return SEGY_INVALID_ARGS;
+    if( traceheader_index < 0
+     || traceheader_index >= ds->metadata.traceheader_count )
+        return SEGY_INVALID_ARGS;
+
+    // do a dummy-read of a zero-init'd buffer to check args, like forall
+    segy_field_data fd;
+    char header[ SEGY_TRACE_HEADER_SIZE ] = { 0 };
+    int err = segy_get_tracefield( header, offset_map, field, &fd );
+    if( err != SEGY_OK ) return SEGY_INVALID_ARGS;
+
+    const int datatype = entry_type_to_datatype_map[ fd.entry_type ];
+    const int elemsize = segy_formatsize( datatype );
+    if( valstride ) valstride = elemsize;
+
+    long long slicelen = slicelength64( start, stop, step );
+    if( slicelen <= 0 ) return SEGY_OK;
+
+    /* a broadcast value only needs encoding once */
+    char value[ 8 ];
+    if( !valstride ) {
+        err = encode_field_value( ds, offset_map, field, datatype, elemsize,
+                                  buf, value );
+        if( err != SEGY_OK ) return err;
+    }
+
+    const long long stride = traceheader_offset( ds, 1, 0, 0 )
+                           - traceheader_offset( ds, 0, 0, 0 );
+    const long long distance = ( step < 0 ? -step : step ) * stride;
+
+    /*
+     * With a small distance between the header words, read-modify-write
+     * blocks of many traces. Otherwise, and for memory datasources where small
+     * writes are cheap, write the header words one by one.
+     */
+    long long batch = 1;
+    if( ds->minimize_requests_number
+     && !ds->memory_speedup
+     && distance - elemsize <= SEGY_COALESCE_MAX_GAP ) {
+        batch = SEGY_COALESCE_MAX_SPAN / distance;
+        if( batch < 1 ) batch = 1;
+        if( batch > slicelen ) batch = slicelen;
+    }
+
+    /*
+     * The blocks are read before they are written, so only coalesce the
+     * header words of traces already in the file. Newly created files are
+     * written past the end, one header word at a time
+     */
+    long long fsize = 0;
+    char* chunk = NULL;
+    if( batch > 1 ) {
+        if( ds->size( ds, &fsize ) != 0 ) return SEGY_DS_READ_ERROR;
+        chunk = malloc( ( batch - 1 ) * distance + elemsize );
+        if( !chunk ) return SEGY_MEMORY_ERROR;
+    }
+
+    const int zfield = field - 1;
+    long long traceno = start;
+    while( slicelen > 0 && err == SEGY_OK ) {
+        const long long n = slicelen < batch ? slicelen : batch;
+
+        /* the block spans from the lowest to the highest trace */
+        const long long last = traceno + ( n - 1 ) * step;
+        const long long low = step > 0 ? traceno : last;
+        const long long pos = traceheader_offset( ds, low,
+                                                  traceheader_index,
+                                                  zfield );
+        const long long size = ( n - 1 ) * distance + elemsize;
+
+        if( chunk && pos + size <= fsize ) {
+            err = read_at( ds, pos, chunk, size );
+            for( long long i = 0; err == SEGY_OK && i < n; ++i ) {
+                const long long t = traceno + i * step;
+                char* dst = chunk + ( t - low ) * stride;
+                if( valstride )
+                    err = encode_field_value( ds, offset_map, field, datatype,
+                                              elemsize, buf + i * valstride,
+                                              dst );
+                else
+                    memcpy( dst, value, elemsize );
+            }
+
+            if( err == SEGY_OK )
+                err = write_at( ds, pos, chunk, size );
+        } else {
+            for( long long i = 0; err == SEGY_OK && i < n; ++i ) {
+                char* dst = valstride ? header : value;
+                if( valstride )
+                    err = encode_field_value( ds, offset_map, field, datatype,
+                                              elemsize, buf + i * valstride,
+                                              dst );
+                if( err != SEGY_OK ) break;
+
+                const long long t = traceno + i * step;
+                err = write_at( ds,
+                                traceheader_offset( ds, t,
+                                                    traceheader_index,
+                                                    zfield ),
+                                dst,
+                                elemsize );
+            }
+        }
+
+        traceno += n * step;
+        buf += n * valstride;
+        slicelen -= n;
+    }
+
+    free( chunk );
+    return err;
+}
+
+int segy_write_field_forall( segy_datasource* ds,
+                             int traceheader_index,
+                             const segy_entry_definition* offset_map,
+                             int field,
+                             long long start,
+                             long long stop,
+                             long long step,
+                             const void* buf ) {
+    return write_field_values( ds, traceheader_index, offset_map, field,
+                               start, stop, step, (const char*)buf, 1 );
+}
+
+int segy_write_field_broadcast( segy_datasource* ds,
+                                int traceheader_index,
+                                const segy_entry_definition* offset_map,
+                                int field,
+                                long long start,
+                                long long stop,
+                                long long step,
+                                const void* buf ) {
+    return write_field_values( ds, traceheader_index, offset_map, field,
+                               start, stop, step, (const char*)buf, 0 );
+}
+
 static int bswap_bin( const segy_datasource* ds, char* xs ) {
     if( ds->metadata.endianness != SEGY_LSB ) return SEGY_OK;
 
@@ -1704,11 +3251,8 @@ static int bswap_bin( const segy_datasource* ds, char* xs ) {
 int segy_binheader( segy_datasource* ds, char* buf ) {
     if( !ds ) return SEGY_INVALID_ARGS;
 
-    int err = ds->seek( ds, SEGY_TEXT_HEADER_SIZE, SEEK_SET );
-    if( err != 0 ) return SEGY_DS_SEEK_ERROR;
-
-    err = ds->read( ds, buf, SEGY_BINARY_HEADER_SIZE );
-    if( err != 0 ) return SEGY_DS_READ_ERROR;
+    int err = read_at( ds, SEGY_TEXT_HEADER_SIZE, buf, SEGY_BINARY_HEADER_SIZE );
+    if( err != SEGY_OK ) return err;
 
     /* successful and file was lsb - swap to present as msb */
     return bswap_bin( ds, buf );
@@ -1721,11 +3265,8 @@ int segy_write_binheader( segy_datasource* ds, const char* buf ) {
     memcpy( swapped, buf, SEGY_BINARY_HEADER_SIZE );
     bswap_bin( ds, swapped );
 
-    int err = ds->seek( ds, SEGY_TEXT_HEADER_SIZE, SEEK_SET );
-    if( err != 0 ) return SEGY_DS_SEEK_ERROR;
-
-    err = ds->write( ds, swapped, sizeof( swapped ) );
-    if( err != 0 ) return SEGY_DS_WRITE_ERROR;
+    int err = write_at( ds, SEGY_TEXT_HEADER_SIZE, swapped, sizeof( swapped ) );
+    if( err != SEGY_OK ) return err;
 
     return SEGY_OK;
 }
@@ -1898,12 +3439,10 @@ int segy_traceheader_names(
     memcpy( names[0], "SEG00000", 8 );
 
     for( int i = 1; i < ds->metadata.traceheader_count; ++i ) {
-        int err = seek_traceheader_offset( ds, 0, i, 232 );
+        const long long pos = traceheader_offset( ds, 0, i, 232 );
+        const int err = read_at( ds, pos, names[i], 8 );
         if( err != SEGY_OK ) return err;
 
-        err = ds->read( ds, names[i], 8 );
-        if( err != 0 ) return SEGY_DS_READ_ERROR;
-
         // it is unclear how to interpret specification "May be ASCII or EBCDIC
         // text." For proprietary headers we don't know the expected name, so
         // have to assume that header name is encoded the same way as main text
@@ -1965,12 +3504,18 @@ int segy_read_traceheader( segy_datasource* ds,
                            int traceheader_no,
                            const segy_entry_definition* mapping,
                            char* buf ) {
+    return segy_read_traceheader64( ds, traceno, traceheader_no, mapping, buf );
+}
 
-    int err = seek_traceheader_offset( ds, traceno, traceheader_no, 0 );
-    if( err != SEGY_OK ) return err;
+int segy_read_traceheader64( segy_datasource* ds,
+                             long long traceno,
+                             int traceheader_no,
+                             const segy_entry_definition* mapping,
+                             char* buf ) {
 
-    err = ds->read( ds, buf, SEGY_TRACE_HEADER_SIZE );
-    if( err != 0 ) return SEGY_DS_READ_ERROR;
+    const long long pos = traceheader_offset( ds, traceno, traceheader_no, 0 );
+    const int err = read_at( ds, pos, buf, SEGY_TRACE_HEADER_SIZE );
+    if( err != SEGY_OK ) return err;
 
     swap_th_encoding( ds, mapping, e2a, buf );
     return bswap_th( ds, mapping, buf );
@@ -1991,20 +3536,23 @@ int segy_write_traceheader( segy_datasource* ds,
                             int traceheader_no,
                             const segy_entry_definition* mapping,
                             const char* buf ) {
-    if( !ds->writable ) return SEGY_READONLY;
+    return segy_write_traceheader64( ds, traceno, traceheader_no, mapping, buf );
+}
 
-    int err = seek_traceheader_offset( ds, traceno, traceheader_no, 0 );
-    if( err != SEGY_OK ) return err;
+int segy_write_traceheader64( segy_datasource* ds,
+                              long long traceno,
+                              int traceheader_no,
+                              const segy_entry_definition* mapping,
+                              const char* buf ) {
+    if( !ds->writable ) return SEGY_READONLY;
 
     char swapped[SEGY_TRACE_HEADER_SIZE];
     memcpy( swapped, buf, SEGY_TRACE_HEADER_SIZE );
     swap_th_encoding( ds, mapping, a2e, swapped );
     bswap_th( ds, mapping, swapped );
 
-    err = ds->write( ds, swapped, SEGY_TRACE_HEADER_SIZE );
-    if( err != 0 ) return SEGY_DS_WRITE_ERROR;
-
-    return SEGY_OK;
+    const long long pos = traceheader_offset( ds, traceno, traceheader_no, 0 );
+    return write_at( ds, pos, swapped, SEGY_TRACE_HEADER_SIZE );
 }
 
 int segy_write_standard_traceheader(
@@ -2025,6 +3573,18 @@ int segy_write_standard_traceheader(
  */
 int segy_traces( segy_datasource* ds,
                  int* traces ) {
+    long long count;
+    const int err = segy_traces64( ds, &count );
+    if( err != SEGY_OK ) return err;
+
+    if( count > INT_MAX ) return SEGY_TOO_MANY_TRACES;
+
+    *traces = (int)count;
+    return SEGY_OK;
+}
+
+int segy_traces64( segy_datasource* ds,
+                   long long* traces ) {
 
     long long trace0 = ds->metadata.trace0;
 
@@ -2043,9 +3603,7 @@ int segy_traces( segy_datasource* ds,
     if( size % trace_bsize != 0 )
         return SEGY_TRACE_SIZE_MISMATCH;
 
-    assert( size / trace_bsize <= (long long)INT_MAX );
-
-    *traces = (int) (size / trace_bsize);
+    *traces = size / trace_bsize;
     return SEGY_OK;
 }
 
@@ -2639,14 +4197,288 @@ int segy_crossline_indices( segy_datasource* ds,
     return SEGY_INVALID_SORTING;
 }
 
-static inline int subtr_seek( segy_datasource* ds,
-                              int traceno,
-                              int start,
-                              int stop,
-                              int elemsize ) {
+/*
+ * Geometry inference by probing. The (inline, crossline, offset) key of a
+ * regular cube is a function of the trace number, so rather than walking the
+ * headers until the offset wraps or the line number repeats, find the
+ * boundaries with a galloping binary search, and check the resulting grid
+ * against a handful of traces spread over the file.
+ *
+ * If the grid does not hold up, the probe gives up with SEGY_NOTFOUND and the
+ * linear scans are used instead, so that irregular files get exactly the same
+ * geometry (or errors) as before.
+ */
+#define SEGY_GEOMETRY_PROBES 16
+
+enum { KEY_IL = 0, KEY_XL = 1, KEY_OF = 2 };
+
+struct geometry_probe {
+    segy_datasource* ds;
+    const segy_entry_definition* map;
+    int fields[ 3 ];
+};
+
+static int probe_key( const struct geometry_probe* g, int traceno, long* key ) {
+    char header[ SEGY_TRACE_HEADER_SIZE ];
+    int err = segy_read_standard_traceheader( g->ds, traceno, header );
+    if( err != SEGY_OK ) return err;
+
+    for( int i = 0; i < 3; ++i ) {
+        segy_field_data fd;
+        err = segy_get_tracefield( header, g->map, g->fields[ i ], &fd );
+        if( err != SEGY_OK ) return err;
+        err = field_data_to_axis( &fd, key + i );
+        if( err != SEGY_OK ) return err;
+    }
+
+    return SEGY_OK;
+}
+
+static bool same_key( const long* a, const long* b, int component ) {
+    if( component >= 0 ) return a[ component ] == b[ component ];
+    return a[ KEY_IL ] == b[ KEY_IL ] && a[ KEY_XL ] == b[ KEY_XL ];
+}
+
+/*
+ * Find the first position p in [1, n) where the key of trace p * stride
+ * differs from ref, in the component (or in inline/crossline if component is
+ * negative), assuming that the key does not change back. Writes n if there is
+ * no such position.
+ */
+static int first_change( const struct geometry_probe* g,
+                         int stride,
+                         int n,
+                         const long* ref,
+                         int component,
+                         int* out ) {
+    long key[ 3 ];
+    long long lo = 0, hi = 1;
+
+    while( hi < n ) {
+        int err = probe_key( g, (int)( hi * stride ), key );
+        if( err != SEGY_OK ) return err;
+        if( !same_key( key, ref, component ) ) break;
+        lo = hi;
+        hi *= 2;
+    }
+    if( hi > n ) hi = n;
+
+    while( hi - lo > 1 ) {
+        const long long mid = lo + ( hi - lo ) / 2;
+        int err = probe_key( g, (int)( mid * stride ), key );
+        if( err != SEGY_OK ) return err;
+        if( same_key( key, ref, component ) ) lo = mid;
+        else hi = mid;
+    }
+
+    *out = (int)hi;
+    return SEGY_OK;
+}
+
+struct grid {
+    int traces;
+    int offsets;
+    int fast;           /* key component that moves fastest, after offset */
+    int slow;
+    int fast_count;
+    int slow_count;
+};
+
+/* The trace numbers that define the key of traceno in a regular grid */
+static void grid_origins( const struct grid* grid, int traceno, int* origins ) {
+    const int offset   = traceno % grid->offsets;
+    const int position = traceno / grid->offsets;
+    const int line     = position / grid->fast_count;
+    const int fast     = position % grid->fast_count;
+    origins[ KEY_OF ] = offset;
+    origins[ grid->fast ] = fast * grid->offsets;
+    origins[ grid->slow ] = line * grid->fast_count * grid->offsets;
+}
+
+static int infer_geometry_probe( const struct geometry_probe* g,
+                                 int traces,
+                                 struct grid* grid ) {
+    long key0[ 3 ], key[ 3 ], origin[ 3 ];
+
+    int err = probe_key( g, 0, key0 );
+    if( err != SEGY_OK ) return err;
+
+    grid->traces = traces;
+    err = first_change( g, 1, traces, key0, -1, &grid->offsets );
+    if( err != SEGY_OK ) return err;
+
+    const int offsets = grid->offsets;
+    if( offsets == traces || traces % offsets != 0 ) return SEGY_NOTFOUND;
+
+    /*
+     * segy_sorting stops at the first trace with the same offset as trace 0,
+     * so the offsets of the first gather must be distinct from it. Pre-stack
+     * files have few offsets, so just read them.
+     */
+    for( int i = 1; i < offsets; ++i ) {
+        err = probe_key( g, i, key );
+        if( err != SEGY_OK ) return err;
+        if( !same_key( key, key0, -1 ) ) return SEGY_NOTFOUND;
+        if( key[ KEY_OF ] == key0[ KEY_OF ] ) return SEGY_NOTFOUND;
+    }
+
+    /* the offset wraps where inline or crossline moves, like segy_sorting */
+    err = probe_key( g, offsets, key );
+    if( err != SEGY_OK ) return err;
+    if( key[ KEY_OF ] != key0[ KEY_OF ] ) return SEGY_NOTFOUND;
+
+    if( key[ KEY_IL ] == key0[ KEY_IL ] && key[ KEY_XL ] != key0[ KEY_XL ] ) {
+        grid->fast = KEY_XL;
+        grid->slow = KEY_IL;
+    } else if( key[ KEY_XL ] == key0[ KEY_XL ] && key[ KEY_IL ] != key0[ KEY_IL ] ) {
+        grid->fast = KEY_IL;
+        grid->slow = KEY_XL;
+    } else {
+        return SEGY_NOTFOUND;
+    }
+
+    const int positions = traces / offsets;
+    err = first_change( g, offsets, positions, key0, grid->slow,
+                        &grid->fast_count );
+    if( err != SEGY_OK ) return err;
+
+    const int fast_count = grid->fast_count;
+    if( positions % fast_count != 0 ) return SEGY_NOTFOUND;
+    grid->slow_count = positions / fast_count;
+
+    /* the next line must start over, like count_lines */
+    if( fast_count < positions ) {
+        err = probe_key( g, fast_count * offsets, key );
+        if( err != SEGY_OK ) return err;
+        if( key[ grid->fast ] != key0[ grid->fast ] ) return SEGY_NOTFOUND;
+        if( key[ KEY_OF ] != key0[ KEY_OF ] ) return SEGY_NOTFOUND;
+    }
+
+    for( int i = 0; i <= SEGY_GEOMETRY_PROBES; ++i ) {
+        const int traceno = (int)( (long long)( traces - 1 ) * i
+                                   / SEGY_GEOMETRY_PROBES );
+        err = probe_key( g, traceno, key );
+        if( err != SEGY_OK ) return err;
+
+        int origins[ 3 ];
+        grid_origins( grid, traceno, origins );
+        for( int k = 0; k < 3; ++k ) {
+            err = probe_key( g, origins[ k ], origin );
+            if( err != SEGY_OK ) return err;
+            if( key[ k ] != origin[ k ] ) return SEGY_NOTFOUND;
+        }
+    }
+
+    return SEGY_OK;
+}
+
+/* Check every trace against the grid, with one pass over the headers */
+static int verify_geometry( const struct geometry_probe* g,
+                            const struct grid* grid ) {
+    const int traces = grid->traces;
+    int* keys = malloc( 3 * (size_t)traces * sizeof( int ) );
+    if( !keys ) return SEGY_MEMORY_ERROR;
+
+    segy_header_column columns[ 3 ];
+    for( int k = 0; k < 3; ++k ) {
+        columns[ k ].traceheader_index = 0;
+        columns[ k ].offset_map = g->map;
+        columns[ k ].field = g->fields[ k ];
+        columns[ k ].buf = keys + (size_t)k * traces;
+    }
+
+    int err = segy_read_all_traceheaders( g->ds, columns, 3 );
+    for( int t = 0; err == SEGY_OK && t < traces; ++t ) {
+        int origins[ 3 ];
+        grid_origins( grid, t, origins );
+        for( int k = 0; k < 3; ++k ) {
+            const int* column = keys + (size_t)k * traces;
+            if( column[ t ] != column[ origins[ k ] ] ) err = SEGY_NOTFOUND;
+        }
+    }
+
+    free( keys );
+    return err;
+}
+
+int segy_infer_geometry( segy_datasource* ds,
+                         int il,
+                         int xl,
+                         int offset,
+                         int strict,
+                         segy_geometry* out ) {
+    int traces;
+    int err = segy_traces( ds, &traces );
+    if( err != SEGY_OK ) return err;
+
+    struct geometry_probe g;
+    g.ds = ds;
+    g.map = ds->traceheader_mapping_standard.offset_to_entry_definition;
+    g.fields[ KEY_IL ] = il;
+    g.fields[ KEY_XL ] = xl;
+    g.fields[ KEY_OF ] = offset;
+
+    struct grid grid;
+    err = SEGY_NOTFOUND;
+    if( traces > 1 )
+        err = infer_geometry_probe( &g, traces, &grid );
+
+    if( err == SEGY_OK && strict )
+        err = verify_geometry( &g, &grid );
+
+    if( err == SEGY_OK ) {
+        const bool ilsorted = grid.slow == KEY_IL;
+        out->sorting = ilsorted ? SEGY_INLINE_SORTING : SEGY_CROSSLINE_SORTING;
+        out->offset_count = grid.offsets;
+        out->iline_count = ilsorted ? grid.slow_count : grid.fast_count;
+        out->xline_count = ilsorted ? grid.fast_count : grid.slow_count;
+        return SEGY_OK;
+    }
+
+    if( err != SEGY_NOTFOUND ) return err;
+
+    /* not a regular grid, or too small to bother - scan it */
+    segy_geometry geo;
+    err = segy_sorting( ds, il, xl, offset, &geo.sorting );
+    if( err != SEGY_OK ) return err;
+
+    err = segy_offsets( ds, il, xl, traces, &geo.offset_count );
+    if( err != SEGY_OK ) return err;
+
+    err = segy_lines_count( ds, il, xl, geo.sorting, geo.offset_count,
+                            &geo.iline_count, &geo.xline_count );
+    if( err != SEGY_OK ) return err;
+
+    if( strict ) {
+        grid.traces = traces;
+        grid.offsets = geo.offset_count;
+        const bool ilsorted = geo.sorting == SEGY_INLINE_SORTING;
+        grid.slow = ilsorted ? KEY_IL : KEY_XL;
+        grid.fast = ilsorted ? KEY_XL : KEY_IL;
+        grid.slow_count = ilsorted ? geo.iline_count : geo.xline_count;
+        grid.fast_count = ilsorted ? geo.xline_count : geo.iline_count;
+
+        const long long cells = (long long)grid.offsets
+                              * grid.slow_count
+                              * grid.fast_count;
+        if( cells != traces ) return SEGY_NOTFOUND;
+
+        err = verify_geometry( &g, &grid );
+        if( err != SEGY_OK ) return err;
+    }
+
+    *out = geo;
+    return SEGY_OK;
+}
+
+static inline long long subtr_offset( const segy_datasource* ds,
+                                     long long traceno,
+                                     int start,
+                                     int stop,
+                                     int elemsize ) {
     /*
      * Optimistically assume that indices are correct by the time they're given
-     * to subtr_seek.
+     * to subtr_offset.
      */
     const int min = start < stop ? start : stop + 1;
     assert( start >= 0 );
@@ -2654,7 +4486,7 @@ static inline int subtr_seek( segy_datasource* ds,
     assert( abs(stop - start) * elemsize <= ds->metadata.trace_bsize );
 
     // skip the traceheaders and skip everything before min
-    return seek_traceheader_offset(
+    return traceheader_offset(
         ds,
         traceno,
         ds->metadata.traceheader_count,
@@ -2678,8 +4510,14 @@ static int reverse( void* buf, int elems, int elemsize ) {
 int segy_readtrace( segy_datasource* ds,
                     int traceno,
                     void* buf ) {
+    return segy_readtrace64( ds, traceno, buf );
+}
+
+int segy_readtrace64( segy_datasource* ds,
+                      long long traceno,
+                      void* buf ) {
     const int stop = ds->metadata.trace_bsize / ds->metadata.elemsize;
-    return segy_readsubtr( ds, traceno, 0, stop, 1, buf, NULL );
+    return segy_readsubtr64( ds, traceno, 0, stop, 1, buf, NULL );
 }
 
 static int bswap64vec( void* vec, long long len ) {
@@ -2732,32 +4570,38 @@ static int bswap16vec( void* vec, long long len ) {
     return SEGY_OK;
 }
 
-int segy_readsubtr( segy_datasource* ds,
-                    int traceno,
-                    int start,
-                    int stop,
-                    int step,
-                    void* buf,
-                    void* rangebuf ) {
+static void bswapvec( void* vec, long long len, int elemsize ) {
+    switch( elemsize ) {
+        case 8: bswap64vec( vec, len ); break;
+        case 4: bswap32vec( vec, len ); break;
+        case 3: bswap24vec( vec, len ); break;
+        case 2: bswap16vec( vec, len ); break;
+        default:                        break;
+    }
+}
+
+/*
+ * Read the subtrace [start, stop) as-is from disk, i.e. without any
+ * byteswapping. The caller is responsible for putting the samples in the right
+ * byte order.
+ */
+static int readsubtr_raw( segy_datasource* ds,
+                          long long traceno,
+                          int start,
+                          int stop,
+                          int step,
+                          void* buf,
+                          void* rangebuf ) {
 
     const int elems = abs( stop - start );
     const int elemsize = ds->metadata.elemsize;
-    bool lsb = ds->metadata.endianness == SEGY_LSB;
 
-    int err = subtr_seek( ds, traceno, start, stop, elemsize );
-    if( err != SEGY_OK ) return err;
+    const long long pos = subtr_offset( ds, traceno, start, stop, elemsize );
 
     // most common case: step == abs(1), reading contiguously
     if( step == 1 || step == -1 ) {
-        err = ds->read( ds, buf, elemsize * elems );
-        if( err != 0 ) return SEGY_DS_READ_ERROR;
-
-        if( lsb ) {
-            if( elemsize == 8 ) bswap64vec( buf, elems );
-            if( elemsize == 4 ) bswap32vec( buf, elems );
-            if( elemsize == 3 ) bswap24vec( buf, elems );
-            if( elemsize == 2 ) bswap16vec( buf, elems );
-        }
+        const int err = read_at( ds, pos, buf, elemsize * elems );
+        if( err != SEGY_OK ) return err;
 
         if( step == -1 ) reverse( buf, elems, elemsize );
 
@@ -2775,31 +4619,19 @@ int segy_readsubtr( segy_datasource* ds,
     if( !ds->minimize_requests_number ) {
         if( ds->memory_speedup ) {
             // separate "memory" path is used for better performance
-            memfile* mp = (memfile*)ds->stream;
-            const char* cur = (char*)mp->cur + elemsize * defstart;
+            const memfile* mp = (memfile*)ds->stream;
+            const char* cur = (char*)mp->addr + pos + elemsize * defstart;
             for( int i = 0; i < slicelen; cur += step, dst += elemsize, ++i ) {
                 memcpy( dst, cur, elemsize );
             }
         } else {
-            err = ds->seek( ds, elemsize * defstart, SEEK_CUR );
-            if( err != 0 ) return SEGY_DS_SEEK_ERROR;
-
-            for( int i = 0; i < slicelen; dst += elemsize, ++i ) {
-                err = ds->read( ds, dst, elemsize );
-                if( err != 0 ) return SEGY_DS_READ_ERROR;
-
-                err = ds->seek( ds, step - elemsize, SEEK_CUR );
-                if( err != 0 ) return SEGY_DS_SEEK_ERROR;
+            long long cur = pos + elemsize * defstart;
+            for( int i = 0; i < slicelen; cur += step, dst += elemsize, ++i ) {
+                const int err = read_at( ds, cur, dst, elemsize );
+                if( err != SEGY_OK ) return err;
             }
         }
 
-        if( lsb ) {
-            if( elemsize == 8 ) bswap64vec( buf, slicelen );
-            if( elemsize == 4 ) bswap32vec( buf, slicelen );
-            if( elemsize == 3 ) bswap24vec( buf, slicelen );
-            if( elemsize == 2 ) bswap16vec( buf, slicelen );
-        }
-
         return SEGY_OK;
     }
 
@@ -2815,36 +4647,89 @@ int segy_readsubtr( segy_datasource* ds,
     void* tracebuf = rangebuf ? rangebuf : malloc( elems * elemsize );
     if (!tracebuf) return SEGY_MEMORY_ERROR;
 
-    err = ds->read( ds, tracebuf, elemsize * elems );
-    if( err != 0 ) {
+    const int err = read_at( ds, pos, tracebuf, elemsize * elems );
+    if( err != SEGY_OK ) {
         if( !rangebuf ) free( tracebuf );
-        return SEGY_DS_READ_ERROR;
+        return err;
     }
 
     const char* cur = (char*)tracebuf + elemsize * defstart;
     for( int i = 0; i < slicelen; cur += step, ++i, dst += elemsize )
         memcpy( dst, cur, elemsize );
 
-    if( lsb ) {
-        if( elemsize == 8 ) bswap64vec( buf, slicelen );
-        if( elemsize == 4 ) bswap32vec( buf, slicelen );
-        if( elemsize == 3 ) bswap24vec( buf, slicelen );
-        if( elemsize == 2 ) bswap16vec( buf, slicelen );
+    if( !rangebuf ) free( tracebuf );
+    return SEGY_OK;
+}
+
+static int subtr_length( int start, int stop, int step ) {
+    if( step == 1 || step == -1 ) return abs( stop - start );
+    return slicelength( start, stop, step );
+}
+
+int segy_readsubtr( segy_datasource* ds,
+                    int traceno,
+                    int start,
+                    int stop,
+                    int step,
+                    void* buf,
+                    void* rangebuf ) {
+    return segy_readsubtr64( ds, traceno, start, stop, step, buf, rangebuf );
+}
+
+int segy_readsubtr64( segy_datasource* ds,
+                      long long traceno,
+                      int start,
+                      int stop,
+                      int step,
+                      void* buf,
+                      void* rangebuf ) {
+
+    const int err = readsubtr_raw( ds, traceno, start, stop, step,
+                                   buf, rangebuf );
+    if( err != SEGY_OK ) return err;
+
+    if( ds->metadata.endianness == SEGY_LSB ) {
+        const int elems = subtr_length( start, stop, step );
+        bswapvec( buf, elems, ds->metadata.elemsize );
     }
 
-    if( !rangebuf ) free( tracebuf );
     return SEGY_OK;
 }
 
 int segy_writetrace( segy_datasource* ds,
                      int traceno,
                      const void* buf ) {
+    return segy_writetrace64( ds, traceno, buf );
+}
+
+int segy_writetrace64( segy_datasource* ds,
+                       long long traceno,
+                       const void* buf ) {
 
     const int stop = ds->metadata.trace_bsize / ds->metadata.elemsize;
-    return segy_writesubtr( ds, traceno, 0, stop, 1, buf, NULL );
+    return segy_writesubtr64( ds, traceno, 0, stop, 1, buf, NULL );
 }
 
 
+int segy_trace_ptr( segy_datasource* ds,
+                    int traceno,
+                    void** out ) {
+    if( !ds->memory_speedup ) return SEGY_MMAP_INVALID;
+
+    const memfile* mp = (memfile*)ds->stream;
+    const long long pos = traceheader_offset( ds,
+                                              traceno,
+                                              ds->metadata.traceheader_count,
+                                              0 );
+    const long long end = pos + ds->metadata.trace_bsize;
+
+    if( traceno < 0 || end > (long long)mp->size )
+        return SEGY_FREAD_ERROR;
+
+    *out = mp->addr + pos;
+    return SEGY_OK;
+}
+
 int segy_writesubtr( segy_datasource* ds,
                      int traceno,
                      int start,
@@ -2852,6 +4737,16 @@ int segy_writesubtr( segy_datasource* ds,
                      int step,
                      const void* buf,
                      void* rangebuf ) {
+    return segy_writesubtr64( ds, traceno, start, stop, step, buf, rangebuf );
+}
+
+int segy_writesubtr64( segy_datasource* ds,
+                       long long traceno,
+                       int start,
+                       int stop,
+                       int step,
+                       const void* buf,
+                       void* rangebuf ) {
 
     if( !ds->writable ) return SEGY_READONLY;
 
@@ -2860,9 +4755,8 @@ int segy_writesubtr( segy_datasource* ds,
     const size_t range = elems * elemsize;
     bool lsb = ds->metadata.endianness == SEGY_LSB;
 
-    int err = subtr_seek( ds, traceno, start, stop, elemsize );
-    if( err != SEGY_OK ) return err;
-
+    const long long pos = subtr_offset( ds, traceno, start, stop, elemsize );
+    int err;
 
     if( step == 1 && !lsb ) {
         /*
@@ -2872,10 +4766,7 @@ int segy_writesubtr( segy_datasource* ds,
          * be handled by the stride-aware code path
          */
 
-        err = ds->write( ds, buf, range );
-        if( err != 0 ) return SEGY_DS_WRITE_ERROR;
-
-        return SEGY_OK;
+        return write_at( ds, pos, buf, range );
     }
 
     /*
@@ -2893,10 +4784,9 @@ int segy_writesubtr( segy_datasource* ds,
         if( elemsize == 3 ) bswap24vec( tracebuf, elems );
         if( elemsize == 2 ) bswap16vec( tracebuf, elems );
 
-        err = ds->write( ds, tracebuf, range );
+        err = write_at( ds, pos, tracebuf, range );
         if( !rangebuf ) free( tracebuf );
-        if( err != 0 ) return SEGY_DS_WRITE_ERROR;
-        return SEGY_OK;
+        return err;
     }
 
     // step != 1, i.e. do strided reads
@@ -2920,36 +4810,31 @@ int segy_writesubtr( segy_datasource* ds,
     const char* src = (const char*)buf;
 
     if( !ds->minimize_requests_number ) {
-        err = ds->seek( ds, elemsize * defstart, SEEK_CUR );
-        if( err != 0 ) return SEGY_DS_SEEK_ERROR;
+        const long long first = pos + elemsize * defstart;
 
         if( !lsb ) {
             // separate "memory" path is used for better performance
             if( ds->memory_speedup ) {
-                memfile* mp = (memfile*)ds->stream;
-                char* cur = (char*)mp->cur;
+                const memfile* mp = (memfile*)ds->stream;
+                char* cur = (char*)mp->addr + first;
                 for( ; slicelen > 0; cur += step, src += elemsize, --slicelen ) {
                     memcpy( cur, src, elemsize );
                 }
             } else {
-                for( ; slicelen > 0; src += elemsize, --slicelen ) {
-                    err = ds->write( ds, src, elemsize );
-                    if( err != 0 ) return SEGY_DS_WRITE_ERROR;
-
-                    err = ds->seek( ds, step - elemsize, SEEK_CUR );
-                    if( err != 0 ) return SEGY_DS_SEEK_ERROR;
+                long long cur = first;
+                for( ; slicelen > 0; cur += step, src += elemsize, --slicelen ) {
+                    err = write_at( ds, cur, src, elemsize );
+                    if( err != SEGY_OK ) return err;
                 }
             }
         } else {
             char temp[8]; // allocate largest possible
-            for( ; slicelen > 0; src += elemsize, --slicelen ) {
+            long long cur = first;
+            for( ; slicelen > 0; cur += step, src += elemsize, --slicelen ) {
                 bswap_mem( temp, src );
 
-                err = ds->write( ds, temp, elemsize );
-                if( err != 0 ) return SEGY_DS_WRITE_ERROR;
-
-                err = ds->seek( ds, step - elemsize, SEEK_CUR );
-                if( err != 0 ) return SEGY_DS_SEEK_ERROR;
+                err = write_at( ds, cur, temp, elemsize );
+                if( err != SEGY_OK ) return err;
             }
         }
 
@@ -2960,16 +4845,10 @@ int segy_writesubtr( segy_datasource* ds,
     if( !tracebuf ) return SEGY_MEMORY_ERROR;
 
     // like in readsubtr, read a larger chunk and then step through that
-    err = ds->read( ds, tracebuf, range );
-    if( err != 0 ) {
-        free( tracebuf );
-        return SEGY_DS_READ_ERROR;
-    }
-    /* rewind, because ds->read advances stream position */
-    err = ds->seek( ds, -(long long)range, SEEK_CUR );
-    if( err != 0 ) {
+    err = read_at( ds, pos, tracebuf, range );
+    if( err != SEGY_OK ) {
         if( !rangebuf ) free( tracebuf );
-        return SEGY_DS_SEEK_ERROR;
+        return err;
     }
 
     char* cur = (char*)tracebuf + elemsize * defstart;
@@ -2983,12 +4862,9 @@ int segy_writesubtr( segy_datasource* ds,
         }
     }
 
-    err = ds->write( ds, tracebuf, range );
+    err = write_at( ds, pos, tracebuf, range );
     if( !rangebuf ) free( tracebuf );
-
-    if( err != 0 ) return SEGY_DS_WRITE_ERROR;
-
-    return SEGY_OK;
+    return err;
 }
 
 /*
@@ -3015,128 +4891,3243 @@ int segy_writesubtr( segy_datasource* ds,
 
 static int segy_native_byteswap(int format, long long size, void* buf) {
 
-    if (HOST_LSB) {
-        const int elemsize = segy_formatsize( format );
-
-        switch (elemsize) {
-            case 8: bswap64vec(buf, size); break;
-            case 4: bswap32vec(buf, size); break;
-            case 3: bswap24vec(buf, size); break;
-            case 2: bswap16vec(buf, size); break;
-            default:                       break;
-        }
-    }
+    if (HOST_LSB) bswapvec( buf, size, segy_formatsize( format ) );
 
     return SEGY_OK;
 }
 
-int segy_to_native( int format,
-                    long long size,
-                    void* buf ) {
+/*
+ * IBM <-> IEEE conversion kernels. The byteswap (when the host is LSB) is
+ * fused with the conversion, so that the buffer is only traversed once. All
+ * kernels must be bit-exact with ibm_native and native_ibm - they implement
+ * the same integer arithmetic, only with the table lookups replaced by
+ * compares and shifts:
+ *
+ * ibm_native: mt[ix] is 1 << shift, where shift is the number of leading
+ * zeros in the top three bits of the mantissa (capped at 3), and it[ix] is
+ * 0x20c00000 + (shift << 22).
+ *
+ * native_ibm: (mt[ix] * mantissa) >> 3 is mantissa >> ((2 - ix) & 3).
+ *
+ * The vectorized kernels handle whole registers, and leave the tail to the
+ * scalar kernel.
+ */
+static void ibm_native_scalar( char* buf, long long size ) {
+    for( long long i = 0; i < size; ++i ) {
+        char* xs = buf + i * sizeof( uint32_t );
+        if( HOST_LSB ) bswap32_mem( xs, xs );
+        ibm_native( xs );
+    }
+}
 
-    const int elemsize = segy_formatsize( format );
-    if( elemsize < 0 ) return SEGY_INVALID_ARGS;
+static void native_ibm_scalar( char* buf, long long size ) {
+    for( long long i = 0; i < size; ++i ) {
+        char* xs = buf + i * sizeof( uint32_t );
+        native_ibm( xs );
+        if( HOST_LSB ) bswap32_mem( xs, xs );
+    }
+}
 
-    segy_native_byteswap( format, size, buf );
+#ifdef SEGY_HAVE_SSE2
+static inline __m128i bswap32_sse2( __m128i x ) {
+    x = _mm_or_si128( _mm_slli_epi16( x, 8 ), _mm_srli_epi16( x, 8 ) );
+    x = _mm_shufflelo_epi16( x, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+    return _mm_shufflehi_epi16( x, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+}
+
+static void ibm_native_sse2( char* buf, long long size ) {
+    const __m128i mantmask = _mm_set1_epi32( 0x00ffffff );
+    const __m128i expmask  = _mm_set1_epi32( 0x7f000000 );
+    const __m128i absmask  = _mm_set1_epi32( 0x7fffffff );
+    const __m128i signmask = _mm_set1_epi32( (int)0x80000000 );
+    const __m128i itstep   = _mm_set1_epi32( 0x00400000 );
+    const __m128i itbase   = _mm_set1_epi32( 0x20c00000 );
+    const __m128i lim1     = _mm_set1_epi32( 0x00800000 );
+    const __m128i lim2     = _mm_set1_epi32( 0x00400000 );
+    const __m128i lim3     = _mm_set1_epi32( 0x00200000 );
+    const __m128i ieeemax  = _mm_set1_epi32( IEEEMAX );
+    const __m128i iemaxib  = _mm_set1_epi32( IEMAXIB );
+    const __m128i ieminib  = _mm_set1_epi32( IEMINIB );
+
+    const long long vecs = size / 4;
+    for( long long i = 0; i < vecs; ++i ) {
+        __m128i* xs = (__m128i*)( buf + i * sizeof( __m128i ) );
+        __m128i u = _mm_loadu_si128( xs );
+        if( HOST_LSB ) u = bswap32_sse2( u );
+
+        const __m128i mant = _mm_and_si128( u, mantmask );
+        const __m128i c1 = _mm_cmplt_epi32( mant, lim1 );
+        const __m128i c2 = _mm_cmplt_epi32( mant, lim2 );
+        const __m128i c3 = _mm_cmplt_epi32( mant, lim3 );
+
+        /* no variable shift in sse2, so double the mantissa once per mask */
+        __m128i m = mant;
+        m = _mm_add_epi32( m, _mm_and_si128( m, c1 ) );
+        m = _mm_add_epi32( m, _mm_and_si128( m, c2 ) );
+        m = _mm_add_epi32( m, _mm_and_si128( m, c3 ) );
+
+        __m128i it = itbase;
+        it = _mm_add_epi32( it, _mm_and_si128( itstep, c1 ) );
+        it = _mm_add_epi32( it, _mm_and_si128( itstep, c2 ) );
+        it = _mm_add_epi32( it, _mm_and_si128( itstep, c3 ) );
+
+        const __m128i iexp = _mm_slli_epi32(
+            _mm_sub_epi32( _mm_and_si128( u, expmask ), it ), 1 );
+        __m128i r = _mm_add_epi32( m, iexp );
+
+        const __m128i inabs = _mm_and_si128( u, absmask );
+        const __m128i big = _mm_cmpgt_epi32( inabs, iemaxib );
+        r = _mm_or_si128( _mm_andnot_si128( big, r ),
+                          _mm_and_si128( big, ieeemax ) );
+        r = _mm_or_si128( r, _mm_and_si128( u, signmask ) );
+        r = _mm_andnot_si128( _mm_cmplt_epi32( inabs, ieminib ), r );
+        _mm_storeu_si128( xs, r );
+    }
 
-    char* dst = (char*)buf;
-    if( format == SEGY_IBM_FLOAT_4_BYTE ) {
-        for( long long i = 0; i < size; ++i )
-            ibm_native( dst + i * elemsize );
+    ibm_native_scalar( buf + vecs * sizeof( __m128i ), size - vecs * 4 );
+}
+
+static void native_ibm_sse2( char* buf, long long size ) {
+    const __m128i ixmask   = _mm_set1_epi32( 0x01800000 );
+    const __m128i expmask  = _mm_set1_epi32( 0x7e000000 );
+    const __m128i mantmask = _mm_set1_epi32( 0x007fffff );
+    const __m128i absmask  = _mm_set1_epi32( 0x7fffffff );
+    const __m128i signmask = _mm_set1_epi32( (int)0x80000000 );
+    const __m128i ix1      = _mm_set1_epi32( 0x00800000 );
+    const __m128i ix2      = _mm_set1_epi32( 0x01000000 );
+    const __m128i itbase   = _mm_set1_epi32( 0x21200000 );
+    const __m128i it1      = _mm_set1_epi32( 0x00200000 );
+    const __m128i it2      = _mm_set1_epi32( 0x00600000 );
+    const __m128i it3      = _mm_set1_epi32( 0x00f00000 );
+    const __m128i zero     = _mm_setzero_si128();
+
+    const long long vecs = size / 4;
+    for( long long i = 0; i < vecs; ++i ) {
+        __m128i* xs = (__m128i*)( buf + i * sizeof( __m128i ) );
+        const __m128i u = _mm_loadu_si128( xs );
+
+        const __m128i ix = _mm_and_si128( u, ixmask );
+        const __m128i e0 = _mm_cmpeq_epi32( ix, zero );
+        const __m128i e1 = _mm_cmpeq_epi32( ix, ix1 );
+        const __m128i e2 = _mm_cmpeq_epi32( ix, ix2 );
+        const __m128i e3 = _mm_cmpeq_epi32( ix, ixmask );
+
+        __m128i it = itbase;
+        it = _mm_add_epi32( it, _mm_and_si128( e1, it1 ) );
+        it = _mm_add_epi32( it, _mm_and_si128( e2, it2 ) );
+        it = _mm_add_epi32( it, _mm_and_si128( e3, it3 ) );
+        const __m128i iexp = _mm_add_epi32(
+            _mm_srli_epi32( _mm_and_si128( u, expmask ), 1 ), it );
+
+        const __m128i m = _mm_and_si128( u, mantmask );
+        __m128i manthi = _mm_and_si128( e0, _mm_srli_epi32( m, 2 ) );
+        manthi = _mm_or_si128( manthi, _mm_and_si128( e1, _mm_srli_epi32( m, 1 ) ) );
+        manthi = _mm_or_si128( manthi, _mm_and_si128( e2, m ) );
+        manthi = _mm_or_si128( manthi, _mm_and_si128( e3, _mm_srli_epi32( m, 3 ) ) );
+
+        __m128i r = _mm_or_si128( _mm_add_epi32( manthi, iexp ),
+                                  _mm_and_si128( u, signmask ) );
+        const __m128i iszero =
+            _mm_cmpeq_epi32( _mm_and_si128( u, absmask ), zero );
+        r = _mm_andnot_si128( iszero, r );
+        if( HOST_LSB ) r = bswap32_sse2( r );
+        _mm_storeu_si128( xs, r );
     }
 
-    return SEGY_OK;
+    native_ibm_scalar( buf + vecs * sizeof( __m128i ), size - vecs * 4 );
 }
+#endif // SEGY_HAVE_SSE2
 
-int segy_from_native( int format,
-                      long long size,
-                      void* buf ) {
-
-    const int elemsize = segy_formatsize( format );
-    if( elemsize < 0 ) return SEGY_INVALID_ARGS;
+#ifdef SEGY_HAVE_AVX2
+__attribute__((target("avx2")))
+static inline __m256i bswap32_avx2( __m256i x ) {
+    const __m256i shuf = _mm256_setr_epi8(
+         3,  2,  1,  0,  7,  6,  5,  4, 11, 10,  9,  8, 15, 14, 13, 12,
+         3,  2,  1,  0,  7,  6,  5,  4, 11, 10,  9,  8, 15, 14, 13, 12
+    );
+    return _mm256_shuffle_epi8( x, shuf );
+}
+
+__attribute__((target("avx2")))
+static void ibm_native_avx2( char* buf, long long size ) {
+    const __m256i mantmask = _mm256_set1_epi32( 0x00ffffff );
+    const __m256i expmask  = _mm256_set1_epi32( 0x7f000000 );
+    const __m256i absmask  = _mm256_set1_epi32( 0x7fffffff );
+    const __m256i signmask = _mm256_set1_epi32( (int)0x80000000 );
+    const __m256i itbase   = _mm256_set1_epi32( 0x20c00000 );
+    const __m256i lim1     = _mm256_set1_epi32( 0x00800000 );
+    const __m256i lim2     = _mm256_set1_epi32( 0x00400000 );
+    const __m256i lim3     = _mm256_set1_epi32( 0x00200000 );
+    const __m256i ieeemax  = _mm256_set1_epi32( IEEEMAX );
+    const __m256i iemaxib  = _mm256_set1_epi32( IEMAXIB );
+    const __m256i ieminib  = _mm256_set1_epi32( IEMINIB );
+    const __m256i zero     = _mm256_setzero_si256();
+
+    const long long vecs = size / 8;
+    for( long long i = 0; i < vecs; ++i ) {
+        __m256i* xs = (__m256i*)( buf + i * sizeof( __m256i ) );
+        __m256i u = _mm256_loadu_si256( xs );
+        if( HOST_LSB ) u = bswap32_avx2( u );
+
+        const __m256i mant = _mm256_and_si256( u, mantmask );
+        /* compares are all-ones masks, so the negated sum is the shift */
+        __m256i shift = _mm256_cmpgt_epi32( lim1, mant );
+        shift = _mm256_add_epi32( shift, _mm256_cmpgt_epi32( lim2, mant ) );
+        shift = _mm256_add_epi32( shift, _mm256_cmpgt_epi32( lim3, mant ) );
+        shift = _mm256_sub_epi32( zero, shift );
+
+        const __m256i m  = _mm256_sllv_epi32( mant, shift );
+        const __m256i it = _mm256_add_epi32( itbase,
+                                             _mm256_slli_epi32( shift, 22 ) );
+        const __m256i iexp = _mm256_slli_epi32(
+            _mm256_sub_epi32( _mm256_and_si256( u, expmask ), it ), 1 );
+        __m256i r = _mm256_add_epi32( m, iexp );
+
+        const __m256i inabs = _mm256_and_si256( u, absmask );
+        const __m256i big = _mm256_cmpgt_epi32( inabs, iemaxib );
+        r = _mm256_blendv_epi8( r, ieeemax, big );
+        r = _mm256_or_si256( r, _mm256_and_si256( u, signmask ) );
+        r = _mm256_andnot_si256( _mm256_cmpgt_epi32( ieminib, inabs ), r );
+        _mm256_storeu_si256( xs, r );
+    }
 
-    char* dst = (char*)buf;
-    if( format == SEGY_IBM_FLOAT_4_BYTE ) {
-        for( long long i = 0; i < size; ++i )
-            native_ibm( dst + i * elemsize );
+    ibm_native_scalar( buf + vecs * sizeof( __m256i ), size - vecs * 8 );
+}
+
+__attribute__((target("avx2")))
+static void native_ibm_avx2( char* buf, long long size ) {
+    const __m256i expmask  = _mm256_set1_epi32( 0x7e000000 );
+    const __m256i mantmask = _mm256_set1_epi32( 0x007fffff );
+    const __m256i absmask  = _mm256_set1_epi32( 0x7fffffff );
+    const __m256i signmask = _mm256_set1_epi32( (int)0x80000000 );
+    const __m256i two      = _mm256_set1_epi32( 2 );
+    const __m256i three    = _mm256_set1_epi32( 3 );
+    const __m256i zero     = _mm256_setzero_si256();
+    const __m256i ittab    = _mm256_setr_epi32( 0x21200000, 0x21400000,
+                                                0x21800000, 0x22100000,
+                                                0x21200000, 0x21400000,
+                                                0x21800000, 0x22100000 );
+
+    const long long vecs = size / 8;
+    for( long long i = 0; i < vecs; ++i ) {
+        __m256i* xs = (__m256i*)( buf + i * sizeof( __m256i ) );
+        const __m256i u = _mm256_loadu_si256( xs );
+
+        const __m256i ix = _mm256_and_si256( _mm256_srli_epi32( u, 23 ), three );
+        const __m256i it = _mm256_permutevar8x32_epi32( ittab, ix );
+        const __m256i iexp = _mm256_add_epi32(
+            _mm256_srli_epi32( _mm256_and_si256( u, expmask ), 1 ), it );
+
+        const __m256i shift = _mm256_and_si256( _mm256_sub_epi32( two, ix ),
+                                                three );
+        const __m256i manthi = _mm256_srlv_epi32(
+            _mm256_and_si256( u, mantmask ), shift );
+
+        __m256i r = _mm256_or_si256( _mm256_add_epi32( manthi, iexp ),
+                                     _mm256_and_si256( u, signmask ) );
+        const __m256i iszero =
+            _mm256_cmpeq_epi32( _mm256_and_si256( u, absmask ), zero );
+        r = _mm256_andnot_si256( iszero, r );
+        if( HOST_LSB ) r = bswap32_avx2( r );
+        _mm256_storeu_si256( xs, r );
     }
 
-    return segy_native_byteswap( format, size, buf );
+    native_ibm_scalar( buf + vecs * sizeof( __m256i ), size - vecs * 8 );
+}
+#endif // SEGY_HAVE_AVX2
+
+#ifdef SEGY_HAVE_AVX512
+__attribute__((target("avx512f,avx512bw")))
+static inline __m512i bswap32_avx512( __m512i x ) {
+    const __m512i shuf = _mm512_set4_epi32( 0x0c0d0e0f, 0x08090a0b,
+                                            0x04050607, 0x00010203 );
+    return _mm512_shuffle_epi8( x, shuf );
 }
 
 /*
- * Determine the position of the element `x` in `xs`.
- * Returns -1 if the value cannot be found
+ * The avx512 kernels handle the tail with masked loads and stores, rather
+ * than falling back to the scalar kernel.
  */
-static int index_of( int x,
-                     const int* xs,
-                     int sz ) {
-    for( int i = 0; i < sz; i++ ) {
-        if( xs[i] == x )
-            return i;
+__attribute__((target("avx512f,avx512bw")))
+static void ibm_native_avx512( char* buf, long long size ) {
+    const __m512i mantmask = _mm512_set1_epi32( 0x00ffffff );
+    const __m512i expmask  = _mm512_set1_epi32( 0x7f000000 );
+    const __m512i absmask  = _mm512_set1_epi32( 0x7fffffff );
+    const __m512i signmask = _mm512_set1_epi32( (int)0x80000000 );
+    const __m512i itbase   = _mm512_set1_epi32( 0x20c00000 );
+    const __m512i lim1     = _mm512_set1_epi32( 0x00800000 );
+    const __m512i lim2     = _mm512_set1_epi32( 0x00400000 );
+    const __m512i lim3     = _mm512_set1_epi32( 0x00200000 );
+    const __m512i one      = _mm512_set1_epi32( 1 );
+    const __m512i ieeemax  = _mm512_set1_epi32( IEEEMAX );
+    const __m512i iemaxib  = _mm512_set1_epi32( IEMAXIB );
+    const __m512i ieminib  = _mm512_set1_epi32( IEMINIB );
+
+    for( long long i = 0; i < size; i += 16 ) {
+        const long long left = size - i;
+        const __mmask16 k = left >= 16
+                          ? (__mmask16)0xffff
+                          : (__mmask16)( ( 1u << left ) - 1 );
+        char* xs = buf + i * sizeof( uint32_t );
+        __m512i u = _mm512_maskz_loadu_epi32( k, xs );
+        if( HOST_LSB ) u = bswap32_avx512( u );
+
+        const __m512i mant = _mm512_and_si512( u, mantmask );
+        __m512i shift = _mm512_maskz_mov_epi32(
+            _mm512_cmplt_epi32_mask( mant, lim1 ), one );
+        shift = _mm512_mask_add_epi32( shift,
+            _mm512_cmplt_epi32_mask( mant, lim2 ), shift, one );
+        shift = _mm512_mask_add_epi32( shift,
+            _mm512_cmplt_epi32_mask( mant, lim3 ), shift, one );
+
+        const __m512i m  = _mm512_sllv_epi32( mant, shift );
+        const __m512i it = _mm512_add_epi32( itbase,
+                                             _mm512_slli_epi32( shift, 22 ) );
+        const __m512i iexp = _mm512_slli_epi32(
+            _mm512_sub_epi32( _mm512_and_si512( u, expmask ), it ), 1 );
+        __m512i r = _mm512_add_epi32( m, iexp );
+
+        const __m512i inabs = _mm512_and_si512( u, absmask );
+        r = _mm512_mask_mov_epi32( r,
+            _mm512_cmpgt_epi32_mask( inabs, iemaxib ), ieeemax );
+        r = _mm512_or_si512( r, _mm512_and_si512( u, signmask ) );
+        r = _mm512_maskz_mov_epi32(
+            _mm512_cmpge_epi32_mask( inabs, ieminib ), r );
+        _mm512_mask_storeu_epi32( xs, k, r );
     }
+}
 
-    return -1;
+__attribute__((target("avx512f,avx512bw")))
+static void native_ibm_avx512( char* buf, long long size ) {
+    const __m512i expmask  = _mm512_set1_epi32( 0x7e000000 );
+    const __m512i mantmask = _mm512_set1_epi32( 0x007fffff );
+    const __m512i absmask  = _mm512_set1_epi32( 0x7fffffff );
+    const __m512i signmask = _mm512_set1_epi32( (int)0x80000000 );
+    const __m512i two      = _mm512_set1_epi32( 2 );
+    const __m512i three    = _mm512_set1_epi32( 3 );
+    const __m512i ittab    = _mm512_set4_epi32( 0x22100000, 0x21800000,
+                                                0x21400000, 0x21200000 );
+
+    for( long long i = 0; i < size; i += 16 ) {
+        const long long left = size - i;
+        const __mmask16 k = left >= 16
+                          ? (__mmask16)0xffff
+                          : (__mmask16)( ( 1u << left ) - 1 );
+        char* xs = buf + i * sizeof( uint32_t );
+        const __m512i u = _mm512_maskz_loadu_epi32( k, xs );
+
+        const __m512i ix = _mm512_and_si512( _mm512_srli_epi32( u, 23 ), three );
+        const __m512i it = _mm512_permutexvar_epi32( ix, ittab );
+        const __m512i iexp = _mm512_add_epi32(
+            _mm512_srli_epi32( _mm512_and_si512( u, expmask ), 1 ), it );
+
+        const __m512i shift = _mm512_and_si512( _mm512_sub_epi32( two, ix ),
+                                                three );
+        const __m512i manthi = _mm512_srlv_epi32(
+            _mm512_and_si512( u, mantmask ), shift );
+
+        __m512i r = _mm512_or_si512( _mm512_add_epi32( manthi, iexp ),
+                                     _mm512_and_si512( u, signmask ) );
+        r = _mm512_maskz_mov_epi32(
+            _mm512_test_epi32_mask( u, absmask ), r );
+        if( HOST_LSB ) r = bswap32_avx512( r );
+        _mm512_mask_storeu_epi32( xs, k, r );
+    }
 }
+#endif // SEGY_HAVE_AVX512
+
+#ifdef SEGY_HAVE_NEON
+static inline uint32x4_t bswap32_neon( uint32x4_t x ) {
+    return vreinterpretq_u32_u8( vrev32q_u8( vreinterpretq_u8_u32( x ) ) );
+}
+
+static void ibm_native_neon( char* buf, long long size ) {
+    const uint32x4_t mantmask = vdupq_n_u32( 0x00ffffff );
+    const uint32x4_t expmask  = vdupq_n_u32( 0x7f000000 );
+    const uint32x4_t absmask  = vdupq_n_u32( 0x7fffffff );
+    const uint32x4_t signmask = vdupq_n_u32( 0x80000000 );
+    const uint32x4_t itbase   = vdupq_n_u32( 0x20c00000 );
+    const uint32x4_t lim1     = vdupq_n_u32( 0x00800000 );
+    const uint32x4_t lim2     = vdupq_n_u32( 0x00400000 );
+    const uint32x4_t lim3     = vdupq_n_u32( 0x00200000 );
+    const uint32x4_t one      = vdupq_n_u32( 1 );
+    const uint32x4_t ieeemax  = vdupq_n_u32( IEEEMAX );
+    const uint32x4_t iemaxib  = vdupq_n_u32( IEMAXIB );
+    const uint32x4_t ieminib  = vdupq_n_u32( IEMINIB );
+
+    const long long vecs = size / 4;
+    for( long long i = 0; i < vecs; ++i ) {
+        uint8_t* xs = (uint8_t*)( buf + i * sizeof( uint32x4_t ) );
+        uint32x4_t u = vreinterpretq_u32_u8( vld1q_u8( xs ) );
+        if( HOST_LSB ) u = bswap32_neon( u );
+
+        const uint32x4_t mant = vandq_u32( u, mantmask );
+        uint32x4_t shift = vandq_u32( vcltq_u32( mant, lim1 ), one );
+        shift = vaddq_u32( shift, vandq_u32( vcltq_u32( mant, lim2 ), one ) );
+        shift = vaddq_u32( shift, vandq_u32( vcltq_u32( mant, lim3 ), one ) );
+
+        const uint32x4_t m = vshlq_u32( mant, vreinterpretq_s32_u32( shift ) );
+        const uint32x4_t it = vaddq_u32( itbase, vshlq_n_u32( shift, 22 ) );
+        const uint32x4_t iexp = vshlq_n_u32(
+            vsubq_u32( vandq_u32( u, expmask ), it ), 1 );
+        uint32x4_t r = vaddq_u32( m, iexp );
+
+        const uint32x4_t inabs = vandq_u32( u, absmask );
+        r = vbslq_u32( vcgtq_u32( inabs, iemaxib ), ieeemax, r );
+        r = vorrq_u32( r, vandq_u32( u, signmask ) );
+        r = vbicq_u32( r, vcltq_u32( inabs, ieminib ) );
+        vst1q_u8( xs, vreinterpretq_u8_u32( r ) );
+    }
 
-/*
- * Read the inline or crossline `lineno`. If it's an inline or crossline
- * depends on the parameters. The line has a length of `line_length` traces,
- * `offsets` are the number of offsets in this file, and `buf` must be of
- * (minimum) `line_length*samples_per_trace` size.  Reads every `stride` trace,
- * starting at the trace specified by the *position* of the value `lineno` in
- * `linenos`. If `lineno` isn't present in `linenos`, SEGY_MISSING_LINE_INDEX
+    ibm_native_scalar( buf + vecs * sizeof( uint32x4_t ), size - vecs * 4 );
+}
+
+static void native_ibm_neon( char* buf, long long size ) {
+    const uint32x4_t ixmask   = vdupq_n_u32( 0x01800000 );
+    const uint32x4_t expmask  = vdupq_n_u32( 0x7e000000 );
+    const uint32x4_t mantmask = vdupq_n_u32( 0x007fffff );
+    const uint32x4_t absmask  = vdupq_n_u32( 0x7fffffff );
+    const uint32x4_t signmask = vdupq_n_u32( 0x80000000 );
+    const uint32x4_t ix1      = vdupq_n_u32( 0x00800000 );
+    const uint32x4_t ix2      = vdupq_n_u32( 0x01000000 );
+    const uint32x4_t itbase   = vdupq_n_u32( 0x21200000 );
+    const uint32x4_t it1      = vdupq_n_u32( 0x00200000 );
+    const uint32x4_t it2      = vdupq_n_u32( 0x00600000 );
+    const uint32x4_t it3      = vdupq_n_u32( 0x00f00000 );
+    const uint32x4_t three    = vdupq_n_u32( 3 );
+    const int32x4_t  two      = vdupq_n_s32( 2 );
+
+    const long long vecs = size / 4;
+    for( long long i = 0; i < vecs; ++i ) {
+        uint8_t* xs = (uint8_t*)( buf + i * sizeof( uint32x4_t ) );
+        const uint32x4_t u = vreinterpretq_u32_u8( vld1q_u8( xs ) );
+
+        const uint32x4_t ix = vandq_u32( u, ixmask );
+        uint32x4_t it = itbase;
+        it = vaddq_u32( it, vandq_u32( vceqq_u32( ix, ix1 ), it1 ) );
+        it = vaddq_u32( it, vandq_u32( vceqq_u32( ix, ix2 ), it2 ) );
+        it = vaddq_u32( it, vandq_u32( vceqq_u32( ix, ixmask ), it3 ) );
+        const uint32x4_t iexp = vaddq_u32(
+            vshrq_n_u32( vandq_u32( u, expmask ), 1 ), it );
+
+        /* shift by a negative count is a right shift */
+        const int32x4_t shift = vnegq_s32( vreinterpretq_s32_u32( vandq_u32(
+            vreinterpretq_u32_s32( vsubq_s32(
+                two, vreinterpretq_s32_u32( vshrq_n_u32( ix, 23 ) ) ) ),
+            three ) ) );
+        const uint32x4_t manthi = vshlq_u32( vandq_u32( u, mantmask ), shift );
+
+        uint32x4_t r = vorrq_u32( vaddq_u32( manthi, iexp ),
+                                  vandq_u32( u, signmask ) );
+        r = vandq_u32( r, vtstq_u32( u, absmask ) );
+        if( HOST_LSB ) r = bswap32_neon( r );
+        vst1q_u8( xs, vreinterpretq_u8_u32( r ) );
+    }
+
+    native_ibm_scalar( buf + vecs * sizeof( uint32x4_t ), size - vecs * 4 );
+}
+#endif // SEGY_HAVE_NEON
+
+static int simd_isa = -1;
+
+int segy_simd_supported( int isa ) {
+    switch( isa ) {
+        case SEGY_SIMD_SCALAR:
+            return 1;
+
+#ifdef SEGY_HAVE_SSE2
+        case SEGY_SIMD_SSE2:
+            return 1;
+#endif
+
+#ifdef SEGY_HAVE_AVX2
+        case SEGY_SIMD_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports( "avx2" ) ? 1 : 0;
+#endif
+
+#ifdef SEGY_HAVE_AVX512
+        case SEGY_SIMD_AVX512:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports( "avx512f" )
+                && __builtin_cpu_supports( "avx512bw" );
+#endif
+
+#ifdef SEGY_HAVE_NEON
+        case SEGY_SIMD_NEON:
+            return 1;
+#endif
+
+        default:
+            return 0;
+    }
+}
+
+int segy_simd( void ) {
+    if( simd_isa >= 0 ) return simd_isa;
+
+    static const int preference[] = {
+        SEGY_SIMD_AVX512,
+        SEGY_SIMD_AVX2,
+        SEGY_SIMD_SSE2,
+        SEGY_SIMD_NEON,
+    };
+
+    int isa = SEGY_SIMD_SCALAR;
+    for( size_t i = 0; i < sizeof( preference ) / sizeof( int ); ++i ) {
+        if( segy_simd_supported( preference[ i ] ) ) {
+            isa = preference[ i ];
+            break;
+        }
+    }
+
+    simd_isa = isa;
+    return isa;
+}
+
+int segy_set_simd( int isa ) {
+    if( !segy_simd_supported( isa ) ) return SEGY_INVALID_ARGS;
+    simd_isa = isa;
+    return SEGY_OK;
+}
+
+static void ibm_native_vec( char* buf, long long size ) {
+    switch( segy_simd() ) {
+#ifdef SEGY_HAVE_AVX512
+        case SEGY_SIMD_AVX512: ibm_native_avx512( buf, size ); return;
+#endif
+#ifdef SEGY_HAVE_AVX2
+        case SEGY_SIMD_AVX2: ibm_native_avx2( buf, size ); return;
+#endif
+#ifdef SEGY_HAVE_SSE2
+        case SEGY_SIMD_SSE2: ibm_native_sse2( buf, size ); return;
+#endif
+#ifdef SEGY_HAVE_NEON
+        case SEGY_SIMD_NEON: ibm_native_neon( buf, size ); return;
+#endif
+        default: ibm_native_scalar( buf, size ); return;
+    }
+}
+
+static void native_ibm_vec( char* buf, long long size ) {
+    switch( segy_simd() ) {
+#ifdef SEGY_HAVE_AVX512
+        case SEGY_SIMD_AVX512: native_ibm_avx512( buf, size ); return;
+#endif
+#ifdef SEGY_HAVE_AVX2
+        case SEGY_SIMD_AVX2: native_ibm_avx2( buf, size ); return;
+#endif
+#ifdef SEGY_HAVE_SSE2
+        case SEGY_SIMD_SSE2: native_ibm_sse2( buf, size ); return;
+#endif
+#ifdef SEGY_HAVE_NEON
+        case SEGY_SIMD_NEON: native_ibm_neon( buf, size ); return;
+#endif
+        default: native_ibm_scalar( buf, size ); return;
+    }
+}
+
+int segy_to_native( int format,
+                    long long size,
+                    void* buf ) {
+
+    const int elemsize = segy_formatsize( format );
+    if( elemsize < 0 ) return SEGY_INVALID_ARGS;
+
+    if( format == SEGY_IBM_FLOAT_4_BYTE ) {
+        ibm_native_vec( (char*)buf, size );
+        return SEGY_OK;
+    }
+
+    return segy_native_byteswap( format, size, buf );
+}
+
+int segy_from_native( int format,
+                      long long size,
+                      void* buf ) {
+
+    const int elemsize = segy_formatsize( format );
+    if( elemsize < 0 ) return SEGY_INVALID_ARGS;
+
+    if( format == SEGY_IBM_FLOAT_4_BYTE ) {
+        native_ibm_vec( (char*)buf, size );
+        return SEGY_OK;
+    }
+
+    return segy_native_byteswap( format, size, buf );
+}
+
+static inline uint16_t load16( const char* src, bool swap ) {
+    uint16_t v;
+    memcpy( &v, src, sizeof( v ) );
+    return swap ? bswap16( v ) : v;
+}
+
+static inline uint32_t load32( const char* src, bool swap ) {
+    uint32_t v;
+    memcpy( &v, src, sizeof( v ) );
+    return swap ? bswap32( v ) : v;
+}
+
+static inline uint64_t load64( const char* src, bool swap ) {
+    uint64_t v;
+    memcpy( &v, src, sizeof( v ) );
+    return swap ? bswap64( v ) : v;
+}
+
+static inline uint32_t load24( const char* src, bool lsb ) {
+    const unsigned char* xs = (const unsigned char*)src;
+    if( lsb ) return (uint32_t)xs[ 2 ] << 16 | (uint32_t)xs[ 1 ] << 8 | xs[ 0 ];
+    else      return (uint32_t)xs[ 0 ] << 16 | (uint32_t)xs[ 1 ] << 8 | xs[ 2 ];
+}
+
+static inline void store_native( char* dst,
+                                 long long i,
+                                 double x,
+                                 int outformat ) {
+    if( outformat == SEGY_IEEE_FLOAT_4_BYTE ) {
+        const float f = (float)x;
+        memcpy( dst + i * sizeof( f ), &f, sizeof( f ) );
+    } else {
+        memcpy( dst + i * sizeof( x ), &x, sizeof( x ) );
+    }
+}
+
+/*
+ * The size of a sample, in bytes, when samples of format are read into
+ * outformat. outformat is either the format itself, i.e. the same as
+ * segy_to_native, or 4- or 8-byte IEEE float. Returns -1 if the conversion is
+ * not supported.
+ */
+static int native_size( int format, int outformat ) {
+    if( outformat == format ) return segy_formatsize( format );
+
+    if( outformat != SEGY_IEEE_FLOAT_4_BYTE
+     && outformat != SEGY_IEEE_FLOAT_8_BYTE )
+        return -1;
+
+    switch( format ) {
+        case SEGY_IBM_FLOAT_4_BYTE:
+        case SEGY_SIGNED_INTEGER_4_BYTE:
+        case SEGY_SIGNED_INTEGER_8_BYTE:
+        case SEGY_SIGNED_SHORT_2_BYTE:
+        case SEGY_IEEE_FLOAT_4_BYTE:
+        case SEGY_IEEE_FLOAT_8_BYTE:
+        case SEGY_SIGNED_CHAR_1_BYTE:
+        case SEGY_UNSIGNED_CHAR_1_BYTE:
+        case SEGY_UNSIGNED_INTEGER_4_BYTE:
+        case SEGY_UNSIGNED_SHORT_2_BYTE:
+        case SEGY_UNSIGNED_INTEGER_8_BYTE:
+        case SEGY_SIGNED_CHAR_3_BYTE:
+        case SEGY_UNSIGNED_INTEGER_3_BYTE:
+            return segy_formatsize( outformat );
+
+        default:
+            return -1;
+    }
+}
+
+/*
+ * Convert size samples of format, as they are laid out on disk, to outformat.
+ * src and dst may overlap, as long as src is at or after dst, and ends at the
+ * same place, i.e. narrowing conversions are done front-to-back in the same
+ * buffer, and widening conversions with src at the end of dst. Every sample is
+ * loaded before its destination is written.
+ */
+static void convert_native( int format,
+                            bool lsb,
+                            long long size,
+                            const char* src,
+                            int outformat,
+                            char* dst ) {
+
+    const bool swap = lsb != HOST_LSB;
+    const int elemsize = segy_formatsize( format );
+
+    if( format == SEGY_IBM_FLOAT_4_BYTE
+     && outformat == SEGY_IEEE_FLOAT_4_BYTE ) {
+        outformat = format;
+    }
+
+    if( outformat == format ) {
+        if( src != dst ) memmove( dst, src, size * elemsize );
+
+        if( format == SEGY_IBM_FLOAT_4_BYTE ) {
+            /* the ibm kernels expect big-endian input */
+            if( lsb ) bswap32vec( dst, size );
+            ibm_native_vec( dst, size );
+            return;
+        }
+
+        if( swap ) bswapvec( dst, size, elemsize );
+        return;
+    }
+
+    switch( format ) {
+        case SEGY_IBM_FLOAT_4_BYTE:
+            for( long long i = 0; i < size; ++i ) {
+                uint32_t u = load32( src + i * 4, swap );
+                float f;
+                ibm_native( &u );
+                memcpy( &f, &u, sizeof( f ) );
+                store_native( dst, i, f, outformat );
+            }
+            return;
+
+        case SEGY_IEEE_FLOAT_4_BYTE:
+            for( long long i = 0; i < size; ++i ) {
+                const uint32_t u = load32( src + i * 4, swap );
+                float f;
+                memcpy( &f, &u, sizeof( f ) );
+                store_native( dst, i, f, outformat );
+            }
+            return;
+
+        case SEGY_IEEE_FLOAT_8_BYTE:
+            for( long long i = 0; i < size; ++i ) {
+                const uint64_t u = load64( src + i * 8, swap );
+                double d;
+                memcpy( &d, &u, sizeof( d ) );
+                store_native( dst, i, d, outformat );
+            }
+            return;
+
+        case SEGY_SIGNED_INTEGER_8_BYTE:
+            for( long long i = 0; i < size; ++i )
+                store_native( dst, i, (int64_t)load64( src + i * 8, swap ), outformat );
+            return;
+
+        case SEGY_UNSIGNED_INTEGER_8_BYTE:
+            for( long long i = 0; i < size; ++i )
+                store_native( dst, i, (double)load64( src + i * 8, swap ), outformat );
+            return;
+
+        case SEGY_SIGNED_INTEGER_4_BYTE:
+            for( long long i = 0; i < size; ++i )
+                store_native( dst, i, (int32_t)load32( src + i * 4, swap ), outformat );
+            return;
+
+        case SEGY_UNSIGNED_INTEGER_4_BYTE:
+            for( long long i = 0; i < size; ++i )
+                store_native( dst, i, load32( src + i * 4, swap ), outformat );
+            return;
+
+        case SEGY_SIGNED_CHAR_3_BYTE:
+            for( long long i = 0; i < size; ++i ) {
+                const uint32_t u = load24( src + i * 3, lsb );
+                /* sign-extend from 24 bits */
+                const int32_t x = (int32_t)( u ^ 0x800000 ) - 0x800000;
+                store_native( dst, i, x, outformat );
+            }
+            return;
+
+        case SEGY_UNSIGNED_INTEGER_3_BYTE:
+            for( long long i = 0; i < size; ++i )
+                store_native( dst, i, load24( src + i * 3, lsb ), outformat );
+            return;
+
+        case SEGY_SIGNED_SHORT_2_BYTE:
+            for( long long i = 0; i < size; ++i )
+                store_native( dst, i, (int16_t)load16( src + i * 2, swap ), outformat );
+            return;
+
+        case SEGY_UNSIGNED_SHORT_2_BYTE:
+            for( long long i = 0; i < size; ++i )
+                store_native( dst, i, load16( src + i * 2, swap ), outformat );
+            return;
+
+        case SEGY_SIGNED_CHAR_1_BYTE:
+            for( long long i = 0; i < size; ++i )
+                store_native( dst, i, (int8_t)src[ i ], outformat );
+            return;
+
+        case SEGY_UNSIGNED_CHAR_1_BYTE:
+            for( long long i = 0; i < size; ++i )
+                store_native( dst, i, (uint8_t)src[ i ], outformat );
+            return;
+
+        default:
+            assert( false && "unsupported format passed native_size" );
+            return;
+    }
+}
+
+int segy_readsubtr_native( segy_datasource* ds,
+                           int traceno,
+                           int start,
+                           int stop,
+                           int step,
+                           int outformat,
+                           void* buf,
+                           void* rangebuf ) {
+    return segy_readsubtr_native64( ds, traceno, start, stop, step,
+                                    outformat, buf, rangebuf );
+}
+
+int segy_readsubtr_native64( segy_datasource* ds,
+                             long long traceno,
+                             int start,
+                             int stop,
+                             int step,
+                             int outformat,
+                             void* buf,
+                             void* rangebuf ) {
+
+    const int format = ds->metadata.format;
+    const int elemsize = ds->metadata.elemsize;
+    const int outsize = native_size( format, outformat );
+    if( outsize < 0 ) return SEGY_INVALID_ARGS;
+
+    const long long elems = subtr_length( start, stop, step );
+    const bool lsb = ds->metadata.endianness == SEGY_LSB;
+
+    /*
+     * Samples are read straight into the output buffer whenever it is large
+     * enough, and converted in-place while still in cache. Widening
+     * conversions read into the back of the buffer, narrowing conversions
+     * (from 8-byte formats to float) need a temporary buffer.
+     */
+    char* dst = (char*)buf;
+    char* raw = dst;
+    char* tmp = NULL;
+    if( outsize > elemsize ) {
+        raw = dst + elems * ( outsize - elemsize );
+    } else if( outsize < elemsize ) {
+        tmp = malloc( elems * elemsize );
+        if( !tmp ) return SEGY_MEMORY_ERROR;
+        raw = tmp;
+    }
+
+    const int err = readsubtr_raw( ds, traceno, start, stop, step,
+                                   raw, rangebuf );
+    if( err == SEGY_OK )
+        convert_native( format, lsb, elems, raw, outformat, dst );
+
+    free( tmp );
+    return err;
+}
+
+/*
+ * Pick the samples [start:stop:step] out of range, which holds the samples
+ * [min(start, stop + 1), max(start, stop + 1)) of a trace, as laid out on disk.
+ */
+static void gather_subtr( const char* range,
+                          int start,
+                          int stop,
+                          int step,
+                          int elemsize,
+                          char* dst ) {
+    const int elems = abs( stop - start );
+
+    if( step == 1 || step == -1 ) {
+        memcpy( dst, range, (size_t)elems * elemsize );
+        if( step == -1 ) reverse( dst, elems, elemsize );
+        return;
+    }
+
+    const int defstart = start < stop ? 0 : elems - 1;
+    const int slicelen = slicelength( start, stop, step );
+    const char* cur = range + elemsize * defstart;
+    for( int i = 0; i < slicelen; cur += step * elemsize, ++i, dst += elemsize )
+        memcpy( dst, cur, elemsize );
+}
+
+/*
+ * Read the subtraces [start:stop:step] of the traces in tracenos as-is from
+ * disk, back-to-back into buf. Runs of ascending or descending traces that are
+ * close on disk are read in one request, and the trace headers in between are
+ * stripped in memory.
+ */
+static int readtraces_raw( segy_datasource* ds,
+                           const long long* tracenos,
+                           long long n,
+                           int start,
+                           int stop,
+                           int step,
+                           char* buf ) {
+
+    const int elemsize = ds->metadata.elemsize;
+    const long long trsize = (long long)subtr_length( start, stop, step ) * elemsize;
+
+    /*
+     * In-memory datasources have nothing to gain from larger requests, so
+     * just copy the subtraces out one by one
+     */
+    if( !ds->minimize_requests_number ) {
+        for( long long i = 0; i < n; ++i, buf += trsize ) {
+            const int err = readsubtr_raw( ds, tracenos[ i ],
+                                           start, stop, step,
+                                           buf, NULL );
+            if( err != SEGY_OK ) return err;
+        }
+        return SEGY_OK;
+    }
+
+    const long long rangelen = (long long)abs( stop - start ) * elemsize;
+    char* span = NULL;
+    long long spancap = 0;
+
+    int err = SEGY_OK;
+    long long i = 0;
+    while( i < n ) {
+        const long long first = subtr_offset( ds, tracenos[ i ],
+                                              start, stop, elemsize );
+        long long lo = first;
+        long long hi = first + rangelen;
+
+        /* extend the run while the next trace continues in the same direction */
+        long long j = i + 1;
+        long long prev = first;
+        int direction = 0;
+        for( ; j < n; ++j ) {
+            const long long pos = subtr_offset( ds, tracenos[ j ],
+                                                start, stop, elemsize );
+            const int dir = pos > prev ? 1 : -1;
+            const long long gap = dir > 0 ? pos - ( prev + rangelen )
+                                          : prev - ( pos + rangelen );
+
+            if( direction != 0 && dir != direction ) break;
+            if( gap < 0 || gap > SEGY_COALESCE_MAX_GAP ) break;
+
+            const long long nlo = pos < lo ? pos : lo;
+            const long long nhi = pos + rangelen > hi ? pos + rangelen : hi;
+            if( nhi - nlo > SEGY_COALESCE_MAX_SPAN ) break;
+
+            direction = dir;
+            lo = nlo;
+            hi = nhi;
+            prev = pos;
+        }
+
+        if( j == i + 1 ) {
+            /* lone trace, read it straight into the output */
+            err = readsubtr_raw( ds, tracenos[ i ], start, stop, step,
+                                 buf, span && spancap >= rangelen ? span : NULL );
+            if( err != SEGY_OK ) break;
+            buf += trsize;
+            i = j;
+            continue;
+        }
+
+        if( hi - lo > spancap ) {
+            free( span );
+            spancap = hi - lo;
+            span = malloc( spancap );
+            if( !span ) {
+                err = SEGY_MEMORY_ERROR;
+                break;
+            }
+        }
+
+        err = read_at( ds, lo, span, hi - lo );
+        if( err != SEGY_OK ) break;
+
+        for( ; i < j; ++i, buf += trsize ) {
+            const long long pos = subtr_offset( ds, tracenos[ i ],
+                                                start, stop, elemsize );
+            gather_subtr( span + ( pos - lo ), start, stop, step, elemsize, buf );
+        }
+    }
+
+    free( span );
+    return err;
+}
+
+/*
+ * Read the subtraces of n traces into out, converted to outformat. Raw samples
+ * are read into the back of out (or into a temporary buffer for narrowing
+ * conversions) and the whole batch converted in one go.
+ */
+static int read_traces( segy_datasource* ds,
+                        const long long* tracenos,
+                        long long n,
+                        int start,
+                        int stop,
+                        int step,
+                        int outformat,
+                        void* out ) {
+
+    const int format = ds->metadata.format;
+    const int elemsize = ds->metadata.elemsize;
+    const int outsize = native_size( format, outformat );
+    if( outsize < 0 ) return SEGY_INVALID_ARGS;
+    if( n < 0 ) return SEGY_INVALID_ARGS;
+
+    const long long elems = subtr_length( start, stop, step ) * n;
+    const bool lsb = ds->metadata.endianness == SEGY_LSB;
+
+    char* dst = (char*)out;
+    char* raw = dst;
+    char* tmp = NULL;
+    if( outsize > elemsize ) {
+        raw = dst + elems * ( outsize - elemsize );
+    } else if( outsize < elemsize ) {
+        tmp = malloc( elems * elemsize );
+        if( !tmp ) return SEGY_MEMORY_ERROR;
+        raw = tmp;
+    }
+
+    const int err = readtraces_raw( ds, tracenos, n, start, stop, step, raw );
+    if( err == SEGY_OK )
+        convert_native( format, lsb, elems, raw, outformat, dst );
+
+    free( tmp );
+    return err;
+}
+
+int segy_read_traces( segy_datasource* ds,
+                      const int* tracenos,
+                      int n,
+                      int sample_start,
+                      int sample_stop,
+                      int sample_step,
+                      void* out ) {
+    if( n < 0 ) return SEGY_INVALID_ARGS;
+
+    /*
+     * Widen the trace numbers a batch at a time. Runs are not coalesced
+     * across batches, but the batches are large enough for that not to
+     * matter.
+     */
+    enum { batchsize = 1024 };
+    long long wide[ batchsize ];
+
+    const long long trsize = (long long)ds->metadata.elemsize
+                           * subtr_length( sample_start,
+                                           sample_stop,
+                                           sample_step );
+    char* dst = (char*)out;
+    for( int i = 0; i < n; i += batchsize ) {
+        const int len = n - i < batchsize ? n - i : batchsize;
+        for( int k = 0; k < len; ++k )
+            wide[ k ] = tracenos[ i + k ];
+
+        const int err = segy_read_traces64( ds, wide, len,
+                                            sample_start,
+                                            sample_stop,
+                                            sample_step,
+                                            dst );
+        if( err != SEGY_OK ) return err;
+        dst += trsize * len;
+    }
+
+    return SEGY_OK;
+}
+
+static int read_traces_dispatch( segy_datasource* ds,
+                                 const long long* tracenos,
+                                 long long n,
+                                 int start,
+                                 int stop,
+                                 int step,
+                                 bool native,
+                                 char* out );
+
+int segy_read_traces64( segy_datasource* ds,
+                        const long long* tracenos,
+                        long long n,
+                        int sample_start,
+                        int sample_stop,
+                        int sample_step,
+                        void* out ) {
+    return read_traces_dispatch( ds, tracenos, n,
+                                 sample_start, sample_stop, sample_step,
+                                 true,
+                                 (char*)out );
+}
+
+/*
+ * Depth slices are read a batch of traces at a time, with the traces of a
+ * batch read like segy_read_traces, and then scattered into the slices. The
+ * batch buffer holds at most this many bytes of samples.
+ */
+#define SEGY_DEPTH_BATCH_SIZE ( 8 * 1024 * 1024 )
+
+/*
+ * Scatter n subtraces of samples elements each, stored back-to-back in src,
+ * into slices that are slicestride elements apart in dst
+ */
+static void scatter_slices( const char* src,
+                            long long n,
+                            int samples,
+                            int elemsize,
+                            long long slicestride,
+                            char* dst ) {
+    /* 4-byte samples are by far the most common, give memcpy a constant */
+    if( elemsize == 4 ) {
+        for( long long k = 0; k < n; ++k ) {
+            char* slice = dst + k * 4;
+            for( int s = 0; s < samples; ++s ) {
+                memcpy( slice, src, 4 );
+                src += 4;
+                slice += slicestride * 4;
+            }
+        }
+        return;
+    }
+
+    for( long long k = 0; k < n; ++k ) {
+        char* slice = dst + k * elemsize;
+        for( int s = 0; s < samples; ++s ) {
+            memcpy( slice, src, elemsize );
+            src += elemsize;
+            slice += slicestride * elemsize;
+        }
+    }
+}
+
+int segy_read_depth_slices( segy_datasource* ds,
+                            long long trace0,
+                            long long count,
+                            int trace_step,
+                            int sample_start,
+                            int sample_stop,
+                            int sample_step,
+                            void* out ) {
+    if( count < 0 || trace_step == 0 ) return SEGY_INVALID_ARGS;
+    if( count == 0 ) return SEGY_OK;
+
+    const int format = ds->metadata.format;
+    const int outsize = native_size( format, format );
+    if( outsize < 0 ) return SEGY_INVALID_ARGS;
+
+    const int slices = subtr_length( sample_start, sample_stop, sample_step );
+    if( slices <= 0 ) return SEGY_OK;
+
+    const long long last = trace0 + ( count - 1 ) * trace_step;
+    if( trace0 < 0 || last < 0 ) return SEGY_INVALID_ARGS;
+
+    const long long trsize = (long long)slices * outsize;
+    long long batch = SEGY_DEPTH_BATCH_SIZE / trsize;
+    if( batch < 1 ) batch = 1;
+    if( batch > count ) batch = count;
+
+    long long* tracenos = malloc( batch * sizeof( long long ) );
+    char* buf = malloc( batch * trsize );
+    if( !tracenos || !buf ) {
+        free( tracenos );
+        free( buf );
+        return SEGY_MEMORY_ERROR;
+    }
+
+    int err = SEGY_OK;
+    char* dst = out;
+    for( long long i = 0; i < count; i += batch ) {
+        const long long len = count - i < batch ? count - i : batch;
+        for( long long k = 0; k < len; ++k )
+            tracenos[ k ] = trace0 + ( i + k ) * trace_step;
+
+        err = read_traces( ds, tracenos, len,
+                           sample_start, sample_stop, sample_step,
+                           format,
+                           buf );
+        if( err != SEGY_OK ) break;
+
+        scatter_slices( buf, len, slices, outsize, count,
+                        dst + i * outsize );
+    }
+
+    free( tracenos );
+    free( buf );
+    return err;
+}
+
+/*
+ * Asynchronous reads.
+ *
+ * A queue has depth slots, and every slot holds one subtrace read in flight.
+ * The reads of io_uring queues are completed by the thread that submits or
+ * waits, while thread pool queues complete reads in the workers. Either way,
+ * the subtrace is gathered and converted by whoever completes the read.
+ */
+#if defined(HAVE_IO_URING) && defined(HAVE_MMAP) && defined(__NR_io_uring_setup)
+    #define SEGY_USE_IO_URING
+#endif
+
+#if defined(HAVE_PTHREAD) || defined(_WIN32)
+    #define SEGY_USE_THREAD_POOL
+#endif
+
+/* Thread pool queues never start more threads than this */
+#define SEGY_QUEUE_MAX_THREADS 16
+
+/* Reads in flight for queues segyio opens on its own */
+#define SEGY_QUEUE_DEPTH 64
+
+/*
+ * Reads of fewer traces than this are not worth the round trip through the
+ * queue, and are read directly
+ */
+#define SEGY_QUEUE_MIN_TRACES 16
+
+struct queue_slot {
+    long long pos;  /* disk position of the bytes still to read */
+    size_t size;    /* bytes still to read */
+    char* buf;      /* where the next byte read goes */
+    char* dst;      /* the output subtrace */
+    char* scratch;  /* sample range of strided reads */
+    size_t scratchcap;
+    bool strided;
+    bool native;
+    int start;
+    int stop;
+    int step;
+#ifdef SEGY_USE_IO_URING
+    struct iovec iov;
+#endif //SEGY_USE_IO_URING
+};
+
+#ifdef SEGY_USE_IO_URING
+struct uring {
+    int fd;
+    int file;
+    void* sqring;
+    size_t sqringsize;
+    void* cqring;
+    size_t cqringsize;
+    struct io_uring_sqe* sqes;
+    size_t sqessize;
+    unsigned* sqtail;
+    unsigned* sqmask;
+    unsigned* sqarray;
+    unsigned* cqhead;
+    unsigned* cqtail;
+    unsigned* cqmask;
+    struct io_uring_cqe* cqes;
+    unsigned pending; /* queued, but not yet submitted to the kernel */
+};
+#endif //SEGY_USE_IO_URING
+
+/*
+ * Threads for the workers of the queues, the multi-threaded readers and the
+ * background writers. start_thread runs fn( arg ) in a new thread, and
+ * returns false if the thread can't be started, in which case the caller
+ * should do the work itself. The worker_thread must stay in place until
+ * join_thread returns, since the thread reads fn and arg from it. Without
+ * thread support, no thread is ever started.
+ */
+typedef struct {
+#if defined(HAVE_PTHREAD)
+    pthread_t handle;
+#elif defined(_WIN32)
+    HANDLE handle;
+#endif
+    void ( *fn )( void* );
+    void* arg;
+} worker_thread;
+
+#if defined(HAVE_PTHREAD)
+static void* thread_main( void* thread ) {
+    worker_thread* t = (worker_thread*)thread;
+    t->fn( t->arg );
+    return NULL;
+}
+
+static bool start_thread( worker_thread* t,
+                          void ( *fn )( void* ),
+                          void* arg ) {
+    t->fn = fn;
+    t->arg = arg;
+    return pthread_create( &t->handle, NULL, thread_main, t ) == 0;
+}
+
+static void join_thread( worker_thread* t ) {
+    pthread_join( t->handle, NULL );
+}
+#elif defined(_WIN32)
+static DWORD WINAPI thread_main( LPVOID thread ) {
+    worker_thread* t = (worker_thread*)thread;
+    t->fn( t->arg );
+    return 0;
+}
+
+static bool start_thread( worker_thread* t,
+                          void ( *fn )( void* ),
+                          void* arg ) {
+    t->fn = fn;
+    t->arg = arg;
+    t->handle = CreateThread( NULL, 0, thread_main, t, 0, NULL );
+    return t->handle != NULL;
+}
+
+static void join_thread( worker_thread* t ) {
+    WaitForSingleObject( t->handle, INFINITE );
+    CloseHandle( t->handle );
+}
+#else
+static bool start_thread( worker_thread* t,
+                          void ( *fn )( void* ),
+                          void* arg ) {
+    (void)t; // mark parameter as unused
+    (void)fn;
+    (void)arg;
+    return false;
+}
+
+static void join_thread( worker_thread* t ) {
+    (void)t; // mark parameter as unused
+}
+#endif
+
+#if defined(HAVE_PTHREAD)
+typedef pthread_mutex_t pool_mutex;
+typedef pthread_cond_t pool_cond;
+#elif defined(_WIN32)
+typedef CRITICAL_SECTION pool_mutex;
+typedef CONDITION_VARIABLE pool_cond;
+#endif
+
+#ifdef SEGY_USE_THREAD_POOL
+struct pool {
+    pool_mutex lock;
+    pool_cond work; /* signalled when a read is queued, or on stop */
+    pool_cond done; /* signalled when a read completes */
+    int* pending;   /* ring of slots waiting for a worker */
+    int head;
+    int count;
+    worker_thread* threads;
+    int nthreads;
+    bool stop;
+};
+#endif //SEGY_USE_THREAD_POOL
+
+struct segy_queue {
+    segy_datasource* ds;
+    int backend;
+    int depth;
+    struct queue_slot* slots;
+    int* free;   /* stack of free slots */
+    int nfree;
+    int err;     /* first error since the last wait */
+#ifdef SEGY_USE_IO_URING
+    struct uring ring;
+#endif //SEGY_USE_IO_URING
+#ifdef SEGY_USE_THREAD_POOL
+    struct pool pool;
+#endif //SEGY_USE_THREAD_POOL
+};
+
+/*
+ * Gather, reverse and convert the subtrace of a completed read, so that it
+ * matches what segy_read_traces (native) or segy_readsubtr (not native) gives.
+ */
+static void finish_slot( const segy_queue* q, const struct queue_slot* s ) {
+    const segy_datasource* ds = q->ds;
+    const int format = ds->metadata.format;
+    const int elemsize = ds->metadata.elemsize;
+    const bool lsb = ds->metadata.endianness == SEGY_LSB;
+    const int elems = subtr_length( s->start, s->stop, s->step );
+
+    if( s->strided )
+        gather_subtr( s->scratch, s->start, s->stop, s->step, elemsize, s->dst );
+    else if( s->step == -1 )
+        reverse( s->dst, elems, elemsize );
+
+    if( s->native )
+        convert_native( format, lsb, elems, s->dst, format, s->dst );
+    else if( lsb )
+        bswapvec( s->dst, elems, elemsize );
+}
+
+/*
+ * Take a free slot and set it up to read the subtrace of traceno. The caller
+ * must make sure there is a free slot.
+ */
+static int prepare_slot( segy_queue* q,
+                         long long traceno,
+                         int start,
+                         int stop,
+                         int step,
+                         bool native,
+                         char* dst,
+                         int* slot ) {
+    const int elemsize = q->ds->metadata.elemsize;
+    const size_t rangelen = (size_t)abs( stop - start ) * elemsize;
+
+    const int i = q->free[ q->nfree - 1 ];
+    struct queue_slot* s = q->slots + i;
+    s->strided = step != 1 && step != -1;
+
+    if( s->strided && s->scratchcap < rangelen ) {
+        char* scratch = realloc( s->scratch, rangelen );
+        if( !scratch ) return SEGY_MEMORY_ERROR;
+        s->scratch = scratch;
+        s->scratchcap = rangelen;
+    }
+
+    s->pos = subtr_offset( q->ds, traceno, start, stop, elemsize );
+    s->size = rangelen;
+    s->buf = s->strided ? s->scratch : dst;
+    s->dst = dst;
+    s->native = native;
+    s->start = start;
+    s->stop = stop;
+    s->step = step;
+
+    q->nfree--;
+    *slot = i;
+    return SEGY_OK;
+}
+
+static void release_slot( segy_queue* q, int slot, int err ) {
+    if( err != SEGY_OK && q->err == SEGY_OK ) q->err = err;
+    q->free[ q->nfree++ ] = slot;
+}
+
+static int read_slot( segy_queue* q, int slot ) {
+    const struct queue_slot* s = q->slots + slot;
+    const int err = read_at( q->ds, s->pos, s->buf, s->size );
+    if( err == SEGY_OK ) finish_slot( q, s );
+    return err;
+}
+
+#ifdef SEGY_USE_IO_URING
+static int uring_fd( const segy_datasource* ds ) {
+#ifdef HAVE_PREAD
+    if( ds->read_at == fdread_at ) return ((const fdfile*)ds->stream)->fd;
+    if( ds->read_at == fileread_at ) return fileno( (FILE*)ds->stream );
+#endif //HAVE_PREAD
+    (void)ds; // mark parameter as unused
+    return -1;
+}
+
+static void uring_close( struct uring* r ) {
+    if( r->sqes ) munmap( r->sqes, r->sqessize );
+    if( r->cqring && r->cqring != r->sqring ) munmap( r->cqring, r->cqringsize );
+    if( r->sqring ) munmap( r->sqring, r->sqringsize );
+    close( r->fd );
+}
+
+static bool uring_open( struct uring* r, int file, unsigned entries ) {
+    memset( r, 0, sizeof( *r ) );
+
+    struct io_uring_params p;
+    memset( &p, 0, sizeof( p ) );
+    r->fd = (int)syscall( __NR_io_uring_setup, entries, &p );
+    /* io_uring may be missing, or disabled by e.g. seccomp */
+    if( r->fd < 0 ) return false;
+    r->file = file;
+
+    r->sqringsize = p.sq_off.array + p.sq_entries * sizeof( unsigned );
+    r->cqringsize = p.cq_off.cqes + p.cq_entries * sizeof( struct io_uring_cqe );
+    const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if( single && r->cqringsize > r->sqringsize )
+        r->sqringsize = r->cqringsize;
+
+    const int prot = PROT_READ | PROT_WRITE;
+    const int flags = MAP_SHARED;
+    void* sq = mmap( NULL, r->sqringsize, prot, flags, r->fd, IORING_OFF_SQ_RING );
+    if( sq == MAP_FAILED ) goto failure;
+    r->sqring = sq;
+
+    if( single ) {
+        r->cqring = r->sqring;
+    } else {
+        void* cq = mmap( NULL, r->cqringsize, prot, flags, r->fd, IORING_OFF_CQ_RING );
+        if( cq == MAP_FAILED ) goto failure;
+        r->cqring = cq;
+    }
+
+    r->sqessize = p.sq_entries * sizeof( struct io_uring_sqe );
+    void* sqes = mmap( NULL, r->sqessize, prot, flags, r->fd, IORING_OFF_SQES );
+    if( sqes == MAP_FAILED ) goto failure;
+    r->sqes = sqes;
+
+    char* sqbase = r->sqring;
+    char* cqbase = r->cqring;
+    r->sqtail  = (unsigned*)( sqbase + p.sq_off.tail );
+    r->sqmask  = (unsigned*)( sqbase + p.sq_off.ring_mask );
+    r->sqarray = (unsigned*)( sqbase + p.sq_off.array );
+    r->cqhead  = (unsigned*)( cqbase + p.cq_off.head );
+    r->cqtail  = (unsigned*)( cqbase + p.cq_off.tail );
+    r->cqmask  = (unsigned*)( cqbase + p.cq_off.ring_mask );
+    r->cqes    = (struct io_uring_cqe*)( cqbase + p.cq_off.cqes );
+    return true;
+
+failure:
+    uring_close( r );
+    return false;
+}
+
+/*
+ * Queue a read of the slot. At most depth reads are ever in flight, and the
+ * rings have room for at least that many, so the submission ring can't be full.
+ */
+static void uring_push( segy_queue* q, int slot ) {
+    struct uring* r = &q->ring;
+    struct queue_slot* s = q->slots + slot;
+    s->iov.iov_base = s->buf;
+    s->iov.iov_len = s->size;
+
+    const unsigned tail = *r->sqtail;
+    const unsigned index = tail & *r->sqmask;
+    struct io_uring_sqe* sqe = r->sqes + index;
+    memset( sqe, 0, sizeof( *sqe ) );
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = r->file;
+    sqe->addr = (unsigned long long)(uintptr_t)&s->iov;
+    sqe->len = 1;
+    sqe->off = (unsigned long long)s->pos;
+    sqe->user_data = (unsigned long long)slot;
+    r->sqarray[ index ] = index;
+
+    __atomic_store_n( r->sqtail, tail + 1, __ATOMIC_RELEASE );
+    r->pending++;
+}
+
+/*
+ * Submit the queued reads, and if wait is set, block until at least one read
+ * completes. An interrupted wait returns early, so callers must check the
+ * completion ring and call again if it is empty.
+ */
+static int uring_enter( struct uring* r, bool wait ) {
+    for( ;; ) {
+        const unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+        const long ret = syscall( __NR_io_uring_enter, r->fd,
+                                  r->pending, wait ? 1 : 0, flags,
+                                  NULL, 0 );
+        if( ret < 0 ) {
+            if( errno == EINTR ) return SEGY_OK;
+            if( errno == EAGAIN ) continue;
+            return SEGY_DS_READ_ERROR;
+        }
+
+        r->pending -= (unsigned)ret;
+        if( r->pending == 0 ) return SEGY_OK;
+    }
+}
+
+static void uring_complete( segy_queue* q, int slot, int res ) {
+    struct queue_slot* s = q->slots + slot;
+
+    if( res == -EINTR || res == -EAGAIN ) {
+        uring_push( q, slot );
+        return;
+    }
+
+    if( res <= 0 ) {
+        release_slot( q, slot, SEGY_DS_READ_ERROR );
+        return;
+    }
+
+    /* short read, queue the rest */
+    if( (size_t)res < s->size ) {
+        s->pos += res;
+        s->buf += res;
+        s->size -= res;
+        uring_push( q, slot );
+        return;
+    }
+
+    finish_slot( q, s );
+    release_slot( q, slot, SEGY_OK );
+}
+
+/*
+ * Block until at least one read completes, and complete all reads that are
+ * done.
+ */
+static int uring_reap( segy_queue* q ) {
+    struct uring* r = &q->ring;
+    for( ;; ) {
+        unsigned head = *r->cqhead;
+        const unsigned tail = __atomic_load_n( r->cqtail, __ATOMIC_ACQUIRE );
+
+        if( head == tail ) {
+            const int err = uring_enter( r, true );
+            if( err != SEGY_OK ) return err;
+            continue;
+        }
+
+        for( ; head != tail; ++head ) {
+            const struct io_uring_cqe* cqe = r->cqes + ( head & *r->cqmask );
+            const int slot = (int)cqe->user_data;
+            const int res = cqe->res;
+            __atomic_store_n( r->cqhead, head + 1, __ATOMIC_RELEASE );
+            uring_complete( q, slot, res );
+        }
+
+        return SEGY_OK;
+    }
+}
+#endif //SEGY_USE_IO_URING
+
+#ifdef SEGY_USE_THREAD_POOL
+#if defined(HAVE_PTHREAD)
+static void pool_lock( struct pool* p )   { pthread_mutex_lock( &p->lock );   }
+static void pool_unlock( struct pool* p ) { pthread_mutex_unlock( &p->lock ); }
+static void pool_wait( struct pool* p, pool_cond* c ) {
+    pthread_cond_wait( c, &p->lock );
+}
+static void pool_signal( pool_cond* c )    { pthread_cond_signal( c );    }
+static void pool_broadcast( pool_cond* c ) { pthread_cond_broadcast( c ); }
+
+static bool pool_init( struct pool* p ) {
+    if( pthread_mutex_init( &p->lock, NULL ) != 0 ) return false;
+    if( pthread_cond_init( &p->work, NULL ) != 0 ) goto nowork;
+    if( pthread_cond_init( &p->done, NULL ) != 0 ) goto nodone;
+    return true;
+
+nodone:
+    pthread_cond_destroy( &p->work );
+nowork:
+    pthread_mutex_destroy( &p->lock );
+    return false;
+}
+
+static void pool_destroy( struct pool* p ) {
+    pthread_cond_destroy( &p->done );
+    pthread_cond_destroy( &p->work );
+    pthread_mutex_destroy( &p->lock );
+}
+
+#elif defined(_WIN32)
+static void pool_lock( struct pool* p )   { EnterCriticalSection( &p->lock ); }
+static void pool_unlock( struct pool* p ) { LeaveCriticalSection( &p->lock ); }
+static void pool_wait( struct pool* p, pool_cond* c ) {
+    SleepConditionVariableCS( c, &p->lock, INFINITE );
+}
+static void pool_signal( pool_cond* c )    { WakeConditionVariable( c );    }
+static void pool_broadcast( pool_cond* c ) { WakeAllConditionVariable( c ); }
+
+static bool pool_init( struct pool* p ) {
+    InitializeCriticalSection( &p->lock );
+    InitializeConditionVariable( &p->work );
+    InitializeConditionVariable( &p->done );
+    return true;
+}
+
+static void pool_destroy( struct pool* p ) {
+    DeleteCriticalSection( &p->lock );
+}
+#endif
+
+static void pool_work( segy_queue* q ) {
+    struct pool* p = &q->pool;
+    pool_lock( p );
+    for( ;; ) {
+        while( p->count == 0 && !p->stop )
+            pool_wait( p, &p->work );
+
+        if( p->count == 0 ) break;
+
+        const int slot = p->pending[ p->head ];
+        p->head = ( p->head + 1 ) % q->depth;
+        p->count--;
+
+        pool_unlock( p );
+        const int err = read_slot( q, slot );
+        pool_lock( p );
+
+        release_slot( q, slot, err );
+        pool_signal( &p->done );
+    }
+    pool_unlock( p );
+}
+
+static void pool_worker( void* arg ) {
+    pool_work( (segy_queue*)arg );
+}
+
+static void pool_close( segy_queue* q ) {
+    struct pool* p = &q->pool;
+    pool_lock( p );
+    p->stop = true;
+    pool_broadcast( &p->work );
+    pool_unlock( p );
+
+    for( int i = 0; i < p->nthreads; ++i )
+        join_thread( p->threads + i );
+
+    pool_destroy( p );
+    free( p->threads );
+    free( p->pending );
+}
+
+static bool pool_open( segy_queue* q ) {
+    struct pool* p = &q->pool;
+    memset( p, 0, sizeof( *p ) );
+
+    const int nthreads = q->depth < SEGY_QUEUE_MAX_THREADS
+                       ? q->depth
+                       : SEGY_QUEUE_MAX_THREADS;
+
+    p->pending = malloc( q->depth * sizeof( int ) );
+    p->threads = malloc( nthreads * sizeof( worker_thread ) );
+    if( !p->pending || !p->threads || !pool_init( p ) ) {
+        free( p->pending );
+        free( p->threads );
+        return false;
+    }
+
+    /* make sure the conversion kernel is selected before any worker starts */
+    segy_simd();
+
+    for( ; p->nthreads < nthreads; ++p->nthreads ) {
+        if( !start_thread( p->threads + p->nthreads, pool_worker, q ) )
+            break;
+    }
+
+    if( p->nthreads == 0 ) {
+        pool_close( q );
+        return false;
+    }
+
+    return true;
+}
+#endif //SEGY_USE_THREAD_POOL
+
+segy_queue* segy_queue_open( segy_datasource* ds, int depth ) {
+    if( !ds || depth < 1 ) return NULL;
+
+    segy_queue* q = calloc( 1, sizeof( segy_queue ) );
+    if( !q ) return NULL;
+
+    q->ds = ds;
+    q->depth = depth;
+    q->backend = SEGY_QUEUE_SYNC;
+    q->slots = calloc( depth, sizeof( struct queue_slot ) );
+    q->free = malloc( depth * sizeof( int ) );
+    if( !q->slots || !q->free ) {
+        free( q->slots );
+        free( q->free );
+        free( q );
+        return NULL;
+    }
+
+    for( int i = 0; i < depth; ++i )
+        q->free[ i ] = depth - 1 - i;
+    q->nfree = depth;
+
+    /*
+     * In-memory datasources have no latency to hide, and without positional
+     * reads there can only be one read in flight anyway
+     */
+    if( ds->memory_speedup || !ds->read_at ) return q;
+
+#ifdef SEGY_USE_IO_URING
+    const int fd = uring_fd( ds );
+    if( fd >= 0 && uring_open( &q->ring, fd, (unsigned)depth ) ) {
+        q->backend = SEGY_QUEUE_IO_URING;
+        return q;
+    }
+#endif //SEGY_USE_IO_URING
+
+#ifdef SEGY_USE_THREAD_POOL
+    if( pool_open( q ) ) q->backend = SEGY_QUEUE_THREADS;
+#endif //SEGY_USE_THREAD_POOL
+
+    return q;
+}
+
+int segy_queue_backend( const segy_queue* q ) {
+    return q->backend;
+}
+
+int segy_wait( segy_queue* q ) {
+    int err = SEGY_OK;
+
+    switch( q->backend ) {
+#ifdef SEGY_USE_IO_URING
+        case SEGY_QUEUE_IO_URING:
+            while( err == SEGY_OK && q->nfree < q->depth )
+                err = uring_reap( q );
+            break;
+#endif //SEGY_USE_IO_URING
+
+#ifdef SEGY_USE_THREAD_POOL
+        case SEGY_QUEUE_THREADS:
+            pool_lock( &q->pool );
+            while( q->nfree < q->depth )
+                pool_wait( &q->pool, &q->pool.done );
+            pool_unlock( &q->pool );
+            break;
+#endif //SEGY_USE_THREAD_POOL
+
+        default:
+            break;
+    }
+
+    if( err == SEGY_OK ) err = q->err;
+    q->err = SEGY_OK;
+    return err;
+}
+
+int segy_queue_close( segy_queue* q ) {
+    if( !q ) return SEGY_OK;
+
+    const int err = segy_wait( q );
+
+    /*
+     * If waiting failed, the kernel may still write to the buffers of reads in
+     * flight, so leak the scratch buffers rather than free them
+     */
+    const bool inflight = q->nfree < q->depth;
+
+#ifdef SEGY_USE_IO_URING
+    if( q->backend == SEGY_QUEUE_IO_URING ) uring_close( &q->ring );
+#endif //SEGY_USE_IO_URING
+
+#ifdef SEGY_USE_THREAD_POOL
+    if( q->backend == SEGY_QUEUE_THREADS ) pool_close( q );
+#endif //SEGY_USE_THREAD_POOL
+
+    for( int i = 0; i < q->depth && !inflight; ++i )
+        free( q->slots[ i ].scratch );
+
+    free( q->slots );
+    free( q->free );
+    free( q );
+    return err;
+}
+
+/*
+ * Read n subtraces without a queue. Unless native is set, the subtraces are
+ * left in the on-disk format, but big-endian, like segy_readsubtr gives them.
+ */
+static int read_traces_sync( segy_datasource* ds,
+                             const long long* tracenos,
+                             long long n,
+                             int start,
+                             int stop,
+                             int step,
+                             bool native,
+                             char* out ) {
+    if( native )
+        return read_traces( ds, tracenos, n, start, stop, step,
+                            ds->metadata.format, out );
+
+    const int err = readtraces_raw( ds, tracenos, n, start, stop, step, out );
+    if( err == SEGY_OK && ds->metadata.endianness == SEGY_LSB )
+        bswapvec( out, subtr_length( start, stop, step ) * n,
+                  ds->metadata.elemsize );
+    return err;
+}
+
+/*
+ * Queue the reads of n subtraces. Unless native is set, the subtraces are left
+ * in the on-disk format, but big-endian, like segy_readsubtr gives them.
+ */
+static int queue_submit( segy_queue* q,
+                         const long long* tracenos,
+                         long long n,
+                         int start,
+                         int stop,
+                         int step,
+                         bool native,
+                         char* out ) {
+    segy_datasource* ds = q->ds;
+    if( n < 0 ) return SEGY_INVALID_ARGS;
+
+    const long long trsize = (long long)subtr_length( start, stop, step )
+                           * ds->metadata.elemsize;
+
+    if( q->backend == SEGY_QUEUE_SYNC ) {
+        if( q->err != SEGY_OK ) return SEGY_OK;
+
+        const int err = read_traces_sync( ds, tracenos, n, start, stop, step,
+                                          native, out );
+        if( err != SEGY_OK ) q->err = err;
+        return SEGY_OK;
+    }
+
+    /* stop queueing reads after the first error */
+    bool failed = false;
+    for( long long i = 0; i < n && !failed; ++i, out += trsize ) {
+        int slot;
+        int err = SEGY_OK;
+
+        switch( q->backend ) {
+#ifdef SEGY_USE_IO_URING
+            case SEGY_QUEUE_IO_URING:
+                while( err == SEGY_OK && q->nfree == 0 )
+                    err = uring_reap( q );
+
+                if( err != SEGY_OK ) return err;
+
+                failed = q->err != SEGY_OK;
+                if( failed ) break;
+
+                err = prepare_slot( q, tracenos[ i ], start, stop, step,
+                                    native, out, &slot );
+                if( err != SEGY_OK ) return err;
+
+                uring_push( q, slot );
+                break;
+#endif //SEGY_USE_IO_URING
+
+#ifdef SEGY_USE_THREAD_POOL
+            case SEGY_QUEUE_THREADS: {
+                struct pool* p = &q->pool;
+                pool_lock( p );
+                while( q->nfree == 0 )
+                    pool_wait( p, &p->done );
+
+                failed = q->err != SEGY_OK;
+                if( !failed )
+                    err = prepare_slot( q, tracenos[ i ], start, stop, step,
+                                        native, out, &slot );
+
+                if( !failed && err == SEGY_OK ) {
+                    p->pending[ ( p->head + p->count ) % q->depth ] = slot;
+                    p->count++;
+                    pool_signal( &p->work );
+                }
+                pool_unlock( p );
+
+                if( err != SEGY_OK ) return err;
+                break;
+            }
+#endif //SEGY_USE_THREAD_POOL
+
+            default:
+                return SEGY_INVALID_ARGS;
+        }
+    }
+
+#ifdef SEGY_USE_IO_URING
+    if( q->backend == SEGY_QUEUE_IO_URING )
+        return uring_enter( &q->ring, false );
+#endif //SEGY_USE_IO_URING
+
+    return SEGY_OK;
+}
+
+int segy_submit_read_traces( segy_queue* q,
+                             const long long* tracenos,
+                             long long n,
+                             int sample_start,
+                             int sample_stop,
+                             int sample_step,
+                             void* out ) {
+    return queue_submit( q, tracenos, n,
+                         sample_start, sample_stop, sample_step,
+                         true,
+                         (char*)out );
+}
+
+/*
+ * The queue of a datasource is handed out to one reader at a time. While it
+ * is taken, ds->queue is the busy marker, and other readers read directly
+ * rather than wait for it or open another queue. Without atomic exchange the
+ * queue is never kept, and all reads are direct.
+ */
+static char queue_busy;
+#define SEGY_QUEUE_BUSY ( (segy_queue*)&queue_busy )
+
+#if defined(__GNUC__) || defined(__clang__)
+static segy_queue* exchange_queue( segy_datasource* ds, segy_queue* q ) {
+    return __atomic_exchange_n( &ds->queue, q, __ATOMIC_ACQ_REL );
+}
+#elif defined(_WIN32)
+static segy_queue* exchange_queue( segy_datasource* ds, segy_queue* q ) {
+    return InterlockedExchangePointer( (PVOID volatile*)&ds->queue, q );
+}
+#else
+#define SEGY_NO_DATASOURCE_QUEUE
+#endif
+
+static segy_queue* take_queue( segy_datasource* ds ) {
+#ifdef SEGY_NO_DATASOURCE_QUEUE
+    (void)ds;
+    return NULL;
+#else
+    segy_queue* q = exchange_queue( ds, SEGY_QUEUE_BUSY );
+    if( q == SEGY_QUEUE_BUSY ) return NULL;
+    if( q ) return q;
+
+    q = segy_queue_open( ds, SEGY_QUEUE_DEPTH );
+    if( !q ) exchange_queue( ds, NULL );
+    return q;
+#endif
+}
+
+static void give_queue( segy_datasource* ds, segy_queue* q ) {
+#ifdef SEGY_NO_DATASOURCE_QUEUE
+    (void)ds;
+    (void)q;
+#else
+    exchange_queue( ds, q );
+#endif
+}
+
+/*
+ * Close the queue kept on the datasource, if any. The busy marker is not a
+ * queue, and means a reader still holds the queue, which segy_close does not
+ * allow for. The queue is then leaked rather than closed under the reader.
+ */
+static int close_queue( segy_datasource* ds ) {
+    segy_queue* q = ds->queue;
+    if( q == SEGY_QUEUE_BUSY ) return SEGY_OK;
+
+    ds->queue = NULL;
+    return segy_queue_close( q );
+}
+
+/*
+ * Many traces that are all too far apart to be coalesced are read through the
+ * datasource's queue, to keep many reads in flight. Everything else, including
+ * in-memory datasources and datasources without positional reads, which have
+ * no latency to hide, is read directly.
+ */
+static bool worth_queueing( const segy_datasource* ds,
+                            const long long* tracenos,
+                            long long n ) {
+    if( n < SEGY_QUEUE_MIN_TRACES ) return false;
+    if( ds->memory_speedup || !ds->read_at ) return false;
+
+    const long long trace_size = (long long)ds->metadata.trace_bsize
+                               + SEGY_TRACE_HEADER_SIZE;
+    for( long long i = 1; i < n; ++i ) {
+        long long dist = tracenos[ i ] - tracenos[ i - 1 ];
+        if( dist < 0 ) dist = -dist;
+        if( dist * trace_size <= SEGY_COALESCE_MAX_GAP ) return false;
+    }
+
+    return true;
+}
+
+static int read_traces_dispatch( segy_datasource* ds,
+                                 const long long* tracenos,
+                                 long long n,
+                                 int start,
+                                 int stop,
+                                 int step,
+                                 bool native,
+                                 char* out ) {
+    if( n < 0 ) return SEGY_INVALID_ARGS;
+
+    segy_queue* q = worth_queueing( ds, tracenos, n ) ? take_queue( ds ) : NULL;
+    if( !q )
+        return read_traces_sync( ds, tracenos, n, start, stop, step,
+                                 native, out );
+
+    const int err = queue_submit( q, tracenos, n, start, stop, step,
+                                  native, out );
+    const int qerr = segy_wait( q );
+    give_queue( ds, q );
+    return err != SEGY_OK ? err : qerr;
+}
+
+/*
+ * Determine the position of the element `x` in `xs`.
+ * Returns -1 if the value cannot be found
+ */
+static int index_of( int x,
+                     const int* xs,
+                     int sz ) {
+    for( int i = 0; i < sz; i++ ) {
+        if( xs[i] == x )
+            return i;
+    }
+
+    return -1;
+}
+
+/*
+ * Read the inline or crossline `lineno`. If it's an inline or crossline
+ * depends on the parameters. The line has a length of `line_length` traces,
+ * `offsets` are the number of offsets in this file, and `buf` must be of
+ * (minimum) `line_length*samples_per_trace` size.  Reads every `stride` trace,
+ * starting at the trace specified by the *position* of the value `lineno` in
+ * `linenos`. If `lineno` isn't present in `linenos`, SEGY_MISSING_LINE_INDEX
  * will be returned.
  *
  * If reading a trace fails, this function will return whatever error
  * segy_readtrace returns.
  */
-int segy_read_line( segy_datasource* ds,
-                    int line_trace0,
-                    int line_length,
-                    int stride,
-                    int offsets,
-                    void* buf ) {
+int segy_read_line( segy_datasource* ds,
+                    int line_trace0,
+                    int line_length,
+                    int stride,
+                    int offsets,
+                    void* buf ) {
+
+    const int samples = ds->metadata.trace_bsize / ds->metadata.elemsize;
+    char* dst = (char*) buf;
+    stride *= offsets;
+
+    enum { batchsize = 1024 };
+    long long tracenos[ batchsize ];
+
+    for( int i = 0; i < line_length; ) {
+        int n = 0;
+        for( ; n < batchsize && i < line_length; ++n, ++i )
+            tracenos[ n ] = line_trace0 + (long long)i * stride;
+
+        const int err = read_traces_dispatch( ds, tracenos, n, 0, samples, 1,
+                                              false, dst );
+        if( err != SEGY_OK ) return err;
+        dst += (long long)n * ds->metadata.trace_bsize;
+    }
+
+    return SEGY_OK;
+}
+
+int segy_read_line_native( segy_datasource* ds,
+                           int line_trace0,
+                           int line_length,
+                           int stride,
+                           int offsets,
+                           int outformat,
+                           void* buf ) {
+    return segy_read_line_parallel( ds,
+                                    line_trace0,
+                                    line_length,
+                                    stride,
+                                    offsets,
+                                    outformat,
+                                    buf,
+                                    1 );
+}
+
+/*
+ * A contiguous chunk [first, last) of the traces line_trace0 + i * stride,
+ * read and converted by one worker. The samples [start, stop) of every trace
+ * are written trace by trace, or, if slicestride is non-zero, transposed into
+ * slices of slicestride samples each.
+ */
+struct trace_job {
+    segy_datasource* ds;
+    long long line_trace0;
+    long long stride;
+    long long first;
+    long long last;
+    int start;
+    int stop;
+    int outformat;
+    int outsize;
+    long long slicestride;
+    char* buf;
+    int err;
+};
+
+static int read_trace_job( struct trace_job* job ) {
+    segy_datasource* ds = job->ds;
+    const int samples = job->stop - job->start;
+    const long long outtrsize = (long long)samples * job->outsize;
+
+    /* read in batches, so that near traces are coalesced into larger reads */
+    enum { batchsize = 1024 };
+    long long tracenos[ batchsize ];
+
+    char* scratch = NULL;
+    if( job->slicestride ) {
+        scratch = malloc( batchsize * outtrsize );
+        if( !scratch ) return SEGY_MEMORY_ERROR;
+    }
+
+    int err = SEGY_OK;
+    for( long long i = job->first; i < job->last; ) {
+        const long long first = i;
+        int n = 0;
+        for( ; n < batchsize && i < job->last; ++n, ++i )
+            tracenos[ n ] = job->line_trace0 + i * job->stride;
+
+        char* dst = scratch ? scratch : job->buf + first * outtrsize;
+        err = read_traces( ds, tracenos, n,
+                           job->start, job->stop, 1,
+                           job->outformat,
+                           dst );
+        if( err != SEGY_OK ) break;
+
+        if( scratch )
+            scatter_slices( scratch, n, samples, job->outsize,
+                            job->slicestride,
+                            job->buf + first * job->outsize );
+    }
+
+    free( scratch );
+    return err;
+}
+
+static void trace_job_worker( void* arg ) {
+    struct trace_job* job = (struct trace_job*)arg;
+    job->err = read_trace_job( job );
+}
+
+/*
+ * Run the jobs, the first in the calling thread and the others in workers. If
+ * a thread can't be started, its job is run by the calling thread after its
+ * own. Returns the first error of any job.
+ */
+static int run_trace_jobs( struct trace_job* jobs, int threads ) {
+    worker_thread* workers = malloc( threads * sizeof( worker_thread ) );
+    bool* started = calloc( threads, sizeof( bool ) );
+    if( !workers || !started ) {
+        free( workers );
+        free( started );
+        return SEGY_MEMORY_ERROR;
+    }
+
+    for( int i = 1; i < threads; ++i )
+        started[ i ] = start_thread( workers + i, trace_job_worker,
+                                     jobs + i );
+
+    int err = read_trace_job( jobs );
+    for( int i = 1; i < threads; ++i ) {
+        if( started[ i ] ) join_thread( workers + i );
+        else               jobs[ i ].err = read_trace_job( jobs + i );
+
+        if( err == SEGY_OK ) err = jobs[ i ].err;
+    }
+
+    free( workers );
+    free( started );
+    return err;
+}
+
+int segy_read_line_parallel( segy_datasource* ds,
+                             int line_trace0,
+                             int line_length,
+                             int stride,
+                             int offsets,
+                             int outformat,
+                             void* buf,
+                             int threads ) {
+
+    if( threads < 1 || line_length < 0 ) return SEGY_INVALID_ARGS;
+
+    const int outsize = native_size( ds->metadata.format, outformat );
+    if( outsize < 0 ) return SEGY_INVALID_ARGS;
+
+    /*
+     * Without positional reads every request moves the shared stream position,
+     * so the workers would race each other. Read serially instead.
+     */
+    if( !ds->read_at ) threads = 1;
+    if( threads > line_length ) threads = line_length;
+    if( threads < 1 ) return SEGY_OK;
+
+    /* make sure the conversion kernel is selected before any worker starts */
+    segy_simd();
+
+    struct trace_job* jobs = malloc( threads * sizeof( struct trace_job ) );
+    if( !jobs ) return SEGY_MEMORY_ERROR;
+
+    const int samples = ds->metadata.trace_bsize / ds->metadata.elemsize;
+    for( int i = 0; i < threads; ++i ) {
+        jobs[ i ].ds = ds;
+        jobs[ i ].line_trace0 = line_trace0;
+        jobs[ i ].stride = (long long)stride * offsets;
+        jobs[ i ].first = (long long)line_length * i / threads;
+        jobs[ i ].last = (long long)line_length * ( i + 1 ) / threads;
+        jobs[ i ].start = 0;
+        jobs[ i ].stop = samples;
+        jobs[ i ].outformat = outformat;
+        jobs[ i ].outsize = outsize;
+        jobs[ i ].slicestride = 0;
+        jobs[ i ].buf = (char*)buf;
+        jobs[ i ].err = SEGY_OK;
+    }
+
+    const int err = run_trace_jobs( jobs, threads );
+    free( jobs );
+    return err;
+}
+
+int segy_read_cube( segy_datasource* ds,
+                    int outformat,
+                    void* buf,
+                    int threads ) {
+    return segy_read_line_parallel( ds,
+                                    0,
+                                    ds->metadata.tracecount,
+                                    1,
+                                    1,
+                                    outformat,
+                                    buf,
+                                    threads );
+}
+
+int segy_transpose( segy_datasource* src,
+                    segy_datasource* dst,
+                    const segy_geometry* geometry,
+                    size_t memory ) {
+
+    const int sorting = geometry->sorting;
+    if( sorting != SEGY_INLINE_SORTING && sorting != SEGY_CROSSLINE_SORTING )
+        return SEGY_INVALID_SORTING;
+
+    const bool inline_sorted = sorting == SEGY_INLINE_SORTING;
+    const long long slow = inline_sorted ? geometry->iline_count
+                                         : geometry->xline_count;
+    const long long fast = inline_sorted ? geometry->xline_count
+                                         : geometry->iline_count;
+    const long long offsets = geometry->offset_count;
+
+    if( slow < 1 || fast < 1 || offsets < 1 ) return SEGY_INVALID_ARGS;
+    if( slow * fast * offsets != src->metadata.tracecount )
+        return SEGY_INVALID_ARGS;
+
+    /*
+     * A cell is the traces of all offsets at one (slow, fast) point, which
+     * are kept together. The output lines are written a band at a time, and
+     * every band is gathered from one run of cells from each input line.
+     */
+    const long long trace0 = src->metadata.trace0;
+    const long long record = traceheader_offset( src, 1, 0, 0 ) - trace0;
+    const long long cell = offsets * record;
+    const long long line = slow * cell;
+
+    long long band = (long long)( memory / line );
+    if( band < 1 ) band = 1;
+    if( band > fast ) band = fast;
+
+    char* buf = malloc( band * line );
+    char* run = malloc( band * cell );
+    if( !buf || !run ) {
+        free( buf );
+        free( run );
+        return SEGY_MEMORY_ERROR;
+    }
+
+    /* the text and binary headers are copied as-is */
+    int err = SEGY_OK;
+    for( long long pos = 0; pos < trace0 && err == SEGY_OK; ) {
+        const long long len = trace0 - pos < band * line
+                            ? trace0 - pos
+                            : band * line;
+        err = read_at( src, pos, buf, len );
+        if( err == SEGY_OK ) err = write_at( dst, pos, buf, len );
+        pos += len;
+    }
+
+    for( long long f0 = 0; f0 < fast && err == SEGY_OK; f0 += band ) {
+        const long long n = fast - f0 < band ? fast - f0 : band;
+
+        for( long long s = 0; s < slow; ++s ) {
+            const long long pos = trace0 + ( s * fast + f0 ) * cell;
+            err = read_at( src, pos, run, n * cell );
+            if( err != SEGY_OK ) break;
+
+            for( long long k = 0; k < n; ++k )
+                memcpy( buf + ( k * slow + s ) * cell, run + k * cell, cell );
+        }
+        if( err != SEGY_OK ) break;
+
+        err = write_at( dst, trace0 + f0 * line, buf, n * line );
+    }
+
+    free( buf );
+    free( run );
+    return err;
+}
+
+int segy_write_depth_major( segy_datasource* src,
+                            segy_datasource* dst,
+                            size_t memory,
+                            int threads ) {
+
+    if( threads < 1 ) return SEGY_INVALID_ARGS;
+
+    const int format = src->metadata.format;
+    const int outsize = native_size( format, format );
+    if( outsize < 0 ) return SEGY_INVALID_ARGS;
+
+    const long long traces = src->metadata.tracecount;
+    const int samples = src->metadata.samplecount;
+    if( traces < 1 || samples < 1 ) return SEGY_OK;
+
+    const long long slice = traces * outsize;
+    long long band = (long long)( memory / slice );
+    if( band < 1 ) band = 1;
+    if( band > samples ) band = samples;
+
+    if( !src->read_at ) threads = 1;
+    if( threads > traces ) threads = (int)traces;
+
+    /* make sure the conversion kernel is selected before any worker starts */
+    segy_simd();
+
+    char* buf = malloc( band * slice );
+    struct trace_job* jobs = malloc( threads * sizeof( struct trace_job ) );
+    if( !buf || !jobs ) {
+        free( buf );
+        free( jobs );
+        return SEGY_MEMORY_ERROR;
+    }
+
+    /*
+     * Every pass reads the whole file, in file order, split between the
+     * threads, and writes band slices
+     */
+    int err = SEGY_OK;
+    for( int s0 = 0; s0 < samples && err == SEGY_OK; s0 += (int)band ) {
+        const int n = samples - s0 < band ? samples - s0 : (int)band;
+
+        for( int i = 0; i < threads; ++i ) {
+            jobs[ i ].ds = src;
+            jobs[ i ].line_trace0 = 0;
+            jobs[ i ].stride = 1;
+            jobs[ i ].first = traces * i / threads;
+            jobs[ i ].last = traces * ( i + 1 ) / threads;
+            jobs[ i ].start = s0;
+            jobs[ i ].stop = s0 + n;
+            jobs[ i ].outformat = format;
+            jobs[ i ].outsize = outsize;
+            jobs[ i ].slicestride = traces;
+            jobs[ i ].buf = buf;
+            jobs[ i ].err = SEGY_OK;
+        }
+
+        err = run_trace_jobs( jobs, threads );
+        if( err == SEGY_OK )
+            err = write_at( dst, s0 * slice, buf, n * slice );
+    }
+
+    free( buf );
+    free( jobs );
+    return err;
+}
+
+static void amplitudes_init( segy_amplitudes* acc ) {
+    acc->count = 0;
+    acc->nans = 0;
+    acc->min = INFINITY;
+    acc->max = -INFINITY;
+    acc->sum = 0;
+    acc->sumsq = 0;
+}
+
+void segy_amplitudes_merge( segy_amplitudes* dst, const segy_amplitudes* src ) {
+    dst->count += src->count;
+    dst->nans += src->nans;
+    if( src->min < dst->min ) dst->min = src->min;
+    if( src->max > dst->max ) dst->max = src->max;
+    dst->sum += src->sum;
+    dst->sumsq += src->sumsq;
+}
+
+/*
+ * The accumulation kernels add n samples to acc. The sums are always
+ * accumulated in double precision, so float samples are widened first.
+ */
+static void amplitudes_double( const double* xs,
+                               long long n,
+                               segy_amplitudes* acc ) {
+    for( long long i = 0; i < n; ++i ) {
+        const double x = xs[ i ];
+        if( isnan( x ) ) {
+            ++acc->nans;
+            continue;
+        }
+
+        if( x < acc->min ) acc->min = x;
+        if( x > acc->max ) acc->max = x;
+        acc->sum += x;
+        acc->sumsq += x * x;
+        ++acc->count;
+    }
+}
+
+static void amplitudes_scalar( const float* xs,
+                               long long n,
+                               segy_amplitudes* acc ) {
+    for( long long i = 0; i < n; ++i ) {
+        const double x = xs[ i ];
+        if( isnan( x ) ) {
+            ++acc->nans;
+            continue;
+        }
+
+        if( x < acc->min ) acc->min = x;
+        if( x > acc->max ) acc->max = x;
+        acc->sum += x;
+        acc->sumsq += x * x;
+        ++acc->count;
+    }
+}
+
+#ifdef SEGY_HAVE_SSE2
+/*
+ * minps returns the second operand if either is NaN, so min( x, lo ) skips NaN
+ * samples without masking. For the sums the NaNs are masked to zero, and the
+ * compare masks (-1) are subtracted from a per-lane NaN counter.
+ */
+static void amplitudes_sse2( const float* xs,
+                             long long n,
+                             segy_amplitudes* acc ) {
+    const long long vecs = n / 4;
+
+    __m128 lo = _mm_set1_ps( INFINITY );
+    __m128 hi = _mm_set1_ps( -INFINITY );
+    __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+    __m128d sq0 = _mm_setzero_pd(), sq1 = _mm_setzero_pd();
+    __m128i nans = _mm_setzero_si128();
+
+    for( long long i = 0; i < vecs; ++i ) {
+        const __m128 x = _mm_loadu_ps( xs + i * 4 );
+        const __m128 nan = _mm_cmpunord_ps( x, x );
+        lo = _mm_min_ps( x, lo );
+        hi = _mm_max_ps( x, hi );
+        nans = _mm_sub_epi32( nans, _mm_castps_si128( nan ) );
+
+        const __m128 v = _mm_andnot_ps( nan, x );
+        const __m128d v0 = _mm_cvtps_pd( v );
+        const __m128d v1 = _mm_cvtps_pd( _mm_movehl_ps( v, v ) );
+        sum0 = _mm_add_pd( sum0, v0 );
+        sum1 = _mm_add_pd( sum1, v1 );
+        sq0 = _mm_add_pd( sq0, _mm_mul_pd( v0, v0 ) );
+        sq1 = _mm_add_pd( sq1, _mm_mul_pd( v1, v1 ) );
+    }
+
+    float los[ 4 ], his[ 4 ];
+    double sums[ 2 ], sqs[ 2 ];
+    int32_t nanc[ 4 ];
+    _mm_storeu_ps( los, lo );
+    _mm_storeu_ps( his, hi );
+    _mm_storeu_pd( sums, _mm_add_pd( sum0, sum1 ) );
+    _mm_storeu_pd( sqs, _mm_add_pd( sq0, sq1 ) );
+    _mm_storeu_si128( (__m128i*)nanc, nans );
+
+    long long nancount = 0;
+    for( int i = 0; i < 4; ++i ) {
+        if( los[ i ] < acc->min ) acc->min = los[ i ];
+        if( his[ i ] > acc->max ) acc->max = his[ i ];
+        nancount += nanc[ i ];
+    }
+    acc->sum += sums[ 0 ] + sums[ 1 ];
+    acc->sumsq += sqs[ 0 ] + sqs[ 1 ];
+    acc->nans += nancount;
+    acc->count += vecs * 4 - nancount;
+
+    amplitudes_scalar( xs + vecs * 4, n - vecs * 4, acc );
+}
+#endif // SEGY_HAVE_SSE2
+
+#ifdef SEGY_HAVE_AVX2
+__attribute__((target("avx2")))
+static void amplitudes_avx2( const float* xs,
+                             long long n,
+                             segy_amplitudes* acc ) {
+    const long long vecs = n / 8;
+
+    __m256 lo = _mm256_set1_ps( INFINITY );
+    __m256 hi = _mm256_set1_ps( -INFINITY );
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    __m256d sq0 = _mm256_setzero_pd(), sq1 = _mm256_setzero_pd();
+    __m256i nans = _mm256_setzero_si256();
+
+    for( long long i = 0; i < vecs; ++i ) {
+        const __m256 x = _mm256_loadu_ps( xs + i * 8 );
+        const __m256 nan = _mm256_cmp_ps( x, x, _CMP_UNORD_Q );
+        lo = _mm256_min_ps( x, lo );
+        hi = _mm256_max_ps( x, hi );
+        nans = _mm256_sub_epi32( nans, _mm256_castps_si256( nan ) );
+
+        const __m256 v = _mm256_andnot_ps( nan, x );
+        const __m256d v0 = _mm256_cvtps_pd( _mm256_castps256_ps128( v ) );
+        const __m256d v1 = _mm256_cvtps_pd( _mm256_extractf128_ps( v, 1 ) );
+        sum0 = _mm256_add_pd( sum0, v0 );
+        sum1 = _mm256_add_pd( sum1, v1 );
+        sq0 = _mm256_add_pd( sq0, _mm256_mul_pd( v0, v0 ) );
+        sq1 = _mm256_add_pd( sq1, _mm256_mul_pd( v1, v1 ) );
+    }
+
+    float los[ 8 ], his[ 8 ];
+    double sums[ 4 ], sqs[ 4 ];
+    int32_t nanc[ 8 ];
+    _mm256_storeu_ps( los, lo );
+    _mm256_storeu_ps( his, hi );
+    _mm256_storeu_pd( sums, _mm256_add_pd( sum0, sum1 ) );
+    _mm256_storeu_pd( sqs, _mm256_add_pd( sq0, sq1 ) );
+    _mm256_storeu_si256( (__m256i*)nanc, nans );
+
+    long long nancount = 0;
+    for( int i = 0; i < 8; ++i ) {
+        if( los[ i ] < acc->min ) acc->min = los[ i ];
+        if( his[ i ] > acc->max ) acc->max = his[ i ];
+        nancount += nanc[ i ];
+    }
+    acc->sum += ( sums[ 0 ] + sums[ 1 ] ) + ( sums[ 2 ] + sums[ 3 ] );
+    acc->sumsq += ( sqs[ 0 ] + sqs[ 1 ] ) + ( sqs[ 2 ] + sqs[ 3 ] );
+    acc->nans += nancount;
+    acc->count += vecs * 8 - nancount;
+
+    amplitudes_scalar( xs + vecs * 8, n - vecs * 8, acc );
+}
+#endif // SEGY_HAVE_AVX2
+
+/*
+ * There are no AVX-512 or NEON accumulation kernels. CPUs with AVX-512 have
+ * AVX2, and the accumulation is bound by reading and converting the samples
+ * anyway.
+ */
+static void amplitudes_vec( const float* xs,
+                            long long n,
+                            segy_amplitudes* acc ) {
+    switch( segy_simd() ) {
+#ifdef SEGY_HAVE_AVX2
+        case SEGY_SIMD_AVX512:
+        case SEGY_SIMD_AVX2: amplitudes_avx2( xs, n, acc ); return;
+#endif
+#ifdef SEGY_HAVE_SSE2
+        case SEGY_SIMD_SSE2: amplitudes_sse2( xs, n, acc ); return;
+#endif
+        default: amplitudes_scalar( xs, n, acc ); return;
+    }
+}
+
+/*
+ * Add the samples in [low, high] to the histogram. The bin is computed in
+ * double precision, and high itself goes in the last bin, like numpy.
+ */
+static void histogram_add( const char* xs,
+                           bool wide,
+                           long long n,
+                           double low,
+                           double high,
+                           int bins,
+                           long long* histogram ) {
+    const double scale = bins / ( high - low );
+    for( long long i = 0; i < n; ++i ) {
+        const double x = wide ? ( (const double*)xs )[ i ]
+                              : ( (const float*)xs )[ i ];
+        if( !( x >= low && x <= high ) ) continue;
+
+        int bin = (int)( ( x - low ) * scale );
+        if( bin >= bins ) bin = bins - 1;
+        ++histogram[ bin ];
+    }
+}
+
+/*
+ * The traces [first, last) accumulated by one worker, into its own group
+ * statistics and histograms. The per-trace statistics are written straight to
+ * the output, since every trace belongs to exactly one worker.
+ */
+struct stats_job {
+    segy_datasource* ds;
+    long long first;
+    long long last;
+    int outformat;
+    const int* groups;
+    segy_amplitudes* stats;
+    segy_amplitudes* traces;
+    double low;
+    double high;
+    int bins;
+    long long* histograms;
+    int err;
+};
+
+static int read_stats_job( struct stats_job* job ) {
+    segy_datasource* ds = job->ds;
+    const int samples = ds->metadata.trace_bsize / ds->metadata.elemsize;
+    const bool wide = job->outformat == SEGY_IEEE_FLOAT_8_BYTE;
+    const long long trsize = (long long)samples * ( wide ? 8 : 4 );
+
+    /* read in batches, so that neighbouring traces are coalesced */
+    enum { batchsize = 1024 };
+    long long tracenos[ batchsize ];
+    long long batch = SEGY_DEPTH_BATCH_SIZE / ( trsize ? trsize : 1 );
+    if( batch < 1 ) batch = 1;
+    if( batch > batchsize ) batch = batchsize;
+
+    char* buf = malloc( batch * trsize + 1 );
+    if( !buf ) return SEGY_MEMORY_ERROR;
+
+    int err = SEGY_OK;
+    for( long long i = job->first; i < job->last; ) {
+        const long long first = i;
+        int n = 0;
+        for( ; n < batch && i < job->last; ++n, ++i )
+            tracenos[ n ] = i;
+
+        err = read_traces( ds, tracenos, n, 0, samples, 1,
+                           job->outformat, buf );
+        if( err != SEGY_OK ) break;
+
+        for( int k = 0; k < n; ++k ) {
+            const char* xs = buf + k * trsize;
+            const long long traceno = first + k;
+            const int group = job->groups ? job->groups[ traceno ] : 0;
+
+            segy_amplitudes acc;
+            amplitudes_init( &acc );
+            if( wide ) amplitudes_double( (const double*)xs, samples, &acc );
+            else       amplitudes_vec( (const float*)xs, samples, &acc );
+
+            segy_amplitudes_merge( job->stats + group, &acc );
+            if( job->traces ) job->traces[ traceno ] = acc;
+
+            if( job->histograms ) {
+                histogram_add( xs, wide, samples,
+                               job->low, job->high, job->bins,
+                               job->histograms + (long long)group * job->bins );
+            }
+        }
+    }
+
+    free( buf );
+    return err;
+}
+
+static void stats_job_worker( void* arg ) {
+    struct stats_job* job = (struct stats_job*)arg;
+    job->err = read_stats_job( job );
+}
+
+/* Like run_trace_jobs, for stats jobs */
+static int run_stats_jobs( struct stats_job* jobs,
+                           worker_thread* workers,
+                           bool* started,
+                           int threads ) {
+    for( int i = 1; i < threads; ++i )
+        started[ i ] = start_thread( workers + i, stats_job_worker,
+                                     jobs + i );
+
+    int err = read_stats_job( jobs );
+    for( int i = 1; i < threads; ++i ) {
+        if( started[ i ] ) join_thread( workers + i );
+        else               jobs[ i ].err = read_stats_job( jobs + i );
+
+        if( err == SEGY_OK ) err = jobs[ i ].err;
+    }
+
+    return err;
+}
+
+int segy_stats( segy_datasource* ds,
+                const int* groups,
+                int ngroups,
+                segy_amplitudes* stats,
+                segy_amplitudes* traces,
+                double low,
+                double high,
+                int bins,
+                long long* histograms,
+                int threads ) {
+
+    if( threads < 1 || ngroups < 1 ) return SEGY_INVALID_ARGS;
+    if( histograms && ( bins < 1 || !( low < high ) ) )
+        return SEGY_INVALID_ARGS;
+
+    const long long tracecount = ds->metadata.tracecount;
+    for( long long i = 0; groups && i < tracecount; ++i ) {
+        if( groups[ i ] < 0 || groups[ i ] >= ngroups )
+            return SEGY_INVALID_ARGS;
+    }
+
+    /*
+     * Samples are accumulated as float, unless that would lose precision, i.e.
+     * for 4-byte integers and all 8-byte formats
+     */
+    int outformat;
+    switch( ds->metadata.format ) {
+        case SEGY_SIGNED_INTEGER_4_BYTE:
+        case SEGY_UNSIGNED_INTEGER_4_BYTE:
+        case SEGY_SIGNED_INTEGER_8_BYTE:
+        case SEGY_UNSIGNED_INTEGER_8_BYTE:
+        case SEGY_IEEE_FLOAT_8_BYTE:
+            outformat = SEGY_IEEE_FLOAT_8_BYTE;
+            break;
+
+        default:
+            outformat = SEGY_IEEE_FLOAT_4_BYTE;
+            break;
+    }
+    if( native_size( ds->metadata.format, outformat ) < 0 )
+        return SEGY_INVALID_ARGS;
+
+    if( !ds->read_at ) threads = 1;
+    if( threads > tracecount ) threads = (int)tracecount;
+    if( threads < 1 ) threads = 1;
+
+    /* make sure the kernels are selected before any worker starts */
+    segy_simd();
+
+    /*
+     * The first job accumulates straight into the output, and the other jobs
+     * into their own copies that are merged into it at the end
+     */
+    const long long histsize = histograms ? (long long)ngroups * bins : 0;
+    const int copies = threads - 1;
+    struct stats_job* jobs = malloc( threads * sizeof( struct stats_job ) );
+    worker_thread* workers = malloc( threads * sizeof( worker_thread ) );
+    bool* started = calloc( threads, sizeof( bool ) );
+    segy_amplitudes* groupstats =
+        malloc( ( copies * (long long)ngroups + 1 ) * sizeof( segy_amplitudes ) );
+    long long* hists = calloc( copies * histsize + 1, sizeof( long long ) );
+
+    int err = SEGY_OK;
+    if( !jobs || !workers || !started || !groupstats || !hists ) {
+        err = SEGY_MEMORY_ERROR;
+        goto cleanup;
+    }
+
+    for( int g = 0; g < ngroups; ++g )
+        amplitudes_init( stats + g );
+    for( long long g = 0; g < copies * (long long)ngroups; ++g )
+        amplitudes_init( groupstats + g );
+    if( histograms )
+        memset( histograms, 0, histsize * sizeof( long long ) );
+
+    for( int i = 0; i < threads; ++i ) {
+        jobs[ i ].ds = ds;
+        jobs[ i ].first = tracecount * i / threads;
+        jobs[ i ].last = tracecount * ( i + 1 ) / threads;
+        jobs[ i ].outformat = outformat;
+        jobs[ i ].groups = groups;
+        jobs[ i ].stats = i == 0 ? stats
+                                 : groupstats + ( i - 1 ) * (long long)ngroups;
+        jobs[ i ].traces = traces;
+        jobs[ i ].low = low;
+        jobs[ i ].high = high;
+        jobs[ i ].bins = bins;
+        jobs[ i ].histograms = !histograms ? NULL
+                             : i == 0 ? histograms
+                             : hists + ( i - 1 ) * histsize;
+        jobs[ i ].err = SEGY_OK;
+    }
+
+    err = run_stats_jobs( jobs, workers, started, threads );
+    if( err != SEGY_OK ) goto cleanup;
+
+    for( int i = 1; i < threads; ++i ) {
+        for( int g = 0; g < ngroups; ++g )
+            segy_amplitudes_merge( stats + g, jobs[ i ].stats + g );
+
+        for( long long b = 0; b < histsize; ++b )
+            histograms[ b ] += jobs[ i ].histograms[ b ];
+    }
+
+cleanup:
+    free( jobs );
+    free( workers );
+    free( started );
+    free( groupstats );
+    free( hists );
+    return err;
+}
+
+/*
+ * Write the inline or crossline `lineno`. If it's an inline or crossline
+ * depends on the parameters. The line has a length of `line_length` traces,
+ * and `buf` must be of (minimum) `line_length*samples_per_trace` size.  Reads
+ * every `stride` trace, starting at the trace specified by the *position* of
+ * the value `lineno` in `linenos`. If `lineno` isn't present in `linenos`,
+ * SEGY_MISSING_LINE_INDEX will be returned.
+ *
+ * If reading a trace fails, this function will return whatever error
+ * segy_readtrace returns.
+ */
+int segy_write_line( segy_datasource* ds,
+                     int line_trace0,
+                     int line_length,
+                     int stride,
+                     int offsets,
+                     const void* buf ) {
+    if( !ds->writable ) return SEGY_READONLY;
 
-    char* dst = (char*) buf;
+    const char* src = (const char*) buf;
     stride *= offsets;
 
-    for( ; line_length--; line_trace0 += stride, dst += ds->metadata.trace_bsize ) {
-        int err = segy_readtrace( ds, line_trace0, dst );
-        if( err != 0 ) return err;
+    for( ; line_length--; line_trace0 += stride, src += ds->metadata.trace_bsize ) {
+        int err = segy_writetrace( ds, line_trace0, src );
+        if( err != 0 ) return err;
+    }
+
+    return SEGY_OK;
+}
+
+/*
+ * Buffered, sequential trace writer. The traces are encoded into the fill
+ * buffer as they are put, and the buffer is written in one go when full. With
+ * a background thread, the full buffer is handed over to a flush job, and the
+ * writer continues with the other buffer, so encoding and writing overlap.
+ */
+#define SEGY_WRITER_BUFFER_SIZE ( 8 * 1024 * 1024 )
+
+struct flush_job {
+    segy_datasource* ds;
+    long long pos;
+    const char* buf;
+    size_t size;
+    int err;
+};
+
+static void run_flush_job( struct flush_job* job ) {
+    job->err = write_at( job->ds, job->pos, job->buf, job->size );
+}
+
+static void flush_job_worker( void* arg ) {
+    run_flush_job( (struct flush_job*)arg );
+}
+
+struct segy_writer {
+    segy_datasource* ds;
+    const segy_entry_definition** mappings;
+    int flags;
+
+    long long pos;      /* disk position of the first trace in the buffer */
+    long long record;   /* bytes per trace, headers included */
+    long long capacity; /* traces per buffer */
+    long long used;     /* traces in the fill buffer */
+
+    char* buf[ 2 ];
+    int fill;           /* index of the buffer being filled */
+
+    struct flush_job job;
+    worker_thread thread;
+    bool flushing;      /* the flush job runs in the background thread */
+
+    int err;
+};
+
+static void writer_join( segy_writer* w ) {
+    if( !w->flushing ) return;
+
+    join_thread( &w->thread );
+    w->flushing = false;
+    if( w->err == SEGY_OK ) w->err = w->job.err;
+}
+
+static int writer_write_buffer( segy_writer* w ) {
+    if( w->used == 0 ) return w->err;
+
+    writer_join( w );
+
+    w->job.ds = w->ds;
+    w->job.pos = w->pos;
+    w->job.buf = w->buf[ w->fill ];
+    w->job.size = w->used * w->record;
+    w->job.err = SEGY_OK;
+
+    w->pos += w->used * w->record;
+    w->used = 0;
+
+    if( ( w->flags & SEGY_WRITER_BACKGROUND ) && w->buf[ 1 ]
+     && start_thread( &w->thread, flush_job_worker, &w->job ) ) {
+        w->flushing = true;
+        w->fill = 1 - w->fill;
+        return w->err;
+    }
+
+    run_flush_job( &w->job );
+    if( w->err == SEGY_OK ) w->err = w->job.err;
+    return w->err;
+}
+
+segy_writer* segy_writer_open( segy_datasource* ds,
+                               long long first,
+                               long long count,
+                               size_t bufsize,
+                               int flags,
+                               const segy_entry_definition* const* mappings ) {
+    if( !ds->writable ) return NULL;
+    if( first < 0 || count < 0 ) return NULL;
+
+    const int headers = ds->metadata.traceheader_count;
+    if( !mappings && headers > 2 ) return NULL;
+
+    segy_writer* w = calloc( 1, sizeof( segy_writer ) );
+    if( !w ) return NULL;
+
+    w->ds = ds;
+    w->flags = flags;
+    w->pos = traceheader_offset( ds, first, 0, 0 );
+    w->record = traceheader_offset( ds, 1, 0, 0 )
+              - traceheader_offset( ds, 0, 0, 0 );
+
+    if( bufsize == 0 ) bufsize = SEGY_WRITER_BUFFER_SIZE;
+    w->capacity = (long long)bufsize / w->record;
+    if( w->capacity < 1 ) w->capacity = 1;
+
+    w->mappings = malloc( headers * sizeof( segy_entry_definition* ) );
+    w->buf[ 0 ] = malloc( w->capacity * w->record );
+    if( !w->mappings || !w->buf[ 0 ] ) goto fail;
+
+    for( int i = 0; i < headers; ++i ) {
+        if( mappings )    w->mappings[ i ] = mappings[ i ];
+        else if( i == 0 ) w->mappings[ i ] =
+            ds->traceheader_mapping_standard.offset_to_entry_definition;
+        else              w->mappings[ i ] =
+            ds->traceheader_mapping_extension1.offset_to_entry_definition;
+    }
+
+    /*
+     * Without the second buffer, the writer silently falls back to writing
+     * in the calling thread
+     */
+    if( flags & SEGY_WRITER_BACKGROUND )
+        w->buf[ 1 ] = malloc( w->capacity * w->record );
+
+#ifdef HAVE_POSIX_FALLOCATE
+    const int fd = datasource_fd( ds );
+    if( ( flags & SEGY_WRITER_PREALLOCATE ) && count > 0 && fd >= 0 ) {
+        /* best effort, file systems without support just don't preallocate */
+        posix_fallocate( fd, (off_t)w->pos, (off_t)( count * w->record ) );
+    }
+#endif //HAVE_POSIX_FALLOCATE
+
+    return w;
+
+fail:
+    free( w->buf[ 0 ] );
+    free( w->mappings );
+    free( w );
+    return NULL;
+}
+
+int segy_writer_put( segy_writer* w, const char* headers, const void* samples ) {
+    if( w->err != SEGY_OK ) return w->err;
+
+    segy_datasource* ds = w->ds;
+    const int count = ds->metadata.traceheader_count;
+    const int samplecount = ds->metadata.samplecount;
+    const int elemsize = ds->metadata.elemsize;
+
+    char* dst = w->buf[ w->fill ] + w->used * w->record;
+    memcpy( dst, headers, count * SEGY_TRACE_HEADER_SIZE );
+    for( int i = 0; i < count; ++i ) {
+        char* header = dst + i * SEGY_TRACE_HEADER_SIZE;
+        swap_th_encoding( ds, w->mappings[ i ], a2e, header );
+        const int err = bswap_th( ds, w->mappings[ i ], header );
+        if( err != SEGY_OK ) return err;
+    }
+
+    char* trace = dst + count * SEGY_TRACE_HEADER_SIZE;
+    memcpy( trace, samples, ds->metadata.trace_bsize );
+    segy_from_native( ds->metadata.format, samplecount, trace );
+    if( ds->metadata.endianness == SEGY_LSB )
+        bswapvec( trace, samplecount, elemsize );
+
+    if( ++w->used == w->capacity )
+        return writer_write_buffer( w );
+
+    return SEGY_OK;
+}
+
+int segy_writer_flush( segy_writer* w ) {
+    writer_write_buffer( w );
+    writer_join( w );
+    return w->err;
+}
+
+int segy_writer_close( segy_writer* w ) {
+    const int err = segy_writer_flush( w );
+
+    free( w->buf[ 1 ] );
+    free( w->buf[ 0 ] );
+    free( w->mappings );
+    free( w );
+    return err;
+}
+
+/*
+ * A gather job reads the source traces src[first..last), sorted by trace
+ * number, into their slots in buf. Traces close to each other on disk are
+ * read with a single request into the chunk, and then copied to their slots.
+ */
+struct gather_job {
+    segy_datasource* ds;
+    long long trace0;
+    long long record;
+    const long long* src;
+    const long long* slot;
+    long long first;
+    long long last;
+    char* buf;
+    char* chunk;
+    long long chunksize;
+    int err;
+};
+
+static int read_gather_job( struct gather_job* job ) {
+    const long long record = job->record;
+    const long long* src = job->src;
+    const long long* slot = job->slot;
+
+    int err = SEGY_OK;
+    long long i = job->first;
+    while( i < job->last && err == SEGY_OK ) {
+        long long j = i + 1;
+        for( ; j < job->last; ++j ) {
+            const long long gap = ( src[ j ] - src[ j - 1 ] - 1 ) * record;
+            const long long span = ( src[ j ] - src[ i ] + 1 ) * record;
+            if( gap > SEGY_COALESCE_MAX_GAP || span > job->chunksize ) break;
+        }
+
+        const long long pos = job->trace0 + src[ i ] * record;
+        if( j - i == 1 ) {
+            err = read_at( job->ds, pos, job->buf + slot[ i ] * record, record );
+        } else {
+            const long long span = ( src[ j - 1 ] - src[ i ] + 1 ) * record;
+            err = read_at( job->ds, pos, job->chunk, span );
+            for( long long k = i; err == SEGY_OK && k < j; ++k ) {
+                memcpy( job->buf + slot[ k ] * record,
+                        job->chunk + ( src[ k ] - src[ i ] ) * record,
+                        record );
+            }
+        }
+
+        i = j;
+    }
+
+    return err;
+}
+
+static void gather_job_worker( void* arg ) {
+    struct gather_job* job = (struct gather_job*)arg;
+    job->err = read_gather_job( job );
+}
+
+/* Like run_trace_jobs, for gather jobs */
+static int run_gather_jobs( struct gather_job* jobs,
+                            worker_thread* workers,
+                            bool* started,
+                            int threads ) {
+    for( int i = 1; i < threads; ++i )
+        started[ i ] = start_thread( workers + i, gather_job_worker,
+                                     jobs + i );
+
+    int err = read_gather_job( jobs );
+    for( int i = 1; i < threads; ++i ) {
+        if( started[ i ] ) join_thread( workers + i );
+        else               jobs[ i ].err = read_gather_job( jobs + i );
+
+        if( err == SEGY_OK ) err = jobs[ i ].err;
+    }
+
+    return err;
+}
+
+int segy_permute_traces( segy_datasource* src,
+                         segy_datasource* dst,
+                         const long long* order,
+                         long long count,
+                         size_t memory,
+                         int threads ) {
+
+    if( threads < 1 || count < 0 ) return SEGY_INVALID_ARGS;
+
+    const long long traces = src->metadata.tracecount;
+    for( long long i = 0; i < count; ++i ) {
+        if( order[ i ] < 0 || order[ i ] >= traces )
+            return SEGY_INVALID_ARGS;
+    }
+
+    const long long trace0 = src->metadata.trace0;
+    const long long record = traceheader_offset( src, 1, 0, 0 ) - trace0;
+
+    if( !src->read_at ) threads = 1;
+    if( count > 0 && threads > count ) threads = (int)count;
+
+    /*
+     * The output is written front to back in bands of traces, double
+     * buffered so that a band is written in the background while the next
+     * band is read. Background writes need positional writes, since dst is
+     * then used by another thread.
+     */
+    long long band = (long long)( memory / ( 2 * record ) );
+    if( band < 1 ) band = 1;
+    if( band > count && count > 0 ) band = count;
+    const bool background = dst->write_at != NULL;
+    const long long chunksize = SEGY_COALESCE_MAX_SPAN;
+
+    char* bufs[ 2 ] = { malloc( band * record ), malloc( band * record ) };
+    long long* srcs = malloc( band * sizeof( long long ) );
+    long long* slots = malloc( 2 * band * sizeof( long long ) );
+    uint64_t* ukeys = malloc( 2 * band * sizeof( uint64_t ) );
+    char* chunks = malloc( threads * chunksize );
+    struct gather_job* jobs = malloc( threads * sizeof( struct gather_job ) );
+    worker_thread* workers = malloc( threads * sizeof( worker_thread ) );
+    bool* started = calloc( threads, sizeof( bool ) );
+
+    int err = SEGY_OK;
+    if( !bufs[ 0 ] || !bufs[ 1 ] || !srcs || !slots || !ukeys || !chunks
+     || !jobs || !workers || !started ) {
+        err = SEGY_MEMORY_ERROR;
+        goto cleanup;
+    }
+
+    /* the text and binary headers are copied as-is */
+    for( long long pos = 0; pos < trace0 && err == SEGY_OK; ) {
+        const long long len = trace0 - pos < band * record
+                            ? trace0 - pos
+                            : band * record;
+        err = read_at( src, pos, bufs[ 0 ], len );
+        if( err == SEGY_OK ) err = write_at( dst, pos, bufs[ 0 ], len );
+        pos += len;
     }
 
-    return SEGY_OK;
-}
+    struct flush_job flush;
+    worker_thread flusher;
+    bool flushing = false;
+    int fill = 0;
 
-/*
- * Write the inline or crossline `lineno`. If it's an inline or crossline
- * depends on the parameters. The line has a length of `line_length` traces,
- * and `buf` must be of (minimum) `line_length*samples_per_trace` size.  Reads
- * every `stride` trace, starting at the trace specified by the *position* of
- * the value `lineno` in `linenos`. If `lineno` isn't present in `linenos`,
- * SEGY_MISSING_LINE_INDEX will be returned.
- *
- * If reading a trace fails, this function will return whatever error
- * segy_readtrace returns.
- */
-int segy_write_line( segy_datasource* ds,
-                     int line_trace0,
-                     int line_length,
-                     int stride,
-                     int offsets,
-                     const void* buf ) {
-    if( !ds->writable ) return SEGY_READONLY;
+    for( long long o0 = 0; o0 < count && err == SEGY_OK; o0 += band ) {
+        const long long n = count - o0 < band ? count - o0 : band;
+        char* buf = bufs[ fill ];
 
-    const char* src = (const char*) buf;
-    stride *= offsets;
+        /* read the band in file order, so that near traces are coalesced */
+        for( long long k = 0; k < n; ++k ) {
+            ukeys[ k ] = (uint64_t)order[ o0 + k ];
+            slots[ k ] = k;
+        }
+        err = radix_sort_pairs( ukeys, slots, ukeys + band, slots + band, n );
+        if( err != SEGY_OK ) break;
+
+        for( long long k = 0; k < n; ++k )
+            srcs[ k ] = (long long)ukeys[ k ];
+
+        for( int t = 0; t < threads; ++t ) {
+            jobs[ t ].ds = src;
+            jobs[ t ].trace0 = trace0;
+            jobs[ t ].record = record;
+            jobs[ t ].src = srcs;
+            jobs[ t ].slot = slots;
+            jobs[ t ].first = n * t / threads;
+            jobs[ t ].last = n * ( t + 1 ) / threads;
+            jobs[ t ].buf = buf;
+            jobs[ t ].chunk = chunks + t * chunksize;
+            jobs[ t ].chunksize = chunksize;
+            jobs[ t ].err = SEGY_OK;
+        }
 
-    for( ; line_length--; line_trace0 += stride, src += ds->metadata.trace_bsize ) {
-        int err = segy_writetrace( ds, line_trace0, src );
-        if( err != 0 ) return err;
+        err = run_gather_jobs( jobs, workers, started, threads );
+
+        if( flushing ) {
+            join_thread( &flusher );
+            flushing = false;
+            if( err == SEGY_OK ) err = flush.err;
+        }
+        if( err != SEGY_OK ) break;
+
+        flush.ds = dst;
+        flush.pos = trace0 + o0 * record;
+        flush.buf = buf;
+        flush.size = n * record;
+        flush.err = SEGY_OK;
+
+        flushing = background
+                && start_thread( &flusher, flush_job_worker, &flush );
+        if( !flushing ) {
+            run_flush_job( &flush );
+            err = flush.err;
+        }
+
+        fill ^= 1;
     }
 
-    return SEGY_OK;
+    if( flushing ) {
+        join_thread( &flusher );
+        if( err == SEGY_OK ) err = flush.err;
+    }
+
+cleanup:
+    free( bufs[ 0 ] );
+    free( bufs[ 1 ] );
+    free( srcs );
+    free( slots );
+    free( ukeys );
+    free( chunks );
+    free( jobs );
+    free( workers );
+    free( started );
+    return err;
 }
 
 int segy_line_trace0( int lineno,
@@ -3204,11 +8195,8 @@ int segy_read_ext_textheader( segy_datasource* ds, int pos, char *buf) {
                         SEGY_TEXT_HEADER_SIZE + SEGY_BINARY_HEADER_SIZE +
                         (pos * SEGY_TEXT_HEADER_SIZE);
 
-    int err = ds->seek( ds, offset, SEEK_SET );
-    if( err != 0 ) return SEGY_DS_SEEK_ERROR;
-
-    err = ds->read( ds, buf, SEGY_TEXT_HEADER_SIZE );
-    if( err != 0 ) return SEGY_DS_READ_ERROR;
+    int err = read_at( ds, offset, buf, SEGY_TEXT_HEADER_SIZE );
+    if( err != SEGY_OK ) return err;
 
     if( pos == -1 && ds->metadata.encoding == SEGY_EBCDIC ) {
         encode( buf, buf, e2a, SEGY_TEXT_HEADER_SIZE );
@@ -3236,11 +8224,8 @@ int segy_write_textheader( segy_datasource* ds, int pos, const char* buf ) {
                       : SEGY_TEXT_HEADER_SIZE + SEGY_BINARY_HEADER_SIZE +
                         ((pos-1) * SEGY_TEXT_HEADER_SIZE);
 
-    err = ds->seek( ds, offset, SEEK_SET );
-    if( err != 0 ) return SEGY_DS_SEEK_ERROR;
-
-    err = ds->write( ds, mbuf, SEGY_TEXT_HEADER_SIZE );
-    if( err != 0 ) return SEGY_DS_WRITE_ERROR;
+    err = write_at( ds, offset, mbuf, SEGY_TEXT_HEADER_SIZE );
+    if( err != SEGY_OK ) return err;
 
     return SEGY_OK;
 }
@@ -3412,6 +8397,456 @@ int segy_rotation_cw( segy_datasource* ds,
     return SEGY_OK;
 }
 
+static int column_value( int datatype, const char* src, double* out ) {
+    int16_t i16; int32_t i32;
+    uint16_t u16; uint32_t u32;
+    float f32; double f64;
+
+    switch( datatype ) {
+        case SEGY_SIGNED_SHORT_2_BYTE:
+            memcpy( &i16, src, 2 ); *out = i16; return SEGY_OK;
+        case SEGY_SIGNED_INTEGER_4_BYTE:
+            memcpy( &i32, src, 4 ); *out = i32; return SEGY_OK;
+        case SEGY_UNSIGNED_SHORT_2_BYTE:
+            memcpy( &u16, src, 2 ); *out = u16; return SEGY_OK;
+        case SEGY_UNSIGNED_INTEGER_4_BYTE:
+            memcpy( &u32, src, 4 ); *out = u32; return SEGY_OK;
+        case SEGY_IBM_FLOAT_4_BYTE:
+        case SEGY_IEEE_FLOAT_4_BYTE:
+            memcpy( &f32, src, 4 ); *out = f32; return SEGY_OK;
+        case SEGY_IEEE_FLOAT_8_BYTE:
+            memcpy( &f64, src, 8 ); *out = f64; return SEGY_OK;
+        default:
+            return SEGY_INVALID_FIELD_DATATYPE;
+    }
+}
+
+/*
+ * Like apply_scalar, but in double precision, as projected coordinates are
+ * often too large to be scaled exactly in single precision.
+ */
+static double scale_coordinate( double raw, int scalar ) {
+    if( scalar == 0 ) return raw;
+    if( scalar < 0 )  return raw / -scalar;
+    return raw * scalar;
+}
+
+int segy_read_cdps( segy_datasource* ds, double* cdpx, double* cdpy ) {
+    const long long tracecount = ds->metadata.tracecount;
+    if( tracecount <= 0 ) return SEGY_OK;
+
+    const segy_header_mapping* standard = &ds->traceheader_mapping_standard;
+    const segy_header_mapping* ext1 = &ds->traceheader_mapping_extension1;
+    const segy_entry_definition* smap = standard->offset_to_entry_definition;
+    const segy_entry_definition* emap = ext1->offset_to_entry_definition;
+
+    const int fields[ 5 ] = {
+        standard->name_to_offset[ SEGY_TR_CDP_X ],
+        standard->name_to_offset[ SEGY_TR_CDP_Y ],
+        standard->name_to_offset[ SEGY_TR_SOURCE_GROUP_SCALAR ],
+        ext1->name_to_offset[ SEGY_EXT1_CDP_X ],
+        ext1->name_to_offset[ SEGY_EXT1_CDP_Y ],
+    };
+
+    /*
+     * The standard coordinates must be integers, which are scaled, or floats,
+     * which are not. This breaks spec on purpose, like scaled_cdp does.
+     */
+    for( int i = 0; i < 2; ++i ) {
+        switch( smap[ fields[ i ] - 1 ].entry_type ) {
+            case SEGY_ENTRY_TYPE_IBMFP:
+            case SEGY_ENTRY_TYPE_IEEE32:
+            case SEGY_ENTRY_TYPE_COOR4:
+            case SEGY_ENTRY_TYPE_INT4:
+            case SEGY_ENTRY_TYPE_UINT4:
+                break;
+            default:
+                return SEGY_INVALID_FIELD_DATATYPE;
+        }
+    }
+
+    switch( smap[ fields[ 2 ] - 1 ].entry_type ) {
+        case SEGY_ENTRY_TYPE_INT2:
+        case SEGY_ENTRY_TYPE_UINT2:
+            break;
+        default:
+            return SEGY_INVALID_FIELD_DATATYPE;
+    }
+
+    /* the extension header 1 coordinates are used only if they're mapped */
+    bool use_ext1[ 2 ];
+    for( int i = 0; i < 2; ++i ) {
+        const SEGY_ENTRY_TYPE type = emap[ fields[ 3 + i ] - 1 ].entry_type;
+        use_ext1[ i ] = ds->metadata.traceheader_count > 1
+                     && type != SEGY_ENTRY_TYPE_UNDEFINED;
+        if( use_ext1[ i ] && type != SEGY_ENTRY_TYPE_IEEE64 )
+            return SEGY_INVALID_FIELD_DATATYPE;
+    }
+
+    const int ncolumns = 3 + use_ext1[ 0 ] + use_ext1[ 1 ];
+    char* buf = malloc( ncolumns * tracecount * sizeof( double ) );
+    if( !buf ) return SEGY_MEMORY_ERROR;
+
+    segy_header_column columns[ 5 ];
+    int datatypes[ 5 ];
+    int c = 0;
+    for( int i = 0; i < 5; ++i ) {
+        if( i >= 3 && !use_ext1[ i - 3 ] ) continue;
+
+        const segy_entry_definition* map = i < 3 ? smap : emap;
+        columns[ c ].traceheader_index = i < 3 ? 0 : 1;
+        columns[ c ].offset_map = map;
+        columns[ c ].field = fields[ i ];
+        columns[ c ].buf = buf + c * tracecount * sizeof( double );
+        datatypes[ i ] = entry_type_to_datatype_map[
+                            map[ fields[ i ] - 1 ].entry_type ];
+        ++c;
+    }
+
+    int err = segy_read_all_traceheaders( ds, columns, ncolumns );
+    if( err != SEGY_OK ) {
+        free( buf );
+        return err;
+    }
+
+    const char* xs = columns[ 0 ].buf;
+    const char* ys = columns[ 1 ].buf;
+    const char* scalars = columns[ 2 ].buf;
+    const char* ext1_xs = use_ext1[ 0 ] ? columns[ 3 ].buf : NULL;
+    const char* ext1_ys = use_ext1[ 1 ] ? columns[ 2 + ncolumns - 3 ].buf : NULL;
+
+    const int xsize = segy_formatsize( datatypes[ 0 ] );
+    const int ysize = segy_formatsize( datatypes[ 1 ] );
+    const int ssize = segy_formatsize( datatypes[ 2 ] );
+    const bool xfloat = datatypes[ 0 ] == SEGY_IBM_FLOAT_4_BYTE
+                     || datatypes[ 0 ] == SEGY_IEEE_FLOAT_4_BYTE;
+    const bool yfloat = datatypes[ 1 ] == SEGY_IBM_FLOAT_4_BYTE
+                     || datatypes[ 1 ] == SEGY_IEEE_FLOAT_4_BYTE;
+    const bool xnonzero = emap[ fields[ 3 ] - 1 ].requires_nonzero_value;
+    const bool ynonzero = emap[ fields[ 4 ] - 1 ].requires_nonzero_value;
+
+    for( long long t = 0; err == SEGY_OK && t < tracecount; ++t ) {
+        double x, y, scalar;
+
+        err = column_value( datatypes[ 2 ], scalars + t * ssize, &scalar );
+        if( err != SEGY_OK ) break;
+
+        if( ext1_xs ) memcpy( &x, ext1_xs + t * sizeof( double ), sizeof( x ) );
+        if( !ext1_xs || ( x == 0 && xnonzero ) ) {
+            err = column_value( datatypes[ 0 ], xs + t * xsize, &x );
+            if( !xfloat ) x = scale_coordinate( x, (int)scalar );
+        }
+
+        if( ext1_ys ) memcpy( &y, ext1_ys + t * sizeof( double ), sizeof( y ) );
+        if( err == SEGY_OK && ( !ext1_ys || ( y == 0 && ynonzero ) ) ) {
+            err = column_value( datatypes[ 1 ], ys + t * ysize, &y );
+            if( !yfloat ) y = scale_coordinate( y, (int)scalar );
+        }
+
+        cdpx[ t ] = x;
+        cdpy[ t ] = y;
+    }
+
+    free( buf );
+    return err;
+}
+
+static long long spatial_cell( double v, double v0, double cellsize,
+                               long long cells ) {
+    const double c = floor( ( v - v0 ) / cellsize );
+    if( !( c > 0 ) ) return 0;
+    if( c >= cells ) return cells - 1;
+    return (long long)c;
+}
+
+int segy_spatial_grid( segy_spatial_index* index ) {
+    const long long n = index->n;
+    if( n < 0 ) return SEGY_INVALID_ARGS;
+
+    index->x0 = 0;
+    index->y0 = 0;
+    index->cellsize = 1;
+    index->columns = 1;
+    index->rows = 1;
+    if( n == 0 ) return SEGY_OK;
+
+    double minx = index->x[ 0 ], maxx = index->x[ 0 ];
+    double miny = index->y[ 0 ], maxy = index->y[ 0 ];
+    for( long long i = 0; i < n; ++i ) {
+        const double x = index->x[ i ];
+        const double y = index->y[ i ];
+        if( !isfinite( x ) || !isfinite( y ) ) return SEGY_INVALID_ARGS;
+        if( x < minx ) minx = x;
+        if( x > maxx ) maxx = x;
+        if( y < miny ) miny = y;
+        if( y > maxy ) maxy = y;
+    }
+
+    /*
+     * Aim for about two points per cell. Cells are square, and at least as
+     * large as the longest side over the number of cells, so that a survey
+     * that is a thin strip does not get a lot more cells than points.
+     */
+    const double cells = n > 2 ? n / 2.0 : 1.0;
+    const double w = maxx - minx;
+    const double h = maxy - miny;
+    const double side = w > h ? w : h;
+    double cellsize = sqrt( w * h / cells );
+    if( cellsize < side / cells ) cellsize = side / cells;
+    if( !( cellsize > 0 ) ) cellsize = 1;
+
+    index->x0 = minx;
+    index->y0 = miny;
+    index->cellsize = cellsize;
+    index->columns = (long long)( w / cellsize ) + 1;
+    index->rows = (long long)( h / cellsize ) + 1;
+    return SEGY_OK;
+}
+
+int segy_spatial_build( segy_spatial_index* index ) {
+    const long long n = index->n;
+    const long long columns = index->columns;
+    const long long rows = index->rows;
+    if( n < 0 || columns < 1 || rows < 1 ) return SEGY_INVALID_ARGS;
+    if( !( index->cellsize > 0 ) ) return SEGY_INVALID_ARGS;
+
+    long long* offsets = index->offsets;
+    const long long cells = columns * rows;
+    memset( offsets, 0, ( cells + 1 ) * sizeof( long long ) );
+
+    for( long long i = 0; i < n; ++i ) {
+        const long long cx = spatial_cell( index->x[ i ], index->x0,
+                                           index->cellsize, columns );
+        const long long cy = spatial_cell( index->y[ i ], index->y0,
+                                           index->cellsize, rows );
+        ++offsets[ cy * columns + cx + 1 ];
+    }
+
+    for( long long c = 0; c < cells; ++c )
+        offsets[ c + 1 ] += offsets[ c ];
+
+    /*
+     * Place the points with offsets[c] as the cursor of cell c, which leaves
+     * offsets[c] at the start of cell c + 1, and shift them back after
+     */
+    for( long long i = 0; i < n; ++i ) {
+        const long long cx = spatial_cell( index->x[ i ], index->x0,
+                                           index->cellsize, columns );
+        const long long cy = spatial_cell( index->y[ i ], index->y0,
+                                           index->cellsize, rows );
+        index->index[ offsets[ cy * columns + cx ]++ ] = i;
+    }
+
+    for( long long c = cells; c > 0; --c )
+        offsets[ c ] = offsets[ c - 1 ];
+    offsets[ 0 ] = 0;
+
+    return SEGY_OK;
+}
+
+/* ordered by distance, then point number */
+static bool spatial_less( double d1, long long p1, double d2, long long p2 ) {
+    return d1 < d2 || ( d1 == d2 && p1 < p2 );
+}
+
+/* sift the element at i down the max-heap of size n */
+static void spatial_sift_down( long long* points, double* distances,
+                               int i, int n ) {
+    for( ;; ) {
+        int largest = i;
+        const int left = 2 * i + 1;
+        const int right = left + 1;
+
+        if( left < n && spatial_less( distances[ largest ], points[ largest ],
+                                      distances[ left ], points[ left ] ) )
+            largest = left;
+        if( right < n && spatial_less( distances[ largest ], points[ largest ],
+                                       distances[ right ], points[ right ] ) )
+            largest = right;
+        if( largest == i ) return;
+
+        const long long p = points[ i ];
+        const double d = distances[ i ];
+        points[ i ] = points[ largest ];
+        distances[ i ] = distances[ largest ];
+        points[ largest ] = p;
+        distances[ largest ] = d;
+        i = largest;
+    }
+}
+
+int segy_spatial_nearest( const segy_spatial_index* index,
+                          double x,
+                          double y,
+                          int k,
+                          long long* points,
+                          double* distances,
+                          int* found ) {
+    if( k < 0 ) return SEGY_INVALID_ARGS;
+    if( !isfinite( x ) || !isfinite( y ) ) return SEGY_INVALID_ARGS;
+
+    const int size = index->n < k ? (int)index->n : k;
+    *found = size;
+    if( size == 0 ) return SEGY_OK;
+
+    const long long columns = index->columns;
+    const long long rows = index->rows;
+    const double cellsize = index->cellsize;
+    const long long cx = spatial_cell( x, index->x0, cellsize, columns );
+    const long long cy = spatial_cell( y, index->y0, cellsize, rows );
+
+    long long last = cx;
+    if( columns - 1 - cx > last ) last = columns - 1 - cx;
+    if( cy > last ) last = cy;
+    if( rows - 1 - cy > last ) last = rows - 1 - cy;
+
+    /*
+     * Search the cells in rings around the cell of (x, y), and keep the k
+     * nearest points so far in a max-heap of squared distances. The points
+     * outside ring r are at least r cells away, so the search stops when the
+     * heap is full and its farthest point is no farther than that.
+     */
+    int heapsize = 0;
+    for( long long r = 0; r <= last; ++r ) {
+        for( long long j = cy - r; j <= cy + r; ++j ) {
+            if( j < 0 || j >= rows ) continue;
+
+            /* only the first and last row of the ring are whole */
+            const long long step = ( j == cy - r || j == cy + r )
+                                 ? 1
+                                 : ( r > 0 ? 2 * r : 1 );
+
+            for( long long i = cx - r; i <= cx + r; i += step ) {
+                if( i < 0 || i >= columns ) continue;
+
+                const long long c = j * columns + i;
+                for( long long p = index->offsets[ c ];
+                     p < index->offsets[ c + 1 ];
+                     ++p ) {
+                    const long long point = index->index[ p ];
+                    const double dx = index->x[ point ] - x;
+                    const double dy = index->y[ point ] - y;
+                    const double d = dx * dx + dy * dy;
+
+                    if( heapsize < size ) {
+                        /* sift up */
+                        int n = heapsize++;
+                        while( n > 0 ) {
+                            const int parent = ( n - 1 ) / 2;
+                            if( !spatial_less( distances[ parent ],
+                                               points[ parent ],
+                                               d, point ) )
+                                break;
+                            points[ n ] = points[ parent ];
+                            distances[ n ] = distances[ parent ];
+                            n = parent;
+                        }
+                        points[ n ] = point;
+                        distances[ n ] = d;
+                    } else if( spatial_less( d, point,
+                                             distances[ 0 ], points[ 0 ] ) ) {
+                        points[ 0 ] = point;
+                        distances[ 0 ] = d;
+                        spatial_sift_down( points, distances, 0, heapsize );
+                    }
+                }
+            }
+        }
+
+        const double reach = r * cellsize;
+        if( heapsize == size && distances[ 0 ] <= reach * reach ) break;
+    }
+
+    /* heap sort, nearest first */
+    for( int n = heapsize - 1; n > 0; --n ) {
+        const long long p = points[ 0 ];
+        const double d = distances[ 0 ];
+        points[ 0 ] = points[ n ];
+        distances[ 0 ] = distances[ n ];
+        points[ n ] = p;
+        distances[ n ] = d;
+        spatial_sift_down( points, distances, 0, n );
+    }
+
+    for( int n = 0; n < heapsize; ++n )
+        distances[ n ] = sqrt( distances[ n ] );
+
+    return SEGY_OK;
+}
+
+/* point-in-polygon with the even-odd rule, by casting a ray east */
+static bool inside_polygon( const double* polygon, int vertices,
+                            double x, double y ) {
+    bool inside = false;
+    for( int i = 0, j = vertices - 1; i < vertices; j = i++ ) {
+        const double xi = polygon[ 2 * i ], yi = polygon[ 2 * i + 1 ];
+        const double xj = polygon[ 2 * j ], yj = polygon[ 2 * j + 1 ];
+
+        if( ( yi > y ) != ( yj > y )
+         && x < ( xj - xi ) * ( y - yi ) / ( yj - yi ) + xi )
+            inside = !inside;
+    }
+    return inside;
+}
+
+static int compare_points( const void* lhs, const void* rhs ) {
+    const long long l = *(const long long*)lhs;
+    const long long r = *(const long long*)rhs;
+    return ( l > r ) - ( l < r );
+}
+
+int segy_spatial_within( const segy_spatial_index* index,
+                         const double* polygon,
+                         int vertices,
+                         long long* points,
+                         long long* count ) {
+    if( vertices < 3 ) return SEGY_INVALID_ARGS;
+
+    double minx = polygon[ 0 ], maxx = polygon[ 0 ];
+    double miny = polygon[ 1 ], maxy = polygon[ 1 ];
+    for( int i = 0; i < vertices; ++i ) {
+        const double x = polygon[ 2 * i ];
+        const double y = polygon[ 2 * i + 1 ];
+        if( !isfinite( x ) || !isfinite( y ) ) return SEGY_INVALID_ARGS;
+        if( x < minx ) minx = x;
+        if( x > maxx ) maxx = x;
+        if( y < miny ) miny = y;
+        if( y > maxy ) maxy = y;
+    }
+
+    *count = 0;
+    if( index->n == 0 ) return SEGY_OK;
+
+    /* only the cells overlapping the bounding box can have points inside */
+    const double cellsize = index->cellsize;
+    const long long c0 = spatial_cell( minx, index->x0, cellsize, index->columns );
+    const long long c1 = spatial_cell( maxx, index->x0, cellsize, index->columns );
+    const long long r0 = spatial_cell( miny, index->y0, cellsize, index->rows );
+    const long long r1 = spatial_cell( maxy, index->y0, cellsize, index->rows );
+
+    long long n = 0;
+    for( long long j = r0; j <= r1; ++j ) {
+        for( long long i = c0; i <= c1; ++i ) {
+            const long long c = j * index->columns + i;
+            for( long long p = index->offsets[ c ];
+                 p < index->offsets[ c + 1 ];
+                 ++p ) {
+                const long long point = index->index[ p ];
+                const double x = index->x[ point ];
+                const double y = index->y[ point ];
+
+                if( x < minx || x > maxx || y < miny || y > maxy ) continue;
+                if( inside_polygon( polygon, vertices, x, y ) )
+                    points[ n++ ] = point;
+            }
+        }
+    }
+
+    qsort( points, n, sizeof( long long ), compare_points );
+    *count = n;
+    return SEGY_OK;
+}
+
 /** Parses stanza header ((stanza_name)) from the text.
  *
  * If header is found, stanza name and stanza name length is extracted and set.
@@ -3494,11 +8929,8 @@ static int read_stanza_header(
     char header[SEGY_TEXT_HEADER_SIZE];
     memset( header, 0, SEGY_TEXT_HEADER_SIZE );
 
-    int err = ds->seek( ds, offset, 0 );
-    if( err != 0 ) return SEGY_DS_SEEK_ERROR;
-
-    err = ds->read( ds, header, read_size );
-    if( err != 0 ) return SEGY_DS_READ_ERROR;
+    int err = read_at( ds, offset, header, read_size );
+    if( err != SEGY_OK ) return err;
 
     return parse_stanza_header(
         header, read_size, stanza_name, stanza_name_length
@@ -3538,11 +8970,365 @@ int segy_read_stanza_data(
                         SEGY_TEXT_HEADER_SIZE * stanza_headerno +
                         (int)stanza_header_length;
 
-    int err = ds->seek( ds, offset, SEEK_SET );
-    if( err != 0 ) return SEGY_DS_SEEK_ERROR;
+    int err = read_at( ds, offset, stanza_data, stanza_data_size );
+    if( err != SEGY_OK ) return err;
 
-    err = ds->read( ds, stanza_data, stanza_data_size );
-    if( err != 0 ) return SEGY_DS_READ_ERROR;
+    return SEGY_OK;
+}
+
+/*
+ * The geometry index is a little-endian file with a fixed 64-byte header,
+ * followed by the inline, crossline and offset labels as 4-byte integers:
+ *
+ *   0  magic "segyidx2"
+ *   8  size of the segy file (int64)
+ *  16  mtime of the segy file (int64), 0 if not recorded
+ *  24  FNV-1a hash of the binary header and some trace headers (uint64)
+ *  32  il, xl, offset field, sorting, tracecount,
+ *      iline count, xline count, offset count (int32)
+ */
+#define SEGY_INDEX_HEADER_SIZE 64
+
+/*
+ * Version 1 also stored the key of every trace, and was written from
+ * geometry that was only checked at a few traces
+ */
+static const char index_magic[] = "segyidx2";
+
+static void put_le32( char* dst, int32_t x ) {
+    const uint32_t u = (uint32_t)x;
+    dst[0] = (char)( u        & 0xFF );
+    dst[1] = (char)((u >>  8) & 0xFF );
+    dst[2] = (char)((u >> 16) & 0xFF );
+    dst[3] = (char)((u >> 24) & 0xFF );
+}
+
+static int32_t get_le32( const char* src ) {
+    const unsigned char* s = (const unsigned char*)src;
+    const uint32_t u = (uint32_t)s[0]
+                     | (uint32_t)s[1] <<  8
+                     | (uint32_t)s[2] << 16
+                     | (uint32_t)s[3] << 24;
+    return (int32_t)u;
+}
+
+static void put_le64( char* dst, uint64_t x ) {
+    put_le32( dst,     (int32_t)( x        & 0xFFFFFFFF ) );
+    put_le32( dst + 4, (int32_t)((x >> 32) & 0xFFFFFFFF ) );
+}
+
+static uint64_t get_le64( const char* src ) {
+    return (uint64_t)(uint32_t)get_le32( src )
+         | (uint64_t)(uint32_t)get_le32( src + 4 ) << 32;
+}
+
+static uint64_t fnv1a( uint64_t hash, const char* buf, size_t len ) {
+    const unsigned char* xs = (const unsigned char*)buf;
+    for( size_t i = 0; i < len; ++i ) {
+        hash ^= xs[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*
+ * Fingerprint the file by its binary header and the first, middle and last
+ * trace header. Combined with the file size, this catches files that have
+ * been replaced or had their headers rewritten, without reading all of it.
+ */
+static int index_fingerprint( segy_datasource* ds, uint64_t* out ) {
+    char buf[ SEGY_BINARY_HEADER_SIZE ];
+    uint64_t hash = 14695981039346656037ULL;
+
+    int err = read_at( ds, SEGY_TEXT_HEADER_SIZE, buf, SEGY_BINARY_HEADER_SIZE );
+    if( err != SEGY_OK ) return err;
+    hash = fnv1a( hash, buf, SEGY_BINARY_HEADER_SIZE );
+
+    const long long tracecount = ds->metadata.tracecount;
+    const long long traces[] = { 0, tracecount / 2, tracecount - 1 };
+    for( int i = 0; i < 3 && tracecount > 0; ++i ) {
+        const long long pos = traceheader_offset( ds, traces[i], 0, 0 );
+        err = read_at( ds, pos, buf, SEGY_TRACE_HEADER_SIZE );
+        if( err != SEGY_OK ) return err;
+        hash = fnv1a( hash, buf, SEGY_TRACE_HEADER_SIZE );
+    }
+
+    *out = hash;
+    return SEGY_OK;
+}
+
+static void encode_index_header( const segy_index_header* h,
+                                 long long filesize,
+                                 long long mtime,
+                                 uint64_t hash,
+                                 char* buf ) {
+    memcpy( buf, index_magic, 8 );
+    put_le64( buf +  8, (uint64_t)filesize );
+    put_le64( buf + 16, (uint64_t)mtime );
+    put_le64( buf + 24, hash );
+    put_le32( buf + 32, h->il );
+    put_le32( buf + 36, h->xl );
+    put_le32( buf + 40, h->offset );
+    put_le32( buf + 44, h->sorting );
+    put_le32( buf + 48, h->tracecount );
+    put_le32( buf + 52, h->iline_count );
+    put_le32( buf + 56, h->xline_count );
+    put_le32( buf + 60, h->offset_count );
+}
+
+static int decode_index_header( FILE* fp,
+                                long long* filesize,
+                                long long* mtime,
+                                uint64_t* hash,
+                                segy_index_header* h ) {
+    char buf[ SEGY_INDEX_HEADER_SIZE ];
+
+    if( fseek( fp, 0, SEEK_SET ) != 0 ) return SEGY_FSEEK_ERROR;
+    if( fread( buf, sizeof( buf ), 1, fp ) != 1 ) return SEGY_INVALID_INDEX;
+    if( memcmp( buf, index_magic, 8 ) != 0 ) return SEGY_INVALID_INDEX;
+
+    *filesize = (long long)get_le64( buf +  8 );
+    *mtime    = (long long)get_le64( buf + 16 );
+    *hash     = get_le64( buf + 24 );
+
+    h->il           = get_le32( buf + 32 );
+    h->xl           = get_le32( buf + 36 );
+    h->offset       = get_le32( buf + 40 );
+    h->sorting      = get_le32( buf + 44 );
+    h->tracecount   = get_le32( buf + 48 );
+    h->iline_count  = get_le32( buf + 52 );
+    h->xline_count  = get_le32( buf + 56 );
+    h->offset_count = get_le32( buf + 60 );
+
+    if( h->tracecount   < 1 ) return SEGY_INVALID_INDEX;
+    if( h->iline_count  < 1 ) return SEGY_INVALID_INDEX;
+    if( h->xline_count  < 1 ) return SEGY_INVALID_INDEX;
+    if( h->offset_count < 1 ) return SEGY_INVALID_INDEX;
+    return SEGY_OK;
+}
+
+static int write_index_ints( FILE* fp, const int* xs, size_t n ) {
+    char buf[ 4096 ];
+    const size_t chunk = sizeof( buf ) / 4;
+
+    while( n > 0 ) {
+        const size_t len = n < chunk ? n : chunk;
+        for( size_t i = 0; i < len; ++i )
+            put_le32( buf + 4 * i, xs[i] );
+
+        if( fwrite( buf, 4, len, fp ) != len ) return SEGY_FWRITE_ERROR;
+        xs += len;
+        n -= len;
+    }
+
+    return SEGY_OK;
+}
+
+static int read_index_ints( FILE* fp, int* xs, size_t n ) {
+    char buf[ 4096 ];
+    const size_t chunk = sizeof( buf ) / 4;
+
+    while( n > 0 ) {
+        const size_t len = n < chunk ? n : chunk;
+        if( fread( buf, 4, len, fp ) != len ) return SEGY_INVALID_INDEX;
+
+        for( size_t i = 0; i < len; ++i )
+            xs[i] = get_le32( buf + 4 * i );
+
+        xs += len;
+        n -= len;
+    }
+
+    return SEGY_OK;
+}
+
+static int write_index_body( segy_datasource* ds,
+                             const segy_index_header* h,
+                             FILE* fp ) {
+    const size_t lines = (size_t)h->iline_count
+                       + (size_t)h->xline_count
+                       + (size_t)h->offset_count;
+    int* labels = malloc( lines * sizeof( int ) );
+    if( !labels ) return SEGY_MEMORY_ERROR;
+
+    int* ilines  = labels;
+    int* xlines  = ilines + h->iline_count;
+    int* offsets = xlines + h->xline_count;
+
+    int err = segy_inline_indices( ds, h->il,
+                                       h->sorting,
+                                       h->iline_count,
+                                       h->xline_count,
+                                       h->offset_count,
+                                       ilines );
+    if( err == SEGY_OK )
+        err = segy_crossline_indices( ds, h->xl,
+                                          h->sorting,
+                                          h->iline_count,
+                                          h->xline_count,
+                                          h->offset_count,
+                                          xlines );
+    if( err == SEGY_OK )
+        err = segy_offset_indices( ds, h->offset, h->offset_count, offsets );
+    if( err == SEGY_OK )
+        err = write_index_ints( fp, labels, lines );
+
+    free( labels );
+    return err;
+}
+
+int segy_write_index( segy_datasource* ds,
+                      const char* path,
+                      long long mtime,
+                      int il,
+                      int xl,
+                      int offset ) {
+    if( !path ) return SEGY_INVALID_ARGS;
+    if( ds->metadata.tracecount > INT_MAX ) return SEGY_TOO_MANY_TRACES;
+
+    segy_index_header h;
+    h.il = il;
+    h.xl = xl;
+    h.offset = offset;
+    h.tracecount = ds->metadata.tracecount;
+
+    /*
+     * The index is trusted without looking at the trace headers again, so
+     * check every trace against the grid before writing it
+     */
+    segy_geometry geo;
+    int err = segy_infer_geometry( ds, il, xl, offset, 1, &geo );
+    if( err != SEGY_OK ) return err;
+
+    h.sorting = geo.sorting;
+    h.offset_count = geo.offset_count;
+    h.iline_count = geo.iline_count;
+    h.xline_count = geo.xline_count;
+
+    long long filesize;
+    err = ds->size( ds, &filesize );
+    if( err != 0 ) return SEGY_DS_ERROR;
+
+    uint64_t hash;
+    err = index_fingerprint( ds, &hash );
+    if( err != SEGY_OK ) return err;
+
+    char header[ SEGY_INDEX_HEADER_SIZE ];
+    encode_index_header( &h, filesize, mtime, hash, header );
+
+    FILE* fp = fopen( path, "wb" );
+    if( !fp ) return SEGY_FOPEN_ERROR;
+
+    /*
+     * Write the header last, so that an index that is interrupted half-way
+     * never has a valid magic.
+     */
+    char blank[ SEGY_INDEX_HEADER_SIZE ] = { 0 };
+    err = SEGY_OK;
+    if( fwrite( blank, sizeof( blank ), 1, fp ) != 1 )
+        err = SEGY_FWRITE_ERROR;
+    if( err == SEGY_OK )
+        err = write_index_body( ds, &h, fp );
+    if( err == SEGY_OK && fseek( fp, 0, SEEK_SET ) != 0 )
+        err = SEGY_FSEEK_ERROR;
+    if( err == SEGY_OK && fwrite( header, sizeof( header ), 1, fp ) != 1 )
+        err = SEGY_FWRITE_ERROR;
+
+    if( fclose( fp ) != 0 && err == SEGY_OK ) err = SEGY_FWRITE_ERROR;
+    if( err != SEGY_OK ) remove( path );
+    return err;
+}
+
+int segy_read_index( segy_datasource* ds,
+                     const char* path,
+                     long long mtime,
+                     int il,
+                     int xl,
+                     int offset,
+                     segy_index_header* out ) {
+    if( !path ) return SEGY_INVALID_ARGS;
+
+    FILE* fp = fopen( path, "rb" );
+    if( !fp ) return SEGY_FOPEN_ERROR;
+
+    long long index_filesize, index_mtime;
+    uint64_t index_hash;
+    segy_index_header h;
+    int err = decode_index_header( fp, &index_filesize,
+                                       &index_mtime,
+                                       &index_hash,
+                                       &h );
+    fclose( fp );
+    if( err != SEGY_OK ) return err;
+
+    if( h.il != il || h.xl != xl || h.offset != offset )
+        return SEGY_INVALID_INDEX;
+
+    if( h.tracecount != ds->metadata.tracecount )
+        return SEGY_INVALID_INDEX;
+
+    if( mtime != 0 && index_mtime != 0 && mtime != index_mtime )
+        return SEGY_INVALID_INDEX;
 
+    long long filesize;
+    err = ds->size( ds, &filesize );
+    if( err != 0 ) return SEGY_DS_ERROR;
+    if( filesize != index_filesize ) return SEGY_INVALID_INDEX;
+
+    uint64_t hash;
+    err = index_fingerprint( ds, &hash );
+    if( err != SEGY_OK ) return err;
+    if( hash != index_hash ) return SEGY_INVALID_INDEX;
+
+    *out = h;
     return SEGY_OK;
 }
+
+/*
+ * Open the index and check that it is the one described by h, positioned at
+ * the first label.
+ */
+static FILE* open_index( const char* path,
+                         const segy_index_header* h,
+                         int* err ) {
+    FILE* fp = fopen( path, "rb" );
+    if( !fp ) {
+        *err = SEGY_FOPEN_ERROR;
+        return NULL;
+    }
+
+    long long filesize, mtime;
+    uint64_t hash;
+    segy_index_header x;
+    *err = decode_index_header( fp, &filesize, &mtime, &hash, &x );
+
+    if( *err == SEGY_OK && memcmp( &x, h, sizeof( x ) ) != 0 )
+        *err = SEGY_INVALID_INDEX;
+
+    if( *err != SEGY_OK ) {
+        fclose( fp );
+        return NULL;
+    }
+
+    return fp;
+}
+
+int segy_read_index_lines( const char* path,
+                           const segy_index_header* h,
+                           int* ilines,
+                           int* xlines,
+                           int* offsets ) {
+    int err;
+    FILE* fp = open_index( path, h, &err );
+    if( !fp ) return err;
+
+    err = read_index_ints( fp, ilines, h->iline_count );
+    if( err == SEGY_OK )
+        err = read_index_ints( fp, xlines, h->xline_count );
+    if( err == SEGY_OK )
+        err = read_index_ints( fp, offsets, h->offset_count );
+
+    fclose( fp );
+    return err;
+}
+
@@ -0,0 +1,73 @@
+/*
+ * Micro-benchmark for the IBM float conversion, reporting throughput for
+ * every instruction set supported by this host.
+ *
+ * usage: bench-ibm [MiB] [repetitions]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <segyio/segy.h>
+
+static double seconds( clock_t start, clock_t stop ) {
+    return (double)( stop - start ) / CLOCKS_PER_SEC;
+}
+
+int main( int argc, char** argv ) {
+    const long long mib  = argc > 1 ? atoll( argv[ 1 ] ) : 64;
+    const int       reps = argc > 2 ? atoi( argv[ 2 ] )  : 10;
+
+    if( mib <= 0 || reps <= 0 ) {
+        fprintf( stderr, "usage: %s [MiB] [repetitions]\n", argv[ 0 ] );
+        return EXIT_FAILURE;
+    }
+
+    const long long size = mib * 1024 * 1024 / sizeof( uint32_t );
+    uint32_t* buf = malloc( size * sizeof( uint32_t ) );
+    if( !buf ) {
+        fprintf( stderr, "unable to allocate %lld MiB\n", mib );
+        return EXIT_FAILURE;
+    }
+
+    uint32_t x = 2463534242u;
+    for( long long i = 0; i < size; ++i ) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        buf[ i ] = x;
+    }
+
+    static const struct { int isa; const char* name; } isas[] = {
+        { SEGY_SIMD_SCALAR, "scalar" },
+        { SEGY_SIMD_SSE2,   "sse2" },
+        { SEGY_SIMD_AVX2,   "avx2" },
+        { SEGY_SIMD_AVX512, "avx512" },
+        { SEGY_SIMD_NEON,   "neon" },
+    };
+
+    const int fmt = SEGY_IBM_FLOAT_4_BYTE;
+    const double gb = (double)size * sizeof( uint32_t ) * reps / 1e9;
+
+    printf( "%-8s %14s %14s\n", "isa", "to-native", "from-native" );
+    for( size_t i = 0; i < sizeof( isas ) / sizeof( isas[ 0 ] ); ++i ) {
+        if( !segy_simd_supported( isas[ i ].isa ) ) continue;
+        segy_set_simd( isas[ i ].isa );
+
+        clock_t start = clock();
+        for( int r = 0; r < reps; ++r ) segy_to_native( fmt, size, buf );
+        const double to = seconds( start, clock() );
+
+        start = clock();
+        for( int r = 0; r < reps; ++r ) segy_from_native( fmt, size, buf );
+        const double from = seconds( start, clock() );
+
+        printf( "%-8s %9.2f GB/s %9.2f GB/s\n",
+                isas[ i ].name, gb / to, gb / from );
+    }
+
+    free( buf );
+    return EXIT_SUCCESS;
+}
@@ -5,6 +5,7 @@
 #include <memory>
 #include <limits>
 #include <vector>
+#include <algorithm>
 #include <array>
 #include <string.h>
 
@@ -39,7 +40,7 @@ using unique_segy = std::unique_ptr< segy_file, segy_fclose >;
 
 segy_file* openfile( const std::string& path, const std::string& mode ) {
     const auto p = testcfg::config().apply( path.c_str() );
-    unique_segy ptr( segy_open( p.c_str(), mode.c_str() ) );
+    unique_segy ptr( testcfg::config().open( p.c_str(), mode.c_str() ) );
     REQUIRE( ptr );
 
     int endianness = testcfg::config().lsbit ? SEGY_LSB : SEGY_MSB;
@@ -108,6 +109,7 @@ struct StringMaker< Err > {
             case SEGY_INVALID_ARGS: return "SEGY_INVALID_ARGS";
             case SEGY_MMAP_ERROR: return "SEGY_MMAP_ERROR";
             case SEGY_MMAP_INVALID: return "SEGY_MMAP_INVALID";
+            case SEGY_INVALID_INDEX: return "SEGY_INVALID_INDEX";
         }
         return "Unknown error";
     }
@@ -397,6 +399,53 @@ TEST_CASE_METHOD( smallbasic,
     CHECK( traces == input_traces );
 }
 
+TEST_CASE_METHOD( smallbasic,
+                  "trace count beyond int is only available as 64-bit",
+                  "[c.segy]" ) {
+    /* pretend the file is much larger than it is */
+    const auto size = fp->size;
+    fp->size = []( segy_datasource*, long long* out ) {
+        const long long stride = 50 * 4 + SEGY_TRACE_HEADER_SIZE;
+        *out = 3600 + stride * ( (1LL << 32) + 5 );
+        return 0;
+    };
+
+    const int input_traces = arbitrary_int();
+    int traces = input_traces;
+    Err err = segy_traces( fp, &traces );
+    CHECK( err == SEGY_TOO_MANY_TRACES );
+    CHECK( traces == input_traces );
+
+    long long traces64;
+    err = segy_traces64( fp, &traces64 );
+    CHECK( success( err ) );
+    CHECK( traces64 == (1LL << 32) + 5 );
+
+    fp->size = size;
+}
+
+TEST_CASE_METHOD( smallbasic,
+                  "64-bit trace numbers do not wrap around",
+                  "[c.segy]" ) {
+    std::vector< char > trace( trace_bsize );
+    std::vector< char > trace64( trace_bsize );
+    Err err = segy_readtrace( fp, 10, trace.data() );
+    REQUIRE( success( err ) );
+    err = segy_readtrace64( fp, 10, trace64.data() );
+    REQUIRE( success( err ) );
+    CHECK( trace == trace64 );
+
+    /* trace 10, if the trace number is truncated to 32 bits */
+    const long long traceno = (1LL << 32) + 10;
+    err = segy_readtrace64( fp, traceno, trace64.data() );
+    CHECK( err == SEGY_FREAD_ERROR );
+
+    char header[ SEGY_TRACE_HEADER_SIZE ];
+    const auto* map = fp->traceheader_mapping_standard.offset_to_entry_definition;
+    err = segy_read_traceheader64( fp, traceno, 0, map, header );
+    CHECK( err == SEGY_FREAD_ERROR );
+}
+
 TEST_CASE_METHOD( smallheader,
                   "valid trace-header fields can be read",
                   "[c.segy]" ) {
@@ -900,121 +949,1591 @@ TEST_CASE_METHOD( smallstep,
     CHECK_THAT( xs, ApproxRange( expected ) );
 }
 
-TEST_CASE_METHOD( smallstep,
-                  "read descending contiguous subtrace",
-                  "[c.segy]" ) {
-    const int start = 3;
-    const int stop  = -1;
-    const int step  = -1;
+TEST_CASE_METHOD( smallstep,
+                  "read descending contiguous subtrace",
+                  "[c.segy]" ) {
+    const int start = 3;
+    const int stop  = -1;
+    const int step  = -1;
+
+    void* rangebuf = nullptr;
+    const std::vector< float > expected = { 3.20003f,
+                                            3.20002f,
+                                            3.20001f,
+                                            3.20000f };
+    std::vector< float > xs( expected.size() );
+
+    Err err = segy_readsubtr( fp,
+                              traceno,
+                              start,
+                              stop,
+                              step,
+                              xs.data(),
+                              rangebuf );
+    segy_to_native( format, xs.size(), xs.data() );
+    CHECK( success( err ) );
+    CHECK_THAT( xs, ApproxRange( expected ) );
+}
+
+TEST_CASE_METHOD( smallstep,
+                  "read descending strided subtrace with pre-start",
+                  "[c.segy]" ) {
+    const int start = 24;
+    const int stop  = -1;
+    const int step  = -5;
+
+    const std::vector< float > expected = { 3.20024f,
+                                            3.20019f,
+                                            3.20014f,
+                                            3.20009f,
+                                            3.20004f };
+    std::vector< float > xs( expected.size() );
+
+    Err err = segy_readsubtr( fp,
+                              traceno,
+                              start,
+                              stop,
+                              step,
+                              xs.data(),
+                              nullptr );
+    segy_to_native( format, xs.size(), xs.data() );
+    CHECK( success( err ) );
+    CHECK_THAT( xs, ApproxRange( expected ) );
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "reading the first inline gives correct values",
+                  "[c.segy]" ) {
+
+    // first line starts at first trace
+    const int line_trace0 = 0;
+    const std::vector< float > expected = [=] {
+        std::vector< float > xs( samples * xlines );
+        for( int i = 0; i < xlines; ++i ) {
+            Err err = segy_readtrace( fp,
+                                      i,
+                                      xs.data() + (i * samples) );
+            REQUIRE( success( err ) );
+        }
+
+        segy_to_native( format, xs.size(), xs.data() );
+        return xs;
+    }();
+
+    std::vector< float > line( expected.size() );
+    Err err = segy_read_line( fp,
+                              line_trace0,
+                              (int) crosslines.size(),
+                              stride,
+                              offsets,
+                              line.data() );
+
+    segy_to_native( format, line.size(), line.data() );
+    CHECK( success( err ) );
+    CHECK_THAT( line, ApproxRange( expected ) );
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "reading the first crossline gives correct values",
+                  "[c.segy]" ) {
+
+    // first line starts at first trace
+    const int line_trace0 = 0;
+    const int stride = ilines;
+    const std::vector< float > expected = [=] {
+        std::vector< float > xs( samples * ilines );
+        for( int i = 0; i < ilines; ++i ) {
+            Err err = segy_readtrace( fp,
+                                      i * stride,
+                                      xs.data() + (i * samples) );
+            REQUIRE( success( err ) );
+        }
+
+        segy_to_native( format, xs.size(), xs.data() );
+        return xs;
+    }();
+
+    std::vector< float > line( expected.size() );
+    Err err = segy_read_line( fp,
+                              line_trace0,
+                              (int) inlines.size(),
+                              stride,
+                              offsets,
+                              line.data() );
+
+    segy_to_native( format, line.size(), line.data() );
+    CHECK( success( err ) );
+    CHECK_THAT( line, ApproxRange( expected ) );
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "reading a line with conversion gives correct values",
+                  "[c.segy]" ) {
+
+    const int line_trace0 = 0;
+    const int line_length = (int) crosslines.size();
+    const std::vector< float > expected = [=] {
+        std::vector< float > xs( samples * line_length );
+        Err err = segy_read_line( fp,
+                                  line_trace0,
+                                  line_length,
+                                  stride,
+                                  offsets,
+                                  xs.data() );
+        REQUIRE( success( err ) );
+        segy_to_native( format, xs.size(), xs.data() );
+        return xs;
+    }();
+
+    SECTION( "in the file format" ) {
+        std::vector< float > line( expected.size() );
+        Err err = segy_read_line_native( fp,
+                                         line_trace0,
+                                         line_length,
+                                         stride,
+                                         offsets,
+                                         format,
+                                         line.data() );
+        CHECK( success( err ) );
+        CHECK( line == expected );
+    }
+
+    SECTION( "as double" ) {
+        std::vector< double > line( expected.size() );
+        Err err = segy_read_line_native( fp,
+                                         line_trace0,
+                                         line_length,
+                                         stride,
+                                         offsets,
+                                         SEGY_IEEE_FLOAT_8_BYTE,
+                                         line.data() );
+        CHECK( success( err ) );
+        CHECK( line == std::vector< double >( expected.begin(),
+                                              expected.end() ) );
+    }
+
+    SECTION( "to unsupported format" ) {
+        std::vector< float > line( expected.size() );
+        Err err = segy_read_line_native( fp,
+                                         line_trace0,
+                                         line_length,
+                                         stride,
+                                         offsets,
+                                         SEGY_SIGNED_SHORT_2_BYTE,
+                                         line.data() );
+        CHECK( err == Err::args() );
+    }
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "reading in parallel gives the same result as serial",
+                  "[c.segy]" ) {
+
+    const int samplecount = samples;
+    const auto serial = [=]( int trace0, int length, int line_stride ) {
+        std::vector< float > xs( samplecount * length );
+        Err err = segy_read_line_native( fp,
+                                         trace0,
+                                         length,
+                                         line_stride,
+                                         offsets,
+                                         format,
+                                         xs.data() );
+        REQUIRE( success( err ) );
+        return xs;
+    };
+
+    const int threads = GENERATE( 1, 2, 3, 8, 100 );
+
+    SECTION( "a crossline" ) {
+        const int line_trace0 = 2;
+        const int line_length = (int) inlines.size();
+        const int line_stride = (int) crosslines.size();
+        const auto expected = serial( line_trace0, line_length, line_stride );
+
+        std::vector< float > line( expected.size() );
+        Err err = segy_read_line_parallel( fp,
+                                           line_trace0,
+                                           line_length,
+                                           line_stride,
+                                           offsets,
+                                           format,
+                                           line.data(),
+                                           threads );
+        CHECK( success( err ) );
+        CHECK( line == expected );
+    }
+
+    SECTION( "the cube" ) {
+        const auto expected = serial( 0, traces, 1 );
+
+        std::vector< float > cube( expected.size() );
+        Err err = segy_read_cube( fp, format, cube.data(), threads );
+        CHECK( success( err ) );
+        CHECK( cube == expected );
+    }
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "reading many traces gives the same result as one by one",
+                  "[c.segy]" ) {
+
+    const std::vector< int > tracenos = GENERATE(
+        std::vector< int >{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 },
+        std::vector< int >{ 24, 23, 22, 21, 20 },
+        std::vector< int >{ 0, 2, 4, 5, 6, 20, 21, 22 },
+        std::vector< int >{ 3, 4, 3, 2, 9, 9, 1, 24, 0 },
+        std::vector< int >{ 7 },
+        std::vector< int >{}
+    );
+
+    const auto sl = GENERATE( slice{ 0, 50, 1 },
+                              slice{ 3, 19, 4 },
+                              slice{ 49, -1, -1 },
+                              slice{ 24, -1, -5 } );
+
+    const int len = (int) std::max( std::abs( sl.stop - sl.start ), 1 );
+    const int elems = sl.step == 1 || sl.step == -1
+                    ? len
+                    : ( len - 1 ) / std::abs( sl.step ) + 1;
+
+    std::vector< float > expected( elems * tracenos.size() );
+    for( size_t i = 0; i < tracenos.size(); ++i ) {
+        Err err = segy_readsubtr( fp,
+                                  tracenos[ i ],
+                                  sl.start,
+                                  sl.stop,
+                                  sl.step,
+                                  expected.data() + i * elems,
+                                  nullptr );
+        REQUIRE( success( err ) );
+    }
+    segy_to_native( format, expected.size(), expected.data() );
+
+    std::vector< float > xs( expected.size() );
+    Err err = segy_read_traces( fp,
+                                tracenos.data(),
+                                (int) tracenos.size(),
+                                sl.start,
+                                sl.stop,
+                                sl.step,
+                                xs.data() );
+    INFO( "slice " << str( sl ) );
+    CHECK( success( err ) );
+    CHECK( xs == expected );
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "depth slices are the same as the samples read one by one",
+                  "[c.segy]" ) {
+
+    struct traces { long long trace0; long long count; int step; };
+    const auto tr = GENERATE( traces{ 0, 25, 1 },
+                              traces{ 24, 25, -1 },
+                              traces{ 2, 6, 4 },
+                              traces{ 0, 0, 1 } );
+
+    const auto sl = GENERATE( slice{ 0, 50, 1 },
+                              slice{ 3, 19, 4 },
+                              slice{ 49, -1, -1 },
+                              slice{ 10, 11, 1 } );
+
+    std::vector< int > depths;
+    for( int d = sl.start; sl.step > 0 ? d < sl.stop : d > sl.stop; d += sl.step )
+        depths.push_back( d );
+
+    std::vector< float > expected( depths.size() * tr.count );
+    for( size_t s = 0; s < depths.size(); ++s ) {
+        for( long long k = 0; k < tr.count; ++k ) {
+            float* x = expected.data() + s * tr.count + k;
+            Err err = segy_readsubtr( fp,
+                                      int( tr.trace0 + k * tr.step ),
+                                      depths[ s ],
+                                      depths[ s ] + 1,
+                                      1,
+                                      x,
+                                      nullptr );
+            REQUIRE( success( err ) );
+        }
+    }
+    segy_to_native( format, expected.size(), expected.data() );
+
+    std::vector< float > xs( expected.size() );
+    Err err = segy_read_depth_slices( fp,
+                                      tr.trace0,
+                                      tr.count,
+                                      tr.step,
+                                      sl.start,
+                                      sl.stop,
+                                      sl.step,
+                                      xs.data() );
+    INFO( "slice " << str( sl ) );
+    CHECK( success( err ) );
+    CHECK( xs == expected );
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "depth slices outside the file are rejected",
+                  "[c.segy]" ) {
+    std::vector< float > xs( 25 );
+    Err err = segy_read_depth_slices( fp, 0, 25, 0, 0, 1, 1, xs.data() );
+    CHECK( err == SEGY_INVALID_ARGS );
+
+    err = segy_read_depth_slices( fp, 2, 25, -1, 0, 1, 1, xs.data() );
+    CHECK( err == SEGY_INVALID_ARGS );
+
+    err = segy_read_depth_slices( fp, 1, 25, 1, 0, 1, 1, xs.data() );
+    CHECK( !success( err ) );
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "queued reads give the same result as segy_read_traces",
+                  "[c.segy]" ) {
+
+    const std::vector< long long > tracenos = GENERATE(
+        std::vector< long long >{ 0, 5, 10, 15, 20, 1, 6, 11, 16, 21 },
+        std::vector< long long >{ 24, 23, 22, 21, 20 },
+        std::vector< long long >{ 3, 4, 3, 2, 9, 9, 1, 24, 0 },
+        std::vector< long long >{}
+    );
+
+    const auto sl = GENERATE( slice{ 0, 50, 1 },
+                              slice{ 3, 19, 4 },
+                              slice{ 49, -1, -1 } );
+
+    const int depth = GENERATE( 1, 4, 64 );
+
+    const int len = std::abs( sl.stop - sl.start );
+    const int elems = sl.step == 1 || sl.step == -1
+                    ? len
+                    : ( len - 1 ) / std::abs( sl.step ) + 1;
+
+    std::vector< float > expected( elems * tracenos.size() );
+    Err err = segy_read_traces64( fp,
+                                  tracenos.data(),
+                                  (long long) tracenos.size(),
+                                  sl.start,
+                                  sl.stop,
+                                  sl.step,
+                                  expected.data() );
+    REQUIRE( success( err ) );
+
+    segy_queue* queue = segy_queue_open( fp, depth );
+    REQUIRE( queue );
+    if( testcfg::config().memmap )
+        CHECK( segy_queue_backend( queue ) == SEGY_QUEUE_SYNC );
+
+    /* submit in two rounds, to check that the queue can be reused */
+    const auto half = (long long) tracenos.size() / 2;
+    std::vector< float > xs( expected.size() );
+    err = segy_submit_read_traces( queue,
+                                   tracenos.data(),
+                                   half,
+                                   sl.start,
+                                   sl.stop,
+                                   sl.step,
+                                   xs.data() );
+    CHECK( success( err ) );
+    CHECK( success( Err( segy_wait( queue ) ) ) );
+
+    err = segy_submit_read_traces( queue,
+                                   tracenos.data() + half,
+                                   (long long) tracenos.size() - half,
+                                   sl.start,
+                                   sl.stop,
+                                   sl.step,
+                                   xs.data() + half * elems );
+    CHECK( success( err ) );
+    CHECK( success( Err( segy_queue_close( queue ) ) ) );
+
+    INFO( "slice " << str( sl ) << ", depth " << depth );
+    CHECK( xs == expected );
+}
+
+namespace {
+
+int ( *forwarded_read_at )( segy_datasource*, long long, void*, size_t );
+
+int forward_read_at( segy_datasource* self,
+                     long long offset,
+                     void* buffer,
+                     size_t size ) {
+    return forwarded_read_at( self, offset, buffer, size );
+}
+
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "queued reads go through the datasource's read_at",
+                  "[c.segy]" ) {
+    if( !fp->read_at || testcfg::config().memmap ) return;
+
+    /* a read_at segyio does not know about can't be replaced with io_uring */
+    forwarded_read_at = fp->read_at;
+    fp->read_at = forward_read_at;
+
+    const std::vector< long long > tracenos = { 2, 7, 12, 17, 22, 0, 24 };
+    std::vector< float > expected( samples * tracenos.size() );
+    Err err = segy_read_traces64( fp,
+                                  tracenos.data(),
+                                  (long long) tracenos.size(),
+                                  0, samples, 1,
+                                  expected.data() );
+    REQUIRE( success( err ) );
+
+    segy_queue* queue = segy_queue_open( fp, 3 );
+    REQUIRE( queue );
+    CHECK( segy_queue_backend( queue ) != SEGY_QUEUE_IO_URING );
+
+    std::vector< float > xs( expected.size() );
+    err = segy_submit_read_traces( queue,
+                                   tracenos.data(),
+                                   (long long) tracenos.size(),
+                                   0, samples, 1,
+                                   xs.data() );
+    CHECK( success( err ) );
+    CHECK( success( Err( segy_queue_close( queue ) ) ) );
+    CHECK( xs == expected );
+
+    fp->read_at = forwarded_read_at;
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "failed queued reads are reported by wait",
+                  "[c.segy]" ) {
+    segy_queue* queue = segy_queue_open( fp, 4 );
+    REQUIRE( queue );
+
+    const std::vector< long long > tracenos = { 1, 2, 25, 3 };
+    std::vector< float > xs( samples * tracenos.size() );
+    Err err = segy_submit_read_traces( queue,
+                                       tracenos.data(),
+                                       (long long) tracenos.size(),
+                                       0, samples, 1,
+                                       xs.data() );
+    CHECK( success( err ) );
+    CHECK( Err( segy_wait( queue ) ) == SEGY_FREAD_ERROR );
+
+    /* the error is only reported once */
+    err = segy_submit_read_traces( queue,
+                                   tracenos.data(),
+                                   2,
+                                   0, samples, 1,
+                                   xs.data() );
+    CHECK( success( err ) );
+    CHECK( success( Err( segy_queue_close( queue ) ) ) );
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "access pattern hints do not change what is read",
+                  "[c.segy]" ) {
+    const int pattern = GENERATE( SEGY_ACCESS_NORMAL,
+                                  SEGY_ACCESS_SEQUENTIAL,
+                                  SEGY_ACCESS_RANDOM,
+                                  SEGY_ACCESS_STRIDED,
+                                  SEGY_ACCESS_WILLNEED );
+
+    std::vector< char > expected( trace_bsize * ilines );
+    Err err = segy_read_line( fp, 2, ilines, xlines, offsets, expected.data() );
+    REQUIRE( success( err ) );
+
+    err = segy_set_access_pattern( fp, pattern );
+    CHECK( success( err ) );
+    err = segy_prefetch_traces( fp, 2, traces - 2 );
+    CHECK( success( err ) );
+
+    std::vector< char > line( expected.size() );
+    err = segy_read_line( fp, 2, ilines, xlines, offsets, line.data() );
+    CHECK( success( err ) );
+    CHECK( line == expected );
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "unknown access patterns and negative ranges are rejected",
+                  "[c.segy]" ) {
+    CHECK( Err( segy_set_access_pattern( fp, -1 ) ) == Err::args() );
+    CHECK( Err( segy_set_access_pattern( fp, 100 ) ) == Err::args() );
+    CHECK( Err( segy_prefetch_traces( fp, -1, 5 ) ) == Err::args() );
+    CHECK( Err( segy_prefetch_traces( fp, 0, -5 ) ) == Err::args() );
+
+    /* ranges past the end of the file are fine, they're only hints */
+    CHECK( success( Err( segy_prefetch_traces( fp, 20, 100 ) ) ) );
+    CHECK( success( Err( segy_prefetch_traces( fp, 0, 0 ) ) ) );
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "cached datasource reads the same as the file",
+                  "[c.segy]" ) {
+    const auto cfg = GENERATE( std::make_pair( 0, 0 ),
+                               std::make_pair( 97, 97 * 3 ),
+                               std::make_pair( 512, 512 * 8 ),
+                               std::make_pair( 4096, 1 ) );
+
+    unique_segy ufp( segy_cached_datasource(
+        openfile( "test-data/small.sgy", "rb" ),
+        cfg.first,
+        cfg.second
+    ) );
+    REQUIRE( ufp );
+    auto cached = ufp.get();
+    CHECK( segy_cached_inner( cached ) );
+    CHECK( !segy_cached_inner( fp ) );
+
+    INFO( "block size " << cfg.first << ", capacity " << cfg.second );
+
+    std::vector< char > expected( trace_bsize * traces );
+    std::vector< char > xs( expected.size() );
+    Err err = segy_read_line( fp, 0, traces, 1, offsets, expected.data() );
+    REQUIRE( success( err ) );
+    err = segy_read_line( cached, 0, traces, 1, offsets, xs.data() );
+    CHECK( success( err ) );
+    CHECK( xs == expected );
+
+    /* crosslines, backwards, to jump between blocks */
+    for( int xl = xlines - 1; xl >= 0; --xl ) {
+        std::vector< char > line( trace_bsize * ilines );
+        err = segy_read_line( fp, xl, ilines, xlines, offsets, line.data() );
+        REQUIRE( success( err ) );
+
+        std::vector< char > cline( line.size() );
+        err = segy_read_line( cached, xl, ilines, xlines, offsets, cline.data() );
+        CHECK( success( err ) );
+        CHECK( cline == line );
+    }
+
+    const auto* map = segy_traceheader_default_map();
+    std::vector< int > il( traces ), cil( traces );
+    err = segy_field_forall( fp, 0, map, SEGY_TR_INLINE, 0, traces, 1, il.data() );
+    REQUIRE( success( err ) );
+    err = segy_field_forall( cached, 0, map, SEGY_TR_INLINE, 0, traces, 1, cil.data() );
+    CHECK( success( err ) );
+    CHECK( cil == il );
+
+    char trace[ 200 ];
+    err = segy_readtrace( cached, traces, trace );
+    CHECK( err == SEGY_FREAD_ERROR );
+}
+
+TEST_CASE( "initialized datasources have no optional callbacks",
+           "[c.segy]" ) {
+    segy_datasource ds;
+    memset( &ds, 0xFF, sizeof( ds ) );
+    segy_init_datasource( &ds );
+    CHECK( ds.stream == nullptr );
+    CHECK( ds.read == nullptr );
+    CHECK( ds.read_at == nullptr );
+    CHECK( ds.write_at == nullptr );
+    CHECK( !ds.writable );
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "reading in parallel needs at least one thread",
+                  "[c.segy]" ) {
+    std::vector< float > cube( samples * traces );
+    CHECK( Err( segy_read_cube( fp, format, cube.data(), 0 ) ) == Err::args() );
+    CHECK( Err( segy_read_cube( fp, format, cube.data(), -1 ) ) == Err::args() );
+}
+
+namespace {
+
+std::string config_suffix() {
+    return std::string( testcfg::config().memmap     ? "-mmap"  : "" )
+         + std::string( testcfg::config().positional ? "-pread" : "" )
+         + std::string( testcfg::config().lsbit      ? "-lsb"   : "" );
+}
+
+}
+
+TEST_CASE( "long strided lines are read through the datasource's queue",
+           "[c.segy]" ) {
+    /* traces long enough that every other trace is too far away to coalesce */
+    const int samples = 20000;
+    const int traces = 40;
+    const int trace_bsize = samples * 4;
+    const std::string name = "long-traces" + config_suffix() + ".sgy";
+
+    {
+        std::vector< char > header( SEGY_TEXT_HEADER_SIZE
+                                  + SEGY_BINARY_HEADER_SIZE );
+        header[ 3220 ] = char( samples >> 8 );
+        header[ 3221 ] = char( samples & 0xFF );
+        header[ 3225 ] = SEGY_IEEE_FLOAT_4_BYTE;
+
+        std::ofstream out( name, std::ios::binary );
+        out.write( header.data(), header.size() );
+        for( int i = 0; i < traces; ++i ) {
+            std::vector< char > trace( SEGY_TRACE_HEADER_SIZE + trace_bsize,
+                                       char( i + 1 ) );
+            out.write( trace.data(), trace.size() );
+        }
+    }
+
+    unique_segy ufp( testcfg::config().open( name.c_str(), "rb" ) );
+    REQUIRE( ufp );
+    segy_file* fp = ufp.get();
+    Err err = segy_collect_metadata( fp, SEGY_MSB, -1, -1 );
+    REQUIRE( success( err ) );
+    testcfg::config().mmap( fp );
+
+    std::vector< char > expected( trace_bsize * traces / 2 );
+    for( int i = 0; i < traces / 2; ++i ) {
+        err = segy_readtrace( fp, 1 + 2 * i, expected.data() + i * trace_bsize );
+        REQUIRE( success( err ) );
+    }
+
+    /* the queue is kept on the datasource, so read twice to reuse it */
+    for( int round = 0; round < 2; ++round ) {
+        std::vector< char > line( expected.size() );
+        err = segy_read_line( fp, 1, traces / 2, 2, 1, line.data() );
+        CHECK( success( err ) );
+        CHECK( line == expected );
+    }
+
+    std::vector< long long > tracenos( traces / 2 );
+    for( int i = 0; i < traces / 2; ++i )
+        tracenos[ i ] = traces - 1 - 2 * i;
+
+    std::vector< float > reversed( samples * tracenos.size() );
+    err = segy_read_traces64( fp, tracenos.data(),
+                                  (long long) tracenos.size(),
+                                  0, samples, 1,
+                                  reversed.data() );
+    CHECK( success( err ) );
+    for( std::size_t i = 0; i < tracenos.size(); ++i ) {
+        std::vector< float > tr( samples );
+        err = segy_readsubtr_native64( fp, tracenos[ i ], 0, samples, 1,
+                                       SEGY_IEEE_FLOAT_4_BYTE,
+                                       tr.data(), nullptr );
+        REQUIRE( success( err ) );
+        INFO( "trace " << tracenos[ i ] );
+        CHECK( std::equal( tr.begin(), tr.end(),
+                           reversed.begin() + i * samples ) );
+    }
+}
+
+TEST_CASE( "cached datasource writes through", "[c.segy]" ) {
+    const std::string name = "cached-write" + config_suffix() + ".sgy";
+    const std::string orig = testcfg::config().lsbit
+                           ? "test-data/small-lsb.sgy"
+                           : "test-data/small.sgy";
+    copyfile( orig, name );
+
+    /* memory mapped files can't grow */
+    const bool append = !testcfg::config().memmap;
+
+    const int trace_bsize = 50 * 4;
+    const std::vector< char > ones( trace_bsize, 1 );
+    const std::vector< char > twos( trace_bsize, 2 );
+
+    {
+        unique_segy ufp( segy_cached_datasource(
+            openfile( name, "r+b" ),
+            128,
+            128 * 6
+        ) );
+        REQUIRE( ufp );
+        auto fp = ufp.get();
+
+        /* read first, so that the blocks written to are cached */
+        std::vector< char > trace( trace_bsize );
+        Err err = segy_readtrace( fp, 5, trace.data() );
+        REQUIRE( success( err ) );
+
+        err = segy_writetrace( fp, 5, ones.data() );
+        CHECK( success( err ) );
+        err = segy_readtrace( fp, 5, trace.data() );
+        CHECK( success( err ) );
+        CHECK( trace == ones );
+
+        if( append ) {
+            /* append a trace, which grows the partially cached last block */
+            err = segy_readtrace( fp, 24, trace.data() );
+            REQUIRE( success( err ) );
+            char header[ SEGY_TRACE_HEADER_SIZE ] = {};
+            err = segy_write_standard_traceheader( fp, 25, header );
+            CHECK( success( err ) );
+            err = segy_writetrace( fp, 25, twos.data() );
+            CHECK( success( err ) );
+            err = segy_readtrace( fp, 25, trace.data() );
+            CHECK( success( err ) );
+            CHECK( trace == twos );
+        }
+    }
+
+    unique_segy ufp( segy_open( name.c_str(), "rb" ) );
+    REQUIRE( ufp );
+    auto fp = ufp.get();
+    Err err = segy_collect_metadata( fp, testcfg::config().lsbit, -1, -1 );
+    REQUIRE( success( err ) );
+    CHECK( fp->metadata.tracecount == ( append ? 26 : 25 ) );
+
+    std::vector< char > trace( trace_bsize );
+    err = segy_readtrace( fp, 5, trace.data() );
+    CHECK( success( err ) );
+    CHECK( trace == ones );
+
+    if( append ) {
+        err = segy_readtrace( fp, 25, trace.data() );
+        CHECK( success( err ) );
+        CHECK( trace == twos );
+    }
+}
+
+namespace {
+
+std::vector< char > slurp( const std::string& path ) {
+    std::ifstream in( path, std::ios::binary );
+    return std::vector< char >( std::istreambuf_iterator< char >( in ),
+                                std::istreambuf_iterator< char >() );
+}
+
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "transposed cube has the traces in the other sorting",
+                  "[c.segy]" ) {
+    const long record = SEGY_TRACE_HEADER_SIZE + trace_bsize;
+    const std::size_t memory = GENERATE( std::size_t( 1 ),
+                                         std::size_t( 2 * 5 * 240 ),
+                                         std::size_t( 1 << 20 ) );
+
+    const std::string name = "transposed" + config_suffix()
+                           + "-" + std::to_string( memory ) + ".sgy";
+
+    segy_geometry geometry;
+    Err err = segy_infer_geometry( fp, il, xl, of, 0, &geometry );
+    REQUIRE( success( err ) );
+    REQUIRE( geometry.sorting == SEGY_INLINE_SORTING );
+
+    {
+        unique_segy dst( segy_open( name.c_str(), "w+b" ) );
+        REQUIRE( dst );
+        err = segy_transpose( fp, dst.get(), &geometry, memory );
+        CHECK( success( err ) );
+    }
+
+    const auto orig = slurp( testcfg::config().lsbit
+                           ? "test-data/small-lsb.sgy"
+                           : "test-data/small.sgy" );
+    const auto transposed = slurp( name );
+    REQUIRE( transposed.size() == orig.size() );
+    CHECK( std::equal( orig.begin(), orig.begin() + trace0,
+                       transposed.begin() ) );
+
+    for( int i = 0; i < ilines; ++i ) {
+        for( int j = 0; j < xlines; ++j ) {
+            const auto src = orig.begin() + trace0 + ( i * xlines + j ) * record;
+            const auto dst = transposed.begin()
+                           + trace0 + ( j * ilines + i ) * record;
+            INFO( "inline " << i << ", crossline " << j );
+            CHECK( std::equal( src, src + record, dst ) );
+        }
+    }
+
+    unique_segy ufp( openfile( name, "rb" ) );
+    segy_geometry result;
+    err = segy_infer_geometry( ufp.get(), il, xl, of, 1, &result );
+    CHECK( success( err ) );
+    CHECK( result.sorting == SEGY_CROSSLINE_SORTING );
+    CHECK( result.iline_count == ilines );
+    CHECK( result.xline_count == xlines );
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "depth major volume is the depth slices of the file",
+                  "[c.segy]" ) {
+    const std::size_t memory = GENERATE( std::size_t( 1 ),
+                                         std::size_t( 3 * 25 * 4 ),
+                                         std::size_t( 1 << 20 ) );
+    const int threads = GENERATE( 1, 3 );
+
+    const std::string name = "depth-major" + config_suffix()
+                           + "-" + std::to_string( memory )
+                           + "-" + std::to_string( threads ) + ".f32";
+
+    std::vector< float > expected( samples * traces );
+    Err err = segy_read_depth_slices( fp, 0, traces, 1,
+                                      0, samples, 1,
+                                      expected.data() );
+    REQUIRE( success( err ) );
+
+    {
+        unique_segy dst( segy_open( name.c_str(), "w+b" ) );
+        REQUIRE( dst );
+        err = segy_write_depth_major( fp, dst.get(), memory, threads );
+        CHECK( success( err ) );
+    }
+
+    const auto raw = slurp( name );
+    REQUIRE( raw.size() == expected.size() * sizeof( float ) );
+    std::vector< float > xs( expected.size() );
+    memcpy( xs.data(), raw.data(), raw.size() );
+    CHECK( xs == expected );
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "buffered writer writes the same file as the original",
+                  "[c.segy]" ) {
+    const std::size_t bufsize = GENERATE( std::size_t( 1 ),
+                                          std::size_t( 3 * 440 ),
+                                          std::size_t( 0 ) );
+    const int flags = GENERATE( 0,
+                                int( SEGY_WRITER_BACKGROUND ),
+                                int( SEGY_WRITER_PREALLOCATE ) );
+
+    const std::string name = "writer" + config_suffix()
+                           + "-" + std::to_string( bufsize )
+                           + "-" + std::to_string( flags ) + ".sgy";
+
+    const auto orig = slurp( testcfg::config().lsbit
+                           ? "test-data/small-lsb.sgy"
+                           : "test-data/small.sgy" );
+    {
+        std::ofstream out( name, std::ios::binary );
+        out.write( orig.data(), trace0 );
+    }
+
+    {
+        unique_segy dst( segy_open( name.c_str(), "r+b" ) );
+        REQUIRE( dst );
+        dst->metadata = fp->metadata;
+
+        segy_writer* w = segy_writer_open( dst.get(), 0, traces,
+                                           bufsize, flags, NULL );
+        REQUIRE( w );
+
+        char header[ SEGY_TRACE_HEADER_SIZE ];
+        std::vector< float > trace( samples );
+        for( int i = 0; i < traces; ++i ) {
+            Err err = segy_read_standard_traceheader( fp, i, header );
+            REQUIRE( success( err ) );
+            err = segy_readtrace( fp, i, trace.data() );
+            REQUIRE( success( err ) );
+            err = segy_to_native( format, samples, trace.data() );
+            REQUIRE( success( err ) );
+
+            err = segy_writer_put( w, header, trace.data() );
+            CHECK( success( err ) );
+        }
+
+        Err err = segy_writer_close( w );
+        CHECK( success( err ) );
+    }
+
+    CHECK( slurp( name ) == orig );
+}
+
+TEST_CASE( "writing a header word to every trace", "[c.segy]" ) {
+    const std::string name = "field-forall" + config_suffix() + ".sgy";
+    const std::string orig = testcfg::config().lsbit
+                           ? "test-data/small-lsb.sgy"
+                           : "test-data/small.sgy";
+    copyfile( orig, name );
+
+    unique_segy ufp( openfile( name, "r+b" ) );
+    auto fp = ufp.get();
+
+    const segy_entry_definition* map = segy_traceheader_default_map();
+    const int field = SEGY_TR_CDP_Y;
+    const int traces = 25;
+
+    std::vector< int > before( traces );
+    Err err = segy_field_forall( fp, 0, map, SEGY_TR_CROSSLINE,
+                                 0, traces, 1, before.data() );
+    REQUIRE( success( err ) );
+
+    std::vector< int > expected( traces );
+    SECTION( "every trace" ) {
+        for( int i = 0; i < traces; ++i ) expected[ i ] = 1000 + i;
+        err = segy_write_field_forall( fp, 0, map, field,
+                                       0, traces, 1, expected.data() );
+        CHECK( success( err ) );
+    }
+
+    SECTION( "every 3rd trace, reversed" ) {
+        err = segy_field_forall( fp, 0, map, field,
+                                 0, traces, 1, expected.data() );
+        REQUIRE( success( err ) );
+
+        std::vector< int > values;
+        for( int i = 24; i > 0; i -= 3 ) {
+            values.push_back( -i );
+            expected[ i ] = -i;
+        }
+        err = segy_write_field_forall( fp, 0, map, field,
+                                       24, 0, -3, values.data() );
+        CHECK( success( err ) );
+    }
+
+    SECTION( "broadcast" ) {
+        err = segy_field_forall( fp, 0, map, field,
+                                 0, traces, 1, expected.data() );
+        REQUIRE( success( err ) );
+
+        const int value = 7;
+        for( int i = 1; i < traces; i += 2 ) expected[ i ] = value;
+        err = segy_write_field_broadcast( fp, 0, map, field,
+                                          1, traces, 2, &value );
+        CHECK( success( err ) );
+    }
+
+    std::vector< int > out( traces );
+    err = segy_field_forall( fp, 0, map, field, 0, traces, 1, out.data() );
+    CHECK( success( err ) );
+    CHECK( out == expected );
+
+    /* the neighbouring header words are untouched */
+    std::vector< int > after( traces );
+    err = segy_field_forall( fp, 0, map, SEGY_TR_CROSSLINE,
+                             0, traces, 1, after.data() );
+    CHECK( success( err ) );
+    CHECK( after == before );
+}
+
+TEST_CASE( "writing a header word rejects invalid arguments", "[c.segy]" ) {
+    const std::string name = "field-forall-args" + config_suffix() + ".sgy";
+    const std::string orig = testcfg::config().lsbit
+                           ? "test-data/small-lsb.sgy"
+                           : "test-data/small.sgy";
+    copyfile( orig, name );
+
+    unique_segy ufp( openfile( name, "r+b" ) );
+    auto fp = ufp.get();
+
+    const segy_entry_definition* map = segy_traceheader_default_map();
+    std::vector< int > values( 25 );
+
+    Err err = segy_write_field_forall( fp, 0, map, SEGY_TR_INLINE + 1,
+                                       0, 25, 1, values.data() );
+    CHECK( err == Err::args() );
+
+    err = segy_write_field_forall( fp, 0, map, SEGY_TR_INLINE,
+                                   0, 25, 0, values.data() );
+    CHECK( err == Err::args() );
+}
+
+TEST_CASE( "grouping traces by key", "[c.segy]" ) {
+    /* (fldr, offset) for 8 traces */
+    const std::vector< long long > keys = {
+        2, 1,
+        2, 2,
+        3, 1,
+        2, 1,
+        3, 1,
+        2, 2,
+        5, 1,
+        2, 1,
+    };
+    const long long traces = 8;
+
+    std::vector< long long > offsets( traces + 1 ), index( traces );
+    long long groups = -1;
+
+    SECTION( "with two words" ) {
+        Err err = segy_group_traces( keys.data(), 2, traces,
+                                     offsets.data(), index.data(), &groups );
+        CHECK( success( err ) );
+        CHECK( groups == 4 );
+
+        const std::vector< long long > expected_offsets = { 0, 3, 5, 7, 8 };
+        const std::vector< long long > expected_index = {
+            0, 3, 7,
+            1, 5,
+            2, 4,
+            6,
+        };
+        offsets.resize( groups + 1 );
+        CHECK( offsets == expected_offsets );
+        CHECK( index == expected_index );
+    }
+
+    SECTION( "with one word" ) {
+        std::vector< long long > fldr;
+        for( long long i = 0; i < traces; ++i )
+            fldr.push_back( keys[ i * 2 ] );
+
+        Err err = segy_group_traces( fldr.data(), 1, traces,
+                                     offsets.data(), index.data(), &groups );
+        CHECK( success( err ) );
+        CHECK( groups == 3 );
+
+        const std::vector< long long > expected_offsets = { 0, 5, 7, 8 };
+        const std::vector< long long > expected_index = {
+            0, 1, 3, 5, 7,
+            2, 4,
+            6,
+        };
+        offsets.resize( groups + 1 );
+        CHECK( offsets == expected_offsets );
+        CHECK( index == expected_index );
+    }
+
+    SECTION( "many groups grow the table" ) {
+        const long long n = 10000;
+        std::vector< long long > ks( n );
+        for( long long i = 0; i < n; ++i ) ks[ i ] = ( i * 7919 ) % 5000;
+
+        offsets.resize( n + 1 );
+        index.resize( n );
+        Err err = segy_group_traces( ks.data(), 1, n,
+                                     offsets.data(), index.data(), &groups );
+        CHECK( success( err ) );
+        CHECK( groups == 5000 );
+
+        for( long long g = 0; g < groups; ++g ) {
+            CHECK( offsets[ g + 1 ] - offsets[ g ] == 2 );
+            const long long a = index[ offsets[ g ] ];
+            const long long b = index[ offsets[ g ] + 1 ];
+            CHECK( a == g );
+            CHECK( b == g + 5000 );
+            CHECK( ks[ a ] == ks[ b ] );
+        }
+    }
+}
+
+TEST_CASE( "sorting traces by key", "[c.segy]" ) {
+    /* (fldr, offset) for 8 traces */
+    const std::vector< long long > keys = {
+         2,  1,
+         2, -2,
+        -3,  1,
+         2,  1,
+        -3,  1,
+         2, -2,
+         5,  1,
+         2,  1,
+    };
+    const long long traces = 8;
+    std::vector< long long > perm( traces );
+
+    SECTION( "ascending" ) {
+        Err err = segy_sort_permutation( keys.data(), 2, NULL, traces,
+                                         perm.data() );
+        CHECK( success( err ) );
+        const std::vector< long long > expected = { 2, 4, 1, 5, 0, 3, 7, 6 };
+        CHECK( perm == expected );
+    }
+
+    SECTION( "descending in the second word" ) {
+        const int descending[] = { 0, 1 };
+        Err err = segy_sort_permutation( keys.data(), 2, descending, traces,
+                                         perm.data() );
+        CHECK( success( err ) );
+        const std::vector< long long > expected = { 2, 4, 0, 3, 7, 1, 5, 6 };
+        CHECK( perm == expected );
+    }
+
+    SECTION( "a wide range of values" ) {
+        const long long n = 5000;
+        std::vector< long long > ks( n );
+        for( long long i = 0; i < n; ++i )
+            ks[ i ] = ( i * 7919 % n - n / 2 ) * 1000003LL * 1000003LL;
+
+        perm.resize( n );
+        Err err = segy_sort_permutation( ks.data(), 1, NULL, n, perm.data() );
+        CHECK( success( err ) );
+
+        std::vector< long long > expected( n );
+        std::iota( expected.begin(), expected.end(), 0 );
+        std::stable_sort( expected.begin(), expected.end(),
+            [&]( long long a, long long b ) { return ks[ a ] < ks[ b ]; } );
+        CHECK( perm == expected );
+    }
+}
+
+TEST_CASE( "sorting and permuting the traces of a file", "[c.segy]" ) {
+    const std::string orig = testcfg::config().lsbit
+                           ? "test-data/small-lsb.sgy"
+                           : "test-data/small.sgy";
+    unique_segy usrc( openfile( orig, "rb" ) );
+    auto src = usrc.get();
+
+    const long long traces = src->metadata.tracecount;
+    const int fields[] = { SEGY_TR_CROSSLINE, SEGY_TR_INLINE };
+    const int descending[] = { 1, 0 };
+
+    /* crossline sorted, with the crosslines in descending order */
+    std::vector< long long > perm( traces );
+    Err err = segy_sort_traces( src, 0, segy_traceheader_default_map(),
+                                fields, descending, 2, perm.data() );
+    REQUIRE( success( err ) );
+
+    std::vector< long long > expected;
+    for( int xl = 4; xl >= 0; --xl )
+        for( int il = 0; il < 5; ++il )
+            expected.push_back( il * 5 + xl );
+    CHECK( perm == expected );
+
+    const std::size_t memory = GENERATE( std::size_t( 1 ),
+                                         std::size_t( 7 * 440 ),
+                                         std::size_t( 1 << 20 ) );
+    const int threads = GENERATE( 1, 3 );
+    const std::string name = "permuted" + config_suffix()
+                           + "-" + std::to_string( memory )
+                           + "-" + std::to_string( threads ) + ".sgy";
+    {
+        unique_segy dst( segy_open( name.c_str(), "w+b" ) );
+        REQUIRE( dst );
+        err = segy_permute_traces( src, dst.get(), perm.data(), traces,
+                                   memory, threads );
+        CHECK( success( err ) );
+    }
+
+    const auto source = slurp( orig );
+    const auto permuted = slurp( name );
+    REQUIRE( permuted.size() == source.size() );
+
+    const long long trace0 = src->metadata.trace0;
+    const long long record = SEGY_TRACE_HEADER_SIZE
+                           + src->metadata.trace_bsize;
+    CHECK( std::equal( source.begin(), source.begin() + trace0,
+                       permuted.begin() ) );
+    for( long long i = 0; i < traces; ++i ) {
+        const auto s = source.begin() + trace0 + perm[ i ] * record;
+        const auto d = permuted.begin() + trace0 + i * record;
+        CHECK( std::equal( s, s + record, d ) );
+    }
+
+    SECTION( "out-of-range traces are rejected" ) {
+        unique_segy dst( segy_open( name.c_str(), "w+b" ) );
+        REQUIRE( dst );
+        const long long order[] = { 0, traces };
+        err = segy_permute_traces( src, dst.get(), order, 2, memory, threads );
+        CHECK( err == Err::args() );
+    }
+}
+
+TEST_CASE( "reading scaled CDP coordinates", "[c.segy]" ) {
+    SECTION( "from the standard header" ) {
+        unique_segy ufp( segy_open( "test-data/acute-small.sgy", "rb" ) );
+        auto fp = ufp.get();
+        REQUIRE( fp );
+        Err err = segy_collect_metadata( fp, -1, -1, 0 );
+        REQUIRE( err == Err::ok() );
+
+        /* the coordinates have scalar -10 */
+        const long long traces = fp->metadata.tracecount;
+        std::vector< double > x( traces ), y( traces );
+        err = segy_read_cdps( fp, x.data(), y.data() );
+        CHECK( success( err ) );
+        CHECK( x[ 0 ] == Approx( 0.0 ) );
+        CHECK( y[ 0 ] == Approx( 10.0 ) );
+        CHECK( x[ 1 ] == Approx( 0.1 ) );
+        CHECK( y[ 1 ] == Approx( 10.1 ) );
+        CHECK( x[ 5 ] == Approx( 0.1 ) );
+        CHECK( y[ 5 ] == Approx( 9.9 ) );
+    }
+
+    SECTION( "from trace header extension 1" ) {
+        unique_segy ufp( segy_open( "test-data/rotated-small-rev2.sgy", "rb" ) );
+        auto fp = ufp.get();
+        REQUIRE( fp );
+        Err err = segy_collect_metadata( fp, -1, -1, 0 );
+        REQUIRE( err == Err::ok() );
+
+        /*
+         * some of the extension header coordinates are zero, and are taken
+         * from the standard header instead, like segy_rotation_cw
+         */
+        const long long traces = fp->metadata.tracecount;
+        std::vector< double > x( traces ), y( traces );
+        err = segy_read_cdps( fp, x.data(), y.data() );
+        CHECK( success( err ) );
+        CHECK( x[ 0 ] == Approx( 2100.0 ) );
+        CHECK( y[ 0 ] == Approx( 100.0 ) );
+        CHECK( x[ 4 ] == Approx( 2016.0 ) );
+        CHECK( y[ 4 ] == Approx( 100.0 ) );
+        CHECK( y[ 5 ] == Approx( 21.0 ) );
+    }
+}
+
+namespace {
+
+struct spatial_fixture {
+    explicit spatial_fixture( std::vector< double > xs,
+                              std::vector< double > ys )
+        : x( std::move( xs ) ), y( std::move( ys ) ) {
+        index.x = x.data();
+        index.y = y.data();
+        index.n = x.size();
+        REQUIRE( success( segy_spatial_grid( &index ) ) );
+
+        offsets.resize( index.columns * index.rows + 1 );
+        points.resize( x.size() );
+        index.offsets = offsets.data();
+        index.index = points.data();
+        REQUIRE( success( segy_spatial_build( &index ) ) );
+    }
+
+    std::vector< double > x, y;
+    std::vector< long long > offsets, points;
+    segy_spatial_index index = {};
+};
+
+/* deterministic, well-spread points */
+double lcg( unsigned long long& state ) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return double( state >> 11 ) / double( 1ULL << 53 );
+}
+
+}
+
+TEST_CASE( "spatial index nearest points", "[c.segy]" ) {
+    /* 5x5 grid with 10 units between the points, like small.sgy */
+    std::vector< double > x, y;
+    for( int i = 0; i < 5; ++i ) {
+        for( int j = 0; j < 5; ++j ) {
+            x.push_back( 1000 + 10 * i );
+            y.push_back( 2000 + 10 * j );
+        }
+    }
+    spatial_fixture sp( x, y );
+
+    std::vector< long long > points( 30 );
+    std::vector< double > distances( 30 );
+    int found = -1;
+
+    SECTION( "the nearest point" ) {
+        Err err = segy_spatial_nearest( &sp.index, 1021, 2032, 1,
+                                        points.data(), distances.data(),
+                                        &found );
+        CHECK( success( err ) );
+        CHECK( found == 1 );
+        CHECK( points[ 0 ] == 13 );
+        CHECK( distances[ 0 ] == Approx( std::sqrt( 5.0 ) ) );
+    }
+
+    SECTION( "ties are ordered by point number" ) {
+        Err err = segy_spatial_nearest( &sp.index, 1015, 2015, 4,
+                                        points.data(), distances.data(),
+                                        &found );
+        CHECK( success( err ) );
+        CHECK( found == 4 );
+        points.resize( found );
+        CHECK( points == std::vector< long long >{ 6, 7, 11, 12 } );
+    }
+
+    SECTION( "far outside the survey" ) {
+        Err err = segy_spatial_nearest( &sp.index, -1e6, 2020, 2,
+                                        points.data(), distances.data(),
+                                        &found );
+        CHECK( success( err ) );
+        CHECK( found == 2 );
+        CHECK( points[ 0 ] == 2 );
+        CHECK( distances[ 0 ] == Approx( 1e6 + 1000 ) );
+    }
+
+    SECTION( "more points than there are" ) {
+        Err err = segy_spatial_nearest( &sp.index, 1000, 2000, 30,
+                                        points.data(), distances.data(),
+                                        &found );
+        CHECK( success( err ) );
+        CHECK( found == 25 );
+        CHECK( points[ 0 ] == 0 );
+        for( int i = 1; i < found; ++i )
+            CHECK( distances[ i - 1 ] <= distances[ i ] );
+    }
+
+    SECTION( "invalid arguments" ) {
+        Err err = segy_spatial_nearest( &sp.index, 0, 0, -1,
+                                        points.data(), distances.data(),
+                                        &found );
+        CHECK( err == Err::args() );
+
+        err = segy_spatial_nearest( &sp.index, NAN, 0, 1,
+                                    points.data(), distances.data(),
+                                    &found );
+        CHECK( err == Err::args() );
+    }
+}
+
+TEST_CASE( "spatial index nearest points match brute force", "[c.segy]" ) {
+    unsigned long long state = 42;
+    std::vector< double > x, y;
+    for( int i = 0; i < 5000; ++i ) {
+        x.push_back( 4e5 + 3000 * lcg( state ) );
+        y.push_back( 6e6 + 500 * lcg( state ) * lcg( state ) );
+    }
+    spatial_fixture sp( x, y );
+
+    const int k = 7;
+    std::vector< long long > points( k );
+    std::vector< double > distances( k );
+
+    for( int q = 0; q < 200; ++q ) {
+        const double qx = 4e5 - 500 + 4000 * lcg( state );
+        const double qy = 6e6 - 100 + 700 * lcg( state );
+
+        std::vector< std::pair< double, long long > > all;
+        for( long long i = 0; i < (long long)x.size(); ++i ) {
+            const double dx = x[ i ] - qx, dy = y[ i ] - qy;
+            all.emplace_back( dx * dx + dy * dy, i );
+        }
+        std::sort( all.begin(), all.end() );
+
+        int found = -1;
+        Err err = segy_spatial_nearest( &sp.index, qx, qy, k,
+                                        points.data(), distances.data(),
+                                        &found );
+        REQUIRE( success( err ) );
+        REQUIRE( found == k );
+        for( int i = 0; i < k; ++i )
+            CHECK( points[ i ] == all[ i ].second );
+    }
+}
+
+TEST_CASE( "spatial index points within polygon", "[c.segy]" ) {
+    std::vector< double > x, y;
+    for( int i = 0; i < 10; ++i ) {
+        for( int j = 0; j < 10; ++j ) {
+            x.push_back( i );
+            y.push_back( j );
+        }
+    }
+    spatial_fixture sp( x, y );
+
+    std::vector< long long > points( x.size() );
+    long long count = -1;
+
+    SECTION( "square" ) {
+        const double square[] = { 1.5, 1.5,  3.5, 1.5,  3.5, 2.5,  1.5, 2.5 };
+        Err err = segy_spatial_within( &sp.index, square, 4,
+                                       points.data(), &count );
+        CHECK( success( err ) );
+        points.resize( count );
+        CHECK( points == std::vector< long long >{ 22, 32 } );
+    }
+
+    SECTION( "concave" ) {
+        /* an L covering columns 0-1, and row 0 out to column 4 */
+        const double ell[] = {
+            -0.5, -0.5,
+             4.5, -0.5,
+             4.5,  0.5,
+             1.5,  0.5,
+             1.5,  2.5,
+            -0.5,  2.5,
+        };
+        Err err = segy_spatial_within( &sp.index, ell, 6,
+                                       points.data(), &count );
+        CHECK( success( err ) );
+        points.resize( count );
+        const std::vector< long long > expected = {
+            0, 1, 2, 10, 11, 12, 20, 30, 40
+        };
+        CHECK( points == expected );
+    }
+
+    SECTION( "outside the survey" ) {
+        const double triangle[] = { 20, 20,  30, 20,  25, 30 };
+        Err err = segy_spatial_within( &sp.index, triangle, 3,
+                                       points.data(), &count );
+        CHECK( success( err ) );
+        CHECK( count == 0 );
+    }
+
+    SECTION( "too few vertices" ) {
+        const double line[] = { 0, 0,  5, 5 };
+        Err err = segy_spatial_within( &sp.index, line, 2,
+                                       points.data(), &count );
+        CHECK( err == Err::args() );
+    }
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "geometry index gives the same geometry as scanning",
+                  "[c.segy]" ) {
+    const int il = SEGY_TR_INLINE;
+    const int xl = SEGY_TR_CROSSLINE;
+    const int of = SEGY_TR_OFFSET;
+    const long long mtime = 1234;
+
+    const std::string path = "small" + config_suffix() + ".sgy.segyidx";
+    Err err = segy_write_index( fp, path.c_str(), mtime, il, xl, of );
+    REQUIRE( success( err ) );
+
+    segy_index_header h;
+    err = segy_read_index( fp, path.c_str(), mtime, il, xl, of, &h );
+    REQUIRE( success( err ) );
+
+    CHECK( h.sorting == SEGY_INLINE_SORTING );
+    CHECK( h.tracecount == traces );
+    CHECK( h.iline_count == (int) inlines.size() );
+    CHECK( h.xline_count == (int) crosslines.size() );
+    CHECK( h.offset_count == offsets );
+
+    std::vector< int > expected_offsets( offsets );
+    err = segy_offset_indices( fp, of, offsets, expected_offsets.data() );
+    REQUIRE( success( err ) );
+
+    SECTION( "line numbers" ) {
+        std::vector< int > ilines( h.iline_count );
+        std::vector< int > xlines( h.xline_count );
+        std::vector< int > offs( h.offset_count );
+        err = segy_read_index_lines( path.c_str(),
+                                     &h,
+                                     ilines.data(),
+                                     xlines.data(),
+                                     offs.data() );
+        CHECK( success( err ) );
+        CHECK( ilines == inlines );
+        CHECK( xlines == crosslines );
+        CHECK( offs == expected_offsets );
+    }
+
+    SECTION( "index with other mtime is rejected" ) {
+        err = segy_read_index( fp, path.c_str(), mtime + 1, il, xl, of, &h );
+        CHECK( err == SEGY_INVALID_INDEX );
+    }
+
+    SECTION( "zero mtime is not checked" ) {
+        err = segy_read_index( fp, path.c_str(), 0, il, xl, of, &h );
+        CHECK( success( err ) );
+    }
+
+    SECTION( "index with other header words is rejected" ) {
+        err = segy_read_index( fp, path.c_str(), mtime, xl, il, of, &h );
+        CHECK( err == SEGY_INVALID_INDEX );
+    }
+
+    SECTION( "missing index is not found" ) {
+        const auto missing = path + ".missing";
+        err = segy_read_index( fp, missing.c_str(), mtime, il, xl, of, &h );
+        CHECK( err == SEGY_FOPEN_ERROR );
+    }
+
+    SECTION( "line numbers of another index are rejected" ) {
+        segy_index_header other = h;
+        other.sorting = SEGY_CROSSLINE_SORTING;
+        std::vector< int > ilines( h.iline_count );
+        std::vector< int > xlines( h.xline_count );
+        std::vector< int > offs( h.offset_count );
+        err = segy_read_index_lines( path.c_str(),
+                                     &other,
+                                     ilines.data(),
+                                     xlines.data(),
+                                     offs.data() );
+        CHECK( err == SEGY_INVALID_INDEX );
+    }
+}
+
+TEST_CASE( "geometry index is rejected when headers change", "[c.segy]" ) {
+    const std::string name = "index-modified" + config_suffix() + ".sgy";
+    const std::string path = name + ".segyidx";
+    const std::string orig = testcfg::config().lsbit
+                           ? "test-data/small-lsb.sgy"
+                           : "test-data/small.sgy";
+    copyfile( orig, name );
+
+    unique_segy ufp( openfile( name, "r+b" ) );
+    auto fp = ufp.get();
+
+    const int il = SEGY_TR_INLINE;
+    const int xl = SEGY_TR_CROSSLINE;
+    const int of = SEGY_TR_OFFSET;
 
-    void* rangebuf = nullptr;
-    const std::vector< float > expected = { 3.20003f,
-                                            3.20002f,
-                                            3.20001f,
-                                            3.20000f };
-    std::vector< float > xs( expected.size() );
+    Err err = segy_write_index( fp, path.c_str(), 0, il, xl, of );
+    REQUIRE( success( err ) );
 
-    Err err = segy_readsubtr( fp,
-                              traceno,
-                              start,
-                              stop,
-                              step,
-                              xs.data(),
-                              rangebuf );
-    segy_to_native( format, xs.size(), xs.data() );
-    CHECK( success( err ) );
-    CHECK_THAT( xs, ApproxRange( expected ) );
+    char header[ SEGY_TRACE_HEADER_SIZE ];
+    err = segy_read_standard_traceheader( fp, 0, header );
+    REQUIRE( success( err ) );
+    err = segy_set_tracefield_int( header, SEGY_TR_SOURCE_GROUP_SCALAR, -10 );
+    REQUIRE( success( err ) );
+    err = segy_write_standard_traceheader( fp, 0, header );
+    REQUIRE( success( err ) );
+
+    segy_index_header h;
+    err = segy_read_index( fp, path.c_str(), 0, il, xl, of, &h );
+    CHECK( err == SEGY_INVALID_INDEX );
 }
 
 TEST_CASE_METHOD( smallstep,
-                  "read descending strided subtrace with pre-start",
+                  "read descending strided subtrace with conversion",
                   "[c.segy]" ) {
     const int start = 24;
     const int stop  = -1;
     const int step  = -5;
 
-    const std::vector< float > expected = { 3.20024f,
-                                            3.20019f,
-                                            3.20014f,
-                                            3.20009f,
-                                            3.20004f };
-    std::vector< float > xs( expected.size() );
-
-    Err err = segy_readsubtr( fp,
-                              traceno,
-                              start,
-                              stop,
-                              step,
-                              xs.data(),
-                              nullptr );
-    segy_to_native( format, xs.size(), xs.data() );
+    const std::vector< double > expected = { 3.20024f,
+                                             3.20019f,
+                                             3.20014f,
+                                             3.20009f,
+                                             3.20004f };
+    std::vector< double > xs( expected.size() );
+
+    Err err = segy_readsubtr_native( fp,
+                                     traceno,
+                                     start,
+                                     stop,
+                                     step,
+                                     SEGY_IEEE_FLOAT_8_BYTE,
+                                     xs.data(),
+                                     nullptr );
     CHECK( success( err ) );
-    CHECK_THAT( xs, ApproxRange( expected ) );
+    CHECK_THAT( xs, SimilarRange< double >( expected ) );
 }
 
-TEST_CASE_METHOD( smallcube,
-                  "reading the first inline gives correct values",
+TEST_CASE_METHOD( smallstep,
+                  "positional reads leave the stream position alone",
                   "[c.segy]" ) {
+    /* only datasources with positional I/O give this guarantee */
+    if( !fp->read_at ) return;
 
-    // first line starts at first trace
-    const int line_trace0 = 0;
-    const std::vector< float > expected = [=] {
-        std::vector< float > xs( samples * xlines );
-        for( int i = 0; i < xlines; ++i ) {
-            Err err = segy_readtrace( fp,
-                                      i,
-                                      xs.data() + (i * samples) );
-            REQUIRE( success( err ) );
-        }
-
-        segy_to_native( format, xs.size(), xs.data() );
-        return xs;
-    }();
+    REQUIRE( fp->seek( fp, 0, SEEK_SET ) == SEGY_OK );
 
-    std::vector< float > line( expected.size() );
-    Err err = segy_read_line( fp,
-                              line_trace0,
-                              (int) crosslines.size(),
-                              stride,
-                              offsets,
-                              line.data() );
+    std::vector< float > xs( 5 );
+    Err err = segy_readsubtr( fp, traceno, 3, 19, 4, xs.data(), nullptr );
+    CHECK( success( err ) );
 
-    segy_to_native( format, line.size(), line.data() );
+    char header[ SEGY_TRACE_HEADER_SIZE ];
+    err = segy_read_standard_traceheader( fp, traceno, header );
     CHECK( success( err ) );
-    CHECK_THAT( line, ApproxRange( expected ) );
+
+    long long pos = -1;
+    CHECK( fp->tell( fp, &pos ) == SEGY_OK );
+    CHECK( pos == 0 );
 }
 
-TEST_CASE_METHOD( smallcube,
-                  "reading the first crossline gives correct values",
+TEST_CASE_METHOD( smallstep,
+                  "trace pointers point into the mapped file",
                   "[c.segy]" ) {
+    void* ptr = nullptr;
+    if( !fp->memory_speedup ) {
+        Err err = segy_trace_ptr( fp, traceno, &ptr );
+        CHECK( err == SEGY_MMAP_INVALID );
+    }
 
-    // first line starts at first trace
-    const int line_trace0 = 0;
-    const int stride = ilines;
-    const std::vector< float > expected = [=] {
-        std::vector< float > xs( samples * ilines );
-        for( int i = 0; i < ilines; ++i ) {
-            Err err = segy_readtrace( fp,
-                                      i * stride,
-                                      xs.data() + (i * samples) );
-            REQUIRE( success( err ) );
+    if( segy_mmap( fp ) != SEGY_OK ) return;
+
+    std::vector< char > trace( trace_bsize );
+    for( int i : { 0, traceno, 24 } ) {
+        Err err = segy_readtrace( fp, i, trace.data() );
+        REQUIRE( success( err ) );
+
+        /* segy_readtrace gives big-endian samples, the pointer is as-is */
+        if( fp->metadata.endianness == SEGY_LSB ) {
+            for( auto x = trace.begin(); x != trace.end(); x += 4 )
+                std::reverse( x, x + 4 );
         }
 
-        segy_to_native( format, xs.size(), xs.data() );
-        return xs;
-    }();
+        err = segy_trace_ptr( fp, i, &ptr );
+        REQUIRE( success( err ) );
+        CHECK( memcmp( ptr, trace.data(), trace.size() ) == 0 );
+    }
 
-    std::vector< float > line( expected.size() );
-    Err err = segy_read_line( fp,
-                              line_trace0,
-                              (int) inlines.size(),
-                              stride,
-                              offsets,
-                              line.data() );
+    void* next = nullptr;
+    Err err = segy_trace_ptr( fp, 1, &next );
+    REQUIRE( success( err ) );
+    err = segy_trace_ptr( fp, 0, &ptr );
+    REQUIRE( success( err ) );
+    const long stride = trace_bsize + SEGY_TRACE_HEADER_SIZE;
+    CHECK( (char*)next - (char*)ptr == stride );
 
-    segy_to_native( format, line.size(), line.data() );
-    CHECK( success( err ) );
-    CHECK_THAT( line, ApproxRange( expected ) );
+    err = segy_trace_ptr( fp, 25, &ptr );
+    CHECK( err == SEGY_FREAD_ERROR );
+    err = segy_trace_ptr( fp, -1, &ptr );
+    CHECK( err == SEGY_FREAD_ERROR );
 }
 
 template< int Start, int Stop, int Step >
@@ -1254,6 +2773,69 @@ TEST_CASE_METHOD( smallfields,
     CHECK_THAT( out, Catch::Equals( crosslines ) );
 }
 
+TEST_CASE_METHOD( smallfields,
+                  "reading all header words gives the same result as forall",
+                  "[c.segy]" ) {
+    const segy_entry_definition* map = segy_traceheader_default_map();
+    const int traces = 25;
+
+    std::vector< int > ilines( traces ), xlines( traces );
+    std::vector< int16_t > scalars( traces );
+    std::vector< int > cdpx( traces );
+
+    std::vector< segy_header_column > columns = {
+        { 0, map, il, ilines.data() },
+        { 0, map, xl, xlines.data() },
+        { 0, map, SEGY_TR_SOURCE_GROUP_SCALAR, scalars.data() },
+        { 0, map, SEGY_TR_CDP_X, cdpx.data() },
+    };
+
+    Err err = segy_read_all_traceheaders( fp,
+                                          columns.data(),
+                                          (int) columns.size() );
+    REQUIRE( success( err ) );
+
+    std::vector< int > expected_ilines( traces ), expected_xlines( traces );
+    std::vector< int16_t > expected_scalars( traces );
+    std::vector< int > expected_cdpx( traces );
+    err = segy_field_forall( fp, 0, map, il, 0, traces, 1,
+                             expected_ilines.data() );
+    CHECK( success( err ) );
+    err = segy_field_forall( fp, 0, map, xl, 0, traces, 1,
+                             expected_xlines.data() );
+    CHECK( success( err ) );
+    err = segy_field_forall( fp, 0, map, SEGY_TR_SOURCE_GROUP_SCALAR,
+                             0, traces, 1, expected_scalars.data() );
+    CHECK( success( err ) );
+    err = segy_field_forall( fp, 0, map, SEGY_TR_CDP_X, 0, traces, 1,
+                             expected_cdpx.data() );
+    CHECK( success( err ) );
+
+    CHECK( ilines == expected_ilines );
+    CHECK( xlines == expected_xlines );
+    CHECK( scalars == expected_scalars );
+    CHECK( cdpx == expected_cdpx );
+}
+
+TEST_CASE_METHOD( smallfields,
+                  "reading all header words rejects invalid columns",
+                  "[c.segy]" ) {
+    const segy_entry_definition* map = segy_traceheader_default_map();
+    std::vector< int > out( 25 );
+
+    SECTION( "unaligned field" ) {
+        segy_header_column column = { 0, map, il + 1, out.data() };
+        Err err = segy_read_all_traceheaders( fp, &column, 1 );
+        CHECK( err == Err::args() );
+    }
+
+    SECTION( "missing trace header" ) {
+        segy_header_column column = { 1, map, il, out.data() };
+        Err err = segy_read_all_traceheaders( fp, &column, 1 );
+        CHECK( err == Err::args() );
+    }
+}
+
 TEST_CASE( "setting unaligned header-field fails",
            "[c.segy]" ) {
     char header[ SEGY_TRACE_HEADER_SIZE ];
@@ -1499,6 +3081,103 @@ TEST_CASE("is sorted when il increases, (xl, offset) decreases", "[c.segy]") {
 }
 
 
+TEST_CASE("inferred geometry is the same as scanned", "[c.segy]") {
+    const std::string name = GENERATE( as< std::string >{},
+        "test-data/small.sgy",
+        "test-data/f3.sgy",
+        "test-data/1x1.sgy",
+        "test-data/1xN.sgy",
+        "test-data/long.sgy",
+        "test-data/small-ps-dec-il-xl-off.sgy",
+        "test-data/small-ps-dec-il-inc-xl-off.sgy",
+        "test-data/small-ps-dec-xl-inc-il-off.sgy",
+        "test-data/small-ps-dec-off-inc-il-xl.sgy",
+        "test-data/small-ps-dec-il-xl-inc-off.sgy",
+        "test-data/small-ps-dec-il-off-inc-xl.sgy",
+        "test-data/small-ps-dec-xl-off-inc-il.sgy"
+    );
+    const int strict = GENERATE( 0, 1 );
+    INFO( name << ( strict ? " (strict)" : "" ) );
+
+    unique_segy ufp( segy_open( name.c_str(), "rb" ) );
+    auto fp = ufp.get();
+    Err err = segy_collect_metadata( fp, -1, -1, 0 );
+    REQUIRE( success( err ) );
+
+    const int il = SEGY_TR_INLINE;
+    const int xl = SEGY_TR_CROSSLINE;
+    const int of = SEGY_TR_OFFSET;
+
+    segy_geometry expected;
+    Err scanerr = segy_sorting( fp, il, xl, of, &expected.sorting );
+    if( success( scanerr ) )
+        scanerr = segy_offsets( fp, il, xl, fp->metadata.tracecount,
+                                &expected.offset_count );
+    if( success( scanerr ) )
+        scanerr = segy_lines_count( fp, il, xl,
+                                    expected.sorting,
+                                    expected.offset_count,
+                                    &expected.iline_count,
+                                    &expected.xline_count );
+
+    segy_geometry geo;
+    err = segy_infer_geometry( fp, il, xl, of, strict, &geo );
+    CHECK( err == scanerr );
+    if( !success( scanerr ) ) return;
+
+    CHECK( geo.sorting == expected.sorting );
+    CHECK( geo.offset_count == expected.offset_count );
+    CHECK( geo.iline_count == expected.iline_count );
+    CHECK( geo.xline_count == expected.xline_count );
+}
+
+TEST_CASE("strict geometry inference finds misplaced traces", "[c.segy]") {
+    const std::string name = "geometry-misplaced" + config_suffix() + ".sgy";
+    const std::string orig = testcfg::config().lsbit
+                           ? "test-data/small-lsb.sgy"
+                           : "test-data/small.sgy";
+    copyfile( orig, name );
+
+    unique_segy ufp( openfile( name, "r+b" ) );
+    auto fp = ufp.get();
+
+    /* move trace 13 (inline 3) to inline 10, outside the first line */
+    char header[ SEGY_TRACE_HEADER_SIZE ];
+    Err err = segy_read_standard_traceheader( fp, 13, header );
+    REQUIRE( success( err ) );
+    err = segy_set_tracefield_int( header, SEGY_TR_INLINE, 10 );
+    REQUIRE( success( err ) );
+    err = segy_write_standard_traceheader( fp, 13, header );
+    REQUIRE( success( err ) );
+
+    const int il = SEGY_TR_INLINE;
+    const int xl = SEGY_TR_CROSSLINE;
+    const int of = SEGY_TR_OFFSET;
+
+    segy_geometry geo;
+    SECTION( "the relaxed inference agrees with the scan" ) {
+        err = segy_infer_geometry( fp, il, xl, of, 0, &geo );
+        CHECK( success( err ) );
+        CHECK( geo.sorting == SEGY_INLINE_SORTING );
+        CHECK( geo.offset_count == 1 );
+        CHECK( geo.iline_count == 5 );
+        CHECK( geo.xline_count == 5 );
+    }
+
+    SECTION( "the strict inference rejects the file" ) {
+        err = segy_infer_geometry( fp, il, xl, of, 1, &geo );
+        CHECK( err == SEGY_NOTFOUND );
+    }
+
+    SECTION( "no geometry index is written for the file" ) {
+        const std::string path = name + ".segyidx";
+        remove( path.c_str() );
+        err = segy_write_index( fp, path.c_str(), 0, il, xl, of );
+        CHECK( err == SEGY_NOTFOUND );
+        CHECK( !std::ifstream( path ) );
+    }
+}
+
 SCENARIO( "reading text header", "[c.segy]" ) {
     const std::string expected =
 "C 1 DATE: 22/02/2016                                                            "
@@ -1689,6 +3368,34 @@ void f3_in_format(int fmt) {
     segy_to_native(f3fmt,  f3trace.size(), f3trace.data());
 
     CHECK_THAT(fptrace, SimilarRange< T >::from(f3trace));
+
+    /* fused read-and-convert must give the same samples */
+    std::vector< T > native(samples);
+    err = segy_readsubtr_native(fp, 0, 0, samples, 1,
+                                fmt,
+                                native.data(),
+                                nullptr);
+    REQUIRE(err == Err::ok());
+    CHECK(memcmp(native.data(), fptrace.data(), trsize) == 0);
+
+    /* the test uint24 is really signed, so it can't be compared to doubles */
+    if (fmt == SEGY_UNSIGNED_INTEGER_3_BYTE) return;
+
+    std::vector< double > f64(samples);
+    err = segy_readsubtr_native(fp, 0, 0, samples, 1,
+                                SEGY_IEEE_FLOAT_8_BYTE,
+                                f64.data(),
+                                nullptr);
+    REQUIRE(err == Err::ok());
+    CHECK_THAT(f64, SimilarRange< double >::from(fptrace));
+
+    std::vector< float > f32(samples);
+    err = segy_readsubtr_native(fp, 0, 0, samples, 1,
+                                SEGY_IEEE_FLOAT_4_BYTE,
+                                f32.data(),
+                                nullptr);
+    REQUIRE(err == Err::ok());
+    CHECK_THAT(f32, SimilarRange< float >::from(fptrace));
 }
 
 /*
@@ -1754,6 +3461,302 @@ TEST_CASE("can open 1-byte unsigned char", "[c.segy][format]") {
     f3_in_format< std::uint8_t >(SEGY_UNSIGNED_CHAR_1_BYTE);
 }
 
+namespace {
+
+/*
+ * Edge cases (signed zeros, under- and overflow, every leading mantissa digit
+ * for every exponent) followed by pseudo-random bit patterns. The length is
+ * not a multiple of any vector width, so the tails are exercised too.
+ */
+std::vector< std::uint32_t > conversion_input() {
+    std::vector< std::uint32_t > xs = {
+        0x00000000, 0x80000000, 0x7fffffff, 0xffffffff,
+        0x611fffff, 0x61200000, 0xe11fffff, 0xe1200000,
+        0x211fffff, 0x21200000, 0xa11fffff, 0xa1200000,
+        0x7f800000, 0xff800000, 0x7fc00000, 0x00000001,
+    };
+
+    for( std::uint32_t exp = 0; exp < 256; ++exp ) {
+        for( std::uint32_t lead = 0; lead < 16; ++lead )
+            xs.push_back( ( exp << 24 ) | ( lead << 20 ) | 0x000abcde );
+    }
+
+    std::uint32_t x = 2463534242;
+    for( int i = 0; i < 100003; ++i ) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        xs.push_back( x );
+    }
+
+    return xs;
+}
+
+struct simd_guard {
+    int isa = segy_simd();
+    ~simd_guard() { segy_set_simd( this->isa ); }
+};
+
+}
+
+TEST_CASE( "vectorized IBM conversion is bit-exact with scalar",
+           "[c.segy]" ) {
+    const simd_guard guard;
+    const auto input = conversion_input();
+    const int format = SEGY_IBM_FLOAT_4_BYTE;
+
+    REQUIRE( Err( segy_set_simd( SEGY_SIMD_SCALAR ) ) == Err::ok() );
+    auto to = input;
+    auto from = input;
+    segy_to_native( format, to.size(), to.data() );
+    segy_from_native( format, from.size(), from.data() );
+
+    const std::pair< int, const char* > isas[] = {
+        { SEGY_SIMD_SSE2,   "sse2" },
+        { SEGY_SIMD_AVX2,   "avx2" },
+        { SEGY_SIMD_AVX512, "avx512" },
+        { SEGY_SIMD_NEON,   "neon" },
+    };
+
+    for( const auto& isa : isas ) {
+        if( !segy_simd_supported( isa.first ) ) continue;
+
+        DYNAMIC_SECTION( isa.second ) {
+            REQUIRE( Err( segy_set_simd( isa.first ) ) == Err::ok() );
+            CHECK( segy_simd() == isa.first );
+
+            auto xs = input;
+            segy_to_native( format, xs.size(), xs.data() );
+            CHECK( xs == to );
+
+            xs = input;
+            segy_from_native( format, xs.size(), xs.data() );
+            CHECK( xs == from );
+
+            /* short and unaligned buffers, where everything is tail */
+            for( std::size_t n = 0; n < 40; ++n ) {
+                INFO( "size " << n );
+                std::vector< std::uint32_t > ys( input.begin(),
+                                                 input.begin() + 1 + n );
+                segy_to_native( format, n, ys.data() + 1 );
+                CHECK( std::equal( ys.begin() + 1, ys.end(), to.begin() + 1 ) );
+                CHECK( ys.front() == input.front() );
+
+                ys.assign( input.begin(), input.begin() + 1 + n );
+                segy_from_native( format, n, ys.data() + 1 );
+                CHECK( std::equal( ys.begin() + 1, ys.end(), from.begin() + 1 ) );
+                CHECK( ys.front() == input.front() );
+            }
+        }
+    }
+}
+
+namespace {
+
+segy_amplitudes amplitudes_of( const float* xs, int n ) {
+    segy_amplitudes acc;
+    acc.count = 0;
+    acc.nans = 0;
+    acc.min = std::numeric_limits< double >::infinity();
+    acc.max = -std::numeric_limits< double >::infinity();
+    acc.sum = 0;
+    acc.sumsq = 0;
+
+    for( int i = 0; i < n; ++i ) {
+        const double x = xs[ i ];
+        if( std::isnan( x ) ) {
+            ++acc.nans;
+            continue;
+        }
+        acc.min = std::min( acc.min, x );
+        acc.max = std::max( acc.max, x );
+        acc.sum += x;
+        acc.sumsq += x * x;
+        ++acc.count;
+    }
+
+    return acc;
+}
+
+void check_amplitudes( const segy_amplitudes& x, const segy_amplitudes& y ) {
+    CHECK( x.count == y.count );
+    CHECK( x.nans == y.nans );
+    CHECK( x.min == y.min );
+    CHECK( x.max == y.max );
+    CHECK( x.sum == Approx( y.sum ) );
+    CHECK( x.sumsq == Approx( y.sumsq ) );
+}
+
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "amplitude statistics per line and trace",
+                  "[c.segy]" ) {
+    std::vector< float > cube( samples * traces );
+    Err err = segy_read_cube( fp, SEGY_IEEE_FLOAT_4_BYTE, cube.data(), 1 );
+    REQUIRE( success( err ) );
+
+    /* small.sgy is inline sorted, so every 5 traces is an inline */
+    const int lines = (int) inlines.size();
+    std::vector< int > groups( traces );
+    for( int i = 0; i < traces; ++i )
+        groups[ i ] = i / (int) crosslines.size();
+
+    std::vector< segy_amplitudes > expected( lines );
+    std::vector< long long > expected_hist( lines * 4, 0 );
+    for( int i = 0; i < lines; ++i ) {
+        const int len = samples * (int) crosslines.size();
+        const float* line = cube.data() + i * len;
+        expected[ i ] = amplitudes_of( line, len );
+
+        /* the samples are il.xl0sss, in [1, 6) with bins 1.25 wide */
+        for( int k = 0; k < len; ++k ) {
+            const int bin = int( ( line[ k ] - 1.0 ) * 4 / 5.0 );
+            ++expected_hist[ i * 4 + std::min( bin, 3 ) ];
+        }
+    }
+
+    const int threads = GENERATE( 1, 2, 3, 8, 100 );
+    std::vector< segy_amplitudes > stats( lines );
+    std::vector< segy_amplitudes > trstats( traces );
+    std::vector< long long > hist( lines * 4, -1 );
+    err = segy_stats( fp, groups.data(), lines,
+                      stats.data(), trstats.data(),
+                      1.0, 6.0, 4, hist.data(),
+                      threads );
+    REQUIRE( success( err ) );
+
+    for( int i = 0; i < lines; ++i ) {
+        INFO( "line " << i );
+        check_amplitudes( stats[ i ], expected[ i ] );
+    }
+
+    for( int i = 0; i < traces; ++i ) {
+        INFO( "trace " << i );
+        check_amplitudes( trstats[ i ],
+                          amplitudes_of( cube.data() + i * samples, samples ) );
+    }
+
+    CHECK( hist == expected_hist );
+
+    SECTION( "all traces in one group" ) {
+        segy_amplitudes file;
+        err = segy_stats( fp, nullptr, 1, &file, nullptr,
+                          0, 0, 0, nullptr, threads );
+        REQUIRE( success( err ) );
+        check_amplitudes( file, amplitudes_of( cube.data(), traces * samples ) );
+
+        segy_amplitudes merged = stats.front();
+        for( int i = 1; i < lines; ++i )
+            segy_amplitudes_merge( &merged, &stats[ i ] );
+        check_amplitudes( merged, file );
+    }
+}
+
+TEST_CASE_METHOD( smallcube,
+                  "amplitude statistics reject invalid arguments",
+                  "[c.segy]" ) {
+    segy_amplitudes stats[ 2 ];
+    long long hist[ 8 ];
+    std::vector< int > groups( traces, 0 );
+
+    CHECK( Err( segy_stats( fp, nullptr, 1, stats, nullptr,
+                            0, 0, 0, nullptr, 0 ) ) == Err::args() );
+    CHECK( Err( segy_stats( fp, nullptr, 0, stats, nullptr,
+                            0, 0, 0, nullptr, 1 ) ) == Err::args() );
+    CHECK( Err( segy_stats( fp, nullptr, 1, stats, nullptr,
+                            0, 1, 0, hist, 1 ) ) == Err::args() );
+    CHECK( Err( segy_stats( fp, nullptr, 1, stats, nullptr,
+                            1, 1, 8, hist, 1 ) ) == Err::args() );
+
+    groups.back() = 2;
+    CHECK( Err( segy_stats( fp, groups.data(), 2, stats, nullptr,
+                            0, 0, 0, nullptr, 1 ) ) == Err::args() );
+    groups.back() = -1;
+    CHECK( Err( segy_stats( fp, groups.data(), 2, stats, nullptr,
+                            0, 0, 0, nullptr, 1 ) ) == Err::args() );
+}
+
+TEST_CASE( "vectorized amplitude statistics skip NaNs",
+           "[c.segy]" ) {
+    const simd_guard guard;
+
+    /*
+     * Reinterpret small.sgy as IEEE float, with some NaNs. The IBM floats
+     * are reasonable IEEE floats of other values, which is good enough
+     */
+    std::ifstream in( "test-data/small.sgy", std::ios::binary );
+    std::vector< unsigned char > file( ( std::istreambuf_iterator< char >( in ) ),
+                                       std::istreambuf_iterator< char >() );
+    REQUIRE( file.size() == 3600 + 25 * ( 240 + 50 * 4 ) );
+    file[ 3224 ] = 0;
+    file[ 3225 ] = SEGY_IEEE_FLOAT_4_BYTE;
+
+    const unsigned char nan[] = { 0x7F, 0xC0, 0x00, 0x01 };
+    const auto sample = [&]( int trace, int i ) {
+        return file.data() + 3600 + trace * ( 240 + 200 ) + 240 + i * 4;
+    };
+    for( int i : { 0, 3, 4, 9, 17, 31, 49 } )
+        std::copy( nan, nan + 4, sample( 2, i ) );
+    for( int i = 0; i < 50; ++i )
+        std::copy( nan, nan + 4, sample( 7, i ) );
+    std::copy( nan, nan + 4, sample( 24, 48 ) );
+
+    unique_segy ds( segy_memopen( file.data(), file.size() ) );
+    REQUIRE( ds );
+    REQUIRE( Err( segy_collect_metadata( ds.get(), -1, -1, -1 ) ) == Err::ok() );
+
+    std::vector< float > cube( 25 * 50 );
+    REQUIRE( success( segy_read_cube( ds.get(),
+                                      SEGY_IEEE_FLOAT_4_BYTE,
+                                      cube.data(),
+                                      1 ) ) );
+
+    const std::pair< int, const char* > isas[] = {
+        { SEGY_SIMD_SCALAR, "scalar" },
+        { SEGY_SIMD_SSE2,   "sse2" },
+        { SEGY_SIMD_AVX2,   "avx2" },
+        { SEGY_SIMD_AVX512, "avx512" },
+        { SEGY_SIMD_NEON,   "neon" },
+    };
+
+    for( const auto& isa : isas ) {
+        if( !segy_simd_supported( isa.first ) ) continue;
+
+        DYNAMIC_SECTION( isa.second ) {
+            REQUIRE( Err( segy_set_simd( isa.first ) ) == Err::ok() );
+
+            segy_amplitudes file_stats;
+            std::vector< segy_amplitudes > trstats( 25 );
+            Err err = segy_stats( ds.get(), nullptr, 1,
+                                  &file_stats, trstats.data(),
+                                  0, 0, 0, nullptr, 2 );
+            REQUIRE( success( err ) );
+
+            const auto expected = amplitudes_of( cube.data(), 25 * 50 );
+            CHECK( expected.nans == 7 + 50 + 1 );
+            check_amplitudes( file_stats, expected );
+
+            for( int i = 0; i < 25; ++i ) {
+                INFO( "trace " << i );
+                check_amplitudes( trstats[ i ],
+                                  amplitudes_of( cube.data() + i * 50, 50 ) );
+            }
+
+            CHECK( trstats[ 7 ].count == 0 );
+            CHECK( trstats[ 7 ].min == std::numeric_limits< double >::infinity() );
+        }
+    }
+}
+
+TEST_CASE( "unsupported instruction sets are rejected", "[c.segy]" ) {
+    const simd_guard guard;
+    CHECK( segy_simd_supported( SEGY_SIMD_SCALAR ) );
+    CHECK( Err( segy_set_simd( -1 ) ) == Err::args() );
+    CHECK( Err( segy_set_simd( 100 ) ) == Err::args() );
+    CHECK( Err( segy_set_simd( SEGY_SIMD_SCALAR ) ) == Err::ok() );
+}
+
 SCENARIO( "reading a 2-byte int file", "[c.segy][2-byte]" ) {
     unique_segy ufp{ openfile( "test-data/f3.sgy", "rb" ) };
     auto fp = ufp.get();
@@ -21,10 +21,17 @@ struct testcfg {
     void lsb( segy_file* );
     void apply( segy_file* );
 
+    /*
+     * Open path with segy_open, or with segy_open_fd if running with
+     * positional (pread/pwrite) I/O
+     */
+    segy_file* open( const char* path, const char* mode );
+
     static testcfg& config();
 
     bool memmap = false;
     bool lsbit = false;
+    bool positional = false;
 };
 
 #endif // SEGYIO_TEST_CONFIG_HPP
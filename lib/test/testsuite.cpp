@@ -1,6 +1,13 @@
 #define CATCH_CONFIG_RUNNER
 #include <catch/catch.hpp>
 
+#include <cstring>
+
+#ifdef HAVE_PREAD
+#include <fcntl.h>
+#include <unistd.h>
+#endif //HAVE_PREAD
+
 #include <segyio/segy.h>
 
 #include "test-config.hpp"
@@ -45,6 +52,28 @@ void testcfg::apply( segy_file* fp ) {
     this->lsb( fp );
 }
 
+segy_file* testcfg::open( const char* path, const char* mode ) {
+#ifdef HAVE_PREAD
+    if( this->positional ) {
+        int flags;
+        if( std::strchr( mode, '+' ) )      flags = O_RDWR;
+        else if( std::strchr( mode, 'r' ) ) flags = O_RDONLY;
+        else                                flags = O_WRONLY;
+
+        if( std::strchr( mode, 'w' ) ) flags |= O_CREAT | O_TRUNC;
+        if( std::strchr( mode, 'a' ) ) flags |= O_CREAT;
+
+        const int fd = ::open( path, flags, 0644 );
+        if( fd == -1 ) return nullptr;
+
+        segy_file* fp = segy_open_fd( fd );
+        if( !fp ) ::close( fd );
+        return fp;
+    }
+#endif //HAVE_PREAD
+    return segy_open( path, mode );
+}
+
 testcfg& testcfg::config() {
     static testcfg s;
     return s;
@@ -59,6 +88,7 @@ int main( int argc, char** argv ) {
       auto cli = session.cli()
           | Opt( cfg.memmap ) ["--test-mmap"] ("run with memory mapped files")
           | Opt( cfg.lsbit )  ["--test-lsb"]  ("run with LSB files")
+          | Opt( cfg.positional ) ["--test-pread"] ("run with pread/pwrite files")
           ;
       session.cli( cli );
 
@@ -190,6 +190,18 @@ def create(filename, spec, layout_xml = None):
     ...         dst.bin = src.bin
     ...         dst.header = src.header
     ...         dst.trace = src.trace
+
+    Copy a file with the buffered writer, which writes the headers and traces
+    together in large, sequential writes (since v2.1):
+
+    >>> with segyio.open(srcpath) as src:
+    ...     spec = segyio.tools.metadata(src)
+    ...     with segyio.create(dstpath, spec) as dst:
+    ...         dst.text[0] = src.text[0]
+    ...         dst.bin = src.bin
+    ...         with dst.writer() as w:
+    ...             for header, trace in zip(src.header, src.trace):
+    ...                 w.append(header, trace)
     """
     return _create(FileDatasourceDescriptor(filename, "w+"), spec, layout_xml)
 
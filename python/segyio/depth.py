@@ -19,7 +19,8 @@ class Depth(Sequence):
 
     This mode works even on unstructured files, because it is not reliant on
     in/crosslines to be sensible. Please note that in the case of unstructured
-    depth slicing, the array shape == tracecount.
+    depth slicing, the array shape == tracecount. Sparse files, which have
+    holes in the cube, are depth sliced like unstructured files.
 
     Notes
     -----
@@ -31,18 +32,24 @@ class Depth(Sequence):
     .. versionchanged:: 1.7.1
        enabled for unstructured files
 
+    .. versionchanged:: 2.1
+       sparse files are sliced like unstructured files
+
     .. warning::
         Accessing the file by depth (fixed z-coordinate) is inefficient because
         of poor locality and many reads. If you read more than a handful
         depths, consider using a faster mode.
     """
 
+    # bytes of depths read per pass over the file when reading slices
+    batchsize = 1 << 26
+
     def __init__(self, segyfile):
         super(Depth, self).__init__(len(segyfile.samples))
         self.segyfd = segyfile.segyfd
         self.dtype = segyfile.dtype
 
-        if segyfile.unstructured:
+        if segyfile.unstructured or segyfile.sparse:
             self.shape = segyfile.tracecount
             self.offsets = 1
         else:
@@ -56,7 +63,9 @@ class Depth(Sequence):
         depth[i] returns a numpy.ndarray, and changes to this array will *not*
         be reflected on disk.
 
-        When i is a slice, a generator of numpy.ndarray is returned.
+        When i is a slice, a generator of numpy.ndarray is returned. The depths
+        are read in batches of about `Depth.batchsize` bytes, with one pass
+        over the file per batch.
 
         The depth slices are returned as a fast-by-slow shaped array, i.e. an
         inline sorted file with 10 inlines and 5 crosslines has the shape
@@ -126,13 +135,28 @@ class Depth(Sequence):
                 raise TypeError(msg.format(type(i).__name__))
 
             def gen():
-                x = np.empty(self.shape, dtype=self.dtype)
+                # read a batch of depths per pass over the file, so that every
+                # trace is read once per batch rather than once per depth. The
+                # batches are double-buffered like single depths are
+                depths = range(*indices)
+                shape = self.shape
+                if not isinstance(shape, tuple):
+                    shape = (shape,)
+
+                size = max(1, int(np.prod(shape)) * self.dtype.itemsize)
+                batch = max(1, min(len(depths), self.batchsize // size))
+                x = np.empty((batch,) + shape, dtype=self.dtype)
                 y = np.copy(x)
 
-                for j in range(*indices):
-                    self.segyfd.getdepth(j, x.size, self.offsets, x)
+                for b in range(0, len(depths), batch):
+                    chunk = depths[b:b + batch]
+                    stop = chunk[-1] + (1 if chunk.step > 0 else -1)
+                    self.segyfd.getdepths(chunk.start, stop, chunk.step,
+                                          len(chunk), x[0].size, self.offsets,
+                                          x)
                     x, y = y, x
-                    yield y
+                    for d in y[:len(chunk)]:
+                        yield d
 
             return gen()
 
@@ -10,9 +10,10 @@ import numpy as np
 try: from future_builtins import zip
 except ImportError: pass
 
+import segyio
 import segyio.tools as tools
 
-from .line import sanitize_slice
+from .line import sanitize_slice, sparse_read
 
 
 class Gather(object):
@@ -189,6 +190,90 @@ class Gather(object):
 
         return gen()
 
+class SparseGather(Gather):
+    """
+    The Gather of a sparse geometry, i.e. a file opened with ``sparse=True``
+    that is not a full cube. Gathers are read like with Gather, but offsets
+    missing from the file are filled with the `fill` value of the inline mode.
+
+    Notes
+    -----
+    .. versionadded:: 2.1
+    """
+
+    def __getitem__(self, index):
+        """gather[i, x, o], gather[:,:,:]
+
+        Reads like ``Gather[i, x, o]``. The traces missing from the file are
+        filled with `iline.fill`.
+
+        Notes
+        -----
+        .. versionadded:: 2.1
+        """
+        if len(index) < 3:
+            index = (index[0], index[1], None)
+
+        il, xl, off = index
+
+        if off is None and len(self.offsets) == 1:
+            off = self.offsets[0]
+
+        # if offset isn't specified, default to all, [:]
+        off = off or slice(None)
+
+        def isslice(x): return isinstance(x, slice)
+
+        line = self.iline
+        shape = line.shape[1:]
+
+        def read(ilno, xlno, offs):
+            # cell of (ilno, xlno) at the first offset
+            cell = line.cells(ilno, self.offsets[0])[self.xline.heads[xlno]]
+            cells = np.array([line.offsets[o] for o in offs], dtype = np.int64)
+            buf = np.empty((len(offs),) + shape, dtype = line.dtype)
+            return sparse_read(line.segyfd, line.index, cells + cell, buf,
+                               line.fill)
+
+        # gather[int,int,int]
+        if not any(map(isslice, [il, xl, off])):
+            return read(il, xl, [off])[0]
+
+        if isslice(off):
+            offs = sanitize_slice(off, self.offsets)
+        else:
+            offs = slice(off, off + 1, 1)
+
+        xs = list(filter(line.offsets.__contains__,
+                    range(*offs.indices(self.offsets[-1]+1))))
+
+        empty = np.empty(0, dtype = line.dtype)
+        # gather[int,int,:]
+        if not any(map(isslice, [il, xl])):
+            if len(xs) == 0: return empty
+            return read(il, xl, xs)
+
+        il_slice = il if isslice(il) else slice(il, il+1)
+        xl_slice = xl if isslice(xl) else slice(xl, xl+1)
+
+        il_range, _ = self.iline.ranges(il_slice, self.offsets[0])
+        xl_range, _ = self.xline.ranges(xl_slice, self.offsets[0])
+        xl_range = list(xl_range)
+
+        # gather[:,:,:], gather[int,:,:], gather[:,int,:]
+        # gather[:,:,int] etc
+        def gen():
+            for ilno in il_range:
+                for xlno in xl_range:
+                    if not isslice(off):
+                        yield read(ilno, xlno, [off])[0]
+                    elif len(xs) == 0:
+                        yield empty
+                    else:
+                        yield read(ilno, xlno, xs)
+
+        return gen()
+
 class Group(object):
     """
     The inner representation of the Groups abstraction provided by Group.
@@ -292,25 +377,79 @@ class Groups(Mapping):
     structure in the headers. This is common for some types of pre-stack data,
     shot gather data etc.
 
+    The key words of all traces are read in a single pass, and the traces are
+    grouped natively. The groups are stored in compressed sparse row form,
+    where the traces of the nth group, in the order of their first trace, are
+    ``index[offsets[n]:offsets[n + 1]]``.
+
+    Attributes
+    ----------
+    offsets : numpy.ndarray of int64
+        The start of every group in index, and the end of the last group
+    index : numpy.ndarray of int64
+        The trace numbers, grouped
+    bins : collections.OrderedDict
+        The fingerprint -> group number mapping
+
     Notes
     -----
     .. versionadded:: 1.9
+
+    .. versionchanged:: 2.1
+        Native grouping, offsets and index
     """
     # TODO: only group in range of traces?
-    # TODO: cache header dicts?
     def __init__(self, trace, header, key):
+        try:
+            words = [int(key)]
+            scalar = True
+        except TypeError:
+            words = list(collections.OrderedDict.fromkeys(int(k) for k in key))
+            scalar = False
+
+        table = header.segyfile.header_table(words)
+        columns = [table[word] for word in words]
+        keys = np.stack([self.keyword(c, scalar) for c in columns], axis = 1)
+        keys = np.ascontiguousarray(keys)
+
+        tracecount = len(keys)
+        offsets = np.empty(tracecount + 1, dtype = np.int64)
+        index = np.empty(tracecount, dtype = np.int64)
+        groups = segyio._segyio.group(keys, len(words), offsets, index)
+        offsets = offsets[:groups + 1].copy()
+
         bins = collections.OrderedDict()
-        for i, h in enumerate(header[:]):
-            k = self.fingerprint(h[key])
-            if k in bins:
-                bins[k].append(i)
+        for n, first in enumerate(index[offsets[:-1]]):
+            if scalar:
+                k = int(columns[0][first])
             else:
-                bins[k] = [i]
+                k = frozenset((w, c[first].item()) for w, c in zip(words, columns))
+            bins[k] = n
 
         self.trace = trace
         self.header = header
         self.key = key
         self.bins = bins
+        self.offsets = offsets
+        self.index = index
+
+    @staticmethod
+    def keyword(column, scalar):
+        """
+        The int64 representation of a column of key words, so that traces are
+        in the same group exactly when their fingerprints are equal. This
+        function is intended for internal use.
+        """
+        kind = column.dtype.kind
+        if kind in 'iu' or (kind == 'f' and scalar):
+            # int() truncates floats when the key is a single word
+            return column.astype(np.int64)
+
+        if kind == 'f':
+            # -0.0 == 0.0, so normalize before comparing the bits
+            return (column.astype(np.float64) + 0.0).view(np.int64)
+
+        return np.ascontiguousarray(column).view(np.int64)
 
     @staticmethod
     def normalize_keys(items):
@@ -417,15 +556,19 @@ class Groups(Mapping):
         >>> record5 = records[5]
         """
         key = self.fingerprint(key)
-        return Group(key, self, self.bins[key])
+        return self._group(key, self.bins[key])
+
+    def _group(self, key, n):
+        index = self.index[self.offsets[n]:self.offsets[n + 1]]
+        return Group(key, self, index.tolist())
 
     def values(self):
-        for key, index in self.bins.items():
-            yield Group(key, self, index)
+        for key, n in self.bins.items():
+            yield self._group(key, n)
 
     def items(self):
-        for key, index in self.bins.items():
-            yield key, Group(key, self, index)
+        for key, n in self.bins.items():
+            yield key, self._group(key, n)
 
     def __iter__(self):
         return self.bins.keys()
@@ -434,11 +577,7 @@ class Groups(Mapping):
         """
         Reorganise the indices in all groups by fields
         """
-        bins = collections.OrderedDict()
-
-        for key, index in self.bins.items():
-            g = Group(key, self, index)
+        for key, n in self.bins.items():
+            g = self._group(key, n)
             g.sort(fields)
-            bins[key] = g.index
-
-        self.bins = bins
+            self.index[self.offsets[n]:self.offsets[n + 1]] = g.index
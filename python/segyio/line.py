@@ -340,6 +340,155 @@ class Line(Mapping):
         """D.values() -> generator of D's (key,values), as 2-tuples"""
         return zip(self.keys(), self[:])
 
+def sparse_lookup(index, cells):
+    """Look up the traces of cells in a sparse index
+
+    Returns the trace numbers of the cells that have a trace, and a mask of
+    which of the cells have a trace.
+    """
+    keys, traces = index
+    pos = np.searchsorted(keys, cells)
+    pos[pos == len(keys)] = 0
+    hit = keys[pos] == cells
+    return traces[pos[hit]], hit
+
+def sparse_read(segyfd, index, cells, buf, fill):
+    """Read the traces of cells into buf, and fill the holes with fill"""
+    tracenos, hit = sparse_lookup(index, cells)
+    if len(tracenos) == len(cells):
+        return segyfd.gettraces(buf, tracenos)
+
+    buf.fill(fill)
+    if len(tracenos) > 0:
+        traces = np.empty((len(tracenos),) + buf.shape[1:], dtype = buf.dtype)
+        buf[hit] = segyfd.gettraces(traces, tracenos)
+    return buf
+
+class SparseLine(Line):
+    """
+    The Line of a sparse geometry, i.e. a file opened with ``sparse=True`` that
+    is not a full cube. Lines are read and written like with Line, but not
+    every trace in the line has to exist in the file. Holes are filled with
+    the `fill` value when reading, and skipped when writing.
+
+    The lines are found through an index from (inline, crossline, offset) to
+    trace number, rather than from the position of the traces in the file, so
+    the traces of a line can be anywhere in the file.
+
+    Notes
+    -----
+    .. versionadded:: 2.1
+    """
+
+    def __init__(self, segyfile, labels, others, offsets, index, name):
+        self.segyfd = segyfile.segyfd
+        self.lines = labels
+        self.length = len(others)
+        self.shape = (len(others), len(segyfile.samples))
+        self.dtype = segyfile.dtype
+        self.index = index
+        self.fill = 0
+
+        # line number -> position in the index
+        self.heads = { label: i for i, label in enumerate(labels) }
+
+        self.offsets = { x: i for i, x in enumerate(offsets) }
+        self.default_offset = offsets[0]
+
+        # the index cells are ordered inline-major, then crossline, then
+        # offset, so a line is its position times the line stride, plus the
+        # position along the line times the trace stride
+        across = np.arange(self.length, dtype = np.int64) * len(offsets)
+        if name == 'inline':
+            self.line_stride = self.length * len(offsets)
+            self.trace_cells = across
+        else:
+            self.line_stride = len(offsets)
+            self.trace_cells = across * len(labels)
+
+    def cells(self, line, offset):
+        head = self.heads[line] * self.line_stride + self.offsets[offset]
+        return self.trace_cells + head
+
+    def __getitem__(self, index):
+        """line[i] or line[i, o]
+
+        Reads like ``Line[i]``, with the traces missing from the file filled
+        with `fill`.
+
+        Notes
+        -----
+        .. versionadded:: 2.1
+        """
+        offset = self.default_offset
+        try: index, offset = index
+        except TypeError: pass
+
+        if not isinstance(index, slice) and not isinstance(offset, slice):
+            return sparse_read(self.segyfd,
+                               self.index,
+                               self.cells(index, offset),
+                               np.empty(self.shape, dtype = self.dtype),
+                               self.fill,
+                              )
+
+        irange, orange = self.ranges(index, offset)
+
+        def gen():
+            x = np.empty(self.shape, dtype=self.dtype)
+            y = np.copy(x)
+
+            for line in irange:
+                for off in orange:
+                    sparse_read(self.segyfd,
+                                self.index,
+                                self.cells(line, off),
+                                y,
+                                self.fill,
+                               )
+                    y, x = x, y
+                    yield x
+
+        return gen()
+
+    def __setitem__(self, index, val):
+        """line[i] = val or line[i, o] = val
+
+        Writes like ``Line[i] = val``, except that the traces of `val` that
+        fall in the holes of the line are not written.
+
+        Notes
+        -----
+        .. versionadded:: 2.1
+        """
+        offset = self.default_offset
+        try: index, offset = index
+        except TypeError: pass
+
+        def put(line, off, val):
+            val = castarray(val, dtype = self.dtype)
+            if val.size < self.shape[0] * self.shape[1]:
+                msg = "line too short: expected {} elements, got {}"
+                raise ValueError(msg.format(self.shape[0] * self.shape[1],
+                                            val.size))
+
+            val = val.reshape(-1)[:self.shape[0] * self.shape[1]]
+            val = val.reshape(self.shape)
+            tracenos, hit = sparse_lookup(self.index, self.cells(line, off))
+            for traceno, trace in zip(tracenos, val[hit]):
+                self.segyfd.puttr(int(traceno), trace)
+
+        if not isinstance(index, slice) and not isinstance(offset, slice):
+            return put(index, offset, val)
+
+        irange, orange = self.ranges(index, offset)
+
+        val = iter(val)
+        for line in irange:
+            for off in orange:
+                try: put(line, off, next(val))
+                except StopIteration: return
+
 class HeaderLine(Line):
     """
     The Line implements the dict interface, with a fixed set of int_like keys,
@@ -357,6 +506,10 @@ class HeaderLine(Line):
     # __len__, keys() etc., however, the __getitem__ is  way different and is re-implemented
 
     def __init__(self, header, base, direction):
+        if isinstance(base, SparseLine):
+            msg = "Header lines are not available for sparse geometries"
+            raise ValueError(msg)
+
         super(HeaderLine, self).__init__(header.segyfile,
                                           base.lines,
                                           base.length,
@@ -1,3 +1,5 @@
+import os
+
 import numpy
 
 import segyio
@@ -10,9 +12,56 @@ from .utils import (
     to_c_encoding
 )
 
-def infer_geometry(f, metrics, strict):
+def infer_sparse_geometry(f):
+    """Index the (inline, crossline, offset) of every trace
+
+    Reads the inline, crossline and offset of all traces in one pass, and
+    builds the geometry from the distinct values of each. Every trace is a
+    cell in the inlines-by-crosslines-by-offsets grid, and the cells are
+    linearised and sorted, so that the trace of a cell is found with a binary
+    search. Cells without a trace are holes in the geometry.
+    """
+    layout = f._traceheader_layouts["SEG00000"]
+    offset = layout.entry_by_name("offset").byte
+    words = f.header_table([f._il, f._xl, offset])
+
+    if f.tracecount == 0:
+        raise ValueError("Unable to index geometry, file has no traces")
+
+    ilines,  il = numpy.unique(words[f._il], return_inverse = True)
+    xlines,  xl = numpy.unique(words[f._xl], return_inverse = True)
+    offsets, of = numpy.unique(words[offset], return_inverse = True)
+
+    cells = il.astype(numpy.int64) * len(xlines) + xl
+    cells = cells * len(offsets) + of
+    traces = numpy.argsort(cells, kind = 'stable').astype(numpy.int64)
+    cells = cells[traces]
+
+    duplicates = numpy.flatnonzero(cells[1:] == cells[:-1])
+    if len(duplicates) > 0:
+        first, second = traces[duplicates[0]], traces[duplicates[0] + 1]
+        problem = 'Traces {} and {} have the same (inline, crossline, offset)'
+        raise ValueError(problem.format(first, second))
+
+    # crossline sorted if the crosslines never decrease, but the inlines do
+    if numpy.all(numpy.diff(xl) >= 0) and numpy.any(numpy.diff(il) < 0):
+        f._sorting = segyio.TraceSortingFormat.CROSSLINE_SORTING
+    else:
+        f._sorting = segyio.TraceSortingFormat.INLINE_SORTING
+
+    f._ilines  = ilines.astype(numpy.intc)
+    f._xlines  = xlines.astype(numpy.intc)
+    f._offsets = offsets.astype(numpy.intc)
+    f._sparse  = (cells, traces)
+    return f
+
+
+def infer_geometry(f, metrics, strict, index = None, sparse = False):
     try:
-        cube_metrics = f.segyfd.cube_metrics()
+        if index is not None and os.path.exists(index[0]):
+            cube_metrics = f.segyfd.cube_metrics(*index)
+        else:
+            cube_metrics = f.segyfd.cube_metrics()
         f._sorting   = cube_metrics['sorting']
         iline_count  = cube_metrics['iline_count']
         xline_count  = cube_metrics['xline_count']
@@ -27,13 +76,17 @@ def infer_geometry(f, metrics, strict):
         f.interpret(ilines, xlines, offsets, f._sorting)
 
     except:
-        if not strict:
-            f._ilines  = None
-            f._xlines  = None
-            f._offsets = None
-        else:
-            f.close()
-            raise
+        try:
+            if not sparse: raise
+            infer_sparse_geometry(f)
+        except:
+            if not strict:
+                f._ilines  = None
+                f._xlines  = None
+                f._offsets = None
+            else:
+                f.close()
+                raise
 
     return f
 
@@ -44,7 +97,8 @@ def open(filename, mode="r", iline = None,
                              ignore_geometry = False,
                              endian = None,
                              encoding = None,
-                             layout_xml = None
+                             layout_xml = None,
+                             sparse = False
                              ):
     """Open a segy file.
 
@@ -74,6 +128,19 @@ def open(filename, mode="r", iline = None,
     essentially the same as using ``strict=False`` on a file that has no
     geometry.
 
+    If there is a geometry index next to the file, i.e. ``filename.segyidx``
+    as written by `segyio.tools.write_index` or the ``segyio-index`` program,
+    segyio reads the geometry from it instead of scanning the trace headers.
+    An index that does not match the file is ignored.
+
+    If ``sparse=True``, files with missing traces, like irregular land
+    surveys, get a sparse geometry instead of being unstructured. The inlines,
+    crosslines and offsets are all the distinct values in the file, and lines
+    and gathers are read through an index from (inline, crossline, offset) to
+    trace, built in one pass over the trace headers. Holes in lines and
+    gathers are filled with zeros. Files with a regular geometry are not
+    affected.
+
     Parameters
     ----------
 
@@ -116,6 +183,10 @@ def open(filename, mode="r", iline = None,
         SEG-Y revision 2.1 D8 xml layout. Takes precedence over layout
         definition xml inside the file.
 
+    sparse : bool, optional
+        Index the traces of files that are not full cubes, and give them a
+        sparse geometry. Defaults to False.
+
     Returns
     -------
 
@@ -139,6 +210,12 @@ def open(filename, mode="r", iline = None,
     .. versionchanged:: 2.0
        Support for SEG-Y revision 2.1
 
+    .. versionchanged:: 2.1
+       Geometry is read from the ``.segyidx`` index when present
+
+    .. versionchanged:: 2.1
+       sparse argument
+
     When a file is opened non-strict, only raw traces access is allowed, and
     using modes such as ``iline`` raise an error.
 
@@ -168,6 +245,11 @@ def open(filename, mode="r", iline = None,
     >>> with segyio.open(path, endian = 'little') as f:
     ...     f.trace[0]
 
+    Open a survey with missing traces:
+
+    >>> with segyio.open(path, sparse = True) as f:
+    ...     line = f.iline[f.ilines[0]]
+
     """
 
     if 'w' in mode:
@@ -177,7 +259,8 @@ def open(filename, mode="r", iline = None,
 
     return _open(
         FileDatasourceDescriptor(filename, mode),
-        iline, xline, strict, ignore_geometry, endian, encoding, layout_xml
+        iline, xline, strict, ignore_geometry, endian, encoding, layout_xml,
+        sparse
     )
 
 
@@ -189,7 +272,9 @@ def open_with(stream,
               endian=None,
               encoding=None,
               minimize_requests_number=True,
-              layout_xml = None
+              layout_xml = None,
+              cache=None,
+              sparse=False
               ):
     """
     Opens a segy file from a stream.
@@ -211,15 +296,31 @@ def open_with(stream,
         Configuration for some internal algorithms. True to minimize number of
         requests to the stream at the cost of higher memory usage. False to
         minimize memory usage at the cost of more requests to the stream.
+    cache : bool or int, optional
+        Read the stream in large blocks and keep them in a cache, so that the
+        many small reads of headers and traces become few, large reads from
+        the stream. True uses a 16 MiB cache, an int is the cache size in
+        bytes. Writes go straight through to the stream.
 
     See other common parameters at `segyio.open`.
+
+    Notes
+    -----
+
+    .. versionchanged:: 2.1
+        cache argument
+
+    .. versionchanged:: 2.1
+        sparse argument
     """
     return _open(
         StreamDatasourceDescriptor(
             stream,
-            minimize_requests_number
+            minimize_requests_number,
+            cache
         ),
-        iline, xline, strict, ignore_geometry, endian, encoding, layout_xml
+        iline, xline, strict, ignore_geometry, endian, encoding, layout_xml,
+        sparse
     )
 
 
@@ -230,7 +331,8 @@ def open_from_memory(memory_buffer,
                    ignore_geometry=False,
                    endian=None,
                    encoding=None,
-                   layout_xml = None
+                   layout_xml = None,
+                   sparse=False
                    ):
     """
     Opens a segy file from memory.
@@ -252,7 +354,8 @@ def open_from_memory(memory_buffer,
         MemoryBufferDatasourceDescriptor(
             memory_buffer
         ),
-        iline, xline, strict, ignore_geometry, endian, encoding, layout_xml
+        iline, xline, strict, ignore_geometry, endian, encoding, layout_xml,
+        sparse
     )
 
 
@@ -263,7 +366,8 @@ def _open(datasource_descriptor,
           ignore_geometry=False,
           endian=None,
           encoding=None,
-          layout_xml = None
+          layout_xml = None,
+          sparse=False
           ):
 
     fd = datasource_descriptor.make_segyfile_descriptor()
@@ -303,4 +407,8 @@ def _open(datasource_descriptor,
     if ignore_geometry:
         return f
 
-    return infer_geometry(f, metrics, strict)
+    return infer_geometry(f,
+                          metrics,
+                          strict,
+                          datasource_descriptor.index(),
+                          sparse)
@@ -6,9 +6,9 @@ except (NameError, ImportError): pass
 
 import numpy as np
 
-from .gather import Gather, Groups
-from .line import Line
-from .trace import Trace, Header, Attributes, Text, Stanza
+from .gather import Gather, SparseGather, Groups
+from .line import Line, SparseLine
+from .trace import Trace, Header, Attributes, Text, Stanza, TraceWriter
 from .trace import RowLayoutEntries, FileFieldAccessor
 from .field import Field
 
@@ -52,6 +52,7 @@ class SegyFile(object):
         self._offsets = None
         self._samples = None
         self._sorting = None
+        self._sparse = None
 
         # private values
         self._iline_length = None
@@ -99,6 +100,7 @@ class SegyFile(object):
         self._gather = None
         self.depth = None
         self.endian = endian
+        self._header_cache = {}
 
         super(SegyFile, self).__init__()
 
@@ -234,6 +236,78 @@ class SegyFile(object):
         """
         return self.segyfd.mmap()
 
+    def advise(self, pattern='normal', traces=None):
+        """Tell the operating system how the file will be read
+
+        Give the operating system a hint of the access pattern, so that it can
+        tune readahead and caching. Sequential makes the system read ahead
+        aggressively, which suits reading all inlines or the whole cube in
+        order. Random and strided turn readahead off, which suits reading
+        crosslines, depth slices, and scattered traces. Willneed starts
+        reading the file into the page cache in the background.
+
+        If traces is given, only these traces are read into the page cache.
+        This is useful to prefetch the next chunk of traces while processing
+        the current one.
+
+        The hints are ignored for in-memory files and on platforms that do not
+        support them.
+
+        Parameters
+        ----------
+        pattern : { 'normal', 'sequential', 'random', 'strided', 'willneed' }
+        traces : slice or range, optional
+            Traces to prefetch, in steps of 1. Only valid with 'willneed'
+
+        Notes
+        -----
+
+        .. versionadded:: 2.1
+
+        Examples
+        --------
+
+        Read all the traces in order:
+
+        >>> f.advise('sequential')
+        >>> for tr in f.trace:
+        ...     pass
+
+        Prefetch the next 1000 traces while working on the current ones:
+
+        >>> f.advise('willneed', traces=range(i + 1000, i + 2000))
+        """
+        patterns = {
+            'normal': 0,
+            'sequential': 1,
+            'random': 2,
+            'strided': 3,
+            'willneed': 4,
+        }
+
+        try:
+            code = patterns[pattern]
+        except KeyError:
+            msg = 'unknown access pattern {}, expected one of {}'
+            raise ValueError(msg.format(pattern, ', '.join(patterns)))
+
+        if traces is None:
+            self.segyfd.advise(code)
+            return
+
+        if pattern != 'willneed':
+            msg = 'traces can only be prefetched with willneed, not {}'
+            raise ValueError(msg.format(pattern))
+
+        if isinstance(traces, range):
+            traces = slice(traces.start, traces.stop, traces.step)
+
+        start, stop, step = traces.indices(self.tracecount)
+        if step != 1:
+            raise ValueError('traces must be prefetched in steps of 1')
+
+        self.segyfd.prefetch(start, max(stop - start, 0))
+
     @property
     def dtype(self):
         """
@@ -385,6 +459,26 @@ class SegyFile(object):
         """
         return self.ilines is None
 
+    @property
+    def sparse(self):
+        """
+        If the file has a sparse geometry, the inlines, crosslines and offsets
+        are all the distinct values in the file, but not every combination of
+        them has a trace. Lines and gathers are read through an index, and the
+        missing traces are filled in.
+
+        Returns
+        -------
+
+        sparse : bool
+            ``True`` if this file has a sparse geometry, ``False`` if not
+
+        Notes
+        -----
+        .. versionadded:: 2.1
+        """
+        return self._sparse is not None
+
     @property
     def tracefield(self):
         """
@@ -558,6 +652,91 @@ class SegyFile(object):
         """
         return Attributes(self, field, 0)
 
+    def header_table(self, fields=None, cache=False):
+        """Read many header words of all traces at once
+
+        Read the header words in fields for every trace in the file, in a
+        single pass over the file. This is a lot faster than reading the
+        header words one by one with `attributes`, which reads through the
+        file once per header word.
+
+        Parameters
+        ----------
+
+        fields : iterable of int or segyio.TraceField or tuple, optional
+            The header words to read. A (name, byte) tuple is the header word
+            at byte in the trace header called name, e.g. an extension header.
+            Defaults to all the words of the standard trace header.
+
+        cache : bool, optional
+            Keep the header words in memory, so that `attributes` on the same
+            header words are served from memory without reading the file.
+            Only available for read-only files.
+
+        Returns
+        -------
+
+        table : dict of numpy.ndarray
+            The header words of all traces, keyed by the elements of fields
+
+        Notes
+        -----
+
+        .. versionadded:: 2.1
+
+        Examples
+        --------
+
+        Read the source and group coordinates:
+
+        >>> fields = [TraceField.SourceX, TraceField.SourceY,
+        ...           TraceField.GroupX, TraceField.GroupY]
+        >>> table = f.header_table(fields)
+        >>> sx = table[TraceField.SourceX]
+
+        Read the inline and crossline numbers once, and let attributes use
+        them:
+
+        >>> _ = f.header_table([f._il, f._xl], cache = True)
+        >>> ilines = f.attributes(f._il)[:]
+        """
+        if cache and not self.readonly:
+            raise ValueError('header cache requires a read-only file')
+
+        if fields is None:
+            standard = self._traceheader_entries[0]
+            fields = [
+                entry.byte for entry in standard
+                if entry.type in Attributes.ENTRY_TYPE_TO_NUMPY
+            ]
+
+        keys = list(fields)
+        columns = []
+        for key in keys:
+            if isinstance(key, tuple):
+                name, byte = key
+                index = self._traceheader_names.index(name)
+            else:
+                index, byte = 0, key
+
+            layout = self._traceheader_entries[index]
+            entry = layout.entry_by_byte(int(byte))
+            if entry is None:
+                raise KeyError('No such field {}'.format(key))
+
+            dtype = Attributes.ENTRY_TYPE_TO_NUMPY[entry.type]
+            column = np.empty(self.tracecount, dtype = dtype)
+            columns.append((index, int(byte), column))
+
+        self.segyfd.header_table(columns)
+
+        if cache:
+            for index, byte, column in columns:
+                column.flags.writeable = False
+                self._header_cache[(index, byte)] = column
+
+        return {key: column for key, (_, _, column) in zip(keys, columns)}
+
     @property
     def trace(self):
         """
@@ -625,6 +804,43 @@ class SegyFile(object):
         """
         self.trace[:] = val
 
+    def writer(self, start=0, background=True):
+        """Sequential, buffered trace writer
+
+        Write traces, header and samples, in order from trace `start`, with
+        large sequential writes. This is the fast way to fill a file created
+        with :func:`segyio.create`.
+
+        Parameters
+        ----------
+        start : int
+            The first trace to write
+        background : bool
+            Write to disk in a background thread, while the next traces are
+            collected
+
+        Returns
+        -------
+        writer : segyio.trace.TraceWriter
+
+        Notes
+        -----
+        .. versionadded:: 2.1
+
+        Examples
+        --------
+        Copy the traces and headers of a file:
+
+        >>> with segyio.create(path, spec) as dst:
+        ...     with dst.writer() as w:
+        ...         for header, trace in zip(src.header, src.trace):
+        ...             w.append(header, trace)
+        """
+        if self.readonly:
+            raise IOError('file not open for writing. open with \'r+\'')
+
+        return TraceWriter(self, start = start, background = background)
+
     @property
     def ilines(self):
         """Inline labels
@@ -664,6 +880,16 @@ class SegyFile(object):
         if self._iline is not None:
             return self._iline
 
+        if self.sparse:
+            self._iline = SparseLine(self,
+                                     self.ilines,
+                                     self.xlines,
+                                     self.offsets,
+                                     self._sparse,
+                                     'inline',
+                                    )
+            return self._iline
+
         self._iline = Line(self,
                            self.ilines,
                            self._iline_length,
@@ -735,6 +961,16 @@ class SegyFile(object):
         if self._xline is not None:
             return self._xline
 
+        if self.sparse:
+            self._xline = SparseLine(self,
+                                     self.xlines,
+                                     self.ilines,
+                                     self.offsets,
+                                     self._sparse,
+                                     'crossline',
+                                    )
+            return self._xline
+
         self._xline = Line(self,
                            self.xlines,
                            self._xline_length,
@@ -882,6 +1118,13 @@ class SegyFile(object):
         if self._gather is not None:
             return self._gather
 
+        if self.sparse:
+            self._gather = SparseGather(self.trace,
+                                        self.iline,
+                                        self.xline,
+                                        self.offsets)
+            return self._gather
+
         self._gather = Gather(self.trace, self.iline, self.xline, self.offsets)
         return self._gather
 
@@ -1132,6 +1375,13 @@ class SegyFile(object):
         self._ilines = ilines
         self._xlines = xlines
 
+        # drop the sparse index and the line modes built on it, if any
+        if self.sparse:
+            self._sparse = None
+            self._iline = None
+            self._xline = None
+            self._gather = None
+
         return self
 
     def group(self, word):
@@ -1140,8 +1390,9 @@ class SegyFile(object):
         This feature is **experimental**, and there are no guarantees code
         using this will work in the future.
 
-        Walks the headers and groups traces into buckets, where all traces in a
-        bucket have the same value for the given set of words. It is
+        Reads the words of all headers in a single pass, and groups traces into
+        buckets, where all traces in a bucket have the same value for the given
+        set of words. It is
         particularly useful for pre-stack files, gathering traces belonging to
         the same gather or shot.
 
@@ -51,6 +51,7 @@ std::string segy_errstr( int err ) {
         case SEGY_INVALID_OFFSETS:     return "segyio.invalid.offsets";
         case SEGY_TRACE_SIZE_MISMATCH: return "segyio.trace.size.mismatch";
         case SEGY_INVALID_ARGS:        return "segyio.invalid.args";
+        case SEGY_TOO_MANY_TRACES:     return "segyio.too.many.traces";
         case SEGY_MMAP_ERROR:          return "segyio.mmap.error";
         case SEGY_MMAP_INVALID:        return "segyio.mmap.invalid";
         case SEGY_READONLY:            return "segyio.readonly";
@@ -164,17 +165,67 @@ PyObject* Error( int err ) {
 
 namespace ds {
 
-int py_read( segy_datasource* self, void* buffer, size_t size ) {
-    int err = SEGY_DS_READ_ERROR;
-    PyObject* stream = (PyObject*)self->stream;
+/*
+ * The python stream and its bound methods, looked up once when the datasource
+ * is created, so that every read and write is a single call without building
+ * argument tuples or looking up attributes.
+ */
+struct pystream {
+    PyObject* stream;
+    PyObject* read;
+    PyObject* readinto; // NULL if the stream has no readinto
+    PyObject* write;
+    PyObject* seek;
+    PyObject* tell;
+    long long size;     // -1 if not known
+};
 
-    PyObject* result = PyObject_CallMethod( stream, "read", "n", size );
-    if( !result ) {
-        if (PyErr_Occurred()) {
-            PyErr_Print();
-        }
-        return err;
+pystream* stream_of( segy_datasource* self ) {
+    return static_cast< pystream* >( self->stream );
+}
+
+int print_error( int err ) {
+    if( PyErr_Occurred() ) {
+        PyErr_Print();
+    }
+    return err;
+}
+
+/*
+ * Wrap segyio's buffer in a memoryview, so that python reads and writes
+ * straight to and from it. Should the stream hold on to the view, it is
+ * released after the call, so that the buffer can not be touched later.
+ */
+PyObject* call_with_view( PyObject* method, void* buffer, size_t size, int flags ) {
+    PyObject* view = PyMemoryView_FromMemory(
+        static_cast< char* >( buffer ),
+        static_cast< Py_ssize_t >( size ),
+        flags
+    );
+    if( !view ) return NULL;
+
+    PyObject* result = PyObject_CallOneArg( method, view );
+    if( Py_REFCNT( view ) > 1 ) {
+        PyObject *type, *value, *traceback;
+        PyErr_Fetch( &type, &value, &traceback );
+        PyObject* released = PyObject_CallMethod( view, "release", NULL );
+        Py_XDECREF( released );
+        if( !released ) PyErr_Clear();
+        PyErr_Restore( type, value, traceback );
     }
+    Py_DECREF( view );
+    return result;
+}
+
+int py_read_bytes( pystream* s, void* buffer, size_t size ) {
+    int err = SEGY_DS_READ_ERROR;
+    PyObject* nbytes = PyLong_FromSize_t( size );
+    if( !nbytes ) return print_error( err );
+
+    PyObject* result = PyObject_CallOneArg( s->read, nbytes );
+    Py_DECREF( nbytes );
+    if( !result ) return print_error( err );
+
     const char* data = PyBytes_AsString( result );
     if( data ) {
         Py_ssize_t result_size = PyBytes_Size( result );
@@ -185,57 +236,102 @@ int py_read( segy_datasource* self, void* buffer, size_t size ) {
     }
 
     Py_DECREF( result );
-    return err;
+    return print_error( err );
 }
 
-int py_write( segy_datasource* self, const void* buffer, size_t size ) {
-    int err = SEGY_DS_WRITE_ERROR;
-    PyObject* stream = (PyObject*)self->stream;
+int py_read( segy_datasource* self, void* buffer, size_t size ) {
+    pystream* s = stream_of( self );
+    if( !s->readinto ) return py_read_bytes( s, buffer, size );
+
+    char* dst = static_cast< char* >( buffer );
+    while( size > 0 ) {
+        PyObject* result = call_with_view( s->readinto, dst, size, PyBUF_WRITE );
+        if( !result ) {
+            /*
+             * io.RawIOBase has readinto, but it is not necessarily
+             * implemented by subclasses - stick to read for this stream
+             */
+            if( !PyErr_ExceptionMatches( PyExc_NotImplementedError ) )
+                return print_error( SEGY_DS_READ_ERROR );
 
-    PyObject* result = PyObject_CallMethod( stream, "write", "y#", buffer, size );
-    if( !result ) {
-        if (PyErr_Occurred()) {
-            PyErr_Print();
+            PyErr_Clear();
+            Py_CLEAR( s->readinto );
+            return py_read_bytes( s, dst, size );
         }
-        return err;
+
+        /* None means no data available right now, 0 means end-of-file */
+        const Py_ssize_t n = result == Py_None ? 0 : PyLong_AsSsize_t( result );
+        Py_DECREF( result );
+        if( n <= 0 || static_cast< size_t >( n ) > size )
+            return print_error( SEGY_DS_READ_ERROR );
+
+        dst += n;
+        size -= n;
     }
 
+    return SEGY_OK;
+}
+
+int py_write( segy_datasource* self, const void* buffer, size_t size ) {
+    pystream* s = stream_of( self );
+    /* a write may grow the stream */
+    s->size = -1;
+
+    PyObject* result = call_with_view(
+        s->write,
+        const_cast< void* >( buffer ),
+        size,
+        PyBUF_READ
+    );
+    if( !result ) return print_error( SEGY_DS_WRITE_ERROR );
+
+    int err = SEGY_DS_WRITE_ERROR;
     Py_ssize_t result_size = PyLong_AsSsize_t( result );
     if( static_cast<size_t>( result_size ) == size ) {
         err = SEGY_OK;
     }
     Py_DECREF( result );
-    return err;
+    return print_error( err );
 }
 
 int py_seek( segy_datasource* self, long long offset, int whence ) {
-    PyObject* stream = (PyObject*)self->stream;
-    PyObject* result = PyObject_CallMethod( stream, "seek", "Li", offset, whence );
-    if( !result ) {
-        if (PyErr_Occurred()) {
-            PyErr_Print();
-        }
-        return SEGY_DS_SEEK_ERROR;
-    }
+    pystream* s = stream_of( self );
+    PyObject* args[] = {
+        PyLong_FromLongLong( offset ),
+        PyLong_FromLong( whence ),
+    };
+
+    PyObject* result = NULL;
+    if( args[ 0 ] && args[ 1 ] )
+        result = PyObject_Vectorcall( s->seek, args, 2, NULL );
+    Py_XDECREF( args[ 0 ] );
+    Py_XDECREF( args[ 1 ] );
+
+    if( !result ) return print_error( SEGY_DS_SEEK_ERROR );
     Py_DECREF( result );
     return SEGY_OK;
 }
 
 int py_tell( segy_datasource* self, long long* pos ) {
-    PyObject* stream = (PyObject*)self->stream;
-    PyObject* result = PyObject_CallMethod( stream, "tell", NULL );
-    if( !result ) {
-        if (PyErr_Occurred()) {
-            PyErr_Print();
-        }
-        return SEGY_DS_ERROR;
-    }
+    PyObject* result = PyObject_CallNoArgs( stream_of( self )->tell );
+    if( !result ) return print_error( SEGY_DS_ERROR );
+
     *pos = PyLong_AsLongLong( result );
     Py_DECREF( result );
     return SEGY_OK;
 }
 
+/*
+ * Finding the size takes four calls into python, so it is only done once and
+ * again after the stream has been written to.
+ */
 int py_size( segy_datasource* self, long long* out ) {
+    pystream* s = stream_of( self );
+    if( s->size >= 0 ) {
+        *out = s->size;
+        return SEGY_OK;
+    }
+
     long long original_tell;
     int err = py_tell( self, &original_tell );
     if( err != SEGY_OK ) return err;
@@ -248,45 +344,43 @@ int py_size( segy_datasource* self, long long* out ) {
 
     err = py_seek( self, original_tell, SEEK_SET );
     if( err != SEGY_OK ) return err;
+
+    s->size = *out;
     return SEGY_OK;
 }
 
 int py_flush( segy_datasource* self ) {
-    PyObject* stream = (PyObject*)self->stream;
+    PyObject* stream = stream_of( self )->stream;
     PyObject* result = PyObject_CallMethod( stream, "flush", NULL );
-    if( !result ) {
-        if (PyErr_Occurred()) {
-            PyErr_Print();
-        }
-        return SEGY_DS_FLUSH_ERROR;
-    }
+    if( !result ) return print_error( SEGY_DS_FLUSH_ERROR );
     Py_DECREF( result );
     return SEGY_OK;
 }
 
+void free_py_stream( pystream* s ) {
+    Py_XDECREF( s->read );
+    Py_XDECREF( s->readinto );
+    Py_XDECREF( s->write );
+    Py_XDECREF( s->seek );
+    Py_XDECREF( s->tell );
+    Py_XDECREF( s->stream );
+    delete s;
+}
+
 int py_close( segy_datasource* self ) {
-    PyObject* stream = (PyObject*)self->stream;
-    PyObject* result = PyObject_CallMethod( stream, "close", NULL );
-    if( !result ) {
-        if (PyErr_Occurred()) {
-            PyErr_Print();
-        }
-        return SEGY_DS_CLOSE_ERROR;
-    }
+    pystream* s = stream_of( self );
+    PyObject* result = PyObject_CallMethod( s->stream, "close", NULL );
+    if( !result ) return print_error( SEGY_DS_CLOSE_ERROR );
     Py_DECREF( result );
-    Py_DECREF( stream );
+    free_py_stream( s );
+    self->stream = NULL;
     return SEGY_OK;
 }
 
 int py_set_writable( segy_datasource* self ) {
-    PyObject* stream = (PyObject*)self->stream;
+    PyObject* stream = stream_of( self )->stream;
     PyObject* result = PyObject_CallMethod( stream, "writable", NULL );
-    if( !result ) {
-        if( PyErr_Occurred() ) {
-            PyErr_Print();
-        }
-        return SEGY_DS_ERROR;
-    }
+    if( !result ) return print_error( SEGY_DS_ERROR );
     self->writable = PyObject_IsTrue( result );
     Py_DECREF( result );
     return SEGY_OK;
@@ -316,11 +410,32 @@ segy_datasource* create_py_stream_datasource(
 ) {
     segy_datasource* ds = (segy_datasource*)malloc( sizeof( segy_datasource ) );
     if( !ds ) return NULL;
+    segy_init_datasource( ds );
 
     /* current requirements on file-like-object stream: read, write, seek, tell,
-     * flush, close, writable
+     * flush, close, writable. readinto is used instead of read when available
      */
-    ds->stream = py_stream;
+    pystream* s = new pystream();
+    /* keep additional reference to assure object does not get deleted before
+     * segy_datasource is closed
+     */
+    Py_INCREF( py_stream );
+    s->stream = py_stream;
+    s->read = PyObject_GetAttrString( py_stream, "read" );
+    s->write = PyObject_GetAttrString( py_stream, "write" );
+    s->seek = PyObject_GetAttrString( py_stream, "seek" );
+    s->tell = PyObject_GetAttrString( py_stream, "tell" );
+    s->readinto = PyObject_GetAttrString( py_stream, "readinto" );
+    s->size = -1;
+    if( !s->readinto ) PyErr_Clear();
+
+    if( !s->read || !s->write || !s->seek || !s->tell ) {
+        free_py_stream( s );
+        free( ds );
+        return NULL;
+    }
+
+    ds->stream = s;
 
     ds->read = py_read;
     ds->write = py_write;
@@ -329,11 +444,17 @@ segy_datasource* create_py_stream_datasource(
     ds->size = py_size;
     ds->flush = py_flush;
     ds->close = py_close;
+    ds->read_at = NULL;
+    ds->write_at = NULL;
 
     // writable is set only on init, assuming stream does not change it during
     // operation
     const int err = py_set_writable( ds );
-    if( err ) return NULL;
+    if( err ) {
+        free_py_stream( s );
+        free( ds );
+        return NULL;
+    }
 
     ds->memory_speedup = false;
     ds->minimize_requests_number = minimize_requests_number;
@@ -363,10 +484,6 @@ segy_datasource* create_py_stream_datasource(
         "SEG00001"
     );
 
-    /* keep additional reference to assure object does not get deleted before
-     * segy_datasource is closed
-     */
-    Py_INCREF( py_stream );
     return ds;
 }
 
@@ -500,7 +617,7 @@ struct segyfd {
     autods ds;
     unsigned long long trace0;
     int trace_bsize;
-    int tracecount;
+    long long tracecount;
     int traceheader_count;
     int samplecount;
     int format;
@@ -508,6 +625,67 @@ struct segyfd {
 
     std::vector<stanza_header> stanzas;
     std::vector<segy_header_mapping> traceheader_mappings;
+
+    // serializes all use of ds, see fdlock
+    PyThread_type_lock lock;
+
+    // number of live buffers over the mapped traces, see getbuffer
+    Py_ssize_t exports;
+    // datasource closed while buffers were still exported
+    autods retired;
+
+    // open sequential writer, see writer_open
+    segy_writer* writer;
+};
+
+/*
+ * Serialize the use of a segyfd across threads. The lock is taken with the
+ * GIL held, but if it is contended the GIL is released while waiting, so that
+ * the thread that holds the lock can make progress.
+ */
+struct fdlock {
+    explicit fdlock( segyfd* self ) : lock( self->lock ) {
+        if( !this->lock ) return;
+        if( PyThread_acquire_lock( this->lock, NOWAIT_LOCK ) ) return;
+
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock( this->lock, WAIT_LOCK );
+        Py_END_ALLOW_THREADS
+    }
+
+    ~fdlock() { if( this->lock ) PyThread_release_lock( this->lock ); }
+
+    PyThread_type_lock lock;
+
+private:
+    fdlock( const fdlock& );
+};
+
+/*
+ * Release the GIL for the lifetime of this object, so that other threads can
+ * run while segyio does I/O and conversions. Only segyio C calls may happen
+ * in this scope, no python API calls, and the segyfd must be locked.
+ *
+ * Python stream datasources call back into python, so for those the GIL is
+ * kept, also when the stream is wrapped in a cache.
+ */
+bool is_py_stream( segy_datasource* ds ) {
+    segy_datasource* inner = segy_cached_inner( ds );
+    if( inner ) ds = inner;
+    return ds->read == ds::py_read;
+}
+
+struct nogil {
+    explicit nogil( segy_datasource* ds ) :
+        state( is_py_stream( ds ) ? NULL : PyEval_SaveThread() )
+    {}
+
+    ~nogil() { if( this->state ) PyEval_RestoreThread( this->state ); }
+
+    PyThreadState* state;
+
+private:
+    nogil( const nogil& );
 };
 
 namespace {
@@ -544,11 +722,20 @@ PyObject* traceheader_layouts( segyfd* self );
 namespace fd {
 
 int init( segyfd* self, PyObject* args, PyObject* kwargs ) {
+    if( !self->lock ) {
+        self->lock = PyThread_allocate_lock();
+        if( !self->lock ) {
+            PyErr_SetString( PyExc_MemoryError, "unable to allocate lock" );
+            return -1;
+        }
+    }
+
     char* filename = NULL;
     char* mode = NULL;
     PyObject* stream = NULL;
     PyObject* memory_buffer = NULL;
     int minimize_requests_number = -1;
+    Py_ssize_t cache = 0;
 
     static const char* keywords[] = {
         "filename",
@@ -556,17 +743,19 @@ int init( segyfd* self, PyObject* args, PyObject* kwargs ) {
         "stream",
         "memory_buffer",
         "minimize_requests_number",
+        "cache",
         NULL
     };
 
     if( !PyArg_ParseTupleAndKeywords(
-            args, kwargs, "|ssOOp",
+            args, kwargs, "|ssOOpn",
             const_cast<char**>( keywords ),
             &filename,
             &mode,
             &stream,
             &memory_buffer,
-            &minimize_requests_number
+            &minimize_requests_number,
+            &cache
         ) ) {
         ValueError( "could not parse arguments" );
         return -1;
@@ -582,9 +771,27 @@ int init( segyfd* self, PyObject* args, PyObject* kwargs ) {
             ValueError( "minimize requests number is not set" );
             return -1;
         }
+        if( cache < 0 ) {
+            ValueError( "cache must be non-negative, was %zd", cache );
+            return -1;
+        }
         ds.ds = ds::create_py_stream_datasource(
             stream, minimize_requests_number
         );
+
+        /*
+         * every read from a python stream is a method call with the GIL held,
+         * so serve the many small header and trace reads from a block cache
+         */
+        if( ds.ds && cache > 0 ) {
+            segy_datasource* cached = segy_cached_datasource( ds.ds, 0, cache );
+            if( !cached ) {
+                PyErr_SetString( PyExc_MemoryError,
+                                 "unable to allocate stream cache" );
+                return -1;
+            }
+            ds.ds = cached;
+        }
     } else if( memory_buffer ) {
         if (memory_buffer == Py_None) {
             ValueError( "buffer must not be None" );
@@ -637,6 +844,7 @@ int init( segyfd* self, PyObject* args, PyObject* kwargs ) {
      * file on the same object. That means the previous file handle must be
      * properly closed before the new file is set
      */
+    const fdlock lock( self );
     self->ds.swap( ds );
 
     return 0;
@@ -761,7 +969,7 @@ PyObject* segycreate( segyfd* self, PyObject* args, PyObject* kwargs ) {
     int endianness = -1;
     int encoding = -1;
     int samples;
-    int tracecount;
+    long long tracecount;
     int ext_headers = 0;
     int traceheader_count = 1;
     int format = SEGY_IBM_FLOAT_4_BYTE;
@@ -786,7 +994,7 @@ PyObject* segycreate( segyfd* self, PyObject* args, PyObject* kwargs ) {
     };
 
     if( !PyArg_ParseTupleAndKeywords( args, kwargs,
-                "ii|iiiiiO",
+                "iL|iiiiiO",
                 const_cast< char** >(kwlist),
                 &samples,
                 &tracecount,
@@ -944,7 +1152,7 @@ PyObject* suopen( segyfd* self, PyObject* args, PyObject* kwargs ) {
     ds->metadata.samplecount = fd.value.u16;
     ds->metadata.trace_bsize = ds->metadata.samplecount * ds->metadata.elemsize;
 
-    err = segy_traces( ds, &ds->metadata.tracecount );
+    err = segy_traces64( ds, &ds->metadata.tracecount );
     if( err == SEGY_OK ) {
         self->format = ds->metadata.format;
         self->elemsize = ds->metadata.elemsize;
@@ -973,19 +1181,76 @@ PyObject* suopen( segyfd* self, PyObject* args, PyObject* kwargs ) {
     return RuntimeError( msg.str().c_str() );
 }
 
+/*
+ * An open writer shares the datasource, and may still be writing buffered
+ * traces from its background thread. Every other method that uses the
+ * datasource first writes out the writer's buffers and waits for the writes to
+ * finish, so that it doesn't race the writer, and sees the traces appended so
+ * far. The writer stays open, and the next writer_put continues after them.
+ * The segyfd must be locked.
+ */
+bool sync_writer( segyfd* self ) {
+    if( !self->writer ) return true;
+
+    int err;
+    {
+        const nogil threads( self->ds );
+        err = segy_writer_flush( self->writer );
+    }
+
+    switch( err ) {
+        case SEGY_OK:
+            return true;
+
+        case SEGY_DS_WRITE_ERROR:
+        case SEGY_DS_SEEK_ERROR:
+            IOError( "I/O operation failed writing traces" );
+            return false;
+
+        default:
+            Error( err );
+            return false;
+    }
+}
+
 void dealloc( segyfd* self ) {
     free_header_mappings_names(
         self->traceheader_mappings.data(),
         self->traceheader_mappings.size()
     );
+    if( self->writer ) segy_writer_close( self->writer );
+    self->writer = NULL;
     self->ds.close();
+    self->retired.close();
+    if( self->lock ) PyThread_free_lock( self->lock );
     Py_TYPE( self )->tp_free( (PyObject*) self );
 }
 
 PyObject* close( segyfd* self ) {
+    const fdlock lock( self );
     /* multiple close() is a no-op */
     if( !self->ds ) return Py_BuildValue( "" );
 
+    if( self->writer ) {
+        const int err = segy_writer_close( self->writer );
+        self->writer = NULL;
+        if( err ) {
+            self->ds.close();
+            return Error( err );
+        }
+    }
+
+    /*
+     * trace views still point into the mapping, so only flush, and put off
+     * the real close until the last view is released
+     */
+    if( self->exports > 0 ) {
+        const int err = segy_flush( self->ds );
+        self->ds.swap( self->retired );
+        if( err ) return Error( err );
+        return Py_BuildValue( "" );
+    }
+
     errno = 0;
     const int err = self->ds.close();
     if ( err ) {
@@ -998,22 +1263,35 @@ PyObject* close( segyfd* self ) {
 }
 
 PyObject* flush( segyfd* self ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
 
     errno = 0;
-    segy_flush( self->ds );
+    int err = SEGY_OK;
+    {
+        const nogil threads( ds );
+        if( self->writer ) err = segy_writer_flush( self->writer );
+        segy_flush( ds );
+    }
+    if( err ) return Error( err );
     if( errno ) return IOErrno();
 
     return Py_BuildValue( "" );
 }
 
 PyObject* mmap( segyfd* self ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
 
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
-    const int err = segy_mmap( ds );
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_mmap( ds );
+    }
 
     if( err != SEGY_OK )
         Py_RETURN_FALSE;
@@ -1021,6 +1299,104 @@ PyObject* mmap( segyfd* self ) {
     Py_RETURN_TRUE;
 }
 
+PyObject* advise( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
+    segy_datasource* ds = self->ds;
+    if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
+
+    int pattern;
+    if( !PyArg_ParseTuple( args, "i", &pattern ) ) return NULL;
+
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_set_access_pattern( ds, pattern );
+    }
+
+    if( err == SEGY_INVALID_ARGS )
+        return ValueError( "unknown access pattern %d", pattern );
+    if( err != SEGY_OK ) return Error( err );
+
+    return Py_BuildValue( "" );
+}
+
+PyObject* prefetch( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
+    segy_datasource* ds = self->ds;
+    if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
+
+    long long first, count;
+    if( !PyArg_ParseTuple( args, "LL", &first, &count ) ) return NULL;
+
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_prefetch_traces( ds, first, count );
+    }
+
+    if( err == SEGY_INVALID_ARGS )
+        return ValueError( "invalid trace range (first = %lld, count = %lld)",
+                           first, count );
+    if( err != SEGY_OK ) return Error( err );
+
+    return Py_BuildValue( "" );
+}
+
+/*
+ * Expose the data traces of a memory mapped (or in-memory) file through the
+ * buffer protocol, without copying. The buffer starts at the first sample of
+ * the first trace and ends at the last sample of the last trace, so the trace
+ * headers are interleaved and consumers must step by the trace stride. The
+ * samples are as stored in the file, in the file's byte order.
+ *
+ * The mapping must outlive the buffers, so if the file is closed while there
+ * are buffers exported, the datasource is kept open until the last one is
+ * released.
+ */
+int getbuffer( segyfd* self, Py_buffer* view, int flags ) {
+    const fdlock lock( self );
+    view->obj = NULL;
+
+    segy_datasource* ds = self->ds;
+    if( !ds ) return -1;
+    if( !sync_writer( self ) ) return -1;
+
+    if( self->tracecount == 0 ) {
+        BufferError( "file has no traces" );
+        return -1;
+    }
+
+    void* ptr;
+    const int err = segy_trace_ptr( ds, 0, &ptr );
+    if( err == SEGY_MMAP_INVALID ) {
+        BufferError( "file is not memory mapped" );
+        return -1;
+    }
+
+    if( err ) {
+        Error( err );
+        return -1;
+    }
+
+    const long long stride = self->trace_bsize
+                           + SEGY_TRACE_HEADER_SIZE * self->traceheader_count;
+    const long long len = stride * (self->tracecount - 1) + self->trace_bsize;
+
+    const int readonly = !ds->writable;
+    if( PyBuffer_FillInfo( view, (PyObject*)self, ptr, len, readonly, flags ) )
+        return -1;
+
+    ++self->exports;
+    return 0;
+}
+
+void releasebuffer( segyfd* self, Py_buffer* ) {
+    if( --self->exports == 0 )
+        self->retired.close();
+}
+
 /*
  * No C++11, so no std::vector::data. single-alloc automatic heap buffer,
  * without resize
@@ -1047,8 +1423,10 @@ private:
 };
 
 PyObject* gettext( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     int index = 0;
     if( !PyArg_ParseTuple( args, "i", &index ) ) return NULL;
@@ -1056,9 +1434,13 @@ PyObject* gettext( segyfd* self, PyObject* args ) {
     heapbuffer buffer( segy_textheader_size() );
     if( !buffer ) return NULL;
 
-    const int err = index == 0
-              ? segy_read_textheader( ds, buffer )
-              : segy_read_ext_textheader( ds, index - 1, buffer );
+    int err;
+    {
+        const nogil threads( ds );
+        err = index == 0
+            ? segy_read_textheader( ds, buffer )
+            : segy_read_ext_textheader( ds, index - 1, buffer );
+    }
 
     if( err ) return Error( err );
     /*
@@ -1069,8 +1451,10 @@ PyObject* gettext( segyfd* self, PyObject* args ) {
 }
 
 PyObject* puttext( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     int index;
     buffer_guard buffer;
@@ -1085,7 +1469,11 @@ PyObject* puttext( segyfd* self, PyObject* args ) {
     const char* src = buffer.buf< const char >();
     std::copy( src, src + size, buf.ptr );
 
-    const int err = segy_write_textheader( ds, index, buf );
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_write_textheader( ds, index, buf );
+    }
 
     if( err ) return Error( err );
 
@@ -1093,8 +1481,10 @@ PyObject* puttext( segyfd* self, PyObject* args ) {
 }
 
 PyObject* getstanza( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     int index = 0;
     if( !PyArg_ParseTuple( args, "i", &index ) ) return NULL;
@@ -1104,33 +1494,45 @@ PyObject* getstanza( segyfd* self, PyObject* args ) {
     heapbuffer buffer( stanza.data_size() );
     if( !buffer ) return NULL;
 
-    const int err = segy_read_stanza_data(
-        ds,
-        stanza.header_length(),
-        stanza.headerindex,
-        stanza.data_size(),
-        buffer
-    );
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_read_stanza_data(
+            ds,
+            stanza.header_length(),
+            stanza.headerindex,
+            stanza.data_size(),
+            buffer
+        );
+    }
     if( err ) return Error( err );
 
     return PyByteArray_FromStringAndSize( buffer, stanza.data_size() );
 }
 
 PyObject* getbin( segyfd* self ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     char buffer[ SEGY_BINARY_HEADER_SIZE ] = {};
 
-    const int err = segy_binheader( ds, buffer );
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_binheader( ds, buffer );
+    }
     if( err ) return Error( err );
 
     return PyByteArray_FromStringAndSize( buffer, sizeof( buffer ) );
 }
 
 PyObject* putbin( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     buffer_guard buffer;
     if( !PyArg_ParseTuple(args, "s*", &buffer ) ) return NULL;
@@ -1140,7 +1542,11 @@ PyObject* putbin( segyfd* self, PyObject* args ) {
                            "expected %i, was %zd",
                            SEGY_BINARY_HEADER_SIZE, buffer.len() );
 
-    const int err = segy_write_binheader( ds, buffer.buf< const char >() );
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_write_binheader( ds, buffer.buf< const char >() );
+    }
 
     if( err == SEGY_INVALID_ARGS )
         return IOError( "file not open for writing. open with 'r+'" );
@@ -1150,14 +1556,16 @@ PyObject* putbin( segyfd* self, PyObject* args ) {
 }
 
 PyObject* getth( segyfd* self, PyObject *args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
-    int traceno;
+    long long traceno;
     uint16_t traceheader_index;
     PyObject* bufferobj;
 
-    if( !PyArg_ParseTuple( args, "iHO", &traceno, &traceheader_index, &bufferobj ) ) return NULL;
+    if( !PyArg_ParseTuple( args, "LHO", &traceno, &traceheader_index, &bufferobj ) ) return NULL;
 
     buffer_guard buffer( bufferobj, PyBUF_CONTIG );
     if( !buffer ) return NULL;
@@ -1173,13 +1581,18 @@ PyObject* getth( segyfd* self, PyObject *args ) {
         );
     }
 
-    int err = segy_read_traceheader(
-        ds,
-        traceno,
-        traceheader_index,
-        self->traceheader_mappings[traceheader_index].offset_to_entry_definition,
-        buffer.buf()
-    );
+    const segy_entry_definition* map =
+        self->traceheader_mappings[traceheader_index].offset_to_entry_definition;
+
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_read_traceheader64( ds,
+                                       traceno,
+                                       traceheader_index,
+                                       map,
+                                       buffer.buf() );
+    }
 
     switch( err ) {
         case SEGY_OK:
@@ -1187,7 +1600,7 @@ PyObject* getth( segyfd* self, PyObject *args ) {
             return bufferobj;
 
         case SEGY_FREAD_ERROR:
-            return IOError( "I/O operation failed on trace header %d",
+            return IOError( "I/O operation failed on trace header %lld",
                             traceno );
 
         default:
@@ -1196,13 +1609,15 @@ PyObject* getth( segyfd* self, PyObject *args ) {
 }
 
 PyObject* putth( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
-    int traceno;
+    long long traceno;
     uint16_t traceheader_index;
     buffer_guard buf;
-    if( !PyArg_ParseTuple( args, "iHs*", &traceno, &traceheader_index, &buf ) ) return NULL;
+    if( !PyArg_ParseTuple( args, "LHs*", &traceno, &traceheader_index, &buf ) ) return NULL;
 
     if( buf.len() < SEGY_TRACE_HEADER_SIZE )
         return ValueError( "internal: trace header buffer too small, "
@@ -1217,20 +1632,25 @@ PyObject* putth( segyfd* self, PyObject* args ) {
 
     const char* buffer = buf.buf< const char >();
 
-    int err = segy_write_traceheader(
-        ds,
-        traceno,
-        traceheader_index,
-        self->traceheader_mappings[traceheader_index].offset_to_entry_definition,
-        buffer
-    );
+    const segy_entry_definition* map =
+        self->traceheader_mappings[traceheader_index].offset_to_entry_definition;
+
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_write_traceheader64( ds,
+                                        traceno,
+                                        traceheader_index,
+                                        map,
+                                        buffer );
+    }
 
     switch( err ) {
         case SEGY_OK:
             return Py_BuildValue( "" );
 
         case SEGY_FWRITE_ERROR:
-            return IOError( "I/O operation failed on trace header %d",
+            return IOError( "I/O operation failed on trace header %lld",
                             traceno );
         default:
             return Error( err );
@@ -1520,17 +1940,19 @@ PyObject* putfield( segyfd* self, PyObject *args ) {
 }
 
 PyObject* field_forall( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     PyObject* bufferobj;
-    int start, stop, step;
+    long long start, stop, step;
     uint16_t traceheader_index;
     int field;
 
     if( !PyArg_ParseTuple(
             args,
-            "OHiiii",
+            "OHLLLi",
             &bufferobj,
             &traceheader_index,
             &start,
@@ -1553,14 +1975,18 @@ PyObject* field_forall( segyfd* self, PyObject* args ) {
     const segy_entry_definition* map =
         self->traceheader_mappings[traceheader_index].offset_to_entry_definition;
 
-    const int err = segy_field_forall( ds,
-                                       traceheader_index,
-                                       map,
-                                       field,
-                                       start,
-                                       stop,
-                                       step,
-                                       buffer.buf< char >() );
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_field_forall64( ds,
+                                   traceheader_index,
+                                   map,
+                                   field,
+                                   start,
+                                   stop,
+                                   step,
+                                   buffer.buf< char >() );
+    }
 
     if( err ) return Error( err );
 
@@ -1568,26 +1994,43 @@ PyObject* field_forall( segyfd* self, PyObject* args ) {
     return bufferobj;
 }
 
-PyObject* field_foreach( segyfd* self, PyObject* args ) {
+PyObject* put_field_forall( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     PyObject* bufferobj;
+    long long start, stop, step;
     uint16_t traceheader_index;
-    buffer_guard indices; //int32 is expected, but not really assured
     int field;
+    int broadcast;
+
     if( !PyArg_ParseTuple(
             args,
-            "OHs*i",
+            "OHLLLip",
             &bufferobj,
             &traceheader_index,
-            &indices,
-            &field
+            &start,
+            &stop,
+            &step,
+            &field,
+            &broadcast
         ) )
         return NULL;
 
-    buffer_guard bufout( bufferobj, PyBUF_CONTIG );
-    if( !bufout ) return NULL;
+    if( step == 0 ) return ValueError( "slice step cannot be zero" );
+
+    buffer_guard buffer( bufferobj );
+    if( !buffer ) return NULL;
+
+    const long long count = step > 0
+                          ? ( stop - start + step - 1 ) / step
+                          : ( start - stop - step - 1 ) / -step;
+    const long long values = broadcast ? 1 : count;
+    if( count > 0 && buffer.len() < values * (&buffer)->itemsize )
+        return ValueError( "expected %lld values, got %zd",
+                           values, buffer.len() / (&buffer)->itemsize );
 
     if( traceheader_index >= self->traceheader_mappings.size() ) {
         return KeyError(
@@ -1597,47 +2040,187 @@ PyObject* field_foreach( segyfd* self, PyObject* args ) {
     const segy_entry_definition* map =
         self->traceheader_mappings[traceheader_index].offset_to_entry_definition;
 
-    int field_size = segy_formatsize( segy_entry_type_to_datatype(
-                                        map[field - 1].entry_type ));
-
-    int buffer_length = bufout.len() / field_size;
-    int indices_length = indices.len() / sizeof( int32_t );
-
-    if( buffer_length != indices_length )
-        return ValueError( "internal: array size mismatch "
-                           "(output %zd, indices %zd)",
-                           buffer_length, indices_length );
-
-    const int* ind = indices.buf< const int >();
-    char* out = bufout.buf< char >();
-    int err = 0;
-    for( int i = 0; err == 0 && i < buffer_length; ++i ) {
-        err = segy_field_forall( ds, traceheader_index, map, field,
-                                     ind[ i ],
-                                     ind[ i ] + 1,
-                                     1,
-                                     out + i * field_size );
+    int err;
+    {
+        const nogil threads( ds );
+        if( broadcast )
+            err = segy_write_field_broadcast( ds,
+                                              traceheader_index,
+                                              map,
+                                              field,
+                                              start,
+                                              stop,
+                                              step,
+                                              buffer.buf< char >() );
+        else
+            err = segy_write_field_forall( ds,
+                                           traceheader_index,
+                                           map,
+                                           field,
+                                           start,
+                                           stop,
+                                           step,
+                                           buffer.buf< char >() );
     }
 
     if( err ) return Error( err );
 
-    Py_INCREF( bufferobj );
-    return bufferobj;
+    return Py_BuildValue( "" );
 }
 
-PyObject* metrics( segyfd* self ) {
+PyObject* field_foreach( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
+    segy_datasource* ds = self->ds;
+    if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
+
+    PyObject* bufferobj;
+    uint16_t traceheader_index;
+    buffer_guard indices; //int32 or int64 is expected, but not really assured
+    int field;
+    if( !PyArg_ParseTuple(
+            args,
+            "OHs*i",
+            &bufferobj,
+            &traceheader_index,
+            &indices,
+            &field
+        ) )
+        return NULL;
+
+    buffer_guard bufout( bufferobj, PyBUF_CONTIG );
+    if( !bufout ) return NULL;
+
+    if( traceheader_index >= self->traceheader_mappings.size() ) {
+        return KeyError(
+            "no trace header mapping available for index %d", traceheader_index
+        );
+    }
+    const segy_entry_definition* map =
+        self->traceheader_mappings[traceheader_index].offset_to_entry_definition;
+
+    int field_size = segy_formatsize( segy_entry_type_to_datatype(
+                                        map[field - 1].entry_type ));
+
+    /*
+     * trace numbers are read as 64-bit integers when the array is wide
+     * enough, and 32-bit otherwise
+     */
+    const bool wide = (&indices)->itemsize == sizeof( int64_t );
+    const Py_ssize_t index_size = wide ? sizeof( int64_t ) : sizeof( int32_t );
+
+    Py_ssize_t buffer_length = bufout.len() / field_size;
+    Py_ssize_t indices_length = indices.len() / index_size;
+
+    if( buffer_length != indices_length )
+        return ValueError( "internal: array size mismatch "
+                           "(output %zd, indices %zd)",
+                           buffer_length, indices_length );
+
+    const int32_t* ind32 = indices.buf< const int32_t >();
+    const int64_t* ind64 = indices.buf< const int64_t >();
+    char* out = bufout.buf< char >();
+    int err = 0;
+    {
+        const nogil threads( ds );
+        for( Py_ssize_t i = 0; err == 0 && i < buffer_length; ++i ) {
+            const long long traceno = wide ? ind64[ i ] : ind32[ i ];
+            err = segy_field_forall64( ds, traceheader_index, map, field,
+                                       traceno,
+                                       traceno + 1,
+                                       1,
+                                       out + i * field_size );
+        }
+    }
+
+    if( err ) return Error( err );
+
+    Py_INCREF( bufferobj );
+    return bufferobj;
+}
+
+PyObject* header_table( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
+    segy_datasource* ds = self->ds;
+    if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
+
+    PyObject* columnsobj;
+    if( !PyArg_ParseTuple( args, "O!", &PyList_Type, &columnsobj ) )
+        return NULL;
+
+    const Py_ssize_t ncolumns = PyList_Size( columnsobj );
+    std::vector< segy_header_column > columns( ncolumns );
+    std::vector< buffer_guard > buffers( ncolumns );
+
+    for( Py_ssize_t i = 0; i < ncolumns; ++i ) {
+        int traceheader_index, field;
+        PyObject* bufferobj;
+        if( !PyArg_ParseTuple( PyList_GetItem( columnsobj, i ),
+                               "iiO",
+                               &traceheader_index,
+                               &field,
+                               &bufferobj ) )
+            return NULL;
+
+        if( traceheader_index < 0
+         || traceheader_index >= int( self->traceheader_mappings.size() ) ) {
+            return KeyError(
+                "no trace header mapping available for index %d",
+                traceheader_index
+            );
+        }
+        const segy_entry_definition* map =
+            self->traceheader_mappings[traceheader_index].offset_to_entry_definition;
+
+        if( field < 1 || field > SEGY_TRACE_HEADER_SIZE )
+            return KeyError( "No such field %d", field );
+
+        const int field_size = segy_formatsize( segy_entry_type_to_datatype(
+                                                  map[field - 1].entry_type ) );
+
+        const int flags = PyBUF_CONTIG | PyBUF_C_CONTIGUOUS;
+        if( PyObject_GetBuffer( bufferobj, &buffers[i], flags ) != 0 )
+            return NULL;
+
+        if( buffers[i].len() < Py_ssize_t( self->tracecount ) * field_size )
+            return ValueError( "internal: column buffer too small, "
+                               "expected %lld, was %zd",
+                               self->tracecount, buffers[i].len() );
+
+        columns[i].traceheader_index = traceheader_index;
+        columns[i].offset_map = map;
+        columns[i].field = field;
+        columns[i].buf = buffers[i].buf();
+    }
+
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_read_all_traceheaders( ds, columns.data(), int( ncolumns ) );
+    }
+
+    if( err == SEGY_INVALID_ARGS )
+        return ValueError( "invalid field in header table" );
+    if( err ) return Error( err );
+
+    return Py_BuildValue( "" );
+}
+
+PyObject* metrics( segyfd* self ) {
     static const int text = SEGY_TEXT_HEADER_SIZE;
     static const int bin  = SEGY_BINARY_HEADER_SIZE;
     const int ext = (self->trace0 - (text + bin)) / text;
     segy_datasource* ds = self->ds;
     int encoding = ds->metadata.encoding;
-    return Py_BuildValue( "{s:i, s:K, s:i, s:i, s:i, s:i, s:i, s:i}",
+    return Py_BuildValue( "{s:L, s:K, s:i, s:i, s:i, s:i, s:i, s:i, s:i}",
                           "tracecount",  self->tracecount,
                           "trace0",      self->trace0,
                           "trace_bsize", self->trace_bsize,
                           "samplecount", self->samplecount,
                           "format",      self->format,
                           "encoding",    encoding,
+                          "endianness",  ds->metadata.endianness,
                           "traceheader_count", self->traceheader_count,
                           "ext_headers", ext );
 }
@@ -1667,9 +2250,15 @@ struct metrics_errmsg {
     }
 };
 
-PyObject* cube_metrics( segyfd* self ) {
+PyObject* cube_metrics( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
+
+    const char* index = NULL;
+    long long mtime = 0;
+    if( !PyArg_ParseTuple( args, "|zL", &index, &mtime ) ) return NULL;
 
     segy_header_mapping& mapping = ds->traceheader_mapping_standard;
 
@@ -1679,30 +2268,35 @@ PyObject* cube_metrics( segyfd* self ) {
 
     metrics_errmsg errmsg = { il, xl, offset };
 
-    int sorting = -1;
-    int err = segy_sorting( ds, il,
-                                xl,
-                                offset,
-                                &sorting );
-
-    if( err ) return errmsg( err );
-
-    int offset_count = -1;
-    err = segy_offsets( ds, il,
-                            xl,
-                            self->tracecount,
-                            &offset_count );
+    int err;
+    if( index ) {
+        /*
+         * A missing or stale index is not an error, it just means the
+         * geometry must be scanned
+         */
+        segy_index_header h;
+        {
+            const nogil threads( ds );
+            err = segy_read_index( ds, index, mtime, il, xl, offset, &h );
+        }
 
-    if( err ) return errmsg( err );
+        if( err == SEGY_OK )
+            return Py_BuildValue( "{s:i, s:i, s:i, s:i, s:i, s:i, s:i, s:s}",
+                                  "sorting",      h.sorting,
+                                  "iline_field",  h.il,
+                                  "xline_field",  h.xl,
+                                  "offset_field", h.offset,
+                                  "offset_count", h.offset_count,
+                                  "iline_count",  h.iline_count,
+                                  "xline_count",  h.xline_count,
+                                  "index",        index );
+    }
 
-    int xl_count = 0;
-    int il_count = 0;
-    err = segy_lines_count( ds, il,
-                                xl,
-                                sorting,
-                                offset_count,
-                                &il_count,
-                                &xl_count );
+    segy_geometry geo;
+    {
+        const nogil threads( ds );
+        err = segy_infer_geometry( ds, il, xl, offset, 0, &geo );
+    }
 
     if( err == SEGY_NOTFOUND )
         return ValueError( "could not parse geometry, "
@@ -1711,13 +2305,13 @@ PyObject* cube_metrics( segyfd* self ) {
     if( err ) return errmsg( err );
 
     return Py_BuildValue( "{s:i, s:i, s:i, s:i, s:i, s:i, s:i}",
-                          "sorting",      sorting,
+                          "sorting",      geo.sorting,
                           "iline_field",  il,
                           "xline_field",  xl,
                           "offset_field", offset,
-                          "offset_count", offset_count,
-                          "iline_count",  il_count,
-                          "xline_count",  xl_count );
+                          "offset_count", geo.offset_count,
+                          "iline_count",  geo.iline_count,
+                          "xline_count",  geo.xline_count );
 }
 
 long getitem( PyObject* dict, const char* key ) {
@@ -1725,8 +2319,10 @@ long getitem( PyObject* dict, const char* key ) {
 }
 
 PyObject* indices( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     PyObject* metrics;
     buffer_guard iline_out;
@@ -1766,84 +2362,234 @@ PyObject* indices( segyfd* self, PyObject* args ) {
 
     metrics_errmsg errmsg = { il_field, xl_field, offset_field };
 
-    int err = segy_inline_indices( ds, il_field,
+    int err;
+    PyObject* index = PyDict_GetItemString( metrics, "index" );
+    if( index ) {
+        const char* path = PyUnicode_AsUTF8( index );
+        if( !path ) return NULL;
+
+        segy_index_header h;
+        h.il           = il_field;
+        h.xl           = xl_field;
+        h.offset       = offset_field;
+        h.sorting      = sorting;
+        h.tracecount   = self->tracecount;
+        h.iline_count  = iline_count;
+        h.xline_count  = xline_count;
+        h.offset_count = offset_count;
+
+        {
+            const nogil threads( ds );
+            err = segy_read_index_lines( path, &h,
+                                         iline_out.buf< int >(),
+                                         xline_out.buf< int >(),
+                                         offset_out.buf< int >() );
+        }
+
+        /* if the index went away since cube_metrics, scan the file instead */
+        if( err == SEGY_OK ) return Py_BuildValue( "" );
+    }
+
+    {
+        const nogil threads( ds );
+        err = segy_inline_indices( ds, il_field,
                                        sorting,
                                        iline_count,
                                        xline_count,
                                        offset_count,
                                        iline_out.buf< int >() );
+    }
     if( err ) return errmsg( err );
 
-    err = segy_crossline_indices( ds, xl_field,
-                                      sorting,
-                                      iline_count,
-                                      xline_count,
-                                      offset_count,
-                                      xline_out.buf< int >() );
+    {
+        const nogil threads( ds );
+        err = segy_crossline_indices( ds, xl_field,
+                                          sorting,
+                                          iline_count,
+                                          xline_count,
+                                          offset_count,
+                                          xline_out.buf< int >() );
+    }
     if( err ) return errmsg( err );
 
-    err = segy_offset_indices( ds, offset_field,
-                                   offset_count,
-                                   offset_out.buf< int >() );
+    {
+        const nogil threads( ds );
+        err = segy_offset_indices( ds, offset_field,
+                                       offset_count,
+                                       offset_out.buf< int >() );
+    }
+    if( err ) return errmsg( err );
+
+    return Py_BuildValue( "" );
+}
+
+PyObject* write_index( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
+    segy_datasource* ds = self->ds;
+    if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
+
+    const char* path;
+    long long mtime = 0;
+    if( !PyArg_ParseTuple( args, "s|L", &path, &mtime ) ) return NULL;
+
+    segy_header_mapping& mapping = ds->traceheader_mapping_standard;
+
+    int il = mapping.name_to_offset[SEGY_TR_INLINE];
+    int xl = mapping.name_to_offset[SEGY_TR_CROSSLINE];
+    int offset = mapping.name_to_offset[SEGY_TR_OFFSET];
+
+    metrics_errmsg errmsg = { il, xl, offset };
+
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_write_index( ds, path, mtime, il, xl, offset );
+    }
+
+    if( err == SEGY_FOPEN_ERROR )
+        return IOError( "unable to write index %s", path );
+
+    if( err == SEGY_NOTFOUND )
+        return ValueError( "could not parse geometry, "
+                           "file has no index-able geometry" );
+
     if( err ) return errmsg( err );
 
     return Py_BuildValue( "" );
 }
 
 PyObject* gettr( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     PyObject* bufferobj;
-    int start, length, step, sample_start, sample_stop, sample_step, samples;
+    long long start, length, step;
+    int sample_start, sample_stop, sample_step, samples;
 
-    if( !PyArg_ParseTuple( args, "Oiiiiiii", &bufferobj, &start, &step, &length,
+    if( !PyArg_ParseTuple( args, "OLLLiiii", &bufferobj, &start, &step, &length,
         &sample_start, &sample_stop, &sample_step, &samples ) )
         return NULL;
 
     buffer_guard buffer( bufferobj, PyBUF_CONTIG );
     if( !buffer) return NULL;
 
-    const int skip = samples * self->elemsize;
-    const long long bufsize = (long long) length * samples;
+    const long long bufsize = length * samples;
 
     if( buffer.len() < bufsize )
         return ValueError( "internal: data trace buffer too small, "
                            "expected %zi, was %zd",
                             bufsize, buffer.len() );
 
-    int err = 0;
-    int i = 0;
-    char* buf = buffer.buf();
-    for( ; err == 0 && i < length; ++i, buf += skip ) {
-        err = segy_readsubtr( ds, start + (i * step),
-                                  sample_start,
-                                  sample_stop,
-                                  sample_step,
-                                  buf,
-                                  NULL );
+    std::vector< long long > tracenos( length );
+    for( long long i = 0; i < length; ++i )
+        tracenos[ i ] = start + i * step;
+
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_read_traces64( ds, tracenos.data(),
+                                      length,
+                                      sample_start,
+                                      sample_stop,
+                                      sample_step,
+                                      buffer.buf() );
     }
 
+    /* a batch read does not tell which of its traces failed */
+    if( err == SEGY_FREAD_ERROR && length == 1 )
+        return IOError( "I/O operation failed on data trace %lld", start );
     if( err == SEGY_FREAD_ERROR )
-        return IOError( "I/O operation failed on data trace %d", i );
+        return IOError( "I/O operation failed reading %lld data traces",
+                        length );
 
     if( err ) return Error( err );
 
-    segy_to_native( self->format, bufsize, buffer.buf() );
+    Py_INCREF( bufferobj );
+    return bufferobj;
+}
+
+/*
+ * Read the traces listed in the int64 array tracenos, in that order, into
+ * buffer. Used for lines and gathers of sparse geometries, where the traces
+ * of a line have no fixed stride.
+ */
+PyObject* gettraces( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
+    segy_datasource* ds = self->ds;
+    if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
+
+    PyObject* bufferobj;
+    PyObject* tracenosobj;
+
+    if( !PyArg_ParseTuple( args, "OO", &bufferobj, &tracenosobj ) )
+        return NULL;
+
+    buffer_guard buffer( bufferobj, PyBUF_CONTIG );
+    if( !buffer ) return NULL;
+
+    buffer_guard tracenos( tracenosobj );
+    if( !tracenos ) return NULL;
+
+    if( tracenos.len() % sizeof( long long ) != 0 )
+        return ValueError( "internal: trace numbers must be int64" );
+
+    const long long count = tracenos.len() / sizeof( long long );
+    const long long* traces = (const long long*)tracenos.buf();
+
+    if( buffer.len() < count * self->samplecount * self->elemsize )
+        return ValueError( "internal: data trace buffer too small, "
+                           "expected %lld, was %zd",
+                           count * self->samplecount * self->elemsize,
+                           buffer.len() );
+
+    for( long long i = 0; i < count; ++i ) {
+        if( traces[ i ] < 0 || traces[ i ] >= self->tracecount )
+            return KeyError( "no such trace %lld", traces[ i ] );
+    }
+
+    if( count == 0 ) {
+        Py_INCREF( bufferobj );
+        return bufferobj;
+    }
+
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_read_traces64( ds, traces,
+                                      count,
+                                      0,
+                                      self->samplecount,
+                                      1,
+                                      buffer.buf() );
+    }
+
+    if( err == SEGY_FREAD_ERROR && count == 1 )
+        return IOError( "I/O operation failed on data trace %lld", traces[ 0 ] );
+    if( err == SEGY_FREAD_ERROR )
+        return IOError( "I/O operation failed reading %lld data traces",
+                        count );
+
+    if( err ) return Error( err );
 
     Py_INCREF( bufferobj );
     return bufferobj;
 }
 
 PyObject* puttr( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
-    int traceno;
+    long long traceno;
     char* buffer;
     Py_ssize_t buflen;
 
-    if( !PyArg_ParseTuple( args, "is#", &traceno, &buffer, &buflen ) )
+    if( !PyArg_ParseTuple( args, "Ls#", &traceno, &buffer, &buflen ) )
         return NULL;
 
     if( self->trace_bsize > buflen )
@@ -1851,19 +2597,29 @@ PyObject* puttr( segyfd* self, PyObject* args ) {
                           self->trace_bsize,
                           buflen );
 
-    segy_from_native( self->format, self->samplecount, buffer );
+    /*
+     * Convert a private copy, so that other threads never see the caller's
+     * buffer in the on-disk format while the GIL is released
+     */
+    heapbuffer trace( self->trace_bsize );
+    if( !trace ) return NULL;
+    std::memcpy( trace, buffer, self->trace_bsize );
 
-    int err = segy_writetrace( ds, traceno,
-                                   buffer );
+    int err;
+    {
+        const nogil threads( ds );
+        segy_from_native( self->format, self->samplecount, trace );
 
-    segy_to_native( self->format, self->samplecount, buffer );
+        err = segy_writetrace64( ds, traceno,
+                                     trace );
+    }
 
     switch( err ) {
         case SEGY_OK:
             return Py_BuildValue("");
 
         case SEGY_FREAD_ERROR:
-            return IOError( "I/O operation failed on data trace %d", traceno );
+            return IOError( "I/O operation failed on data trace %lld", traceno );
 
         default:
             return Error( err );
@@ -1871,43 +2627,54 @@ PyObject* puttr( segyfd* self, PyObject* args ) {
 }
 
 PyObject* getline( segyfd* self, PyObject* args) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     int line_trace0;
     int line_length;
     int stride;
     int offsets;
     PyObject* bufferobj;
+    int nthreads = 1;
 
-    if( !PyArg_ParseTuple( args, "iiiiO", &line_trace0,
-                                          &line_length,
-                                          &stride,
-                                          &offsets,
-                                          &bufferobj ) )
+    if( !PyArg_ParseTuple( args, "iiiiO|i", &line_trace0,
+                                            &line_length,
+                                            &stride,
+                                            &offsets,
+                                            &bufferobj,
+                                            &nthreads ) )
         return NULL;
 
+    if( nthreads < 1 )
+        return ValueError( "threads must be positive, was %d", nthreads );
+
     buffer_guard buffer( bufferobj, PyBUF_CONTIG );
     if( !buffer ) return NULL;
 
-    int err = segy_read_line( ds, line_trace0,
-                                  line_length,
-                                  stride,
-                                  offsets,
-                                  buffer.buf() );
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_read_line_parallel( ds, line_trace0,
+                                           line_length,
+                                           stride,
+                                           offsets,
+                                           self->format,
+                                           buffer.buf(),
+                                           nthreads );
+    }
     if( err ) return Error( err );
 
-    segy_to_native( self->format,
-                    self->samplecount * line_length,
-                    buffer.buf() );
-
     Py_INCREF( bufferobj );
     return bufferobj;
 }
 
 PyObject* putline( segyfd* self, PyObject* args) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     int line_trace0;
     int line_length;
@@ -1926,7 +2693,8 @@ PyObject* putline( segyfd* self, PyObject* args) {
                                             &val ) )
         return NULL;
 
-    buffer_guard buffer( val, PyBUF_CONTIG );
+    buffer_guard buffer( val, PyBUF_CONTIG_RO );
+    if( !buffer ) return NULL;
 
     if( self->trace_bsize * line_length > buffer.len() )
         return ValueError("line too short: expected %d elements, got %zd",
@@ -1934,15 +2702,21 @@ PyObject* putline( segyfd* self, PyObject* args) {
                           buffer.len() / self->elemsize );
 
     const int elems = line_length * self->samplecount;
-    segy_from_native( self->format, elems, buffer.buf() );
+    heapbuffer line( self->trace_bsize * line_length );
+    if( !line ) return NULL;
+    std::memcpy( line, buffer.buf(), self->trace_bsize * line_length );
 
-    int err = segy_write_line( ds, line_trace0,
+    int err;
+    {
+        const nogil threads( ds );
+        segy_from_native( self->format, elems, line );
+
+        err = segy_write_line( ds, line_trace0,
                                    line_length,
                                    stride,
                                    offsets,
-                                   buffer.buf() );
-
-    segy_to_native( self->format, elems, buffer.buf() );
+                                   line );
+    }
 
     switch( err ) {
         case SEGY_OK:
@@ -1957,9 +2731,135 @@ PyObject* putline( segyfd* self, PyObject* args) {
     }
 }
 
+/*
+ * Sequential, buffered trace writing. writer_put appends a batch of traces,
+ * headers and native samples, to the open writer. The other methods write
+ * out the writer's buffers before touching the file (see sync_writer), so they
+ * see the traces put so far, and the writer stays open.
+ */
+PyObject* writer_open( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
+    segy_datasource* ds = self->ds;
+    if( !ds ) return NULL;
+
+    long long first;
+    long long count;
+    Py_ssize_t bufsize;
+    int background;
+
+    if( !PyArg_ParseTuple( args, "LLnp", &first, &count, &bufsize, &background ) )
+        return NULL;
+
+    if( self->writer ) return RuntimeError( "writer is already open" );
+    if( !ds->writable ) return Error( SEGY_READONLY );
+
+    if( first < 0 || count < 0 || bufsize < 0 )
+        return ValueError( "expected non-negative first, count and bufsize" );
+
+    std::vector< const segy_entry_definition* > mappings;
+    for( size_t i = 0; i < self->traceheader_mappings.size(); ++i )
+        mappings.push_back(
+            self->traceheader_mappings[ i ].offset_to_entry_definition
+        );
+
+    if( (int)mappings.size() < self->traceheader_count )
+        return RuntimeError( "internal: missing trace header mappings" );
+
+    /* python streams need the GIL, so they can't be written from a thread */
+    int flags = SEGY_WRITER_PREALLOCATE;
+    if( background && !is_py_stream( ds ) ) flags |= SEGY_WRITER_BACKGROUND;
+
+    self->writer = segy_writer_open( ds, first, count, bufsize, flags,
+                                     mappings.data() );
+    if( !self->writer ) {
+        PyErr_SetString( PyExc_MemoryError, "unable to allocate writer" );
+        return NULL;
+    }
+
+    return Py_BuildValue( "" );
+}
+
+PyObject* writer_put( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
+    segy_datasource* ds = self->ds;
+    if( !ds ) return NULL;
+
+    buffer_guard headers;
+    buffer_guard traces;
+    Py_ssize_t count;
+
+    if( !PyArg_ParseTuple( args, "s*s*n", &headers, &traces, &count ) )
+        return NULL;
+
+    if( !self->writer ) return RuntimeError( "writer is not open" );
+
+    const Py_ssize_t thsize = SEGY_TRACE_HEADER_SIZE * self->traceheader_count;
+    if( headers.len() < count * thsize )
+        return ValueError( "headers too short: expected %zd bytes, got %zd",
+                           count * thsize, headers.len() );
+
+    if( traces.len() < count * self->trace_bsize )
+        return ValueError( "traces too short: expected %zd bytes, got %zd",
+                           count * self->trace_bsize, traces.len() );
+
+    int err = SEGY_OK;
+    {
+        const nogil threads( ds );
+        const char* header = headers.buf();
+        const char* trace = traces.buf();
+        for( Py_ssize_t i = 0; i < count && err == SEGY_OK; ++i ) {
+            err = segy_writer_put( self->writer, header, trace );
+            header += thsize;
+            trace += self->trace_bsize;
+        }
+    }
+
+    switch( err ) {
+        case SEGY_OK:
+            return Py_BuildValue( "" );
+
+        case SEGY_DS_WRITE_ERROR:
+        case SEGY_DS_SEEK_ERROR:
+            return IOError( "I/O operation failed writing traces" );
+
+        default:
+            return Error( err );
+    }
+}
+
+PyObject* writer_close( segyfd* self ) {
+    const fdlock lock( self );
+    segy_datasource* ds = self->ds;
+    if( !ds ) return NULL;
+
+    /* multiple close() is a no-op */
+    if( !self->writer ) return Py_BuildValue( "" );
+
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_writer_close( self->writer );
+    }
+    self->writer = NULL;
+
+    switch( err ) {
+        case SEGY_OK:
+            return Py_BuildValue( "" );
+
+        case SEGY_DS_WRITE_ERROR:
+        case SEGY_DS_SEEK_ERROR:
+            return IOError( "I/O operation failed writing traces" );
+
+        default:
+            return Error( err );
+    }
+}
+
 PyObject* getdepth( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     int depth;
     int count;
@@ -1975,36 +2875,92 @@ PyObject* getdepth( segyfd* self, PyObject* args ) {
     buffer_guard buffer( bufferobj, PyBUF_CONTIG );
     if( !buffer ) return NULL;
 
-    int traceno = 0;
-    int err = 0;
-    char* buf = buffer.buf();
-    const int skip = self->elemsize;
+    if( count * self->elemsize > buffer.len() )
+        return ValueError( "buffer too short: expected %d elements, got %zd",
+                           count, buffer.len() / self->elemsize );
 
-    for( ; err == 0 && traceno < count; ++traceno, buf += skip ) {
-        err = segy_readsubtr( ds,
-                              traceno * offsets,
-                              depth,
-                              depth + 1,
-                              1,
-                              buf,
-                              NULL );
+    int err = 0;
+    {
+        const nogil threads( ds );
+        err = segy_read_depth_slices( ds,
+                                      0,
+                                      count,
+                                      offsets,
+                                      depth,
+                                      depth + 1,
+                                      1,
+                                      buffer.buf() );
     }
 
     if( err == SEGY_FREAD_ERROR )
-        return IOError( "I/O operation failed on data trace %d at depth %d",
-                        traceno, depth );
+        return IOError( "I/O operation failed on data at depth %d", depth );
 
     if( err ) return Error( err );
 
-    segy_to_native( self->format, count, buffer.buf() );
+    Py_INCREF( bufferobj );
+    return bufferobj;
+}
+
+/*
+ * Read the depths [start:stop:step] into a slice-major buffer, in a single
+ * pass over the file
+ */
+PyObject* getdepths( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
+    segy_datasource* ds = self->ds;
+    if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
+
+    int start, stop, step, length;
+    int count;
+    int offsets;
+    PyObject* bufferobj;
+
+    if( !PyArg_ParseTuple( args, "iiiiiiO", &start,
+                                            &stop,
+                                            &step,
+                                            &length,
+                                            &count,
+                                            &offsets,
+                                            &bufferobj ) )
+        return NULL;
+
+    buffer_guard buffer( bufferobj, PyBUF_CONTIG );
+    if( !buffer ) return NULL;
+
+    const Py_ssize_t depths = length;
+    if( depths * count * self->elemsize > buffer.len() )
+        return ValueError( "buffer too short: expected %zd elements, got %zd",
+                           depths * count, buffer.len() / self->elemsize );
+
+    int err = 0;
+    {
+        const nogil threads( ds );
+        err = segy_read_depth_slices( ds,
+                                      0,
+                                      count,
+                                      offsets,
+                                      start,
+                                      stop,
+                                      step,
+                                      buffer.buf() );
+    }
+
+    if( err == SEGY_FREAD_ERROR )
+        return IOError( "I/O operation failed on data at depths %d to %d",
+                        start, stop );
+
+    if( err ) return Error( err );
 
     Py_INCREF( bufferobj );
     return bufferobj;
 }
 
 PyObject* putdepth( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     int depth;
     int count;
@@ -2017,32 +2973,37 @@ PyObject* putdepth( segyfd* self, PyObject* args ) {
                                          &val ) )
         return NULL;
 
-    buffer_guard buffer( val, PyBUF_CONTIG );
+    buffer_guard buffer( val, PyBUF_CONTIG_RO );
     if( !buffer ) return NULL;
 
     if( count * self->elemsize > buffer.len() )
         return ValueError("slice too short: expected %d elements, got %zd",
                           count, buffer.len() / self->elemsize );
 
+    heapbuffer slice( count * self->elemsize );
+    if( !slice ) return NULL;
+    std::memcpy( slice, buffer.buf(), count * self->elemsize );
+
     int traceno = 0;
     int err = 0;
-    const char* buf = buffer.buf();
+    const char* buf = slice;
     const int skip = self->elemsize;
 
-    segy_from_native( self->format, count, buffer.buf() );
-
-    for( ; err == 0 && traceno < count; ++traceno, buf += skip ) {
-        err = segy_writesubtr( ds,
-                               traceno * offsets,
-                               depth,
-                               depth + 1,
-                               1,
-                               buf,
-                               NULL );
+    {
+        const nogil threads( ds );
+        segy_from_native( self->format, count, slice );
+
+        for( ; err == 0 && traceno < count; ++traceno, buf += skip ) {
+            err = segy_writesubtr( ds,
+                                   traceno * offsets,
+                                   depth,
+                                   depth + 1,
+                                   1,
+                                   buf,
+                                   NULL );
+        }
     }
 
-    segy_to_native( self->format, count, buffer.buf() );
-
     if( err == SEGY_FREAD_ERROR )
         return IOError( "I/O operation failed on data trace %d at depth %d",
                         traceno, depth );
@@ -2053,14 +3014,20 @@ PyObject* putdepth( segyfd* self, PyObject* args ) {
 }
 
 PyObject* getdt( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     float fallback;
     if( !PyArg_ParseTuple(args, "f", &fallback ) ) return NULL;
 
     float dt;
-    int err = segy_sample_interval( ds, fallback, &dt );
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_sample_interval( ds, fallback, &dt );
+    }
 
     if( err == SEGY_OK )
         return PyFloat_FromDouble( dt );
@@ -2089,11 +3056,17 @@ PyObject* getdt( segyfd* self, PyObject* args ) {
 }
 
 PyObject* getdelay( segyfd* self ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     float delay;
-    int err = segy_delay_recoding_time( ds, &delay );
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_delay_recoding_time( ds, &delay );
+    }
 
     if( err == SEGY_OK )
         return PyFloat_FromDouble( delay );
@@ -2102,8 +3075,10 @@ PyObject* getdelay( segyfd* self ) {
 }
 
 PyObject* rotation( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
     segy_datasource* ds = self->ds;
     if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
 
     int line_length;
     int stride;
@@ -2118,18 +3093,134 @@ PyObject* rotation( segyfd* self, PyObject* args ) {
 
     float rotation;
     int linenos_sz = static_cast<int>( linenos.len() / sizeof( int ) );
-    int err = segy_rotation_cw( ds, line_length,
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_rotation_cw( ds, line_length,
                                     stride,
                                     offsets,
                                     linenos.buf< const int >(),
                                     linenos_sz,
                                     &rotation );
+    }
 
     if( err ) return Error( err );
 
     return PyFloat_FromDouble( rotation );
 }
 
+PyObject* cdps( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
+    segy_datasource* ds = self->ds;
+    if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
+
+    PyObject* xobj;
+    PyObject* yobj;
+    if( !PyArg_ParseTuple( args, "OO", &xobj, &yobj ) ) return NULL;
+
+    buffer_guard x( xobj, PyBUF_CONTIG );
+    if( !x ) return NULL;
+    buffer_guard y( yobj, PyBUF_CONTIG );
+    if( !y ) return NULL;
+
+    const Py_ssize_t size = self->tracecount * sizeof( double );
+    if( x.len() < size || y.len() < size )
+        return ValueError( "internal: coordinate buffer too small, "
+                           "expected %zd, was %zd",
+                           size, std::min( x.len(), y.len() ) );
+
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_read_cdps( ds, x.buf< double >(), y.buf< double >() );
+    }
+
+    if( err == SEGY_INVALID_FIELD_DATATYPE )
+        return RuntimeError( "CDP-X, CDP-Y or scalar has an unsupported type" );
+    if( err ) return Error( err );
+
+    return Py_BuildValue( "" );
+}
+
+PyObject* stats( segyfd* self, PyObject* args ) {
+    const fdlock lock( self );
+    segy_datasource* ds = self->ds;
+    if( !ds ) return NULL;
+    if( !sync_writer( self ) ) return NULL;
+
+    PyObject* groupsobj;
+    int ngroups;
+    PyObject* statsobj;
+    PyObject* tracesobj;
+    double low;
+    double high;
+    int bins;
+    PyObject* histobj;
+    int nthreads;
+
+    if( !PyArg_ParseTuple( args, "OiOOddiOi", &groupsobj,
+                                              &ngroups,
+                                              &statsobj,
+                                              &tracesobj,
+                                              &low,
+                                              &high,
+                                              &bins,
+                                              &histobj,
+                                              &nthreads ) )
+        return NULL;
+
+    if( nthreads < 1 )
+        return ValueError( "threads must be positive, was %d", nthreads );
+
+    /* groups, traces and histograms are optional, and None if not wanted */
+    buffer_guard groups;
+    buffer_guard traces;
+    buffer_guard histograms;
+    if( groupsobj != Py_None
+     && PyObject_GetBuffer( groupsobj, &groups, PyBUF_CONTIG_RO ) != 0 )
+        return NULL;
+    if( tracesobj != Py_None
+     && PyObject_GetBuffer( tracesobj, &traces, PyBUF_CONTIG ) != 0 )
+        return NULL;
+    if( histobj != Py_None
+     && PyObject_GetBuffer( histobj, &histograms, PyBUF_CONTIG ) != 0 )
+        return NULL;
+
+    buffer_guard out( statsobj, PyBUF_CONTIG );
+    if( !out ) return NULL;
+
+    const Py_ssize_t tracecount = self->tracecount;
+    if( out.len() < ngroups * Py_ssize_t( sizeof( segy_amplitudes ) ) )
+        return ValueError( "internal: stats buffer too small" );
+    if( groups && groups.len() < tracecount * Py_ssize_t( sizeof( int ) ) )
+        return ValueError( "internal: groups buffer too small" );
+    if( traces &&
+        traces.len() < tracecount * Py_ssize_t( sizeof( segy_amplitudes ) ) )
+        return ValueError( "internal: traces buffer too small" );
+    if( histograms && histograms.len() <
+            Py_ssize_t( ngroups ) * bins * Py_ssize_t( sizeof( long long ) ) )
+        return ValueError( "internal: histogram buffer too small" );
+
+    int err;
+    {
+        const nogil threads( ds );
+        err = segy_stats( ds,
+                          groups.buf< const int >(),
+                          ngroups,
+                          out.buf< segy_amplitudes >(),
+                          traces.buf< segy_amplitudes >(),
+                          low,
+                          high,
+                          bins,
+                          histograms.buf< long long >(),
+                          nthreads );
+    }
+
+    if( err ) return Error( err );
+    return Py_BuildValue( "" );
+}
+
 PyObject* stanza_names( segyfd* self ) {
     PyObject* names = PyList_New( self->stanzas.size() );
     if( !names ) {
@@ -2172,6 +3263,9 @@ PyMethodDef methods [] = {
     { "flush", (PyCFunction) fd::flush, METH_VARARGS, "Flush file." },
     { "mmap",  (PyCFunction) fd::mmap,  METH_NOARGS,  "mmap file."  },
 
+    { "advise",   (PyCFunction) fd::advise,   METH_VARARGS, "Set access pattern." },
+    { "prefetch", (PyCFunction) fd::prefetch, METH_VARARGS, "Prefetch traces."    },
+
     { "gettext", (PyCFunction) fd::gettext, METH_VARARGS, "Get text header." },
     { "puttext", (PyCFunction) fd::puttext, METH_VARARGS, "Put text header." },
     { "getstanza", (PyCFunction) fd::getstanza, METH_VARARGS, "Get stanza data." },
@@ -2187,22 +3281,33 @@ PyMethodDef methods [] = {
 
     { "field_forall",  (PyCFunction) fd::field_forall,  METH_VARARGS, "Field for-all."  },
     { "field_foreach", (PyCFunction) fd::field_foreach, METH_VARARGS, "Field for-each." },
+    { "put_field_forall", (PyCFunction) fd::put_field_forall, METH_VARARGS, "Put field for-all." },
+    { "header_table",  (PyCFunction) fd::header_table,  METH_VARARGS, "Header words of all traces." },
 
     { "gettr", (PyCFunction) fd::gettr, METH_VARARGS, "Get trace." },
+    { "gettraces", (PyCFunction) fd::gettraces, METH_VARARGS, "Get traces by number." },
     { "puttr", (PyCFunction) fd::puttr, METH_VARARGS, "Put trace." },
 
     { "getline",  (PyCFunction) fd::getline,  METH_VARARGS, "Get line." },
     { "putline",  (PyCFunction) fd::putline,  METH_VARARGS, "Put line." },
+
+    { "writer_open",  (PyCFunction) fd::writer_open,  METH_VARARGS, "Open sequential writer."  },
+    { "writer_put",   (PyCFunction) fd::writer_put,   METH_VARARGS, "Append traces to writer." },
+    { "writer_close", (PyCFunction) fd::writer_close, METH_NOARGS,  "Close sequential writer." },
     { "getdepth", (PyCFunction) fd::getdepth, METH_VARARGS, "Get depth." },
+    { "getdepths", (PyCFunction) fd::getdepths, METH_VARARGS, "Get depths." },
     { "putdepth", (PyCFunction) fd::putdepth, METH_VARARGS, "Put depth." },
 
     { "getdt",    (PyCFunction) fd::getdt,    METH_VARARGS, "Get sample interval (dt)." },
     { "getdelay", (PyCFunction) fd::getdelay, METH_NOARGS,  "Get recording delay."      },
     { "rotation", (PyCFunction) fd::rotation, METH_VARARGS, "Get clockwise rotation."   },
+    { "cdps",     (PyCFunction) fd::cdps,     METH_VARARGS, "Get CDP coordinates."      },
+    { "stats",    (PyCFunction) fd::stats,    METH_VARARGS, "Amplitude statistics."     },
 
     { "metrics",      (PyCFunction) fd::metrics,      METH_NOARGS,  "Metrics."         },
-    { "cube_metrics", (PyCFunction) fd::cube_metrics, METH_NOARGS,  "Cube metrics."    },
+    { "cube_metrics", (PyCFunction) fd::cube_metrics, METH_VARARGS, "Cube metrics."    },
     { "indices",      (PyCFunction) fd::indices,      METH_VARARGS, "Indices."         },
+    { "write_index",  (PyCFunction) fd::write_index,  METH_VARARGS, "Write geometry index." },
 
     { "stanza_names", (PyCFunction) fd::stanza_names, METH_NOARGS, "Stanza names in order." },
 
@@ -2227,6 +3332,11 @@ PyMethodDef methods [] = {
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wmissing-field-initializers"
 #endif
+PyBufferProcs buffer = {
+    (getbufferproc)fd::getbuffer,         /* bf_getbuffer */
+    (releasebufferproc)fd::releasebuffer, /* bf_releasebuffer */
+};
+
 PyTypeObject Segyfd = {
     PyVarObject_HEAD_INIT( NULL, 0 )
     "_segyio.segyfd",               /* name */
@@ -2246,7 +3356,7 @@ PyTypeObject Segyfd = {
     0,                              /* tp_str */
     0,                              /* tp_getattro */
     0,                              /* tp_setattro */
-    0,                              /* tp_as_buffer */
+    &buffer,                        /* tp_as_buffer */
     Py_TPFLAGS_DEFAULT,             /* tp_flags */
     "segyio file descriptor",       /* tp_doc */
     0,                              /* tp_traverse */
@@ -2380,6 +3490,261 @@ PyObject* format( PyObject* , PyObject* args ) {
     return out;
 }
 
+PyObject* group( PyObject* , PyObject* args ) {
+    PyObject* keysobj;
+    PyObject* offsetsobj;
+    PyObject* indexobj;
+    int nkeys;
+
+    if( !PyArg_ParseTuple( args, "OiOO", &keysobj,
+                                         &nkeys,
+                                         &offsetsobj,
+                                         &indexobj ) )
+        return NULL;
+
+    if( nkeys < 1 ) return ValueError( "expected at least one key word" );
+
+    buffer_guard keys( keysobj );
+    if( !keys ) return NULL;
+    buffer_guard offsets( offsetsobj, PyBUF_CONTIG );
+    if( !offsets ) return NULL;
+    buffer_guard index( indexobj, PyBUF_CONTIG );
+    if( !index ) return NULL;
+
+    const Py_ssize_t words = keys.len() / sizeof( long long );
+    const long long traces = words / nkeys;
+    if( words % nkeys != 0 )
+        return ValueError( "expected %d words per trace", nkeys );
+
+    if( index.len() < Py_ssize_t( traces * sizeof( long long ) ) )
+        return ValueError( "index too small for %lld traces", traces );
+
+    if( offsets.len() < Py_ssize_t( ( traces + 1 ) * sizeof( long long ) ) )
+        return ValueError( "offsets too small for %lld traces", traces );
+
+    long long groups = 0;
+    int err;
+    Py_BEGIN_ALLOW_THREADS
+    err = segy_group_traces( keys.buf< long long >(),
+                             nkeys,
+                             traces,
+                             offsets.buf< long long >(),
+                             index.buf< long long >(),
+                             &groups );
+    Py_END_ALLOW_THREADS
+
+    if( err ) return Error( err );
+    return PyLong_FromLongLong( groups );
+}
+
+/*
+ * The spatial index is kept by python as the tuple
+ * (x, y, (x0, y0, cellsize, columns, rows), offsets, index), with the x and y
+ * coordinates as double arrays and the offsets and index as int64 arrays.
+ * Check that the arrays fit the grid, and point a segy_spatial_index at them.
+ */
+bool spatial_index( segy_spatial_index& si,
+                    const buffer_guard& x,
+                    const buffer_guard& y,
+                    const buffer_guard& offsets,
+                    const buffer_guard& index ) {
+    const Py_ssize_t n = x.len() / Py_ssize_t( sizeof( double ) );
+    if( x.len() != y.len() || x.len() % sizeof( double ) != 0 ) {
+        ValueError( "expected x and y of the same length" );
+        return false;
+    }
+
+    if( si.columns < 1 || si.rows < 1 || !( si.cellsize > 0 ) ) {
+        ValueError( "invalid grid (%lld columns, %lld rows)",
+                    si.columns, si.rows );
+        return false;
+    }
+
+    const long long cells = si.columns * si.rows;
+    if( offsets.len() < Py_ssize_t( ( cells + 1 ) * sizeof( long long ) ) ) {
+        ValueError( "offsets too small for %lld cells", cells );
+        return false;
+    }
+
+    if( index.len() < Py_ssize_t( n * sizeof( long long ) ) ) {
+        ValueError( "index too small for %zd points", n );
+        return false;
+    }
+
+    si.x = x.buf< const double >();
+    si.y = y.buf< const double >();
+    si.n = n;
+    si.offsets = offsets.buf< long long >();
+    si.index = index.buf< long long >();
+    return true;
+}
+
+PyObject* spatial_grid( PyObject*, PyObject* args ) {
+    PyObject* xobj;
+    PyObject* yobj;
+
+    if( !PyArg_ParseTuple( args, "OO", &xobj, &yobj ) ) return NULL;
+
+    buffer_guard x( xobj );
+    if( !x ) return NULL;
+    buffer_guard y( yobj );
+    if( !y ) return NULL;
+
+    if( x.len() != y.len() || x.len() % sizeof( double ) != 0 )
+        return ValueError( "expected x and y of the same length" );
+
+    segy_spatial_index si = {};
+    si.x = x.buf< const double >();
+    si.y = y.buf< const double >();
+    si.n = x.len() / sizeof( double );
+
+    const int err = segy_spatial_grid( &si );
+    if( err == SEGY_INVALID_ARGS )
+        return ValueError( "coordinates must be finite" );
+    if( err ) return Error( err );
+
+    return Py_BuildValue( "(dddLL)", si.x0,
+                                     si.y0,
+                                     si.cellsize,
+                                     si.columns,
+                                     si.rows );
+}
+
+PyObject* spatial_build( PyObject*, PyObject* args ) {
+    PyObject *xobj, *yobj, *offsetsobj, *indexobj;
+    segy_spatial_index si = {};
+
+    if( !PyArg_ParseTuple( args, "(OO(dddLL)OO)", &xobj, &yobj,
+                                                  &si.x0, &si.y0,
+                                                  &si.cellsize,
+                                                  &si.columns, &si.rows,
+                                                  &offsetsobj, &indexobj ) )
+        return NULL;
+
+    buffer_guard x( xobj );
+    if( !x ) return NULL;
+    buffer_guard y( yobj );
+    if( !y ) return NULL;
+    buffer_guard offsets( offsetsobj, PyBUF_CONTIG );
+    if( !offsets ) return NULL;
+    buffer_guard index( indexobj, PyBUF_CONTIG );
+    if( !index ) return NULL;
+
+    if( !spatial_index( si, x, y, offsets, index ) ) return NULL;
+
+    int err;
+    Py_BEGIN_ALLOW_THREADS
+    err = segy_spatial_build( &si );
+    Py_END_ALLOW_THREADS
+
+    if( err ) return Error( err );
+    return Py_BuildValue( "" );
+}
+
+PyObject* spatial_nearest( PyObject*, PyObject* args ) {
+    PyObject *xobj, *yobj, *offsetsobj, *indexobj;
+    PyObject *pointsobj, *distancesobj;
+    segy_spatial_index si = {};
+    double qx, qy;
+    int k;
+
+    if( !PyArg_ParseTuple( args, "(OO(dddLL)OO)ddiOO", &xobj, &yobj,
+                                                       &si.x0, &si.y0,
+                                                       &si.cellsize,
+                                                       &si.columns, &si.rows,
+                                                       &offsetsobj, &indexobj,
+                                                       &qx, &qy, &k,
+                                                       &pointsobj,
+                                                       &distancesobj ) )
+        return NULL;
+
+    if( k < 0 ) return ValueError( "k must be non-negative, was %d", k );
+
+    buffer_guard x( xobj );
+    if( !x ) return NULL;
+    buffer_guard y( yobj );
+    if( !y ) return NULL;
+    buffer_guard offsets( offsetsobj );
+    if( !offsets ) return NULL;
+    buffer_guard index( indexobj );
+    if( !index ) return NULL;
+    buffer_guard points( pointsobj, PyBUF_CONTIG );
+    if( !points ) return NULL;
+    buffer_guard distances( distancesobj, PyBUF_CONTIG );
+    if( !distances ) return NULL;
+
+    if( !spatial_index( si, x, y, offsets, index ) ) return NULL;
+
+    if( points.len() < Py_ssize_t( k * sizeof( long long ) )
+     || distances.len() < Py_ssize_t( k * sizeof( double ) ) )
+        return ValueError( "output too small for %d points", k );
+
+    int found = 0;
+    int err;
+    Py_BEGIN_ALLOW_THREADS
+    err = segy_spatial_nearest( &si, qx, qy, k,
+                                points.buf< long long >(),
+                                distances.buf< double >(),
+                                &found );
+    Py_END_ALLOW_THREADS
+
+    if( err == SEGY_INVALID_ARGS )
+        return ValueError( "coordinates must be finite" );
+    if( err ) return Error( err );
+    return PyLong_FromLong( found );
+}
+
+PyObject* spatial_within( PyObject*, PyObject* args ) {
+    PyObject *xobj, *yobj, *offsetsobj, *indexobj;
+    PyObject *polygonobj, *pointsobj;
+    segy_spatial_index si = {};
+
+    if( !PyArg_ParseTuple( args, "(OO(dddLL)OO)OO", &xobj, &yobj,
+                                                    &si.x0, &si.y0,
+                                                    &si.cellsize,
+                                                    &si.columns, &si.rows,
+                                                    &offsetsobj, &indexobj,
+                                                    &polygonobj,
+                                                    &pointsobj ) )
+        return NULL;
+
+    buffer_guard x( xobj );
+    if( !x ) return NULL;
+    buffer_guard y( yobj );
+    if( !y ) return NULL;
+    buffer_guard offsets( offsetsobj );
+    if( !offsets ) return NULL;
+    buffer_guard index( indexobj );
+    if( !index ) return NULL;
+    buffer_guard polygon( polygonobj );
+    if( !polygon ) return NULL;
+    buffer_guard points( pointsobj, PyBUF_CONTIG );
+    if( !points ) return NULL;
+
+    if( !spatial_index( si, x, y, offsets, index ) ) return NULL;
+
+    const Py_ssize_t vertices = polygon.len() / Py_ssize_t( 2 * sizeof( double ) );
+    if( polygon.len() % ( 2 * sizeof( double ) ) != 0 || vertices < 3 )
+        return ValueError( "polygon must have at least 3 (x, y) vertices" );
+
+    if( points.len() < Py_ssize_t( si.n * sizeof( long long ) ) )
+        return ValueError( "output too small for %lld points", si.n );
+
+    long long count = 0;
+    int err;
+    Py_BEGIN_ALLOW_THREADS
+    err = segy_spatial_within( &si, polygon.buf< const double >(),
+                                    int( vertices ),
+                                    points.buf< long long >(),
+                                    &count );
+    Py_END_ALLOW_THREADS
+
+    if( err == SEGY_INVALID_ARGS )
+        return ValueError( "polygon coordinates must be finite" );
+    if( err ) return Error( err );
+    return PyLong_FromLongLong( count );
+}
+
 #ifdef IS_CLANG
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wcast-function-type"
@@ -2400,6 +3765,11 @@ PyMethodDef SegyMethods[] = {
     { "line_metrics", (PyCFunction) line_metrics,  METH_VARARGS, "Find the length and stride of lines." },
     { "fread_trace0", (PyCFunction) fread_trace0,  METH_VARARGS, "Find trace0 of a line."               },
     { "native",       (PyCFunction) format,        METH_VARARGS, "Convert to native float."             },
+    { "group",        (PyCFunction) group,         METH_VARARGS, "Group traces by key."                 },
+    { "spatial_grid",    (PyCFunction) spatial_grid,    METH_VARARGS, "Size a spatial index grid." },
+    { "spatial_build",   (PyCFunction) spatial_build,   METH_VARARGS, "Build a spatial index."     },
+    { "spatial_nearest", (PyCFunction) spatial_nearest, METH_VARARGS, "Nearest points."            },
+    { "spatial_within",  (PyCFunction) spatial_within,  METH_VARARGS, "Points inside polygon."     },
 
     { NULL }
 };
@@ -0,0 +1,119 @@
+import numpy as np
+
+
+class SpatialIndex(object):
+    """
+    An index over the CDP coordinates of the traces in a file, for finding the
+    traces nearest to a point, or inside a polygon, without going through the
+    trace headers for every query.
+
+    The coordinates are binned in a uniform grid with about two traces per
+    cell, so a query only looks at the traces in the cells near the point or
+    polygon. Building the index is a single pass over the coordinates. Get one
+    with `segyio.tools.spatial_index`.
+
+    Notes
+    -----
+    .. versionadded:: 2.1
+    """
+
+    def __init__(self, cdpx, cdpy):
+        from . import _segyio
+
+        self.cdpx = np.ascontiguousarray(cdpx, dtype = np.float64)
+        self.cdpy = np.ascontiguousarray(cdpy, dtype = np.float64)
+
+        if self.cdpx.ndim != 1 or self.cdpx.shape != self.cdpy.shape:
+            raise ValueError('expected cdpx and cdpy of the same length')
+
+        grid = _segyio.spatial_grid(self.cdpx, self.cdpy)
+        columns, rows = grid[3], grid[4]
+        offsets = np.empty(columns * rows + 1, dtype = np.int64)
+        index = np.empty(len(self.cdpx), dtype = np.int64)
+
+        self.index = (self.cdpx, self.cdpy, grid, offsets, index)
+        _segyio.spatial_build(self.index)
+
+    def __len__(self):
+        """x.__len__() <==> len(x)"""
+        return len(self.cdpx)
+
+    def nearest(self, x, y, k = 1):
+        """Find the k traces nearest to a point
+
+        Parameters
+        ----------
+        x : float
+        y : float
+        k : int
+            Number of traces to find
+
+        Returns
+        -------
+        traces : numpy.ndarray of int
+            The trace numbers, nearest first. Traces at the same distance are
+            ordered by trace number. If there are fewer than k traces, all the
+            traces are returned.
+        distances : numpy.ndarray of float
+            The distance from (x, y) to each trace
+
+        Notes
+        -----
+        .. versionadded:: 2.1
+
+        Examples
+        --------
+        Find the trace closest to a well:
+
+        >>> traces, _ = index.nearest(well_x, well_y)
+        >>> trace = f.trace[traces[0]]
+        """
+        from . import _segyio
+
+        traces = np.empty(k, dtype = np.int64)
+        distances = np.empty(k, dtype = np.float64)
+        found = _segyio.spatial_nearest(self.index,
+                                        float(x),
+                                        float(y),
+                                        int(k),
+                                        traces,
+                                        distances)
+        return traces[:found], distances[:found]
+
+    def within(self, polygon):
+        """Find the traces inside a polygon
+
+        A trace is inside by the even-odd rule, so self-intersecting polygons
+        have holes. Traces right on an edge can go either way.
+
+        Parameters
+        ----------
+        polygon : array_like of float
+            The (x, y) vertices of the polygon, as an n-by-2 array. The polygon
+            is closed by an edge from the last vertex back to the first.
+
+        Returns
+        -------
+        traces : numpy.ndarray of int
+            The trace numbers, in increasing order
+
+        Notes
+        -----
+        .. versionadded:: 2.1
+
+        Examples
+        --------
+        Read the traces in an area:
+
+        >>> area = [(1000, 2000), (1500, 2000), (1500, 2600), (1000, 2600)]
+        >>> traces = [f.trace[i] for i in index.within(area)]
+        """
+        from . import _segyio
+
+        polygon = np.ascontiguousarray(polygon, dtype = np.float64)
+        if polygon.ndim != 2 or polygon.shape[1] != 2:
+            raise ValueError('expected polygon as (x, y) vertices')
+
+        traces = np.empty(len(self), dtype = np.int64)
+        count = _segyio.spatial_within(self.index, polygon, traces)
+        return traces[:count].copy()
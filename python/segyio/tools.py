@@ -3,6 +3,7 @@ from . import TraceSortingFormat
 from . import SegySampleFormat
 
 import numpy as np
+import os
 import textwrap
 
 
@@ -206,7 +207,7 @@ def collect(itr):
     """
     return np.stack([np.copy(x) for x in itr])
 
-def cube(f):
+def cube(f, threads=1):
     """Read a full cube from a file
 
     Takes an open segy file (created with segyio.open) or a file name.
@@ -215,10 +216,16 @@ def cube(f):
     ``(fast, slow, offset, sample)``. If it is post-stack (only the one
     offset), the dimensions are normalised to ``(fast, slow, sample)``
 
+    If the file has a sparse geometry, the traces missing from the file are
+    zero in the cube.
+
     Parameters
     ----------
 
     f : str or segyio.SegyFile
+    threads : int
+        Number of threads to read the cube with. Files opened from a stream
+        are always read by one thread.
 
     Returns
     -------
@@ -230,11 +237,17 @@ def cube(f):
 
     .. versionadded:: 1.1
 
+    .. versionchanged:: 2.1
+        Added the threads argument, to read the cube with several threads
+
+    .. versionchanged:: 2.1
+        Sparse files
+
     """
 
     if not isinstance(f, segyio.SegyFile):
         with segyio.open(f) as fl:
-            return cube(fl)
+            return cube(fl, threads=threads)
 
     ilsort = f.sorting == segyio.TraceSortingFormat.INLINE_SORTING
     fast = f.ilines if ilsort else f.xlines
@@ -242,7 +255,177 @@ def cube(f):
     fast, slow, offs = len(fast), len(slow), len(f.offsets)
     smps = len(f.samples)
     dims = (fast, slow, smps) if offs == 1 else (fast, slow, offs, smps)
-    return f.trace.raw[:].reshape(dims)
+
+    if threads == 1:
+        buf = f.trace.raw[:]
+    else:
+        # all traces in file order is the line starting at trace 0 with
+        # stride 1
+        buf = np.empty((f.tracecount, smps), dtype=f.dtype)
+        f.segyfd.getline(0, f.tracecount, 1, 1, buf, threads)
+
+    if not f.sparse:
+        return buf.reshape(dims)
+
+    # the sparse index cells are inline-major, so scatter the traces into an
+    # inline sorted cube, and swap the lines if the file is crossline sorted
+    cells, traces = f._sparse
+    ils, xls = len(f.ilines), len(f.xlines)
+    grid = np.zeros((ils * xls * offs, smps), dtype=f.dtype)
+    grid[cells] = buf[traces]
+    grid = grid.reshape((ils, xls, offs, smps))
+    if not ilsort:
+        grid = grid.swapaxes(0, 1)
+    return np.ascontiguousarray(grid).reshape(dims)
+
+# the layout of segy_amplitudes
+_amplitudes = np.dtype([
+    ('count', np.int64),
+    ('nans', np.int64),
+    ('min', np.float64),
+    ('max', np.float64),
+    ('sum', np.float64),
+    ('sumsq', np.float64),
+])
+
+def stats(f, per = 'file', bins = None, range = None, threads = 1):
+    """Amplitude statistics
+
+    Compute the min, max, mean, RMS and number of NaN samples of the whole
+    file, every line, or every trace, in a single pass over the file. The
+    traces are streamed and never all in memory at once, so this works for
+    files of any size, unlike computing the same with numpy on
+    `segyio.tools.cube`.
+
+    NaN samples are counted, and left out of everything else. If all the
+    samples are NaN, min and max are inf and -inf, and mean and rms are nan.
+
+    Takes an open segy file (created with segyio.open) or a file name.
+
+    Parameters
+    ----------
+    f : str or segyio.SegyFile
+    per : { 'file', 'trace', 'iline', 'xline', 'offset' }
+        Compute the statistics of the whole file, every trace, or the traces
+        of every line or offset
+    bins : int, optional
+        Also compute a histogram with this many bins for the file, or every
+        line or offset. Requires range.
+    range : (float, float), optional
+        The lower and upper edge of the histogram, like numpy.histogram.
+        Samples outside the range are not counted.
+    threads : int
+        Number of threads to read the file with. Files opened from a stream
+        are always read by one thread.
+
+    Returns
+    -------
+    stats : numpy.ndarray
+        Structured array with the fields count, nans, min, max, mean and rms,
+        where count is the number of samples that are not NaN. A single record
+        for per='file', one per trace for per='trace', and one per line or
+        offset, in the order of f.ilines, f.xlines or f.offsets, otherwise. If
+        the file is unstructured, the lines are in increasing order.
+    histogram : numpy.ndarray of int
+        Only if bins is given. The histogram of the file, or one histogram per
+        line or offset. The bin edges are
+        ``numpy.linspace(range[0], range[1], bins + 1)``.
+
+    Notes
+    -----
+    .. versionadded:: 2.1
+
+    Examples
+    --------
+    Find inlines with dead or corrupt traces:
+
+    >>> s = segyio.tools.stats(f, per = 'iline', threads = 8)
+    >>> f.ilines[(s['rms'] == 0) | (s['nans'] > 0)]
+
+    Histogram of the amplitudes of the whole file:
+
+    >>> s, hist = segyio.tools.stats(f, bins = 100, range = (-1000, 1000))
+    """
+    if not isinstance(f, segyio.SegyFile):
+        with segyio.open(f) as fl:
+            return stats(fl, per = per, bins = bins, range = range,
+                         threads = threads)
+
+    fields = {
+        'iline': (f._il, f.ilines),
+        'xline': (f._xl, f.xlines),
+        'offset': (segyio.TraceField.offset, f.offsets),
+    }
+
+    if per not in ('file', 'trace') and per not in fields:
+        msg = 'per must be file, trace, iline, xline or offset, was {}'
+        raise ValueError(msg.format(per))
+
+    if bins is not None:
+        if per == 'trace':
+            raise ValueError('histograms per trace are not supported')
+        if range is None:
+            raise ValueError('histograms need a range')
+        if bins < 1:
+            raise ValueError('bins must be positive, was {}'.format(bins))
+        low, high = float(range[0]), float(range[1])
+        if not low < high:
+            raise ValueError('expected range[0] < range[1], was {}'.format(range))
+    else:
+        low, high = 0.0, 0.0
+
+    groups, ngroups = None, 1
+    if per in fields:
+        field, lines = fields[per]
+        values = f.attributes(field)[:]
+        if lines is None or len(lines) == 0:
+            lines = np.unique(values)
+        sorter = np.argsort(lines, kind = 'stable')
+        pos = np.searchsorted(lines, values, sorter = sorter)
+        groups = sorter[np.minimum(pos, len(lines) - 1)]
+        if not np.array_equal(lines[groups], values):
+            raise ValueError('traces that are not in any {}'.format(per))
+        groups = np.ascontiguousarray(groups, dtype = np.intc)
+        ngroups = len(lines)
+
+    acc = np.empty(ngroups, dtype = _amplitudes)
+    traces = None
+    if per == 'trace':
+        traces = np.empty(f.tracecount, dtype = _amplitudes)
+    hist = None
+    if bins is not None:
+        hist = np.empty((ngroups, bins), dtype = np.int64)
+
+    f.segyfd.stats(groups, ngroups, acc, traces, low, high,
+                   bins or 0, hist, threads)
+
+    if traces is not None:
+        acc = traces
+
+    result = np.empty(len(acc), dtype = [
+        ('count', np.int64),
+        ('nans', np.int64),
+        ('min', np.float64),
+        ('max', np.float64),
+        ('mean', np.float64),
+        ('rms', np.float64),
+    ])
+    result['count'] = acc['count']
+    result['nans'] = acc['nans']
+    result['min'] = acc['min']
+    result['max'] = acc['max']
+    with np.errstate(invalid = 'ignore', divide = 'ignore'):
+        result['mean'] = acc['sum'] / acc['count']
+        result['rms'] = np.sqrt(acc['sumsq'] / acc['count'])
+
+    if per == 'file':
+        result = result[0]
+        if hist is not None: hist = hist[0]
+
+    if hist is None:
+        return result
+
+    return result, hist
 
 def rotation(f, line = 'fast'):
     """ Find rotation of the survey
@@ -281,6 +464,9 @@ def rotation(f, line = 'fast'):
     if f.unstructured:
         raise ValueError("Rotation requires a structured file")
 
+    if f.sparse:
+        raise ValueError("Rotation requires a file without missing traces")
+
     lines = { 'fast': f.fast,
               'slow': f.slow,
               'iline': f.iline,
@@ -351,6 +537,128 @@ def metadata(f):
 
     return spec
 
+def write_index(f, path = None):
+    """Write the geometry index of a file
+
+    Scan the trace headers for the sorting, line numbers and offsets, and
+    write them to the index ``filename.segyidx``. ``segyio.open`` reads the
+    geometry from the index instead of scanning the file again, which makes
+    opening large files a lot faster.
+
+    The index is only valid for the file as it is now. If the file is
+    modified, the index is ignored until it is written again.
+
+    Takes an open segy file (created with segyio.open) or a file name.
+
+    Parameters
+    ----------
+
+    f : str or segyio.SegyFile
+    path : str, optional
+        Write the index to path instead of next to the file. segyio.open only
+        looks for the index next to the file.
+
+    Notes
+    -----
+
+    .. versionadded:: 2.1
+
+    """
+
+    if not isinstance(f, segyio.SegyFile):
+        with segyio.open(f, ignore_geometry = True) as fl:
+            return write_index(fl, path = path)
+
+    index = f._datasource_descriptor.index()
+    if index is None:
+        raise ValueError('geometry index requires a file opened with segyio.open')
+
+    default_path, mtime = index
+    if path is None:
+        path = default_path
+
+    f.segyfd.write_index(str(path), mtime)
+
+def spatial_index(f, path = None):
+    """Build a spatial index over the CDP coordinates
+
+    Read the CDP-X and CDP-Y of every trace in a single pass over the trace
+    headers, and index them for nearest-trace and point-in-polygon queries.
+    The coordinates are scaled like `rotation` does it, and are taken from the
+    trace header extension 1 when the file has it.
+
+    Reading the coordinates is the expensive part of building the index, so
+    they can be kept in a file. If `path` exists, and was written for this
+    file with the same size and modification time as it has now, the
+    coordinates are read from it. Otherwise they are read from the trace
+    headers, and written to `path`. Files opened with `open_with` or from
+    memory have no modification time to check, and `path` is not used for
+    them.
+
+    Takes an open segy file (created with segyio.open) or a file name.
+
+    Parameters
+    ----------
+
+    f : str or segyio.SegyFile
+    path : str, optional
+        File to keep the coordinates in, as a numpy .npz archive
+
+    Returns
+    -------
+
+    index : segyio.spatial.SpatialIndex
+
+    Notes
+    -----
+
+    .. versionadded:: 2.1
+
+    Examples
+    --------
+
+    Find the 4 traces nearest to a point:
+
+    >>> index = segyio.tools.spatial_index(f)
+    >>> traces, distances = index.nearest(453210.5, 6781230.0, k = 4)
+
+    Find the traces inside a polygon, and keep the index for next time:
+
+    >>> index = segyio.tools.spatial_index(f, path = 'survey.cdps.npz')
+    >>> traces = index.within([(0, 0), (100, 0), (100, 50), (0, 50)])
+    """
+
+    if not isinstance(f, segyio.SegyFile):
+        with segyio.open(f, ignore_geometry = True) as fl:
+            return spatial_index(fl, path = path)
+
+    from .spatial import SpatialIndex
+
+    # the size and modification time of the file, so that coordinates kept
+    # for another file, or an older version of this one, are not used. Only
+    # files opened by name have them
+    stamp = None
+    if f._datasource_descriptor.index() is not None:
+        st = os.stat(str(f._datasource_descriptor.filename))
+        stamp = np.array([st.st_mtime_ns, st.st_size], dtype = np.int64)
+
+    if stamp is not None and path is not None and os.path.exists(str(path)):
+        with np.load(str(path)) as kept:
+            if ('stamp' in kept.files
+                    and np.array_equal(kept['stamp'], stamp)
+                    and len(kept['cdpx']) == f.tracecount):
+                return SpatialIndex(kept['cdpx'], kept['cdpy'])
+
+    cdpx = np.empty(f.tracecount, dtype = np.float64)
+    cdpy = np.empty(f.tracecount, dtype = np.float64)
+    f.segyfd.cdps(cdpx, cdpy)
+
+    if stamp is not None and path is not None:
+        with open(str(path), 'wb') as fp:
+            np.savez(fp, cdpx = cdpx, cdpy = cdpy, stamp = stamp)
+
+    return SpatialIndex(cdpx, cdpy)
+
 def resample(f, rate = None, delay = None, micro = False,
                                            trace = True,
                                            binary = True):
@@ -497,24 +805,25 @@ def from_array(filename, data, iline=189,
     samplecount = len(spec.samples)
 
     with segyio.create(filename, spec) as f:
-        tr = 0
-        for ilno, il in enumerate(spec.ilines):
-            for xlno, xl in enumerate(spec.xlines):
-                for offno, off in enumerate(spec.offsets):
-                    f.header[tr] = {
-                        segyio.su.tracf  : tr,
-                        segyio.su.cdpt   : tr,
-                        segyio.su.offset : off,
-                        segyio.su.ns     : samplecount,
-                        segyio.su.dt     : dt,
-                        segyio.su.delrt  : delrt,
-                        segyio.su.iline  : il,
-                        segyio.su.xline  : xl
-                    }
-                    if dimensions == 2: f.trace[tr] = data[tr, :]
-                    if dimensions == 3: f.trace[tr] = data[ilno, xlno, :]
-                    if dimensions == 4: f.trace[tr] = data[ilno, xlno, offno, :]
-                    tr += 1
+        with f.writer() as w:
+            tr = 0
+            for ilno, il in enumerate(spec.ilines):
+                for xlno, xl in enumerate(spec.xlines):
+                    for offno, off in enumerate(spec.offsets):
+                        header = {
+                            segyio.su.tracf  : tr,
+                            segyio.su.cdpt   : tr,
+                            segyio.su.offset : off,
+                            segyio.su.ns     : samplecount,
+                            segyio.su.dt     : dt,
+                            segyio.su.delrt  : delrt,
+                            segyio.su.iline  : il,
+                            segyio.su.xline  : xl
+                        }
+                        if dimensions == 2: w.append(header, data[tr, :])
+                        if dimensions == 3: w.append(header, data[ilno, xlno, :])
+                        if dimensions == 4: w.append(header, data[ilno, xlno, offno, :])
+                        tr += 1
 
         f.bin.update(
             hdt=dt,
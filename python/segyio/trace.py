@@ -1,6 +1,8 @@
 try:
+    from collections.abc import Mapping # noqa
     from collections.abc import Sequence # noqa
 except ImportError:
+    from collections import Mapping # noqa
     from collections import Sequence # noqa
 
 import contextlib
@@ -12,6 +14,7 @@ except ImportError: pass
 
 import numpy as np
 
+import segyio
 from .line import HeaderLine
 from .field import Field, HeaderFieldAccessor
 from .utils import castarray
@@ -102,6 +105,9 @@ class Trace(Sequence):
 
     """
 
+    # bytes of traces read per request when iterating over read-only files
+    batchsize = 1 << 20
+
     def __init__(self, segyfd, dtype, tracecount, samples, readonly):
         super(Trace, self).__init__(tracecount)
         self.segyfd = segyfd
@@ -142,7 +148,8 @@ class Trace(Sequence):
             segyio can run through arbitrarily large files without consuming
             much memory, but it is potentially slow if the goal is to read the
             entire file into memory. If that is the case, consider using
-            `trace.raw`, which reads eagerly.
+            `trace.raw`, which reads eagerly. Files opened read-only are read
+            in batches of about `Trace.batchsize` bytes.
 
         Examples
         --------
@@ -225,7 +232,35 @@ class Trace(Sequence):
                     x, y = y, x
                     yield y
 
-            return gen()
+            def batched():
+                # read-only files can't change while iterating, so read a
+                # batch of traces at a time, which is read in large requests.
+                # The batches are double-buffered like single traces are
+                traces = range(*indices)
+                rowsize = max(1, n_elements * self.dtype.itemsize)
+                batch = max(1, min(len(traces), self.batchsize // rowsize))
+                x = np.zeros((batch, n_elements), dtype=self.dtype)
+                y = np.zeros((batch, n_elements), dtype=self.dtype)
+
+                for b in range(0, len(traces), batch):
+                    ks = traces[b:b + batch]
+                    try:
+                        self.segyfd.gettr(x, ks.start, ks.step, len(ks),
+                                          start, stop, step, n_elements)
+                    except Exception:
+                        # re-read trace by trace, so that all traces before
+                        # the bad one are still given to the caller
+                        for k in ks:
+                            tr = np.zeros(n_elements, dtype=self.dtype)
+                            yield self.segyfd.gettr(tr, k, 1, 1, start, stop,
+                                                    step, n_elements)
+                        continue
+
+                    x, y = y, x
+                    for row in y[:len(ks)]:
+                        yield row
+
+            return batched() if self.readonly else gen()
         except AttributeError:
             # At this point we have tried to unpack index as a single int, a
             # slice and a pair with either element being an int or slice.
@@ -339,6 +374,67 @@ class Trace(Sequence):
         yield x
         x.flush()
 
+    def memmap(self):
+        """
+        A zero-copy view of all traces
+
+        Expose the traces of a memory mapped file as a 2D numpy.ndarray, with
+        one row per trace, directly over the mapped file. Nothing is read or
+        copied, the trace headers between the traces are skipped by striding.
+        The view is read-only for read-only files, and writes to the view go
+        straight to the file in r+ mode.
+
+        The samples have the file's byte order, and it is up to numpy to swap
+        bytes when the byte order is not native. IBM floats and 3-byte
+        integers have no numpy equivalent and are not supported.
+
+        The file must be memory mapped, see SegyFile.mmap. The view keeps the
+        mapping alive, and stays valid even after the file is closed.
+
+        Returns
+        -------
+        view : numpy.ndarray
+            array of shape (tracecount, samples)
+
+        Raises
+        ------
+        BufferError
+            If the file is not memory mapped
+        ValueError
+            If the data format has no numpy equivalent
+
+        Notes
+        -----
+        .. versionadded:: 2.1
+
+        Examples
+        --------
+        >>> f.mmap()
+        True
+        >>> view = f.trace.memmap()
+        >>> avg = view[10:20].mean(axis = 1)
+        """
+        metrics = self.segyfd.metrics()
+        if metrics['format'] not in (2, 3, 5, 6, 8, 9, 10, 11, 12, 16):
+            msg = 'Trace views are not supported for format {}'
+            raise ValueError(msg.format(metrics['format']))
+
+        byteorder = '<' if metrics['endianness'] == 1 else '>'
+        dtype = self.dtype.newbyteorder(byteorder)
+        stride = metrics['trace_bsize'] + 240 * metrics['traceheader_count']
+
+        # frombuffer holds on to the exported buffer, which keeps the mapping
+        # alive for as long as the view
+        mapped = np.frombuffer(self.segyfd, dtype = np.uint8)
+        view = np.ndarray(shape = (len(self), self.shape),
+                          dtype = dtype,
+                          buffer = mapped,
+                          strides = (stride, dtype.itemsize),
+                         )
+        if self.readonly:
+            view.flags.writeable = False
+        return view
+
 class RawTrace(Trace):
     """
     Behaves exactly like trace, except reads are done eagerly and returned as
@@ -575,6 +671,126 @@ class RefTrace(Trace):
 
             return gen()
 
+class TraceWriter(object):
+    """Sequential, buffered trace writer
+
+    Write traces, header and samples together, in order. The traces are
+    collected in batches and handed to segyio's buffered writer, which encodes
+    them and writes them to disk in large, sequential writes. This is much
+    faster than assigning to ``f.header[i]`` and ``f.trace[i]`` for every
+    trace when creating a file.
+
+    The traces are collected in batches, and only reach the file when the batch
+    is full, or on :meth:`flush` and :meth:`close`. Reading the file while the
+    writer is open is safe, and sees the traces written so far. Call
+    :meth:`flush` first to include the traces appended to the current batch.
+
+    Notes
+    -----
+    .. versionadded:: 2.1
+
+    Examples
+    --------
+    Write the traces of a new file:
+
+    >>> with segyio.create(path, spec) as f:
+    ...     with f.writer() as w:
+    ...         for i, trace in enumerate(traces):
+    ...             w.append({ segyio.su.tracf: i }, trace)
+    """
+
+    # bytes collected in python before handing the batch to segyio
+    batchsize = 1 << 22
+
+    def __init__(self, segyfile, start=0, background=True):
+        self.segyfd = segyfile.segyfd
+        self.thcount = segyfile.traceheader_count
+        self.thsize = segyio._segyio.thsize()
+
+        tracecount = segyfile.tracecount
+        samplecount = len(segyfile.samples)
+        record = self.thcount * self.thsize
+        record += samplecount * np.dtype(segyfile.dtype).itemsize
+        batch = max(1, self.batchsize // record)
+
+        self.headers = bytearray(batch * self.thcount * self.thsize)
+        self.traces = np.zeros((batch, samplecount), dtype = segyfile.dtype)
+        self.count = 0
+
+        self.segyfd.writer_open(start,
+                                max(0, tracecount - start),
+                                0,
+                                background)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, type, value, traceback):
+        self.close()
+
+    def append(self, header, trace):
+        """Write the next trace
+
+        Parameters
+        ----------
+        header : dict_like or list of dict_like
+            The trace header, as a mapping of fields to values like
+            ``f.header[i] = header``, or a :class:`segyio.field.Field`. Files
+            with more than one trace header take a list, with one mapping per
+            trace header. Fields that are not set are zero.
+        trace : array_like
+            The samples of the trace
+        """
+        if self.count == len(self.traces):
+            self.flush()
+
+        if isinstance(header, (list, tuple)):
+            headers = header
+        else:
+            headers = [header]
+
+        if len(headers) > self.thcount:
+            msg = 'expected at most {} trace headers, got {}'
+            raise ValueError(msg.format(self.thcount, len(headers)))
+
+        first = self.count * self.thcount * self.thsize
+        view = memoryview(self.headers)
+        view[first : first + self.thcount * self.thsize] = bytes(self.thcount * self.thsize)
+
+        for index, h in enumerate(headers):
+            begin = first + index * self.thsize
+            buf = view[begin : begin + self.thsize]
+
+            if isinstance(h, Field):
+                buf[:] = h.buf
+                continue
+
+            if not isinstance(h, Mapping):
+                msg = 'header must be dict_like, was {}'
+                raise TypeError(msg.format(type(h)))
+
+            for key, value in h.items():
+                self.segyfd.putfield(buf, index, int(key), value)
+
+        self.traces[self.count] = trace
+        self.count += 1
+
+    def flush(self):
+        """Hand the collected traces to segyio"""
+        if self.count == 0:
+            return
+
+        self.segyfd.writer_put(self.headers, self.traces, self.count)
+        self.count = 0
+
+    def close(self):
+        """Write all traces to disk and close the writer"""
+        try:
+            self.flush()
+        finally:
+            self.segyfd.writer_close()
+
+
 class Header(Sequence):
     """Interact with segy in header mode
 
@@ -709,8 +925,21 @@ class Header(Sequence):
 
         >>> for x in header[::2]:
         ...     x.update({ TraceField.offset : 2 })
+
+        Set a fixed set of values in a range of headers. Only the given header
+        words are written, which is much faster than updating the headers one
+        by one:
+
+        >>> header[:] = { TraceField.TRACE_SAMPLE_INTERVAL: 4000 }
         """
 
+        if isinstance(i, slice) and type(val) is dict:
+            columns = self._columns(val)
+            if columns is not None:
+                for attrs, value in columns:
+                    attrs[i] = value
+                return
+
         x = self[i]
 
         try:
@@ -722,6 +951,34 @@ class Header(Sequence):
             for h, v in zip(x, val):
                 h.update(v)
 
+    def _columns(self, val):
+        # The per-field Attributes and values to broadcast the dict val, or
+        # None if any key or value is invalid. All of val is checked before
+        # anything is written, which keeps the assignment atomic, and the
+        # header-by-header path reports the error
+        layout = list(self.segyfile._traceheader_layouts.values())[0]
+        columns = []
+        for key, value in val.items():
+            try:
+                entry = layout.entry_by_byte(int(key))
+            except (TypeError, ValueError):
+                return None
+
+            if entry is None or entry.type not in Attributes.ENTRY_TYPE_TO_NUMPY:
+                return None
+
+            attrs = Attributes(self.segyfile, int(key), 0)
+            try:
+                value = attrs._values(value)
+            except ValueError:
+                return None
+
+            if value.ndim != 0:
+                return None
+            columns.append((attrs, value))
+
+        return columns
+
     @property
     def iline(self):
         """
@@ -1024,9 +1281,9 @@ class RowFieldAccessor(Sequence):
 
 
 class Attributes(Sequence):
-    """File-wide attribute (header word) reading
+    """File-wide attribute (header word) reading and writing
 
-    Lazily read a single header word for every trace in the file. The
+    Lazily read or write a single header word for every trace in the file. The
     Attributes implement the array interface, and will behave as expected when
     indexed and sliced.
 
@@ -1068,6 +1325,9 @@ class Attributes(Sequence):
         entry = traceheader_layout.entry_by_byte(field)
         self.dtype = Attributes.ENTRY_TYPE_TO_NUMPY[entry.type]
 
+        key = (traceheader_index, int(field))
+        self.cache = segyfile._header_cache.get(key)
+
     def __iter__(self):
         # attributes requires a custom iter, because self[:] returns a numpy
         # array, which in itself is iterable, but not an iterator
@@ -1108,9 +1368,13 @@ class Attributes(Sequence):
         >>> scatter(gx, gy)
         """
         try:
-            xs = np.asarray(i, dtype=np.int32)
-            xs = xs.astype(dtype=np.int32, order='C', copy=False)
+            xs = np.asarray(i, dtype=np.int64)
+            xs = xs.astype(dtype=np.int64, order='C', copy=False)
             attrs = np.empty(len(xs), dtype = self.dtype)
+            if self.cache is not None:
+                # the cache is only ever made for all traces, and take raises
+                # IndexError on out-of-range indices like field_foreach
+                return np.take(self.cache, xs, out = attrs)
             return self.segyfd.field_foreach(attrs, self.traceheader_index, xs, self.field)
 
         except TypeError:
@@ -1123,11 +1387,88 @@ class Attributes(Sequence):
             segyfd = self.segyfd
             field = self.field
 
+            if self.cache is not None:
+                return self.cache[i].copy()
+
             start, stop, step = i.indices(traces)
             indices = range(start, stop, step)
             attrs = np.empty(len(indices), dtype = self.dtype)
             return segyfd.field_forall(attrs, self.traceheader_index, start, stop, step, field)
 
+    def __setitem__(self, i, val):
+        """attributes[:] = val
+
+        Write the header word of the traces. The values are written directly to
+        the header word on disk, without reading and writing back the full
+        header of every trace.
+
+        Parameters
+        ----------
+        i   : int or slice or array_like
+        val : array_like of dtype or scalar
+            One value per trace, or a single value to write to all the traces
+
+        Notes
+        -----
+        .. versionadded:: 2.1
+
+        Examples
+        --------
+        Renumber the traces:
+
+        >>> attrs = f.attributes(segyio.TraceField.TRACE_SEQUENCE_FILE)
+        >>> attrs[:] = np.arange(1, f.tracecount + 1)
+
+        Set the sample interval in every other trace:
+
+        >>> f.attributes(segyio.TraceField.TRACE_SAMPLE_INTERVAL)[::2] = 4000
+        """
+        xs = self._values(val)
+        segyfd = self.segyfd
+        index = self.traceheader_index
+        field = self.field
+
+        try:
+            indices = np.asarray(i, dtype=np.int64)
+        except TypeError:
+            indices = None
+
+        if indices is not None and indices.ndim > 0:
+            xs = np.broadcast_to(xs, indices.shape)
+            indices = [self.wrapindex(int(x)) for x in indices]
+            for x, v in zip(indices, xs):
+                v = np.ascontiguousarray(v)
+                segyfd.put_field_forall(v, index, x, x + 1, 1, field, True)
+        else:
+            try:
+                i = self.wrapindex(i)
+                i = slice(i, i + 1, 1)
+            except TypeError:
+                pass
+
+            start, stop, step = i.indices(self.tracecount)
+            count = len(range(start, stop, step))
+            broadcast = xs.ndim == 0
+            if not broadcast and xs.shape != (count,):
+                msg = 'expected {} values, got {}'
+                raise ValueError(msg.format(count, xs.size))
+            segyfd.put_field_forall(xs, index, start, stop, step, field, broadcast)
+
+    def _values(self, val):
+        values = np.asarray(val)
+        dtype = np.dtype(self.dtype)
+        try:
+            xs = values.astype(dtype, order='C')
+        except (TypeError, ValueError, OverflowError):
+            msg = 'cannot write {} to header word {} of type {}'
+            raise ValueError(msg.format(values.dtype, self.field, dtype))
+
+        if dtype.kind in 'iu' and not np.array_equal(xs, values):
+            msg = 'value out of range for header word {} of type {}'
+            raise ValueError(msg.format(self.field, dtype))
+
+        return xs
+
 class Text(Sequence):
     """Interact with segy in text mode
 
@@ -1,3 +1,4 @@
+import os
 import warnings
 import numpy as np
 import xml.etree.ElementTree as ET
@@ -72,6 +73,16 @@ class FileDatasourceDescriptor():
     def readonly(self):
         return self.mode == 'rb' or self.mode == 'r'
 
+    def index(self):
+        """Path and modification time to validate the geometry index with
+
+        The modification time is in nanoseconds, so that a file rewritten
+        within the same second as its index is still caught. The index also
+        records the file size, which is checked when it is read.
+        """
+        path = str(self.filename) + '.segyidx'
+        return path, os.stat(self.filename).st_mtime_ns
+
     def make_segyfile_descriptor(self):
         from . import _segyio
         fd = _segyio.segyfd(
@@ -82,11 +93,12 @@ class FileDatasourceDescriptor():
 
 
 class StreamDatasourceDescriptor():
-    def __init__(self, stream, minimize_requests_number):
+    def __init__(self, stream, minimize_requests_number, cache=None):
         if stream is None:
             raise ValueError("stream object is required")
         self.stream = stream
         self.minimize_requests_number = minimize_requests_number
+        self.cache = cache
 
     def __repr__(self):
         return "'{}'".format(self.stream)
@@ -97,11 +109,22 @@ class StreamDatasourceDescriptor():
     def readonly(self):
         return not self.stream.writable()
 
+    def index(self):
+        return None
+
     def make_segyfile_descriptor(self):
         from . import _segyio
+        if self.cache is True:
+            cache = 16 * 1024 * 1024
+        elif not self.cache:
+            cache = 0
+        else:
+            cache = int(self.cache)
+
         fd = _segyio.segyfd(
             stream=self.stream,
             minimize_requests_number=self.minimize_requests_number,
+            cache=cache,
         )
         return fd
 
@@ -121,6 +144,9 @@ class MemoryBufferDatasourceDescriptor():
     def readonly(self):
         return False
 
+    def index(self):
+        return None
+
     def make_segyfile_descriptor(self):
         from . import _segyio
         fd = _segyio.segyfd(
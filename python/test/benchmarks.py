@@ -5,6 +5,7 @@ import os
 import segyio
 import pytest
 import numpy as np
+from concurrent.futures import ThreadPoolExecutor
 
 
 # Files are expected to be present at the run location
@@ -116,6 +117,26 @@ def update_by_traces(f):
         f.trace[i] = new[i]
 
 
+def read_ilines_share(filepath, mmap, share, shares):
+    with segyio.open(filepath) as f:
+        if mmap:
+            f.mmap()
+        for il in f.ilines[share::shares]:
+            f.iline[il]
+
+
+def run_threaded(filepath, mmap, threads):
+    # the same amount of work is split between the threads, so with the GIL
+    # released the run time should go down ~linearly with the thread count
+    with ThreadPoolExecutor(max_workers=threads) as pool:
+        futures = [
+            pool.submit(read_ilines_share, filepath, mmap, share, threads)
+            for share in range(threads)
+        ]
+        for future in futures:
+            future.result()
+
+
 def create(output_file):
     spec = segyio.spec()
 
@@ -175,6 +196,14 @@ def test_mmap_read_speed(benchmark, read_file, func):
     benchmark(run, read_file, True, func)
 
 
+@pytest.mark.benchmark(group="threads")
+@pytest.mark.parametrize("read_file", read_files)
+@pytest.mark.parametrize("mmap", [False, True])
+@pytest.mark.parametrize("threads", [1, 2, 4, 8])
+def test_threaded_read_speed(benchmark, read_file, mmap, threads):
+    benchmark(run_threaded, read_file, mmap, threads)
+
+
 @pytest.mark.benchmark(group="cube")
 @pytest.mark.parametrize("read_file", read_files)
 def test_cube_speed(make_datasource, benchmark, read_file):
@@ -183,6 +212,25 @@ def test_cube_speed(make_datasource, benchmark, read_file):
     )
 
 
+def run_cube_threaded(filepath, mmap, threads):
+    with segyio.open(filepath) as f:
+        if mmap:
+            f.mmap()
+        segyio.tools.cube(f, threads=threads)
+
+
+@pytest.mark.benchmark(group="cube threads")
+@pytest.mark.parametrize("read_file", read_files)
+@pytest.mark.parametrize("mmap", [False, True])
+@pytest.mark.parametrize("threads", [1, 2, 4, 8])
+def test_cube_threads_speed(benchmark, read_file, mmap, threads):
+    # file.sgy as written by create() is ~1.4GB; for numbers that reflect the
+    # disk rather than the page cache, use a file larger than memory
+    benchmark.pedantic(
+        run_cube_threaded, rounds=5, args=[read_file, mmap, threads]
+    )
+
+
 @pytest.mark.benchmark(group="write")
 @pytest.mark.parametrize("write_file", write_files)
 @pytest.mark.parametrize("func", write_operations)
@@ -9,6 +9,7 @@ except ImportError:
 
 from types import GeneratorType
 
+import collections
 import itertools
 import filecmp
 import shutil
@@ -25,7 +26,7 @@ import segyio
 from segyio import TraceField, BinField, TraceSortingFormat
 from segyio.field import Field
 from segyio.line import Line, HeaderLine
-from segyio.trace import Trace, Header
+from segyio.trace import Trace, Header, Attributes
 
 small_sus = [
     (segyio.su.open, { 'filename': testdata / 'small.su',
@@ -92,6 +93,49 @@ def test_inline_4(openfn, kwargs):
         # last sample
         assert 4.24049 == approx(data[last_line, sample_count - 1], abs=1e-6)
 
+def concurrent_reads(f):
+    from concurrent.futures import ThreadPoolExecutor
+
+    expected = {
+        'iline': {il: f.iline[il] for il in f.ilines},
+        'xline': {xl: f.xline[xl] for xl in f.xlines},
+        'depth': [f.depth_slice[i] for i in range(len(f.samples))],
+        'trace': f.trace.raw[:],
+        'header': list(f.attributes(TraceField.INLINE_3D)[:]),
+    }
+
+    def read(i):
+        il = f.ilines[i % len(f.ilines)]
+        xl = f.xlines[i % len(f.xlines)]
+        npt.assert_array_equal(f.iline[il], expected['iline'][il])
+        npt.assert_array_equal(f.xline[xl], expected['xline'][xl])
+        npt.assert_array_equal(f.depth_slice[i % len(f.samples)],
+                               expected['depth'][i % len(f.samples)])
+        npt.assert_array_equal(f.trace.raw[:], expected['trace'])
+        assert list(f.attributes(TraceField.INLINE_3D)[:]) == expected['header']
+
+    with ThreadPoolExecutor(max_workers=8) as pool:
+        list(pool.map(read, range(200)))
+
+
+@pytest.mark.parametrize(('openfn', 'kwargs'), small_segys)
+def test_concurrent_reads_on_one_handle(openfn, kwargs):
+    with openfn(**kwargs) as f:
+        concurrent_reads(f)
+
+
+def test_concurrent_reads_on_one_mmap_handle():
+    with segyio.open(testdata / 'small.sgy') as f:
+        f.mmap()
+        concurrent_reads(f)
+
+
+def test_concurrent_reads_on_one_stream_handle():
+    with open(str(testdata / 'small.sgy'), 'rb') as stream:
+        with segyio.open_with(stream) as f:
+            concurrent_reads(f)
+
+
 def test_inline_4_seismic_unix():
     with segyio.su.open(testdata / 'small.su',
             iline = 5,
@@ -327,6 +371,24 @@ def test_traces_subslicing(openfn, kwargs):
         assert traces[0].shape[0] == 6
 
 
+@pytest.mark.parametrize(('openfn', 'kwargs'), smallfiles)
+@pytest.mark.parametrize('batchsize', [1, 3 * 50 * 4, 1 << 20])
+def test_traces_batched_iteration(openfn, kwargs, batchsize, monkeypatch):
+    monkeypatch.setattr(segyio.trace.Trace, 'batchsize', batchsize)
+    with openfn(**kwargs) as f:
+        for sl in [slice(None), slice(None, None, -1), slice(1, 20, 3),
+                   slice(22, 2, -4)]:
+            expected = [f.trace[i] for i in range(*sl.indices(f.tracecount))]
+            traces = list(map(np.copy, f.trace[sl]))
+            assert len(traces) == len(expected)
+            for trace, ref in zip(traces, expected):
+                npt.assert_array_equal(trace, ref)
+
+        subtraces = list(map(np.copy, f.trace[::2, 10:2:-3]))
+        for i, trace in enumerate(subtraces):
+            npt.assert_array_equal(trace, f.trace[2 * i][10:2:-3])
+
+
 def test_traces_offset():
     with segyio.open(testdata / 'small-ps.sgy') as f:
         assert 2 == len(f.offsets)
@@ -501,6 +563,76 @@ def test_attributes(openfn, kwargs):
         assert ils == attrils
 
 
+@tmpfiles(testdata / 'small.sgy')
+def test_attributes_setitem(tmpdir):
+    il = TraceField.INLINE_3D
+    xl = TraceField.CROSSLINE_3D
+    cdpy = TraceField.CDP_Y
+    with segyio.open(tmpdir / 'small.sgy', 'r+') as f:
+        attrs = f.attributes(cdpy)
+        attrs[:] = np.arange(25) * 10
+        attrs[1:21:3] = [-1, -2, -3, -4, -5, -6, -7]
+        attrs[::-5] = 7
+        attrs[2] = 100
+        attrs[[3, -1]] = [200, 300]
+
+    expected = np.arange(25, dtype = np.int32) * 10
+    expected[1:21:3] = [-1, -2, -3, -4, -5, -6, -7]
+    expected[::-5] = 7
+    expected[2] = 100
+    expected[[3, -1]] = [200, 300]
+
+    with segyio.open(tmpdir / 'small.sgy') as f:
+        assert np.array_equal(f.attributes(cdpy)[:], expected)
+        assert [h[cdpy] for h in f.header] == list(expected)
+
+        ils = [(i // 5) + 1 for i in range(25)]
+        xls = [(i % 5) + 20 for i in range(25)]
+        assert list(f.attributes(il)[:]) == ils
+        assert list(f.attributes(xl)[:]) == xls
+
+
+@tmpfiles(testdata / 'small.sgy')
+def test_attributes_setitem_invalid(tmpdir):
+    dt = TraceField.TRACE_SAMPLE_INTERVAL
+    with segyio.open(tmpdir / 'small.sgy', 'r+') as f:
+        attrs = f.attributes(dt)
+        with pytest.raises(ValueError):
+            attrs[:] = [1, 2, 3]
+
+        with pytest.raises(ValueError):
+            attrs[:] = 70000
+
+        with pytest.raises(IndexError):
+            attrs[[0, 25]] = 1
+
+        assert list(attrs[:]) == [0] * 25
+
+    with segyio.open(tmpdir / 'small.sgy') as f:
+        with pytest.raises(IOError):
+            f.attributes(dt)[:] = 2000
+
+
+@tmpfiles(testdata / 'small.sgy')
+def test_header_setitem_broadcast(tmpdir):
+    dt = TraceField.TRACE_SAMPLE_INTERVAL
+    scalar = TraceField.ElevationScalar
+    with segyio.open(tmpdir / 'small.sgy', 'r+') as f:
+        f.header[::2] = { dt: 2000, scalar: 3 }
+
+        # an invalid key fails the whole assignment, and writes nothing
+        with pytest.raises(KeyError):
+            f.header[:] = { dt: 1000, 2: 1 }
+
+        f.header = { TraceField.DelayRecordingTime: 4 }
+
+    with segyio.open(tmpdir / 'small.sgy') as f:
+        for i, h in enumerate(f.header):
+            assert h[dt] == (2000 if i % 2 == 0 else 0)
+            assert h[scalar] == (3 if i % 2 == 0 else 0)
+            assert h[TraceField.DelayRecordingTime] == 4
+
+
 def test_iline_offset():
     with segyio.open(testdata / 'small-ps.sgy') as f:
         line1 = f.iline[1, 1]
@@ -1092,6 +1224,73 @@ def test_traceheader_attributes(small):
         assert f.tracefield.SEG00000.xline[0] == 20
 
 
+@pytest.mark.parametrize(('openfn', 'kwargs'), smallfiles)
+def test_header_table(openfn, kwargs):
+    with openfn(**kwargs) as f:
+        table = f.header_table()
+        assert len(table) > 0
+        for field, column in table.items():
+            assert len(column) == f.tracecount
+            assert np.array_equal(column, f.attributes(field)[:])
+
+        il = kwargs.get('iline', TraceField.INLINE_3D)
+        xl = kwargs.get('xline', TraceField.CROSSLINE_3D)
+        table = f.header_table([xl, il])
+        assert list(table.keys()) == [xl, il]
+        assert list(table[il]) == [(i // 5) + 1 for i in range(25)]
+        assert list(table[xl]) == [(i % 5) + 20 for i in range(25)]
+
+
+def test_header_table_extension_headers():
+    with segyio.open(testdata / 'rotated-small-rev2.sgy') as f:
+        for index, name in enumerate(f._traceheader_names):
+            layout = f._traceheader_entries[index]
+            fields = [
+                (name, entry.byte) for entry in layout
+                if entry.type in Attributes.ENTRY_TYPE_TO_NUMPY
+            ]
+            table = f.header_table(fields)
+            for (_, byte), column in table.items():
+                expected = Attributes(f, byte, index)[:]
+                assert np.array_equal(column, expected)
+
+
+def test_header_table_cache(small):
+    il, xl = TraceField.INLINE_3D, TraceField.CROSSLINE_3D
+    with segyio.open(small) as f:
+        expected = f.attributes(il)[:]
+        table = f.header_table([il], cache = True)
+
+        attrs = f.attributes(il)
+        assert attrs.cache is not None
+        assert f.attributes(xl).cache is None
+
+        assert np.array_equal(attrs[:], expected)
+        assert np.array_equal(attrs[::-1], expected[::-1])
+        assert np.array_equal(attrs[1:21:3], expected[1:21:3])
+        assert np.array_equal(attrs[3], expected[3:4])
+        assert np.array_equal(attrs[[0, 5, 11]], expected[[0, 5, 11]])
+
+        # modifying the output must not modify the cache
+        xs = attrs[:]
+        xs[0] = 100
+        assert np.array_equal(attrs[:], expected)
+        with pytest.raises(ValueError):
+            table[il][0] = 100
+
+
+def test_header_table_cache_readonly(small):
+    with segyio.open(small, 'r+') as f:
+        with pytest.raises(ValueError):
+            f.header_table([TraceField.INLINE_3D], cache = True)
+
+
+def test_header_table_invalid_field(small):
+    with segyio.open(small) as f:
+        with pytest.raises(KeyError):
+            f.header_table([TraceField.INLINE_3D + 1])
+
+
 def test_depricated_fields(small):
     with segyio.open(small, "r") as f:
         assert f.bin[BinField.EnsembleTraces] == 25
@@ -1447,6 +1646,28 @@ def test_write_with_array_likes(small):
             assert np.array_equal(f.trace[0], ones)
 
 
+def test_write_leaves_source_untouched(small):
+    # not every float survives a round trip through IBM float, so converting
+    # the source in place and back would change it
+    rng = np.random.default_rng(0)
+    with segyio.open(small, mode = 'r+') as f:
+        trace = rng.standard_normal(len(f.samples)).astype(np.single)
+        expected = trace.copy()
+        f.trace[0] = trace
+        assert np.array_equal(trace, expected)
+
+        first = f.ilines[0]
+        line = rng.standard_normal(f.iline[first].shape).astype(np.single)
+        expected = line.copy()
+        f.iline[first] = line
+        assert np.array_equal(line, expected)
+
+        depth = rng.standard_normal(f.depth_slice[0].shape).astype(np.single)
+        expected = depth.copy()
+        f.depth_slice[0] = depth
+        assert np.array_equal(depth, expected)
+
+
 def test_assign_all_traces(small):
     orig = str(small.dirname + '/small.sgy')
     copy = str(small.dirname + '/copy.sgy')
@@ -1523,6 +1744,76 @@ def test_create_sgy(small):
     assert filecmp.cmp(orig, fresh)
 
 
+@pytest.mark.parametrize('background', [True, False])
+def test_create_sgy_writer(tmpdir, background):
+    orig = str(testdata / 'small.sgy')
+    fresh = str(tmpdir / 'fresh.sgy')
+    with segyio.open(orig) as src:
+        spec = segyio.spec()
+        spec.format = int(src.format)
+        spec.sorting = int(src.sorting)
+        spec.samples = src.samples
+        spec.ilines = src.ilines
+        spec.xlines = src.xlines
+
+        with segyio.create(fresh, spec) as dst:
+            dst.text[0] = src.text[0]
+            dst.bin = src.bin
+
+            with dst.writer(background = background) as w:
+                for header, trace in zip(src.header, src.trace):
+                    w.append(header, trace)
+
+    assert filecmp.cmp(orig, fresh)
+
+
+def test_writer_headers_from_dict(tmpdir):
+    spec = segyio.spec()
+    spec.format = 5
+    spec.samples = range(10)
+    spec.tracecount = 3000
+
+    with segyio.create(tmpdir / 'mk.sgy', spec) as dst:
+        with dst.writer() as w:
+            for i in range(len(dst.trace)):
+                w.append({ TraceField.TRACE_SEQUENCE_FILE: i },
+                         np.full(10, i, dtype = np.float32))
+
+    with segyio.open(tmpdir / 'mk.sgy', ignore_geometry = True) as f:
+        seq = f.attributes(TraceField.TRACE_SEQUENCE_FILE)[:]
+        npt.assert_array_equal(seq, np.arange(3000))
+        npt.assert_array_equal(f.trace.raw[:][:, 0], np.arange(3000))
+
+
+@pytest.mark.parametrize('background', [True, False])
+def test_writer_read_while_writing(tmpdir, background):
+    spec = segyio.spec()
+    spec.format = 5
+    spec.samples = range(10)
+    spec.tracecount = 100
+
+    with segyio.create(tmpdir / 'mk.sgy', spec) as dst:
+        with dst.writer(background = background) as w:
+            for i in range(len(dst.trace)):
+                w.append({ TraceField.TRACE_SEQUENCE_FILE: i },
+                         np.full(10, i, dtype = np.float32))
+
+                if i % 10 == 0:
+                    w.flush()
+                    assert dst.header[i][TraceField.TRACE_SEQUENCE_FILE] == i
+                    npt.assert_array_equal(dst.trace[i], np.full(10, i))
+
+        seq = dst.attributes(TraceField.TRACE_SEQUENCE_FILE)[:]
+        npt.assert_array_equal(seq, np.arange(100))
+        npt.assert_array_equal(dst.trace.raw[:][:, 0], np.arange(100))
+
+
+def test_writer_readonly():
+    with segyio.open(testdata / 'small.sgy') as f:
+        with pytest.raises(IOError):
+            f.writer()
+
+
 def test_ref_getitem(small):
     with segyio.open(small, mode = 'r+') as f:
         with f.trace.ref as ref:
@@ -2107,6 +2398,23 @@ def test_depth_slice_unstructured(openfn, kwargs):
         np.testing.assert_almost_equal(f.depth_slice[0], traces[:,0])
 
 
+@pytest.mark.parametrize('batchsize', [1, 3 * 25 * 4, 1 << 26])
+@pytest.mark.parametrize('ignore_geometry', [False, True])
+def test_depth_slice_batched(batchsize, ignore_geometry, monkeypatch):
+    monkeypatch.setattr(segyio.depth.Depth, 'batchsize', batchsize)
+    with segyio.open(testdata / 'small-ps.sgy',
+                     ignore_geometry=ignore_geometry) as f:
+        for sl in [slice(None), slice(None, None, -1), slice(1, 9, 3),
+                   slice(8, 0, -3)]:
+            traces = f.trace.raw[::f.depth_slice.offsets]
+            expected = [traces[:, i].reshape(f.depth_slice.shape)
+                        for i in range(*sl.indices(len(f.samples)))]
+            depths = list(map(np.copy, f.depth_slice[sl]))
+            assert len(depths) == len(expected)
+            for depth, ref in zip(depths, expected):
+                npt.assert_array_equal(depth, ref)
+
+
 def test_depth_slice_writing(small):
     from itertools import islice
 
@@ -2184,6 +2492,70 @@ def test_readtrace_int16():
         assert list(tr[40:19:-5]) == [-888, -2213, 5198, -1170, 0]
         assert list(tr[53:50:-1]) == [-2609, -2625, 681]
 
+@pytest.mark.parametrize(('filename', 'endian'), [
+    ('f3.sgy', 'big'),
+    ('f3-lsb.sgy', 'little'),
+])
+def test_trace_memmap(filename, endian):
+    with segyio.open(testdata / filename, endian = endian) as f:
+        with pytest.raises(BufferError):
+            f.trace.memmap()
+
+        if not f.mmap():
+            pytest.skip('mmap not available')
+
+        view = f.trace.memmap()
+        assert view.shape == (f.tracecount, len(f.samples))
+        assert not view.flags.writeable
+        npt.assert_array_equal(view, f.trace.raw[:])
+
+    # the view keeps the mapping alive after close
+    npt.assert_array_equal(view[10][20:45:5], [0, -1170, 5198, -2213, -888])
+
+def test_trace_memmap_ibm_float(small):
+    with segyio.open(small) as f:
+        f.mmap()
+        with pytest.raises(ValueError):
+            f.trace.memmap()
+
+@tmpfiles(testdata / 'f3.sgy')
+def test_trace_memmap_write(tmpdir):
+    fname = str(tmpdir / 'f3.sgy')
+    with segyio.open(fname, 'r+') as f:
+        if not f.mmap():
+            pytest.skip('mmap not available')
+        neighbours = f.trace[4], f.trace[6]
+        view = f.trace.memmap()
+        assert view.flags.writeable
+        view[5] = 7
+        del view
+
+    with segyio.open(fname) as f:
+        npt.assert_array_equal(f.trace[5], np.full(len(f.samples), 7))
+        npt.assert_array_equal(f.trace[4], neighbours[0])
+        npt.assert_array_equal(f.trace[6], neighbours[1])
+
+@pytest.mark.parametrize('mmap', [False, True])
+def test_advise(small, mmap):
+    with segyio.open(small) as f:
+        if mmap:
+            f.mmap()
+        expected = f.xline[21]
+        for pattern in ['sequential', 'random', 'strided', 'willneed', 'normal']:
+            f.advise(pattern)
+        f.advise('willneed', traces=range(5, 15))
+        f.advise('willneed', traces=slice(20, None))
+        npt.assert_array_equal(f.xline[21], expected)
+
+def test_advise_invalid(small):
+    with segyio.open(small) as f:
+        with pytest.raises(ValueError):
+            f.advise('backwards')
+        with pytest.raises(ValueError):
+            f.advise('random', traces=range(5))
+        with pytest.raises(ValueError):
+            f.advise('willneed', traces=range(0, 10, 2))
+
 def test_attributes_shortword_little_endian():
     f3msb = testdata / 'f3.sgy'
     f3lsb = testdata / 'f3-lsb.sgy'
@@ -2255,6 +2627,142 @@ def test_interpret_invalid_args():
             xl = [20, 21, 22, 23, 24]
             f.interpret(il, xl, sorting=0)
 
+def write_subset(src, dst, traces):
+    """Write the traces of src, in the order of traces, to dst"""
+    with segyio.open(src, ignore_geometry = True) as f:
+        spec = segyio.spec()
+        spec.format = int(f.format)
+        spec.samples = f.samples
+        spec.tracecount = len(traces)
+        with segyio.create(dst, spec) as g:
+            g.bin = f.bin
+            for i, traceno in enumerate(traces):
+                g.header[i] = f.header[traceno]
+                g.trace[i] = f.trace[traceno]
+
+
+def test_sparse_geometry(tmpdir):
+    holes = [0, 7, 13]
+    path = str(tmpdir / 'holes.sgy')
+    write_subset(testdata / 'small.sgy', path,
+                 [i for i in range(25) if i not in holes])
+
+    with pytest.raises(ValueError):
+        segyio.open(path)
+
+    with segyio.open(path, ignore_geometry = True) as f:
+        assert not f.sparse
+        assert f.unstructured
+
+    with segyio.open(testdata / 'small.sgy') as ref:
+        with segyio.open(path, sparse = True) as f:
+            assert f.sparse
+            assert not f.unstructured
+            assert f.sorting == TraceSortingFormat.INLINE_SORTING
+            assert list(f.ilines) == list(ref.ilines)
+            assert list(f.xlines) == list(ref.xlines)
+            assert list(f.offsets) == [1]
+
+            expected = segyio.tools.cube(ref)
+            expected.reshape(25, -1)[holes] = 0
+            assert np.array_equal(segyio.tools.cube(f), expected)
+
+            assert np.array_equal(f.iline[1], expected[0])
+            assert np.array_equal(f.iline[2], expected[1])
+            assert np.array_equal(f.xline[22], expected[:, 2])
+
+            lines = list(f.iline[:])
+            assert len(lines) == 5
+            assert np.array_equal(lines[-1], expected[-1])
+
+            assert np.array_equal(f.gather[1, 20], np.zeros(50))
+            assert np.array_equal(f.gather[1, 21], expected[0, 1])
+            gathers = list(f.gather[2, :])
+            assert len(gathers) == 5
+            assert np.array_equal(gathers[2], expected[1, 2])
+
+            with pytest.raises(KeyError):
+                f.iline[6]
+
+            with pytest.raises(KeyError):
+                f.gather[1, 19]
+
+            with pytest.raises(ValueError):
+                f.header.iline[1]
+
+            assert f.depth_slice[0].shape == (22,)
+
+
+def test_sparse_geometry_prestack_crossline_sorted(tmpdir):
+    with segyio.open(testdata / 'small-ps.sgy') as ref:
+        ilines = ref.attributes(TraceField.INLINE_3D)[:]
+        xlines = ref.attributes(TraceField.CROSSLINE_3D)[:]
+        offsets = ref.attributes(TraceField.offset)[:]
+        order = np.lexsort((offsets, ilines, xlines))
+        expected = segyio.tools.cube(ref)
+
+    holes = [1, 9, 10]
+    path = str(tmpdir / 'holes.sgy')
+    write_subset(testdata / 'small-ps.sgy', path, np.delete(order, holes))
+    expected.reshape(-1, expected.shape[-1])[order[holes]] = 0
+
+    with segyio.open(path, sparse = True) as f:
+        assert f.sparse
+        assert f.sorting == TraceSortingFormat.CROSSLINE_SORTING
+        assert list(f.offsets) == [1, 2]
+
+        cube = segyio.tools.cube(f)
+        assert np.array_equal(cube, expected.swapaxes(0, 1))
+
+        for il in f.ilines:
+            for off in f.offsets:
+                i = list(f.ilines).index(il)
+                o = list(f.offsets).index(off)
+                assert np.array_equal(f.iline[il, off], expected[i, :, o])
+
+        assert np.array_equal(f.xline[2, 2], expected[:, 1, 1])
+        assert np.array_equal(f.gather[1, 1], expected[0, 0])
+        assert np.array_equal(f.gather[1, 1, 2], expected[0, 0, 1])
+        assert len(list(f.gather[:, :, :])) == 12
+
+
+def test_sparse_geometry_regular_file():
+    with segyio.open(testdata / 'small.sgy', sparse = True) as f:
+        assert not f.sparse
+        assert not f.unstructured
+        assert isinstance(f.iline, Line)
+
+
+def test_sparse_geometry_duplicates(tmpdir):
+    path = str(tmpdir / 'duplicates.sgy')
+    write_subset(testdata / 'small.sgy', path, [0, 1, 2, 2])
+
+    with pytest.raises(ValueError):
+        segyio.open(path, sparse = True)
+
+    with segyio.open(path, sparse = True, strict = False) as f:
+        assert not f.sparse
+        assert f.unstructured
+
+
+def test_sparse_geometry_write(tmpdir):
+    holes = [5, 6]
+    path = str(tmpdir / 'holes.sgy')
+    write_subset(testdata / 'small.sgy', path,
+                 [i for i in range(25) if i not in holes])
+
+    with segyio.open(path, 'r+', sparse = True) as f:
+        f.iline[2] = np.ones((5, 50), dtype = np.float32)
+        f.xline[24] = np.full((5, 50), 2, dtype = np.float32)
+
+    with segyio.open(path, sparse = True) as f:
+        line = f.iline[2]
+        assert np.array_equal(line[:2], np.zeros((2, 50)))
+        assert np.array_equal(line[2:4], np.ones((2, 50)))
+        assert np.array_equal(line[4], np.full(50, 2))
+        assert f.tracecount == 23
+
+
 def test_group_single_key():
     with segyio.open(testdata / 'shot-gather.sgy', ignore_geometry = True) as f:
         group = f.group(segyio.su.fldr)
@@ -2335,6 +2843,30 @@ def test_group_multi_key_corret_index():
             assert index == shot.index
             assert key == shot.key
 
+def test_group_offsets_index():
+    with segyio.open(testdata / 'shot-gather.sgy', ignore_geometry = True) as f:
+        key = (segyio.su.fldr, segyio.su.grnofr)
+        groups = f.group(key)
+
+        # group by walking the headers, like segyio did before native grouping
+        expected = collections.OrderedDict()
+        for i, h in enumerate(f.header):
+            k = frozenset((int(w), h[w]) for w in key)
+            expected.setdefault(k, []).append(i)
+
+        assert list(groups.bins.keys()) == list(expected.keys())
+        assert len(groups.offsets) == len(expected) + 1
+        assert groups.offsets[0] == 0
+        assert groups.offsets[-1] == f.tracecount
+
+        for n, index in enumerate(expected.values()):
+            lo, hi = groups.offsets[n], groups.offsets[n + 1]
+            assert list(groups.index[lo:hi]) == index
+
+        fldr = f.group(segyio.su.fldr)
+        assert list(fldr.offsets) == [0, 10, 22, 35, 61]
+        assert np.array_equal(fldr.index, np.arange(f.tracecount))
+
 def test_specific_group_sort():
     with segyio.open(testdata / 'shot-gather.sgy', ignore_geometry = True) as f:
         group = f.group((segyio.su.fldr, segyio.su.grnofr))
@@ -9,12 +9,14 @@ def open_with_stream(
     make_stream,
     filename,
     mode="rb",
-    minimize_requests_number=True
+    minimize_requests_number=True,
+    cache=None
 ):
     stream = make_stream(filename, mode)
     return segyio.open_with(
         stream,
-        minimize_requests_number=minimize_requests_number
+        minimize_requests_number=minimize_requests_number,
+        cache=cache
     )
 
 
@@ -94,14 +96,16 @@ def verify_trace_reads_on_known_pattern_file(
 
 
 @pytest.mark.parametrize("minimize_requests_number", [True, False])
-def test_read(make_stream, minimize_requests_number):
+@pytest.mark.parametrize("cache", [None, True, 256])
+def test_read(make_stream, minimize_requests_number, cache):
     with open_with_stream(make_stream, testfile) as f:
         cube = segyio.tools.cube(f)
 
     with open_with_stream(
         make_stream,
         testfile,
-        minimize_requests_number=minimize_requests_number
+        minimize_requests_number=minimize_requests_number,
+        cache=cache
     ) as f:
         assert f.tracecount == 6
         assert f.bin[segyio.BinField.Samples] == 4
@@ -135,12 +139,31 @@ def test_create(make_stream):
 
             assert dst.bin == src.bin
             assert np.array_equal(dst.header, src.header)
-            assert np.array_equal(dst.trace, src.trace)
+            assert np.array_equal(dst.trace.raw[:], src.trace.raw[:])
 
         with open_with_stream(make_stream, fresh) as f:
             assert f.bin == src.bin
             assert np.array_equal(f.header, src.header)
-            assert np.array_equal(f.trace, src.trace)
+            assert np.array_equal(f.trace.raw[:], src.trace.raw[:])
+
+
+def test_create_writer(make_stream):
+    fresh = "fresh.sgy"
+    with open_with_stream(make_stream, testfile) as src:
+        spec = segyio.spec()
+        spec.format = int(src.format)
+        spec.sorting = int(src.sorting)
+        spec.samples = src.samples
+        spec.ilines = src.ilines
+        spec.xlines = src.xlines
+        with create_with_stream(make_stream, fresh, spec) as dst:
+            dst.bin = src.bin
+            with dst.writer() as w:
+                for header, trace in zip(src.header, src.trace):
+                    w.append(header, trace)
+
+            assert np.array_equal(dst.header, src.header)
+            assert np.array_equal(dst.trace.raw[:], src.trace.raw[:])
 
 
 def run_test_update(open_datasource):
@@ -200,6 +223,17 @@ def test_update(stream_source):
     run_test_update(stream_source)
 
 
+def test_update_cached(make_stream):
+    def open(mode="rb"):
+        return open_with_stream(make_stream, testfile, mode=mode, cache=True)
+    run_test_update(open)
+
+
+def test_negative_cache(make_stream):
+    with pytest.raises(ValueError):
+        open_with_stream(make_stream, testfile, cache=-1)
+
+
 def test_none_stream():
     with pytest.raises(ValueError):
         segyio.open_with(None)
@@ -230,3 +264,60 @@ def test_resource_deallocation(make_stream, execution_number):
     f = open_with_stream(make_stream, testfile)
     f.xline[1]
     f.close()
+
+
+class ReadOnlyStream():
+    """
+    Stream without readinto, which segyio then reads with read(), like it does
+    for custom streams that only implement the minimal interface
+    """
+    def __init__(self, stream):
+        self.stream = stream
+
+    def __getattr__(self, name):
+        if name == 'readinto':
+            raise AttributeError(name)
+        return getattr(self.stream, name)
+
+
+class UnimplementedReadintoStream(ReadOnlyStream):
+    def readinto(self, buffer):
+        raise NotImplementedError
+
+
+@pytest.mark.parametrize(
+    "wrapper",
+    [lambda s: s, ReadOnlyStream, UnimplementedReadintoStream]
+)
+def test_read_protocol(make_stream, wrapper):
+    with open_with_stream(make_stream, testfile) as f:
+        expected = f.trace.raw[:]
+        header = dict(f.header[3])
+
+    with segyio.open_with(wrapper(make_stream(testfile, "rb"))) as f:
+        assert np.array_equal(f.trace.raw[:], expected)
+        assert dict(f.header[3]) == header
+
+
+try:
+    import pytest_benchmark
+    has_benchmark = True
+except ImportError:
+    has_benchmark = False
+
+
+@pytest.mark.skipif(not has_benchmark, reason="needs pytest-benchmark")
+@pytest.mark.benchmark(group="stream")
+@pytest.mark.parametrize("protocol", ["readinto", "read"])
+@pytest.mark.parametrize("cache", [None, True])
+def test_read_speed(make_stream, benchmark, protocol, cache):
+    wrapper = ReadOnlyStream if protocol == "read" else lambda s: s
+
+    def run():
+        stream = wrapper(make_stream("small.sgy", "rb"))
+        with segyio.open_with(stream, cache=cache) as f:
+            for _ in f.trace:
+                pass
+            f.attributes(segyio.TraceField.offset)[:]
+
+    benchmark(run)
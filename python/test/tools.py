@@ -1,3 +1,4 @@
+import os
 import numpy as np
 import pytest
 from pytest import approx
@@ -131,6 +132,22 @@ def test_cube_identity_prestack():
         assert np.all(x == segyio.tools.cube(f))
 
 
+@pytest.mark.parametrize('filename', ['small.sgy', 'small-ps.sgy'])
+@pytest.mark.parametrize('mmap', [False, True])
+@pytest.mark.parametrize('threads', [2, 3, 100])
+def test_cube_threads(filename, mmap, threads):
+    with segyio.open(testdata / filename) as f:
+        if mmap:
+            f.mmap()
+        assert np.all(segyio.tools.cube(f) == segyio.tools.cube(f, threads))
+
+
+def test_cube_threads_must_be_positive():
+    with segyio.open(testdata / 'small.sgy') as f:
+        with pytest.raises(ValueError):
+            segyio.tools.cube(f, threads=0)
+
+
 def test_unstructured_rotation():
     with pytest.raises(ValueError):
         with segyio.open(testdata / 'small.sgy', ignore_geometry=True) as f:
@@ -209,6 +226,257 @@ def test_metadata():
     assert spec.xline == 193
 
 
+@tmpfiles(testdata / 'small-ps.sgy')
+def test_write_index(tmpdir):
+    path = tmpdir / 'small-ps.sgy'
+    with segyio.open(path) as f:
+        ilines, xlines, offsets = f.ilines, f.xlines, f.offsets
+        sorting = f.sorting
+        segyio.tools.write_index(f)
+
+    index = tmpdir / 'small-ps.sgy.segyidx'
+    assert index.exists()
+
+    with segyio.open(path) as f:
+        assert np.array_equal(ilines, f.ilines)
+        assert np.array_equal(xlines, f.xlines)
+        assert np.array_equal(offsets, f.offsets)
+        assert sorting == f.sorting
+
+    # the line numbers are read from the index, not the file
+    with open(str(index), 'r+b') as fp:
+        fp.seek(64)
+        fp.write(np.array([100], dtype='<i4').tobytes())
+
+    with segyio.open(path) as f:
+        assert f.ilines[0] == 100
+
+
+@tmpfiles(testdata / 'small.sgy')
+def test_stale_index_is_ignored(tmpdir):
+    path = tmpdir / 'small.sgy'
+    segyio.tools.write_index(path)
+
+    with segyio.open(path, 'r+') as f:
+        f.header[0][TraceField.INLINE_3D] = 10
+        f.header[1][TraceField.INLINE_3D] = 10
+        f.header[2][TraceField.INLINE_3D] = 10
+        f.header[3][TraceField.INLINE_3D] = 10
+        f.header[4][TraceField.INLINE_3D] = 10
+
+    with segyio.open(path) as f:
+        assert list(f.ilines) == [10, 2, 3, 4, 5]
+
+
+@tmpfiles(testdata / 'small.sgy')
+def test_index_of_file_rewritten_in_same_second_is_ignored(tmpdir):
+    path = str(tmpdir / 'small.sgy')
+    second = os.stat(path).st_mtime_ns // 10**9 * 10**9
+    os.utime(path, ns = (second, second))
+    segyio.tools.write_index(path)
+
+    # the second inline is not among the traces the index fingerprints
+    with segyio.open(path, 'r+') as f:
+        for i in range(5, 10):
+            f.header[i][TraceField.INLINE_3D] = 20
+    os.utime(path, ns = (second + 1, second + 1))
+
+    with segyio.open(path) as f:
+        assert list(f.ilines) == [1, 20, 3, 4, 5]
+
+
+def test_write_index_needs_file():
+    with open(testdata / 'small.sgy', 'rb') as stream:
+        with segyio.open_with(stream) as f:
+            with pytest.raises(ValueError):
+                segyio.tools.write_index(f)
+
+
+def test_spatial_index_nearest():
+    with segyio.open(testdata / 'acute-small.sgy') as f:
+        index = segyio.tools.spatial_index(f)
+        assert len(index) == f.tracecount
+
+        # the coordinates are scaled by -10
+        x = f.attributes(TraceField.CDP_X)[:] / 10.0
+        y = f.attributes(TraceField.CDP_Y)[:] / 10.0
+        assert np.allclose(index.cdpx, x)
+        assert np.allclose(index.cdpy, y)
+
+        qx, qy = 0.23, 10.04
+        traces, distances = index.nearest(qx, qy, k = 3)
+        expected = np.lexsort((np.arange(len(x)), np.hypot(x - qx, y - qy)))
+        assert list(traces) == list(expected[:3])
+        assert np.allclose(distances, np.hypot(x - qx, y - qy)[expected[:3]])
+
+        traces, _ = index.nearest(qx, qy, k = 100)
+        assert len(traces) == f.tracecount
+
+
+def test_spatial_index_within():
+    with segyio.open(testdata / 'acute-small.sgy') as f:
+        index = segyio.tools.spatial_index(f)
+        x, y = index.cdpx, index.cdpy
+
+        box = [(0.05, 9.95), (0.25, 9.95), (0.25, 10.35), (0.05, 10.35)]
+        traces = index.within(box)
+        inside = (x > 0.05) & (x < 0.25) & (y > 9.95) & (y < 10.35)
+        assert list(traces) == list(np.flatnonzero(inside))
+
+        assert len(index.within([(50, 50), (60, 50), (55, 60)])) == 0
+
+        with pytest.raises(ValueError):
+            index.within([(0, 0), (1, 1)])
+
+
+@tmpfiles(testdata / 'acute-small.sgy')
+def test_spatial_index_kept(tmpdir):
+    path = tmpdir / 'acute-small.sgy'
+    kept = str(tmpdir / 'acute-small.cdps.npz')
+
+    with segyio.open(path) as f:
+        expected = segyio.tools.spatial_index(f, path = kept)
+
+    # the coordinates are read from the kept file, not the trace headers
+    with np.load(kept) as npz:
+        cdpx, cdpy, stamp = npz['cdpx'], npz['cdpy'], npz['stamp']
+    cdpx[0] = 100
+    with open(kept, 'wb') as fp:
+        np.savez(fp, cdpx = cdpx, cdpy = cdpy, stamp = stamp)
+
+    with segyio.open(path) as f:
+        index = segyio.tools.spatial_index(f, path = kept)
+        assert index.cdpx[0] == 100
+        assert np.array_equal(index.cdpx[1:], expected.cdpx[1:])
+
+    # coordinates kept for another file, or another version of it, are not,
+    # even when the modification time is only a nanosecond off
+    mtime, size = stamp
+    for other in ([mtime - 1, size], [mtime, size + 240]):
+        with open(kept, 'wb') as fp:
+            np.savez(fp, cdpx = cdpx, cdpy = cdpy, stamp = np.array(other))
+
+        index = segyio.tools.spatial_index(path, path = kept)
+        assert np.array_equal(index.cdpx, expected.cdpx)
+
+
+@tmpfiles(testdata / 'acute-small.sgy')
+def test_spatial_index_not_kept_for_streams(tmpdir):
+    path = str(tmpdir / 'acute-small.sgy')
+    kept = str(tmpdir / 'acute-small.cdps.npz')
+
+    with segyio.open(path) as f:
+        expected = segyio.tools.spatial_index(f, path = kept)
+
+    # streams have no modification time, so coordinates kept for another
+    # file with the same number of traces must not be used
+    with np.load(kept) as npz:
+        cdpx, cdpy, stamp = npz['cdpx'], npz['cdpy'], npz['stamp']
+    with open(kept, 'wb') as fp:
+        np.savez(fp, cdpx = cdpx + 1, cdpy = cdpy, stamp = stamp)
+
+    with open(path, 'rb') as stream:
+        with segyio.open_with(stream) as f:
+            index = segyio.tools.spatial_index(f, path = kept)
+            assert np.array_equal(index.cdpx, expected.cdpx)
+
+    # and the kept file is left alone
+    with np.load(kept) as npz:
+        assert np.array_equal(npz['cdpx'], cdpx + 1)
+
+
+def test_stats_file():
+    with segyio.open(testdata / 'small.sgy') as f:
+        cube = segyio.tools.cube(f).astype(np.float64)
+        for threads in (1, 3):
+            s = segyio.tools.stats(f, threads = threads)
+            assert s['count'] == cube.size
+            assert s['nans'] == 0
+            assert s['min'] == cube.min()
+            assert s['max'] == cube.max()
+            assert s['mean'] == approx(cube.mean())
+            assert s['rms'] == approx(np.sqrt(np.mean(cube ** 2)))
+
+    s = segyio.tools.stats(testdata / 'small.sgy')
+    assert s['count'] == cube.size
+
+
+def test_stats_per_line():
+    with segyio.open(testdata / 'small-ps.sgy') as f:
+        cube = segyio.tools.cube(f).astype(np.float64)
+        per = {
+            'iline': [cube[i] for i in range(len(f.ilines))],
+            'xline': [cube[:, i] for i in range(len(f.xlines))],
+            'offset': [cube[:, :, i] for i in range(len(f.offsets))],
+        }
+
+        for key, lines in per.items():
+            s, hist = segyio.tools.stats(f, per = key,
+                                            bins = 7,
+                                            range = (0, 4),
+                                            threads = 2)
+            assert len(s) == len(lines)
+            assert len(hist) == len(lines)
+            for x, h, line in zip(s, hist, lines):
+                assert x['count'] == line.size
+                assert x['min'] == line.min()
+                assert x['max'] == line.max()
+                assert x['mean'] == approx(line.mean())
+                assert x['rms'] == approx(np.sqrt(np.mean(line ** 2)))
+                expected, _ = np.histogram(line, bins = 7, range = (0, 4))
+                assert list(h) == list(expected)
+
+
+def test_stats_per_trace_nan(tmpdir):
+    path = str(tmpdir / 'nan.sgy')
+    data = np.arange(4 * 5 * 10, dtype = np.float32).reshape((4, 5, 10))
+    data[1, 2, 3] = np.nan
+    data[2, 4, :] = np.nan
+    segyio.tools.from_array(path, data,
+                            format = SegySampleFormat.IEEE_FLOAT_4_BYTE)
+
+    with segyio.open(path) as f:
+        traces = data.reshape(f.tracecount, -1).astype(np.float64)
+        s = segyio.tools.stats(f, per = 'trace')
+        assert len(s) == f.tracecount
+        assert list(s['nans']) == list(np.isnan(traces).sum(axis = 1))
+        assert list(s['count']) == list((~np.isnan(traces)).sum(axis = 1))
+
+        live = s['count'] > 0
+        assert np.array_equal(s['min'][live], np.nanmin(traces[live], axis = 1))
+        assert np.array_equal(s['max'][live], np.nanmax(traces[live], axis = 1))
+        assert np.allclose(s['mean'][live], np.nanmean(traces[live], axis = 1))
+
+        dead = s[~live]
+        assert len(dead) == 1
+        assert dead['min'] == np.inf
+        assert dead['max'] == -np.inf
+        assert np.isnan(dead['mean'])
+
+        s = segyio.tools.stats(f)
+        assert s['nans'] == 11
+        assert s['count'] == data.size - 11
+        assert s['mean'] == approx(np.nanmean(data))
+
+
+def test_stats_invalid():
+    with segyio.open(testdata / 'small.sgy') as f:
+        with pytest.raises(ValueError):
+            segyio.tools.stats(f, per = 'sample')
+
+        with pytest.raises(ValueError):
+            segyio.tools.stats(f, bins = 10)
+
+        with pytest.raises(ValueError):
+            segyio.tools.stats(f, bins = 10, range = (1, 1))
+
+        with pytest.raises(ValueError):
+            segyio.tools.stats(f, per = 'trace', bins = 10, range = (0, 1))
+
+        with pytest.raises(ValueError):
+            segyio.tools.stats(f, threads = 0)
+
+
 @tmpfiles(testdata / 'small.sgy')
 def test_resample_none(tmpdir):
     old = list(range(0, 200, 4))
@@ -331,7 +599,7 @@ def test_from_array3D(tmpdir, create):
             assert len(g.samples) == len(f.samples)
             assert g.tracecount   == f.tracecount
 
-            assert np.array_equal(f.trace, g.trace)
+            assert np.array_equal(f.trace.raw[:], g.trace.raw[:])
             assert list(g.ilines) == list(range(1, 6))
             assert list(g.xlines) == list(range(1, 6))
             assert list(f.offsets) == list(range(1, 2))